@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <pico/stdlib.h>
+#include <hardware/structs/systick.h>
+#include "uart_rx_decode.h"
+
+// Number of times every character is decoded per measurement
+#define BENCH_ROUNDS 64
+
+// Data bits per frame used for the benchmark (8N1)
+#define BENCH_BITS 8
+
+static uint32_t samples[1 << BENCH_BITS]; // Aligned half-bit sample words, one per character
+static volatile uint32_t sink;            // Keeps the compiler from discarding the decoded values
+
+/**
+ * @brief Starts SysTick as a free-running 24-bit down-counter clocked by the processor.
+ */
+static void systick_start()
+{
+    systick_hw->csr = 0;
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5; // Enable, processor clock, no interrupt
+}
+
+/**
+ * @brief Returns the number of cycles elapsed since `start` (SysTick counts down).
+ */
+static uint32_t systick_elapsed(uint32_t start)
+{
+    return (start - systick_hw->cvr) & 0x00FFFFFF;
+}
+
+/**
+ * @brief Builds the sample word the PIO RX program would push for a character.
+ *
+ * Every bit is sampled twice, followed by the stop bit, and the word is aligned so that the
+ * first data bit sits at bit 0 (as `UartRx_decode` does before calling the decoder).
+ */
+static uint32_t encode(uint32_t c, int bits)
+{
+    uint32_t word = 3u << (bits * 2); // Stop bit
+    for (int b = 0; b < bits; b++)
+    {
+        if (c & (1u << b))
+        {
+            word |= 3u << (b * 2);
+        }
+    }
+    return word;
+}
+
+/**
+ * @brief Decodes every sample `BENCH_ROUNDS` times and returns the cycles spent per character.
+ */
+static uint32_t bench_loop()
+{
+    uint32_t start = systick_hw->cvr;
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        for (int c = 0; c < (1 << BENCH_BITS); c++)
+        {
+            sink = UartRx_decodeLoop(samples[c], BENCH_BITS);
+        }
+    }
+    return systick_elapsed(start) / (BENCH_ROUNDS << BENCH_BITS);
+}
+
+#if UART_RX_DECODE_TABLE_BITS
+/**
+ * @brief Same as `bench_loop` but with the bit-compaction table decoder.
+ */
+static uint32_t bench_table()
+{
+    uint32_t start = systick_hw->cvr;
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        for (int c = 0; c < (1 << BENCH_BITS); c++)
+        {
+            sink = UartRx_decodeTable(samples[c], BENCH_BITS);
+        }
+    }
+    return systick_elapsed(start) / (BENCH_ROUNDS << BENCH_BITS);
+}
+#endif
+
+void setup()
+{
+    stdio_init_all();
+    while (!stdio_usb_connected())
+    {
+        tight_loop_contents(); // Wait for USB serial connection to be ready
+    }
+    sleep_ms(100);
+
+    for (int c = 0; c < (1 << BENCH_BITS); c++)
+    {
+        samples[c] = encode(c, BENCH_BITS);
+#if UART_RX_DECODE_TABLE_BITS
+        if (UartRx_decodeLoop(samples[c], BENCH_BITS) != c || UartRx_decodeTable(samples[c], BENCH_BITS) != c)
+        {
+            printf("Decoder mismatch for 0x%02x\n", c);
+        }
+#endif
+    }
+    systick_start();
+    printf("Benchmark Initialized.\n");
+}
+
+void loop()
+{
+    printf("\nRX decode (cycles per byte)\n");
+    printf("Bit loop: %lu\n", (unsigned long)bench_loop());
+#if UART_RX_DECODE_TABLE_BITS
+    printf("Table (%d-bit index): %lu\n", UART_RX_DECODE_TABLE_BITS, (unsigned long)bench_table());
+#else
+    printf("Table: disabled (UART_RX_DECODE_TABLE_BITS=0)\n");
+#endif
+    sleep_ms(5000);
+}
+
+int main()
+{
+    setup();
+    while (true)
+    {
+        loop();
+    }
+    return 0;
+}
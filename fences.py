@@ -0,0 +1,246 @@
+import argparse
+import json
+import math
+import sys
+
+# Compiler of geofences for gps/geofence.h: reads GeoJSON polygons, writes a C file of constant
+# tables (a GeofenceIndex) that stays in flash.
+#
+#   python fences.py zones.geojson -o fences.c                # index named geofence_index
+#   python fences.py zones.geojson -o fences.c --margin 15    # 15 m of hysteresis
+#
+# Every Polygon or MultiPolygon feature is a fence (outer rings only), identified by its "id"
+# property, or by its position in the file. Fences must not cross the antimeridian.
+
+GEOFENCE_VERSION = 1         # GEOFENCE_VERSION
+CELL_INSIDE = 0x8000         # GEOFENCE_CELL_INSIDE
+MAX_FENCES = 0x7FFF          # GEOFENCE_FENCE_MASK
+SCALE_ONE = 65535            # GEOFENCE_SCALE_ONE
+EDGE_MAX = 1 << 19           # Longest edge along either axis, latitude units (the runtime's products fit 64 bits)
+DEGREES_SCALE = 10000000     # NMEA_DEGREES_SCALE
+UNITS_PER_M = DEGREES_SCALE * 360 / (2 * math.pi * 6371008.8)  # Latitude units per meter
+
+class Fence:
+    """
+    One ring in integer units, with the scale that makes longitudes comparable to latitudes.
+    """
+    def __init__(self, number, fence_id, ring):
+        self.number = number
+        self.id = fence_id
+        latitudes = [lat for lat, _ in ring]
+        self.scale = min(SCALE_ONE, round(math.cos(math.radians((min(latitudes) + max(latitudes)) / 2 / DEGREES_SCALE)) * 65536))
+        self.ring = split(ring, self.scale)
+        self.south, self.north = min(latitudes), max(latitudes)
+        longitudes = [lon for _, lon in ring]
+        self.west, self.east = min(longitudes), max(longitudes)
+
+    def metric(self, lat, lon):
+        """
+        Position in the fence's metric plane: latitude units on both axes.
+        """
+        return lon * self.scale / 65536, lat
+
+def split(ring, scale):
+    """
+    Cuts the edges longer than EDGE_MAX on either axis into equal parts.
+    """
+    out = []
+    for i, (lat, lon) in enumerate(ring):
+        nlat, nlon = ring[(i + 1) % len(ring)]
+        parts = max(1, math.ceil(max(abs(nlat - lat), abs(nlon - lon) * scale / 65536) / EDGE_MAX))
+        for part in range(parts):
+            out.append((lat + (nlat - lat) * part // parts, lon + (nlon - lon) * part // parts))
+    return out
+
+def load(path):
+    """
+    Reads the outer rings of the GeoJSON polygons as (id, [(lat, lon), ...]) in integer units.
+    """
+    with open(path) as source:
+        data = json.load(source)
+    features = data["features"] if data.get("type") == "FeatureCollection" else [data]
+    fences = []
+    for feature in features:
+        geometry = feature.get("geometry") or {}
+        properties = feature.get("properties") or {}
+        if geometry.get("type") == "Polygon":
+            polygons = [geometry["coordinates"]]
+        elif geometry.get("type") == "MultiPolygon":
+            polygons = geometry["coordinates"]
+        else:
+            continue
+        for polygon in polygons:
+            ring = [(round(lat * DEGREES_SCALE), round(lon * DEGREES_SCALE)) for lon, lat, *_ in polygon[0]]
+            if len(ring) > 1 and ring[0] == ring[-1]:
+                ring.pop()
+            if len(ring) < 3:
+                raise ValueError(f"{path}: a fence needs at least 3 vertices")
+            if max(lon for _, lon in ring) - min(lon for _, lon in ring) > 180 * DEGREES_SCALE:
+                raise ValueError(f"{path}: fence {properties.get('id', len(fences))} crosses the antimeridian")
+            fence_id = int(properties.get("id", len(fences)))
+            if not 0 <= fence_id <= 0xFFFF:
+                raise ValueError(f"{path}: fence id {fence_id} does not fit 16 bits")
+            fences.append((fence_id, ring))
+    if len(fences) > MAX_FENCES:
+        raise ValueError(f"{path}: {len(fences)} fences, at most {MAX_FENCES}")
+    return fences
+
+def inside(ring, x, y, fence):
+    """
+    Crossing parity of a ray going east from a metric position.
+    """
+    result = False
+    for i in range(len(ring)):
+        ax, ay = fence.metric(*ring[i - 1])
+        bx, by = fence.metric(*ring[i])
+        if (ay > y) != (by > y) and x < ax + (bx - ax) * (y - ay) / (by - ay):
+            result = not result
+    return result
+
+def point_segment(px, py, ax, ay, bx, by):
+    dx, dy = bx - ax, by - ay
+    length2 = dx * dx + dy * dy
+    t = 0 if length2 == 0 else max(0, min(1, ((px - ax) * dx + (py - ay) * dy) / length2))
+    return math.hypot(px - ax - t * dx, py - ay - t * dy)
+
+def crosses(ax, ay, bx, by, cx, cy, dx, dy):
+    def side(px, py, qx, qy, rx, ry):
+        return (qx - px) * (ry - py) - (qy - py) * (rx - px)
+    return (side(ax, ay, bx, by, cx, cy) * side(ax, ay, bx, by, dx, dy) <= 0 and
+            side(cx, cy, dx, dy, ax, ay) * side(cx, cy, dx, dy, bx, by) <= 0)
+
+def segment_box(ax, ay, bx, by, west, south, east, north):
+    """
+    Distance from a segment to a rectangle (0 if they touch).
+    """
+    if west <= ax <= east and south <= ay <= north:
+        return 0
+    corners = [(west, south), (east, south), (east, north), (west, north)]
+    for i in range(4):
+        if crosses(ax, ay, bx, by, *corners[i - 1], *corners[i]):
+            return 0
+    def point_box(px, py):
+        return math.hypot(max(west - px, 0, px - east), max(south - py, 0, py - north))
+    return min([point_box(ax, ay), point_box(bx, by)] + [point_segment(x, y, ax, ay, bx, by) for x, y in corners])
+
+def compile_index(fences, margin, cell):
+    """
+    Lays the grid over the fences and lists, for every cell, the fences within the margin.
+    Returns the grid, the cells as {key: [candidate, ...]} and the Fence objects.
+    """
+    fences = [Fence(number, fence_id, ring) for number, (fence_id, ring) in enumerate(fences)]
+    slack = margin + 2 # Rounding of the integer runtime
+    south = min(f.south for f in fences) - slack
+    north = max(f.north for f in fences) + slack
+    scale = math.cos(math.radians((south + north) / 2 / DEGREES_SCALE))
+    west = min(f.west - slack * 65536 / f.scale for f in fences)
+    east = max(f.east + slack * 65536 / f.scale for f in fences)
+    cell_lat = max(1, round(cell))
+    cell_lon = max(1, round(cell / max(scale, 0.001)))
+    grid = {"latitude": math.floor(south), "longitude": math.floor(west), "cell_latitude": cell_lat,
+            "cell_longitude": cell_lon}
+    grid["columns"] = max(1, math.ceil((east - grid["longitude"]) / cell_lon))
+    grid["rows"] = max(1, math.ceil((north - grid["latitude"]) / cell_lat))
+    if grid["columns"] * grid["rows"] >= 1 << 32:
+        raise ValueError("too many cells: use a larger --cell")
+
+    cells = {}
+    for fence in fences:
+        lon_slack = slack * 65536 / fence.scale
+        rows = range(int((fence.south - slack - grid["latitude"]) // cell_lat),
+                     int((fence.north + slack - grid["latitude"]) // cell_lat) + 1)
+        columns = range(int((fence.west - lon_slack - grid["longitude"]) // cell_lon),
+                        int((fence.east + lon_slack - grid["longitude"]) // cell_lon) + 1)
+        edges = [(*fence.metric(*fence.ring[i - 1]), *fence.metric(*fence.ring[i])) for i in range(len(fence.ring))]
+        for row in rows:
+            for column in columns:
+                south_edge = grid["latitude"] + row * cell_lat
+                west_edge = grid["longitude"] + column * cell_lon
+                x0, y0 = fence.metric(south_edge, west_edge)
+                x1, y1 = fence.metric(south_edge + cell_lat, west_edge + cell_lon)
+                distance = min(segment_box(*edge, x0, y0, x1, y1) for edge in edges)
+                if distance <= slack:
+                    candidate = fence.number
+                elif inside(fence.ring, (x0 + x1) / 2, (y0 + y1) / 2, fence):
+                    candidate = fence.number | CELL_INSIDE
+                else:
+                    continue # Outside by more than the margin
+                cells.setdefault(row * grid["columns"] + column, []).append(candidate)
+    return grid, cells, fences
+
+def rows(out, entries, width=100):
+    """
+    Prints array entries, as many per line as fit.
+    """
+    line = ""
+    for entry in entries:
+        if line and len(line) + len(entry) + 1 > width:
+            print(line, file=out)
+            line = ""
+        line = f"{line} {entry}" if line else f"    {entry}"
+    if line:
+        print(line, file=out)
+
+def write(out, name, source, grid, cells, fences, margin):
+    keys = sorted(cells)
+    vertices = sum(len(f.ring) for f in fences)
+    candidates = sum(len(cells[key]) for key in keys)
+    print(f"// Generated by fences.py from {source}: {len(fences)} fences, {vertices} vertices, "
+          f"{len(keys)} cells, {candidates} candidates", file=out)
+    print('#include "geofence.h"\n', file=out)
+    print("static const GeofenceFence fences[] = {", file=out)
+    first = 0
+    for fence in fences:
+        print(f"    {{{first}, {len(fence.ring)}, {fence.id}, {fence.scale}}},", file=out)
+        first += len(fence.ring)
+    print("};\n\nstatic const GeofenceVertex vertices[] = {", file=out)
+    for fence in fences:
+        print("    " + " ".join(f"{{{lat}, {lon}}}," for lat, lon in fence.ring), file=out)
+    print("};\n\nstatic const GeofenceCell cells[] = {", file=out)
+    entries = []
+    first = 0
+    for key in keys:
+        entries.append(f"{{{key}, {first}}},")
+        first += len(cells[key])
+    rows(out, entries)
+    print(f"    {{0xFFFFFFFF, {first}}}, // Sentinel", file=out)
+    print("};\n\nstatic const uint16_t candidates[] = {", file=out)
+    rows(out, [f"0x{candidate:04X}," for key in keys for candidate in sorted(cells[key])])
+    print("};\n", file=out)
+    print(f"const GeofenceIndex {name} = {{", file=out)
+    print(f"    GEOFENCE_VERSION, {grid['latitude']}, {grid['longitude']}, {grid['cell_latitude']}, "
+          f"{grid['cell_longitude']}, {grid['columns']}, {grid['rows']}, {round(margin)},", file=out)
+    print(f"    {len(fences)}, {len(keys)}, fences, vertices, cells, candidates,", file=out)
+    print("};", file=out)
+    size = len(fences) * 12 + vertices * 8 + (len(keys) + 1) * 8 + candidates * 2 + 56
+    most = max((len(cells[key]) for key in keys), default=0)
+    print(f"# {len(fences)} fences, {vertices} vertices, {len(keys)} of {grid['columns'] * grid['rows']} cells, "
+          f"{candidates} candidates (at most {most} per cell), {size} bytes of flash", file=sys.stderr)
+
+def main():
+    parser = argparse.ArgumentParser(description="Compiles GeoJSON polygons into a GeofenceIndex for gps/geofence.h")
+    parser.add_argument("geojson", help="FeatureCollection of Polygon or MultiPolygon features")
+    parser.add_argument("-o", "--output", help="C file to write (default: stdout)")
+    parser.add_argument("-n", "--name", default="geofence_index", help="name of the GeofenceIndex")
+    parser.add_argument("-m", "--margin", type=float, default=10.0, help="hysteresis distance in meters")
+    parser.add_argument("-c", "--cell", type=float, default=250.0, help="cell size in meters")
+    args = parser.parse_args()
+
+    try:
+        fences = load(args.geojson)
+        if not fences:
+            raise ValueError(f"{args.geojson}: no polygons")
+        margin = args.margin * UNITS_PER_M
+        grid, cells, compiled = compile_index(fences, margin, args.cell * UNITS_PER_M)
+    except (OSError, ValueError, KeyError) as error:
+        print(f"fences.py: {error}", file=sys.stderr)
+        return 1
+    if args.output:
+        with open(args.output, "w") as out:
+            write(out, args.name, args.geojson, grid, cells, compiled, margin)
+    else:
+        write(sys.stdout, args.name, args.geojson, grid, cells, compiled, margin)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
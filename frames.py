@@ -0,0 +1,215 @@
+import argparse
+import struct
+import sys
+import time
+
+# Decoder of the binary output of nmea/nmea_output.c (NMEA_BINARY_OUTPUT=1 in the examples).
+#
+#   python frames.py COM5              # read the Pico's USB serial port (pip install pyserial)
+#   python frames.py -f frames.bin     # decode a capture, e.g. the one written by nmea_replay -o
+#
+# Fixes are printed as CSV on stdout, throughput reports (fixes/s, bytes/s, lost frames) on stderr.
+
+serial_baudrate = 115200 # Same as flash.py
+
+FRAME_VERSION = 1   # NMEA_OUTPUT_VERSION
+FRAME_FIX = 1       # NMEA_OUTPUT_FIX
+FRAME_STATS = 2     # NMEA_OUTPUT_STATS
+
+HEADER = struct.Struct("<BBH")              # Version, type, sequence number
+FIX = struct.Struct("<IIIiiiiHHHHBBBB")     # NMEAOutput_fixBody
+STATS = struct.Struct("<8I")                # NMEAOutput_statsBody
+
+DEGREES_SCALE = 1e7   # NMEA_DEGREES_SCALE
+SPEED_SCALE = 1e3     # NMEA_SPEED_SCALE
+ANGLE_SCALE = 1e2     # NMEA_ANGLE_SCALE
+ALTITUDE_SCALE = 1e2  # NMEA_ALTITUDE_SCALE
+DOP_SCALE = 1e2       # NMEA_DOP_SCALE
+
+def crc16(data):
+    """
+    CRC-16/CCITT-FALSE, the checksum that ends every frame.
+    """
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021 if crc & 0x8000 else crc << 1) & 0xFFFF
+    return crc
+
+def cobs_decode(data):
+    """
+    Reverses the COBS encoding of one frame (without its zero delimiter).
+    Returns None if the frame is malformed.
+    """
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data) + 1:
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+def check(chunk):
+    """
+    Decodes one frame and checks its CRC. Returns header, body and CRC, or None.
+    """
+    frame = cobs_decode(chunk)
+    if frame is None or len(frame) < HEADER.size + 2 or crc16(frame[:-2]) != struct.unpack("<H", frame[-2:])[0]:
+        return None
+    return frame
+
+class Decoder:
+    """
+    Splits a byte stream on zero bytes and decodes the frames, counting what was lost.
+    """
+    def __init__(self):
+        self.pending = bytearray()
+        self.sequence = None
+        self.frames = 0
+        self.fixes = 0
+        self.bytes = 0
+        self.crc_errors = 0
+        self.gaps = 0
+        self.text = 0
+        self.first_ms = None # Boot time of the first and last fix: the rate on the device's clock
+        self.last_ms = None
+
+    def feed(self, data):
+        """
+        Decodes every complete frame in `data` and yields (type, sequence, fields).
+        Text printed between frames (start-up messages, trace reports) is yielded as ("text", line).
+        """
+        self.bytes += len(data)
+        self.pending += data
+        while True:
+            end = self.pending.find(0)
+            if end < 0:
+                return
+            chunk = bytes(self.pending[:end])
+            del self.pending[:end + 1]
+            frame = check(chunk)
+            text = b""
+            if frame is None:
+                # Text has no zero bytes, so it arrives in front of the next frame
+                text = chunk
+                split = chunk.find(b"\n")
+                while split >= 0 and frame is None:
+                    frame = check(chunk[split + 1:])
+                    if frame is not None:
+                        text = chunk[:split + 1]
+                    split = chunk.find(b"\n", split + 1)
+            if text:
+                lines = text.decode("ascii", "replace").splitlines()
+                if all(line.isprintable() for line in lines):
+                    self.text += len(lines)
+                    for line in lines:
+                        yield "text", line
+                else:
+                    self.crc_errors += 1 # A damaged frame
+            if frame is None:
+                continue
+            version, kind, sequence = HEADER.unpack_from(frame)
+            if version != FRAME_VERSION:
+                self.crc_errors += 1
+                continue
+            if self.sequence is not None and sequence != (self.sequence + 1) & 0xFFFF:
+                self.gaps += (sequence - self.sequence - 1) & 0xFFFF
+            self.sequence = sequence
+            self.frames += 1
+            body = frame[HEADER.size:-2]
+            if kind == FRAME_FIX and len(body) == FIX.size:
+                self.fixes += 1
+                fields = FIX.unpack(body)
+                self.first_ms = fields[0] if self.first_ms is None else self.first_ms
+                self.last_ms = fields[0]
+                yield "fix", sequence, fields
+            elif kind == FRAME_STATS and len(body) == STATS.size:
+                yield "stats", sequence, STATS.unpack(body)
+
+def format_fix(fields):
+    """
+    One CSV line per fix: boot time, UTC date and time, position, altitude, speed, course, quality.
+    """
+    (boot_ms, utc, date, lat, lon, alt, speed, course, hdop, pdop, vdop,
+     quality, mode, satellites, flags) = fields
+    return (f"{boot_ms},{date:06d},{utc // 1000:06d}.{utc % 1000:03d},{lat / DEGREES_SCALE:.7f},"
+            f"{lon / DEGREES_SCALE:.7f},{alt / ALTITUDE_SCALE:.2f},{speed / SPEED_SCALE:.3f},"
+            f"{course / ANGLE_SCALE:.2f},{hdop / DOP_SCALE:.2f},{quality},{mode},{satellites},{flags & 1}")
+
+def format_stats(fields):
+    accepted, rejected, overflows, dma_overflows, truncations, framing, cycles_max, cycles_avg = fields
+    return (f"# sentences: {accepted} accepted, {rejected} bad checksum, {truncations} truncated, "
+            f"{overflows} bytes overrun, {dma_overflows} DMA overruns, {framing} framing errors; "
+            f"parse cycles max {cycles_max} avg {cycles_avg}")
+
+def report(decoder, elapsed, previous):
+    """
+    Prints the throughput since the previous report and returns the counters it was based on.
+    """
+    fixes, frames, data = decoder.fixes - previous[0], decoder.frames - previous[1], decoder.bytes - previous[2]
+    print(f"# {fixes / elapsed:.1f} fixes/s, {frames / elapsed:.1f} frames/s, {data / elapsed:.0f} bytes/s; "
+          f"total {decoder.frames} frames, {decoder.crc_errors} bad, {decoder.gaps} lost, {decoder.text} text lines",
+          file=sys.stderr)
+    return decoder.fixes, decoder.frames, decoder.bytes
+
+def run(read, quiet, interval):
+    decoder = Decoder()
+    start = last = time.monotonic()
+    previous = (0, 0, 0)
+    if not quiet:
+        print("boot_ms,date,utc,latitude,longitude,altitude,speed_kn,course,hdop,quality,mode,satellites,valid")
+    while True:
+        data = read()
+        if data is None:
+            break
+        for item in decoder.feed(data):
+            if quiet:
+                continue
+            if item[0] == "fix":
+                print(format_fix(item[2]))
+            elif item[0] == "stats":
+                print(format_stats(item[2]))
+            else:
+                print(f"# {item[1]}")
+        now = time.monotonic()
+        if now - last >= interval:
+            previous = report(decoder, now - last, previous)
+            last = now
+    elapsed = time.monotonic() - start
+    report(decoder, max(elapsed, 1e-9), (0, 0, 0))
+    if decoder.fixes > 1 and decoder.last_ms != decoder.first_ms:
+        span = (decoder.last_ms - decoder.first_ms) / 1000 # Device time, also right for captures
+        print(f"# device clock: {(decoder.fixes - 1) / span:.2f} fixes/s, {decoder.bytes / decoder.fixes:.1f} bytes/fix, "
+              f"{decoder.bytes * (decoder.fixes - 1) / decoder.fixes / span:.0f} bytes/s", file=sys.stderr)
+    return 0 if decoder.crc_errors == 0 and decoder.gaps == 0 else 1
+
+def main():
+    parser = argparse.ArgumentParser(description="Decodes the binary output of the examples (NMEA_BINARY_OUTPUT=1)")
+    parser.add_argument("port", nargs="?", help="serial port of the Pico, e.g. COM5 or /dev/ttyACM0")
+    parser.add_argument("-f", "--file", help="decode a capture instead, e.g. the one written by nmea_replay -o")
+    parser.add_argument("-q", "--quiet", action="store_true", help="print only the throughput reports")
+    parser.add_argument("-i", "--interval", type=float, default=5.0, help="seconds between throughput reports")
+    args = parser.parse_args()
+
+    if args.file:
+        with open(args.file, "rb") as capture:
+            return run(lambda: capture.read(4096) or None, args.quiet, args.interval)
+    if not args.port:
+        parser.error("a serial port or -f is required")
+
+    import serial # pip install pyserial
+    port = serial.Serial(args.port, serial_baudrate, timeout=0.1) # USB CDC ignores the rate
+    try:
+        return run(lambda: port.read(4096), args.quiet, args.interval)
+    except KeyboardInterrupt:
+        return 0
+    finally:
+        port.close()
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -4,58 +4,9 @@
 #include <cstdio>
 #include <math.h>
 
-/**
- * @brief Updates the NMEA sentence output intervals for the GPS module.
- *
- * This function constructs a command string to set the output intervals for different
- * NMEA sentences (GLL, RMC, VTG, GGA, GSA, GSV) based on the current configuration
- * stored in the `intervals` member of the `GPS` class. The command is sent to the GPS
- * module, enabling or disabling the sentences according to the provided `enable` flag.
- *
- * @param enable - A boolean value indicating whether to enable or disable the intervals.
- *                 If `true`, the intervals are enabled; if `false`, the intervals are disabled.
- */
-void GPS::_doUpdateIntervals(bool enable)
-{
-    // Constructs and sends the NMEA command for updating sentence intervals
-    char command[100];
-    snprintf(command, sizeof(command),
-             "$PMTK314,%d,%d,%d,%d,%d,%d,0,0,0,0,0,0,0,0,0,0,0,0,0*%s",
-             intervals.GLL ? 1 : 0,
-             intervals.RMC ? 1 : 0,
-             intervals.VTG ? 1 : 0,
-             intervals.GGA ? 1 : 0,
-             intervals.GSA ? 1 : 0,
-             intervals.GSV ? 1 : 0,
-             enable ? "28" : "29"); // Command format with checksum (enable/disable)
-    write(command);
-}
-
-/**
- * @brief Converts a latitude or longitude in DDMM format to decimal degrees.
- *
- * This function takes a coordinate in DDMM format (degrees and minutes) and converts it
- * to decimal degrees, which is commonly used in GPS systems. The conversion is done by
- * extracting the degrees and minutes, then calculating the fractional degree value and
- * adding it to the degrees.
- *
- * @param ddmm - The coordinate in DDMM format (degrees and minutes, e.g., 12345.67 for 123° 45.67').
- *
- * @return A double representing the coordinate in decimal degrees.
- *         The result can be positive or negative depending on the direction (e.g., North/South for latitude or East/West for longitude).
- */
-double GPS::_convertToDecimalDegrees(double ddmm)
-{
-    // Converts DDMM format to decimal degrees
-    int degrees = (int)(ddmm / 100);             // Extract degrees
-    double lat_mm_mmmm = ddmm - (degrees * 100); // Extract minutes
-    int minutes = (int)lat_mm_mmmm;
-    double fractionalMinutes = lat_mm_mmmm - minutes;
-
-    double minutesDecimal = (minutes + fractionalMinutes) / 60.0; // Convert minutes to decimal
-    double decimalDegrees = degrees + minutesDecimal;             // Add degrees and minutes
-    return decimalDegrees;
-}
+// Constant commands, with their checksums computed by the compiler
+static constexpr auto STANDBY_COMMAND = PMTK_constant("PMTK161,0"); // 3.8. Packet Type: 161 PMTK_CMD_STANDBY_MODE
+static constexpr auto TEST_COMMAND = PMTK_constant("PMTK000");      // 3.1. Packet Type: 000 PMTK_TEST
 
 /**
  * @brief Constructs a GPS object with the specified sentence intervals.
@@ -66,6 +17,12 @@ GPS::GPS(IntervalType intervals)
     // Initialize GPS with sentence intervals configuration
     this->intervals = intervals;
     this->start_year = 2000;
+    this->_nmeaParser = nullptr;
+    for (Registration &registration : _listeners)
+    {
+        registration = {nullptr, nullptr};
+    }
+    PMTKAcks_init(&_acks);
 }
 
 /**
@@ -74,8 +31,10 @@ GPS::GPS(IntervalType intervals)
 GPS::~GPS()
 {
     // Clean up allocated resources
-    NMEAParser_free(this->_nmeaParser);
-    delete this->_nmeaParser;
+    if (this->_nmeaParser != nullptr)
+    {
+        NMEAParser_free(this->_nmeaParser);
+    }
 }
 
 /**
@@ -86,8 +45,15 @@ GPS::~GPS()
 void GPS::init(int rx, int tx)
 {
     // Initialize NMEA parser with specified RX and TX pins
-    this->_nmeaParser = new NMEAParser();
+    this->_parser = NMEAParser(); // Zeroed, so the parser picks its own UART settings
+    this->_nmeaParser = &this->_parser;
     NMEAParser_init(_nmeaParser, rx, tx);
+    NMEAParser_on(_nmeaParser, NMEA_SENTENCE_BIT(NMEA_SENTENCE_ACK) | NMEA_EVENT_EPOCH, _onParserEvent, this);
+    GPSPower_init(&_power, _nmeaParser, &_acks, 1000); // The module starts at 1 Hz
+    GPSStartup_init(&_startup, _nmeaParser->uart_tx, &_acks); // Loads the state saved in flash
+    _rate = GPSRate();                                         // No throttling until setHighRate
+    GPSTrack_init(&_track);
+    Geofence_init(&_geofence, _nmeaParser);
     updateIntervals();
 }
 
@@ -108,6 +74,10 @@ bool GPS::isAvailable()
 char *GPS::read()
 {
     // Reads the next available NMEA sentence
+    if (_rate.active)
+    {
+        GPSRate_sample(&_rate, _nmeaParser->uart_rx); // Backlog the reader has not caught up with
+    }
     return NMEAParser_read(_nmeaParser);
 }
 
@@ -118,9 +88,48 @@ char *GPS::read()
 void GPS::write(const char *str)
 {
     // Sends a command string to the GPS module
+    PMTKAcks_sent(&_acks, str);
     UartTx_println(_nmeaParser->uart_tx, str);
 }
 
+/**
+ * @brief Returns the acknowledgement state of the last command of a packet type.
+ * @param command - The packet type, e.g. PMTK_SET_NMEA_OUTPUT.
+ * @return PMTK_ACK_PENDING until the module replied, then its reply (PMTK_ACK_SUCCESS, ...).
+ */
+PMTKAckStatus GPS::ack(uint16_t command) const
+{
+    return PMTKAcks_status(&_acks, command);
+}
+
+/**
+ * @brief Handles the parser events of the object: dispatches every committed epoch to the startup accelerator,
+ *        the fix smoother, the geofences and the throttling, and records the $PMTK001 replies of the module.
+ *
+ * One listener for both events, so the object takes a single slot of NMEA_PARSER_LISTENERS.
+ */
+void GPS::_onParserEvent(NMEAParser *parser, uint32_t event, void *ctx)
+{
+    GPS *gps = static_cast<GPS *>(ctx);
+    if (event == NMEA_EVENT_EPOCH)
+    {
+        NMEAFix fix;
+        NMEAParser_fix(parser, &fix);
+        GPSStartup_fix(&gps->_startup, &fix);
+        GPSTrack_fix(&gps->_track, &fix);
+        Geofence_fix(&gps->_geofence, &fix); // Calls onGeofence of the listeners
+        if (GPSRate_epoch(&gps->_rate, parser->uart_rx))
+        {
+            PMTKCommand command;
+            gps->write(PMTKCommand_output(&command, gps->_rate.rates)); // Shed or restored one step
+        }
+        return;
+    }
+    const PMTK001_Data *pmtk001 = &parser->data.pmtk001;
+    PMTKAcks_receive(&gps->_acks, pmtk001->command, pmtk001->flag);
+    GPSStartup_ack(&gps->_startup, pmtk001->command, pmtk001->flag);
+}
+
 /**
  * @brief Retrieves the current GPS data.
  * @return A constant reference to the GPSData object.
@@ -131,53 +140,45 @@ const GPSData &GPS::getGPSData() const
     return _nmeaParser->data;
 }
 
+/**
+ * @brief Takes a consistent snapshot of the current fix.
+ *
+ * The snapshot is a few dozen bytes and cannot be torn by the parser updating it; take one
+ * per sentence and read all fields from it rather than calling several accessors.
+ * @return The latest fix.
+ */
+NMEAFix GPS::fix() const
+{
+    NMEAFix fix;
+    NMEAParser_fix(_nmeaParser, &fix);
+    return fix;
+}
+
 /**
  * @brief Gets the latitude in decimal degrees.
- * @return The latitude value in decimal degrees.
+ * @return The latitude value in decimal degrees (negative south).
  */
 double GPS::latitude()
 {
-    // Returns latitude in decimal degrees, considering the hemisphere (N/S)
-    GPSData data = getGPSData();
-    if (data.latitude > 0 && data.latitude_dir != NULL)
-    {
-        double decimalDegrees = _convertToDecimalDegrees(data.latitude);
-        if (strcmp(data.latitude_dir, "S") == 0)
-        {
-            decimalDegrees = -decimalDegrees;
-        }
-        return decimalDegrees;
-    }
-    return 0;
+    return (double)fix().latitude / NMEA_DEGREES_SCALE;
 }
 
 /**
  * @brief Gets the longitude in decimal degrees.
- * @return The longitude value in decimal degrees.
+ * @return The longitude value in decimal degrees (negative west).
  */
 double GPS::longitude()
 {
-    // Returns longitude in decimal degrees, considering the hemisphere (E/W)
-    GPSData data = getGPSData();
-    if (data.longitude > 0 && data.longitude_dir != NULL)
-    {
-        double decimalDegrees = _convertToDecimalDegrees(data.longitude);
-        if (strcmp(data.longitude_dir, "W") == 0)
-        {
-            decimalDegrees = -decimalDegrees;
-        }
-        return decimalDegrees;
-    }
-    return 0;
+    return (double)fix().longitude / NMEA_DEGREES_SCALE;
 }
 
 /**
- * @brief Retrieves the current date in YYYYMMDD format.
+ * @brief Retrieves the current date in DDMMYY format.
  * @return The current date as a long integer.
  */
 const long GPS::getDate()
 {
-    return atol(getGPSData().gprmc.date);
+    return fix().date;
 }
 
 /**
@@ -213,7 +214,23 @@ uint8_t GPS::day()
  */
 float GPS::speed()
 {
-    return getGPSData().speed;
+    return (float)fix().speed / NMEA_SPEED_SCALE;
+}
+
+/**
+ * @brief Estimates the position and velocity at any time between epochs.
+ *
+ * The committed fixes are smoothed by a constant-velocity Kalman filter, weighted by their
+ * HDOP; the estimate extrapolates the last one in O(1) and may be read from any core or
+ * interrupt (see GPSTrack_predict).
+ *
+ * @param time_us - The time of the estimate in microseconds since boot, e.g. time_us_32().
+ * @param estimate - Receives the estimate.
+ * @return false before the first valid fix, or more than GPS_TRACK_HORIZON_MS after the last one.
+ */
+bool GPS::predict(uint32_t time_us, GPSTrackEstimate &estimate) const
+{
+    return GPSTrack_predict(&_track, time_us, &estimate);
 }
 
 /**
@@ -222,31 +239,75 @@ float GPS::speed()
  */
 void GPS::updateIntervals()
 {
-    // Toggle the NMEA sentence output intervals (enable/disable)
-    _doUpdateIntervals(false); // Disable intervals first
-    _doUpdateIntervals(true);  // Then enable them
+    // Sends the output rate of every sentence at once; the module replies with PMTK_RESPONSE
+    const uint8_t rates[PMTK_OUTPUT_COUNT] = {intervals.GLL, intervals.RMC, intervals.VTG,
+                                              intervals.GGA, intervals.GSA, intervals.GSV};
+    PMTKCommand command;
+    if (_rate.active)
+    {
+        GPSRate_request(&_rate, rates); // The high-rate profile sheds what its link budget cannot carry
+        write(PMTKCommand_output(&command, _rate.rates));
+        return;
+    }
+    write(PMTKCommand_output(&command, rates));
 }
 
 /**
  * @brief Sets the GPS position update frequency.
- * @param hz - The desired frequency in Hertz (Hz).
+ * @param hz - The desired frequency in Hertz (Hz), clamped to 0.1..10; ignored unless positive.
  * @see  3.13. Packet Type: 220 PMTK_SET_POS_FIX
  */
 void GPS::setFrequency(double hz)
 {
     // Sends a command to set the frequency of position updates (in Hz)
-    char nmea[50], checksum_str[3], command[60];
-    int interval = (int)(1000 / hz); // Convert Hz to interval in milliseconds
-    snprintf(nmea, sizeof(nmea), "PMTK220,%d", interval);
+    if (!(hz > 0))
+    {
+        return;
+    }
+    double ms = 1000 / hz; // Convert Hz to interval in milliseconds, within what the module accepts
+    uint16_t interval = ms < PMTK_MIN_FIX_INTERVAL   ? PMTK_MIN_FIX_INTERVAL
+                        : ms > PMTK_MAX_FIX_INTERVAL ? PMTK_MAX_FIX_INTERVAL
+                                                     : (uint16_t)ms;
+    PMTKCommand command;
+    write(PMTKCommand_fixInterval(&command, interval));
+    GPSPower_setInterval(&_power, interval);
+    _rate.interval = interval;
+}
 
-    unsigned char checksum = 0;
-    for (int i = 0; nmea[i] != '\0'; i++)
+/**
+ * @brief Switches to a high fix rate with sentence rates and a baud rate that fit the link.
+ *
+ * Works out the bytes per epoch of `intervals`, sheds GSV, GLL, GSA and VTG (in that order)
+ * if even 115200 baud cannot carry them, and sends the sentence rates (PMTK314), the slowest
+ * baud rate that fits (PMTK251) and the fix interval (PMTK220), in that order. From then on,
+ * every epoch checks the receive ring and its overflow counters, and sheds or restores one step
+ * before characters are lost (see `GPSRate`).
+ * @param hz - The fix rate in Hertz (up to 10).
+ * @return The baud rate picked.
+ */
+unsigned long GPS::setHighRate(double hz)
+{
+    const uint8_t rates[PMTK_OUTPUT_COUNT] = {intervals.GLL, intervals.RMC, intervals.VTG,
+                                              intervals.GGA, intervals.GSA, intervals.GSV};
+    uint32_t baud = GPSRate_plan(&_rate, _nmeaParser->uart_rx, (uint16_t)(1000 / hz), rates, GPS_RATE_MAX_BAUD);
+    PMTKCommand command;
+    write(PMTKCommand_output(&command, _rate.rates));
+    if (baud != _nmeaParser->pico->baud)
     {
-        checksum ^= nmea[i];
+        setBaud(baud);
     }
-    snprintf(checksum_str, sizeof(checksum_str), "%02X", checksum);
-    snprintf(command, sizeof(command), "$%s*%s", nmea, checksum_str);
-    write(command);
+    setFrequency(hz);
+    return baud;
+}
+
+/**
+ * @brief Returns the counters of the sentence throttling.
+ */
+GPSRateStats GPS::rateStats() const
+{
+    GPSRateStats stats;
+    GPSRate_stats(&_rate, &stats);
+    return stats;
 }
 
 /**
@@ -260,6 +321,40 @@ void GPS::setDelay(uint16_t seconds)
     setFrequency(1.0 / seconds);
 }
 
+/**
+ * @brief Switches the module and the PIO UART to another baud rate.
+ *
+ * The command is sent at the current rate and the state machines are re-timed once it has left
+ * the TX pin, so no sentence is lost beyond the one being received during the switch.
+ * @param baud - The new baud rate (4800 to 115200).
+ * @return true on success, false if the UART is not active.
+ * @see 3.17. Packet Type: 251 PMTK_SET_NMEA_BAUDRATE
+ */
+bool GPS::setBaud(unsigned long baud)
+{
+    PMTKCommand command;
+    write(PMTKCommand_baudRate(&command, baud));
+    return NMEAParser_setBaud(_nmeaParser, baud) == NMEA_PARSER_SUCCESS;
+}
+
+/**
+ * @brief Detects the baud rate of the module and re-times the receiver to it.
+ *
+ * If the module was not at the configured rate, the output intervals sent by `init` were lost,
+ * so they are sent again. Blocks for up to a few seconds; call it once after `init`.
+ * @return The detected baud rate, or 0 if no valid sentence was received at any rate.
+ */
+unsigned long GPS::detectBaud()
+{
+    unsigned long configured = _nmeaParser->pico->baud;
+    unsigned long baud = NMEAParser_detectBaud(_nmeaParser);
+    if (baud != 0 && baud != configured)
+    {
+        updateIntervals();
+    }
+    return baud;
+}
+
 /**
  * @brief Puts the GPS module in standby mode.
  * @see 3.8. Packet Type: 161 PMTK_CMD_STANDBY_MODE
@@ -267,14 +362,210 @@ void GPS::setDelay(uint16_t seconds)
 void GPS::standby()
 {
     // Puts GPS into standby mode
-    write("$PMTK161,0*28");
+    write(STANDBY_COMMAND.text);
 }
 
 /**
  * @brief Wakes up the GPS module from standby mode.
+ *
+ * Any character wakes the module; a test packet is sent so that `ack(0)` confirms it is awake.
+ * The time to first fix is measured from here as a wakeup.
+ * @see 3.1. Packet Type: 000 PMTK_TEST
  */
 void GPS::wakeup()
 {
     // Wakes up GPS from standby mode
-    write("$PMTK161,0*29");
+    write(TEST_COMMAND.text);
+    GPSStartup_wakeup(&_startup);
+}
+
+/**
+ * @brief Switches the module to a periodic power saving mode, or back to normal mode.
+ *
+ * In the periodic standby and backup modes the module runs for `run` milliseconds and then
+ * sleeps for `sleep` milliseconds on its own; `idle()` sleeps the core through the sleep window.
+ * @param mode - The operation mode, e.g. PMTK_PERIODIC_STANDBY.
+ * @param run - Time the module runs and outputs fixes, in milliseconds.
+ * @param sleep - Time the module sleeps afterwards, in milliseconds.
+ * @see Packet Type: 225 PMTK_SET_PERIODIC_MODE
+ */
+void GPS::setPeriodic(PMTKPeriodicMode mode, uint32_t run, uint32_t sleep)
+{
+    GPSPower_periodic(&_power, mode, run, sleep);
+}
+
+/**
+ * @brief Puts the module in standby mode, sleeps the core for `ms` milliseconds, then wakes both.
+ * @param ms - Time to stay in standby mode in milliseconds.
+ * @see 3.8. Packet Type: 161 PMTK_CMD_STANDBY_MODE
+ */
+void GPS::suspend(uint32_t ms)
+{
+    GPSPower_suspend(&_power, ms);
+    GPSStartup_wakeup(&_startup);
+}
+
+/**
+ * @brief Sleeps the core until a sentence may be available; call it after reading everything.
+ *
+ * Returns on the first received character (IRQ receive mode), shortly before the next burst is
+ * due (DMA receive mode), or on any other interrupt.
+ */
+void GPS::idle()
+{
+    GPSPower_idle(&_power);
+}
+
+/**
+ * @brief Returns the measured awake time per fix.
+ */
+GPSPowerStats GPS::powerStats() const
+{
+    GPSPowerStats stats;
+    GPSPower_stats(&_power, &stats);
+    return stats;
+}
+
+/**
+ * @brief Aids the module after power-on with the current time and the position saved in flash.
+ * @param utc - Current UTC in seconds since 2000-01-01 (see `GPSStartup_seconds`), or 0 if unknown.
+ * @return true if PMTK740 (and PMTK741 for a recent position) was sent.
+ * @see GPSStartup_aid
+ */
+bool GPS::aid(uint32_t utc)
+{
+    return GPSStartup_aid(&_startup, utc);
+}
+
+/**
+ * @brief Saves the last fix to flash for the next start; call it before standby or power-off.
+ * @return true if the state was written (at most once every GPS_STARTUP_SAVE_S).
+ */
+bool GPS::saveStartup()
+{
+    return GPSStartup_save(&_startup);
+}
+
+/**
+ * @brief Starts uploading MTK EPO data, one acknowledged satellite record at a time.
+ * @param data - The EPO file contents; must stay readable until the upload ends.
+ * @param length - Length of `data` in bytes.
+ * @param utc - Current UTC in seconds since 2000-01-01, or 0 to use the time of the last fix.
+ * @return The number of records to upload.
+ * @see GPSStartup_epo
+ */
+uint32_t GPS::uploadEPO(const uint8_t *data, size_t length, uint32_t utc)
+{
+    return GPSStartup_epo(&_startup, data, length, utc);
+}
+
+/**
+ * @brief Returns the time to first fix of the last start and the startup counters.
+ */
+GPSStartupStats GPS::startupStats() const
+{
+    GPSStartupStats stats;
+    GPSStartup_stats(&_startup, &stats);
+    return stats;
+}
+
+/**
+ * @brief Starts evaluating every committed fix against a set of fences, outside all of them.
+ *
+ * Entries and exits are delivered to `GPSListener::onGeofence`.
+ * @param index - The fences compiled by fences.py, or nullptr to stop.
+ * @return GEOFENCE_SUCCESS, GEOFENCE_ERROR_VERSION or GEOFENCE_ERROR_FENCES.
+ */
+int GPS::setFences(const GeofenceIndex *index)
+{
+    return Geofence_load(&_geofence, index);
+}
+
+/**
+ * @brief Checks whether the receiver is in a fence.
+ * @param fence - Number of the fence in the index.
+ * @return true after its entry event, until its exit event.
+ */
+bool GPS::inFence(uint16_t fence) const
+{
+    return Geofence_inside(&_geofence, fence);
+}
+
+/**
+ * @brief Returns the counters of the geofence evaluation.
+ */
+GeofenceStats GPS::fenceStats() const
+{
+    GeofenceStats stats;
+    Geofence_stats(&_geofence, &stats);
+    return stats;
+}
+
+/**
+ * @brief Forwards a parser event to the listener it was registered for.
+ */
+void GPS::_dispatch(NMEAParser * /*parser*/, uint32_t event, void *ctx)
+{
+    Registration *registration = static_cast<Registration *>(ctx);
+    if (event == NMEA_EVENT_EPOCH)
+    {
+        registration->listener->onEpoch(*registration->gps, registration->gps->fix());
+        return;
+    }
+    if (event == NMEA_EVENT_GEOFENCE)
+    {
+        registration->listener->onGeofence(*registration->gps, *Geofence_event(&registration->gps->_geofence));
+        return;
+    }
+    for (int type = 0; type < NMEA_SENTENCE_COUNT; type++)
+    {
+        if (event == NMEA_SENTENCE_BIT(type))
+        {
+            registration->listener->onSentence(*registration->gps, static_cast<NMEASentenceType>(type));
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Registers a listener for parsed sentences and completed epochs (after `init`).
+ *
+ * The listener is called from `read` only when something changed, so the application does not
+ * have to poll the `last_time` fields. The listener must outlive its registration.
+ * @param listener - The listener to call.
+ * @param events - Sentence bits (`NMEA_SENTENCE_BIT`), `NMEA_EVENT_EPOCH` and/or `NMEA_EVENT_GEOFENCE`.
+ * @return true on success, false if `NMEA_PARSER_LISTENERS` listeners are already registered.
+ */
+bool GPS::addListener(GPSListener *listener, uint32_t events)
+{
+    for (Registration &registration : _listeners)
+    {
+        if (registration.listener == nullptr)
+        {
+            registration = {this, listener};
+            if (NMEAParser_on(_nmeaParser, events, _dispatch, &registration) != NMEA_PARSER_SUCCESS)
+            {
+                registration = {nullptr, nullptr};
+                return false;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Unregisters a listener added with `addListener`.
+ * @param listener - The listener to remove.
+ */
+void GPS::removeListener(GPSListener *listener)
+{
+    for (Registration &registration : _listeners)
+    {
+        if (registration.listener == listener)
+        {
+            NMEAParser_off(_nmeaParser, _dispatch, &registration);
+            registration = {nullptr, nullptr};
+        }
+    }
 }
@@ -2,35 +2,54 @@
 #define GPS_H
 
 #include "nmea_parser.h"
-
-// Default response for setting the NMEA output.
-#define PMTK_RESPONSE "$PMTK001,314,3*36\r\n" // 3.23. Packet Type: 314 PMTK_API_SET_NMEA_OUTPUT
+#include "geofence.h"
+#include "pmtk.h"
+#include "power.h"
+#include "rate.h"
+#include "startup.h"
+#include "track.h"
 
 // Default intervals for various NMEA sentence types.
 #define DEFAULT_INTERVALS() \
     {                       \
-        .GLL = true,        \
-        .RMC = true,        \
-        .VTG = true,        \
-        .GGA = true,        \
-        .GSA = false,       \
-        .GSV = false,       \
+        .GLL = 1,           \
+        .RMC = 1,           \
+        .VTG = 1,           \
+        .GGA = 1,           \
+        .GSA = 0,           \
+        .GSV = 0,           \
     }
 
 /**
  * @brief Represents the configuration for NMEA sentence intervals.
- *        Controls which NMEA sentences are enabled and their frequency.
+ *        Controls which NMEA sentences are enabled and their frequency:
+ *        0 disables a sentence, N (1 to 5) outputs it once every N fixes.
  */
 typedef struct
 {
-    bool GLL; // Geographic Position - Latitude longitude
-    bool RMC; // Recommended Minimum Specific GPS Sentence
-    bool VTG; // Course Over Ground and Ground Speed
-    bool GGA; // GPS Fix Data
-    bool GSA; // GPS DOPS and Active Satellites
-    bool GSV; // GPS Satellites in View
+    uint8_t GLL; // Geographic Position - Latitude longitude
+    uint8_t RMC; // Recommended Minimum Specific GPS Sentence
+    uint8_t VTG; // Course Over Ground and Ground Speed
+    uint8_t GGA; // GPS Fix Data
+    uint8_t GSA; // GPS DOPS and Active Satellites
+    uint8_t GSV; // GPS Satellites in View
 } IntervalType;
 
+class GPS;
+
+/**
+ * @brief Receives the events of a `GPS` instead of polling it (see `GPS::addListener`).
+ *        Override only the events of interest; they run from `GPS::read`.
+ */
+class GPSListener
+{
+public:
+    virtual ~GPSListener() {}
+    virtual void onSentence(GPS & /*gps*/, NMEASentenceType /*type*/) {}        /**< A sentence was parsed. */
+    virtual void onEpoch(GPS & /*gps*/, const NMEAFix & /*fix*/) {}              /**< All sentences of one UTC time were parsed. */
+    virtual void onGeofence(GPS & /*gps*/, const GeofenceEvent & /*event*/) {} /**< A fence was entered or left. */
+};
+
 /**
  * @brief GPS class that encapsulates the interaction with a GPS module.
  *        Handles communication, parsing, and NMEA sentence interval configuration.
@@ -38,10 +57,25 @@ typedef struct
 class GPS
 {
 private:
-    NMEAParser *_nmeaParser; /**< Pointer to the NMEA parser object. */
+    NMEAParser _parser;      /**< The NMEA parser, part of the object so nothing is allocated. */
+    NMEAParser *_nmeaParser; /**< Pointer to `_parser` once initialized, NULL before. */
+
+    struct Registration
+    {
+        GPS *gps;
+        GPSListener *listener;
+    };
+    Registration _listeners[NMEA_PARSER_LISTENERS]; /**< Listeners registered with the parser. */
+    PMTKAcks _acks;                                 /**< Acknowledgements of the commands sent. */
+    GPSPower _power;                                /**< Core sleep between the bursts of sentences. */
+    GPSStartup _startup;                            /**< Saved state, aiding and time to first fix. */
+    GPSRate _rate;                                  /**< High-rate profile and sentence throttling. */
+    GPSTrack _track;                                /**< Fix smoother, predicts the position between epochs. */
+    Geofence _geofence;                             /**< Zone entry and exit events. */
+
     // Helper functions
-    void _doUpdateIntervals(bool enable);
-    double _convertToDecimalDegrees(double ddmm);
+    static void _dispatch(NMEAParser *parser, uint32_t event, void *ctx);
+    static void _onParserEvent(NMEAParser *parser, uint32_t event, void *ctx);
 
 public:
     IntervalType intervals; /**< Stores the sentence intervals configuration. */
@@ -52,7 +86,9 @@ public:
     bool isAvailable();
     char *read();
     void write(const char *str);
+    PMTKAckStatus ack(uint16_t command) const;
     const GPSData &getGPSData() const;
+    NMEAFix fix() const;
     double latitude();
     double longitude();
     const long getDate();
@@ -60,13 +96,32 @@ public:
     uint8_t month();
     uint8_t day();
     float speed();
+    bool predict(uint32_t time_us, GPSTrackEstimate &estimate) const;
+    bool addListener(GPSListener *listener,
+                     uint32_t events = NMEA_SENTENCES_ALL | NMEA_EVENT_EPOCH | NMEA_EVENT_GEOFENCE);
+    void removeListener(GPSListener *listener);
 
     // https://www.dragino.com/downloads/downloads/datasheet/other_vendors/L80/Quectel_L80_GPS_Protocol_Specification_V1.3.pdf
     void updateIntervals();
     void setFrequency(double hz);
+    unsigned long setHighRate(double hz);
+    GPSRateStats rateStats() const;
     void setDelay(uint16_t seconds);
+    bool setBaud(unsigned long baud);
+    unsigned long detectBaud();
     void standby();
     void wakeup();
+    void setPeriodic(PMTKPeriodicMode mode, uint32_t run, uint32_t sleep);
+    void suspend(uint32_t ms);
+    void idle();
+    GPSPowerStats powerStats() const;
+    bool aid(uint32_t utc = 0);
+    bool saveStartup();
+    uint32_t uploadEPO(const uint8_t *data, size_t length, uint32_t utc = 0);
+    GPSStartupStats startupStats() const;
+    int setFences(const GeofenceIndex *index);
+    bool inFence(uint16_t fence) const;
+    GeofenceStats fenceStats() const;
 };
 
 #endif // GPS_H
\ No newline at end of file
@@ -0,0 +1,216 @@
+#ifndef STATIC_GPS_H
+#define STATIC_GPS_H
+
+#include "nmea_parser.h"
+#include "pmtk.h"
+
+// Sentences a StaticGPS selects, combined with '|'
+namespace Sentences
+{
+    constexpr uint32_t GGA = NMEA_SENTENCE_BIT(NMEA_SENTENCE_GGA);
+    constexpr uint32_t GLL = NMEA_SENTENCE_BIT(NMEA_SENTENCE_GLL);
+    constexpr uint32_t RMC = NMEA_SENTENCE_BIT(NMEA_SENTENCE_RMC);
+    constexpr uint32_t GSA = NMEA_SENTENCE_BIT(NMEA_SENTENCE_GSA);
+    constexpr uint32_t VTG = NMEA_SENTENCE_BIT(NMEA_SENTENCE_VTG);
+    constexpr uint32_t GSV = NMEA_SENTENCE_BIT(NMEA_SENTENCE_GSV);
+    constexpr uint32_t ACK = NMEA_SENTENCE_BIT(NMEA_SENTENCE_ACK); // Always parsed, for `ack`
+    constexpr uint32_t ALL = GGA | GLL | RMC | GSA | VTG | GSV;
+}
+
+// Baud rates of the module's NMEA port (3.17. Packet Type: 251 PMTK_SET_NMEA_BAUDRATE)
+namespace Baud
+{
+    constexpr unsigned long k4800 = 4800;
+    constexpr unsigned long k9600 = 9600;
+    constexpr unsigned long k19200 = 19200;
+    constexpr unsigned long k38400 = 38400;
+    constexpr unsigned long k57600 = 57600;
+    constexpr unsigned long k115200 = 115200;
+}
+
+/**
+ * @brief PMTK314 output rate of a sentence: once per fix if it is selected, never otherwise.
+ */
+constexpr uint8_t StaticGPS_rate(uint32_t selection, uint32_t sentence)
+{
+    return (selection & sentence) ? 1 : 0;
+}
+
+/**
+ * @brief GPS front end whose sentences, baud rate and receive FIFO are fixed at compile time.
+ *
+ * The parser and its UART settings are members (the receiver and the transmitter come from the
+ * heap, or from the static pools with `RP_PICO_STATIC_ALLOC`), and the PMTK314 and PMTK251
+ * commands are constants built by the compiler, checksums included. The parser skips every
+ * sentence that is not selected before splitting it; build the library with
+ * `NMEA_PARSER_SENTENCES` set to the same selection plus `Sentences::ACK` and the parsing code of
+ * every other type is left out as well (a selection the library cannot parse fails to compile).
+ *
+ * @tparam Selection The sentences to output and parse, e.g. `Sentences::RMC | Sentences::GGA`.
+ * @tparam Rate Baud rate of the link; `detectBaud` moves the module to it.
+ * @tparam Fifo Size of the receive FIFO in characters (power of two).
+ */
+template <uint32_t Selection, unsigned long Rate = Baud::k9600, size_t Fifo = 128>
+class StaticGPS
+{
+    static_assert(Selection != 0 && (Selection & ~Sentences::ALL) == 0, "Select output sentences with Sentences::...");
+    static_assert(((Selection | Sentences::ACK) & ~(uint32_t)NMEA_PARSER_SENTENCES) == 0,
+                  "A selected sentence is compiled out of the parser (NMEA_PARSER_SENTENCES)");
+    static_assert(Rate == Baud::k4800 || Rate == Baud::k9600 || Rate == Baud::k19200 || Rate == Baud::k38400 ||
+                      Rate == Baud::k57600 || Rate == Baud::k115200,
+                  "Unsupported baud rate");
+    static_assert(Fifo >= 2 && (Fifo & (Fifo - 1)) == 0, "The receive FIFO must be a power of two");
+    static_assert(!RP_PICO_STATIC_ALLOC || Fifo <= UART_RX_STATIC_FIFO_SIZE,
+                  "The receive FIFO is larger than the static pool (UART_RX_STATIC_FIFO_SIZE)");
+
+    UartPico _pico;     /**< UART settings of the parser. */
+    NMEAParser _parser; /**< The NMEA parser. */
+    PMTKAcks _acks;     /**< Acknowledgements of the commands sent. */
+
+    /**
+     * @brief Records the $PMTK001 replies of the module.
+     */
+    static void _receiveAck(NMEAParser *parser, uint32_t event, void *ctx)
+    {
+        (void)event;
+        const PMTK001_Data *pmtk001 = &parser->data.pmtk001;
+        PMTKAcks_receive(static_cast<PMTKAcks *>(ctx), pmtk001->command, pmtk001->flag);
+    }
+
+public:
+    // PMTK314 enabling exactly the selected sentences
+    static constexpr auto OUTPUT_COMMAND = PMTK_outputConstant(
+        {StaticGPS_rate(Selection, Sentences::GLL), StaticGPS_rate(Selection, Sentences::RMC),
+         StaticGPS_rate(Selection, Sentences::VTG), StaticGPS_rate(Selection, Sentences::GGA),
+         StaticGPS_rate(Selection, Sentences::GSA), StaticGPS_rate(Selection, Sentences::GSV)});
+
+    // PMTK251 switching the module to `Rate`
+    static constexpr auto BAUD_COMMAND = PMTK_baudConstant<Rate>();
+
+    static_assert(PMTK_valid(OUTPUT_COMMAND.text) && PMTK_valid(BAUD_COMMAND.text), "PMTK checksum");
+
+    StaticGPS() : _pico{Rate, Fifo, 1, 8}, _parser(), _acks()
+    {
+        PMTKAcks_init(&_acks);
+    }
+
+    StaticGPS(const StaticGPS &) = delete; // The parser points into the object
+    StaticGPS &operator=(const StaticGPS &) = delete;
+
+    ~StaticGPS()
+    {
+        _parser.pico = NULL; // Part of this object, not allocated by the parser
+        NMEAParser_free(&_parser);
+    }
+
+    /**
+     * @brief Starts the UART at `Rate` and sends the output selection.
+     * @param rx - The RX pin number.
+     * @param tx - The TX pin number.
+     * @return NMEA_PARSER_SUCCESS, or the error of NMEAParser_init.
+     */
+    int init(int rx, int tx)
+    {
+        _parser.pico = &_pico;
+        int result = NMEAParser_init(&_parser, rx, tx);
+        if (result != NMEA_PARSER_SUCCESS)
+        {
+            return result;
+        }
+        _parser.enabled = Selection | Sentences::ACK;
+        NMEAParser_on(&_parser, Sentences::ACK, _receiveAck, &_acks);
+        write(OUTPUT_COMMAND.text);
+        return NMEA_PARSER_SUCCESS;
+    }
+
+    /**
+     * @brief Finds the rate the module sends at and, if it is not `Rate`, moves the module and the UART to `Rate`.
+     *
+     * Blocks for up to a few seconds (see NMEAParser_detectBaud); call it once after `init`.
+     * @return The rate the module was found at, or 0 if no valid sentence was received at any rate.
+     */
+    unsigned long detectBaud()
+    {
+        unsigned long baud = NMEAParser_detectBaud(&_parser);
+        if (baud != 0 && baud != Rate)
+        {
+            write(OUTPUT_COMMAND.text); // Lost while the rates differed
+            write(BAUD_COMMAND.text);
+            NMEAParser_setBaud(&_parser, Rate);
+        }
+        return baud;
+    }
+
+    /**
+     * @brief Checks if a character is waiting to be read.
+     */
+    bool isAvailable()
+    {
+        return NMEAParser_available(&_parser) > 0;
+    }
+
+    /**
+     * @brief Reads and parses the next sentence (see NMEAParser_read).
+     * @return The sentence, or NULL if no complete sentence is available.
+     */
+    char *read()
+    {
+        return NMEAParser_read(&_parser);
+    }
+
+    /**
+     * @brief Sends a command to the module and tracks its acknowledgement.
+     * @param str - The command, e.g. one of the PMTK constants.
+     */
+    void write(const char *str)
+    {
+        PMTKAcks_sent(&_acks, str);
+        UartTx_println(_parser.uart_tx, str);
+    }
+
+    /**
+     * @brief Returns the acknowledgement state of the last command of a packet type.
+     */
+    PMTKAckStatus ack(uint16_t command) const
+    {
+        return PMTKAcks_status(&_acks, command);
+    }
+
+    /**
+     * @brief Registers a callback for parser events (see NMEAParser_on).
+     */
+    int on(uint32_t events, NMEAParserCallback callback, void *ctx)
+    {
+        return NMEAParser_on(&_parser, events, callback, ctx);
+    }
+
+    /**
+     * @brief Takes a consistent snapshot of the current fix.
+     */
+    NMEAFix fix()
+    {
+        NMEAFix fix;
+        NMEAParser_fix(&_parser, &fix);
+        return fix;
+    }
+
+    /**
+     * @brief Copies the sentence counters and parse timing (see NMEAParser_stats).
+     */
+    NMEAParserStats stats()
+    {
+        NMEAParserStats stats;
+        NMEAParser_stats(&_parser, &stats);
+        return stats;
+    }
+
+    /**
+     * @brief The underlying parser, for the C API (power management, baud rate, ...).
+     */
+    NMEAParser &parser()
+    {
+        return _parser;
+    }
+};
+
+#endif // STATIC_GPS_H
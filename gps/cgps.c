@@ -6,40 +6,31 @@
 #include <string.h>
 
 /**
- * @brief Updates the NMEA sentence output intervals for the GPS module.
+ * @brief Handles the parser events of the object: dispatches every committed epoch to the startup accelerator,
+ *        the fix smoother, the geofences and the throttling, and records the $PMTK001 replies of the module.
  *
- * @param gps - The GPS object.
- * @param enable - A boolean value indicating whether to enable or disable the intervals.
- */
-static void _doUpdateIntervals(CGPS *gps, int enable)
-{
-    char command[100];
-    snprintf(command, sizeof(command),
-             "$PMTK314,%d,%d,%d,%d,%d,%d,0,0,0,0,0,0,0,0,0,0,0,0,0*%s",
-             gps->intervals.GLL ? 1 : 0,
-             gps->intervals.RMC ? 1 : 0,
-             gps->intervals.VTG ? 1 : 0,
-             gps->intervals.GGA ? 1 : 0,
-             gps->intervals.GSA ? 1 : 0,
-             gps->intervals.GSV ? 1 : 0,
-             enable ? "28" : "29"); // Command format with checksum (enable/disable)
-    GPS_write(gps, command);
-}
-
-/**
- * @brief Converts a latitude or longitude in DDMM format to decimal degrees.
- * @param ddmm - The coordinate in DDMM format.
- * @return A double representing the coordinate in decimal degrees.
+ * One listener for both events, so the object takes a single slot of NMEA_PARSER_LISTENERS.
  */
-static double _convertToDecimalDegrees(double ddmm)
+static void _onParserEvent(NMEAParser *parser, uint32_t event, void *ctx)
 {
-    int degrees = (int)(ddmm / 100);             // Extract degrees
-    double lat_mm_mmmm = ddmm - (degrees * 100); // Extract minutes
-    int minutes = (int)lat_mm_mmmm;
-    double fractionalMinutes = lat_mm_mmmm - minutes;
-
-    double minutesDecimal = (minutes + fractionalMinutes) / 60.0; // Convert minutes to decimal
-    return degrees + minutesDecimal;                              // Return decimal degrees
+    CGPS *gps = (CGPS *)ctx;
+    if (event == NMEA_EVENT_EPOCH)
+    {
+        NMEAFix fix;
+        NMEAParser_fix(parser, &fix);
+        GPSStartup_fix(&gps->startup, &fix);
+        GPSTrack_fix(&gps->track, &fix);
+        Geofence_fix(&gps->geofence, &fix); // Fires NMEA_EVENT_GEOFENCE to the listeners
+        if (GPSRate_epoch(&gps->rate, parser->uart_rx))
+        {
+            PMTKCommand command;
+            GPS_write(gps, PMTKCommand_output(&command, gps->rate.rates)); // Shed or restored one step
+        }
+        return;
+    }
+    const PMTK001_Data *pmtk001 = &parser->data.pmtk001;
+    PMTKAcks_receive(&gps->acks, pmtk001->command, pmtk001->flag);
+    GPSStartup_ack(&gps->startup, pmtk001->command, pmtk001->flag);
 }
 
 /**
@@ -53,7 +44,14 @@ void GPS_init(CGPS *gps, IntervalType intervals, int rx, int tx)
 {
     gps->intervals = intervals;
     gps->start_year = 2000;
+    PMTKAcks_init(&gps->acks);
     NMEAParser_init(&gps->nmeaParser, rx, tx);
+    NMEAParser_on(&gps->nmeaParser, NMEA_SENTENCE_BIT(NMEA_SENTENCE_ACK) | NMEA_EVENT_EPOCH, _onParserEvent, gps);
+    GPSPower_init(&gps->power, &gps->nmeaParser, &gps->acks, 1000); // The module starts at 1 Hz
+    GPSStartup_init(&gps->startup, gps->nmeaParser.uart_tx, &gps->acks); // Loads the state saved in flash
+    memset(&gps->rate, 0, sizeof(GPSRate)); // No throttling until GPS_setHighRate
+    GPSTrack_init(&gps->track);
+    Geofence_init(&gps->geofence, &gps->nmeaParser);
     GPS_updateIntervals(gps);
 }
 
@@ -83,6 +81,10 @@ int GPS_isAvailable(CGPS *gps)
  */
 char *GPS_read(CGPS *gps)
 {
+    if (gps->rate.active)
+    {
+        GPSRate_sample(&gps->rate, gps->nmeaParser.uart_rx); // Backlog the reader has not caught up with
+    }
     return NMEAParser_read(&gps->nmeaParser);
 }
 
@@ -93,9 +95,21 @@ char *GPS_read(CGPS *gps)
  */
 void GPS_write(CGPS *gps, const char *str)
 {
+    PMTKAcks_sent(&gps->acks, str);
     UartTx_println(gps->nmeaParser.uart_tx, str);
 }
 
+/**
+ * @brief Returns the acknowledgement state of the last command of a packet type.
+ * @param gps - The GPS object.
+ * @param command - The packet type, e.g. PMTK_SET_NMEA_OUTPUT.
+ * @return PMTK_ACK_PENDING until the module replied, then its reply (PMTK_ACK_SUCCESS, ...).
+ */
+PMTKAckStatus GPS_ack(CGPS *gps, uint16_t command)
+{
+    return PMTKAcks_status(&gps->acks, command);
+}
+
 /**
  * @brief Retrieves the current GPS data.
  * @param gps - The GPS object.
@@ -106,54 +120,63 @@ const GPSData *GPS_getGPSData(CGPS *gps)
     return &gps->nmeaParser.data;
 }
 
+/**
+ * @brief Takes a consistent snapshot of the current fix.
+ * @param gps - The GPS object.
+ * @param fix - Receives the latest fix.
+ */
+void GPS_fix(CGPS *gps, NMEAFix *fix)
+{
+    NMEAParser_fix(&gps->nmeaParser, fix);
+}
+
+/**
+ * @brief Registers a callback for parser events (see NMEAParser_on).
+ * @param gps - The GPS object.
+ * @param events - NMEA_SENTENCE_BIT() of the sentence types, NMEA_EVENT_EPOCH and/or NMEA_EVENT_GEOFENCE.
+ * @param callback - Called from GPS_read for every matching event.
+ * @param ctx - Passed back to the callback.
+ * @return NMEA_PARSER_SUCCESS, or NMEA_PARSER_ERROR_LISTENERS_FULL.
+ */
+int GPS_on(CGPS *gps, uint32_t events, NMEAParserCallback callback, void *ctx)
+{
+    return NMEAParser_on(&gps->nmeaParser, events, callback, ctx);
+}
+
 /**
  * @brief Gets the latitude in decimal degrees.
  * @param gps - The GPS object.
- * @return The latitude value in decimal degrees.
+ * @return The latitude value in decimal degrees (negative south).
  */
 double GPS_latitude(CGPS *gps)
 {
-    GPSData data = *GPS_getGPSData(gps);
-    if (data.latitude > 0 && data.latitude_dir != NULL)
-    {
-        double decimalDegrees = _convertToDecimalDegrees(data.latitude);
-        if (strcmp(data.latitude_dir, "S") == 0)
-        {
-            decimalDegrees = -decimalDegrees;
-        }
-        return decimalDegrees;
-    }
-    return 0;
+    NMEAFix fix;
+    GPS_fix(gps, &fix);
+    return (double)fix.latitude / NMEA_DEGREES_SCALE;
 }
 
 /**
  * @brief Gets the longitude in decimal degrees.
  * @param gps - The GPS object.
- * @return The longitude value in decimal degrees.
+ * @return The longitude value in decimal degrees (negative west).
  */
 double GPS_longitude(CGPS *gps)
 {
-    GPSData data = *GPS_getGPSData(gps);
-    if (data.longitude > 0 && data.longitude_dir != NULL)
-    {
-        double decimalDegrees = _convertToDecimalDegrees(data.longitude);
-        if (strcmp(data.longitude_dir, "W") == 0)
-        {
-            decimalDegrees = -decimalDegrees;
-        }
-        return decimalDegrees;
-    }
-    return 0;
+    NMEAFix fix;
+    GPS_fix(gps, &fix);
+    return (double)fix.longitude / NMEA_DEGREES_SCALE;
 }
 
 /**
- * @brief Retrieves the current date in YYYYMMDD format.
+ * @brief Retrieves the current date in DDMMYY format.
  * @param gps - The GPS object.
  * @return The current date as a long integer.
  */
 long GPS_getDate(CGPS *gps)
 {
-    return atol(GPS_getGPSData(gps)->gprmc.date);
+    NMEAFix fix;
+    GPS_fix(gps, &fix);
+    return fix.date;
 }
 
 /**
@@ -193,7 +216,21 @@ unsigned char GPS_day(CGPS *gps)
  */
 float GPS_speed(CGPS *gps)
 {
-    return GPS_getGPSData(gps)->speed;
+    NMEAFix fix;
+    GPS_fix(gps, &fix);
+    return (float)fix.speed / NMEA_SPEED_SCALE;
+}
+
+/**
+ * @brief Estimates the position and velocity at any time between epochs (see GPSTrack_predict).
+ * @param gps - The GPS object.
+ * @param time_us - The time of the estimate in microseconds since boot, e.g. time_us_32().
+ * @param estimate - Receives the estimate.
+ * @return false before the first valid fix, or more than GPS_TRACK_HORIZON_MS after the last one.
+ */
+bool GPS_predict(CGPS *gps, uint32_t time_us, GPSTrackEstimate *estimate)
+{
+    return GPSTrack_predict(&gps->track, time_us, estimate);
 }
 
 /**
@@ -202,29 +239,75 @@ float GPS_speed(CGPS *gps)
  */
 void GPS_updateIntervals(CGPS *gps)
 {
-    _doUpdateIntervals(gps, 0); // Disable intervals first
-    _doUpdateIntervals(gps, 1); // Then enable them
+    // Sends the output rate of every sentence at once; the module replies with PMTK_RESPONSE
+    const uint8_t rates[PMTK_OUTPUT_COUNT] = {gps->intervals.GLL, gps->intervals.RMC, gps->intervals.VTG,
+                                              gps->intervals.GGA, gps->intervals.GSA, gps->intervals.GSV};
+    PMTKCommand command;
+    if (gps->rate.active)
+    {
+        GPSRate_request(&gps->rate, rates); // The high-rate profile sheds what its link budget cannot carry
+        GPS_write(gps, PMTKCommand_output(&command, gps->rate.rates));
+        return;
+    }
+    GPS_write(gps, PMTKCommand_output(&command, rates));
 }
 
 /**
  * @brief Sets the GPS position update frequency.
  * @param gps - The GPS object.
- * @param hz - The desired frequency in Hertz (Hz).
+ * @param hz - The desired frequency in Hertz (Hz), clamped to 0.1..10; ignored unless positive.
  */
 void GPS_setFrequency(CGPS *gps, double hz)
 {
-    char nmea[50], checksum_str[3], command[60];
-    int interval = (int)(1000 / hz); // Convert Hz to interval in milliseconds
-    snprintf(nmea, sizeof(nmea), "PMTK220,%d", interval);
+    if (!(hz > 0))
+    {
+        return;
+    }
+    double ms = 1000 / hz; // Convert Hz to interval in milliseconds, within what the module accepts
+    uint16_t interval = ms < PMTK_MIN_FIX_INTERVAL   ? PMTK_MIN_FIX_INTERVAL
+                        : ms > PMTK_MAX_FIX_INTERVAL ? PMTK_MAX_FIX_INTERVAL
+                                                     : (uint16_t)ms;
+    PMTKCommand command;
+    GPS_write(gps, PMTKCommand_fixInterval(&command, interval));
+    GPSPower_setInterval(&gps->power, interval);
+    gps->rate.interval = interval;
+}
 
-    unsigned char checksum = 0;
-    for (int i = 0; nmea[i] != '\0'; i++)
+/**
+ * @brief Switches to a high fix rate with sentence rates and a baud rate that fit the link.
+ *
+ * Works out the bytes per epoch of `intervals`, sheds GSV, GLL, GSA and VTG (in that order)
+ * if even 115200 baud cannot carry them, and sends the sentence rates (PMTK314), the slowest
+ * baud rate that fits (PMTK251) and the fix interval (PMTK220), in that order. From then on,
+ * every epoch checks the receive ring and its overflow counters, and sheds or restores one step
+ * before characters are lost (see `GPSRate`).
+ * @param gps - The GPS object.
+ * @param hz - The fix rate in Hertz (up to 10).
+ * @return The baud rate picked.
+ */
+unsigned long GPS_setHighRate(CGPS *gps, double hz)
+{
+    const uint8_t rates[PMTK_OUTPUT_COUNT] = {gps->intervals.GLL, gps->intervals.RMC, gps->intervals.VTG,
+                                              gps->intervals.GGA, gps->intervals.GSA, gps->intervals.GSV};
+    uint32_t baud = GPSRate_plan(&gps->rate, gps->nmeaParser.uart_rx, (uint16_t)(1000 / hz), rates, GPS_RATE_MAX_BAUD);
+    PMTKCommand command;
+    GPS_write(gps, PMTKCommand_output(&command, gps->rate.rates));
+    if (baud != gps->nmeaParser.pico->baud)
     {
-        checksum ^= nmea[i];
+        GPS_setBaud(gps, baud);
     }
-    snprintf(checksum_str, sizeof(checksum_str), "%02X", checksum);
-    snprintf(command, sizeof(command), "$%s*%s", nmea, checksum_str);
-    GPS_write(gps, command);
+    GPS_setFrequency(gps, hz);
+    return baud;
+}
+
+/**
+ * @brief Copies the counters of the sentence throttling.
+ * @param gps - The GPS object.
+ * @param stats - Receives the counters.
+ */
+void GPS_rateStats(CGPS *gps, GPSRateStats *stats)
+{
+    GPSRate_stats(&gps->rate, stats);
 }
 
 /**
@@ -237,20 +320,194 @@ void GPS_setDelay(CGPS *gps, unsigned short seconds)
     GPS_setFrequency(gps, 1.0 / seconds);
 }
 
+/**
+ * @brief Switches the module and the PIO UART to another baud rate.
+ *
+ * The command is sent at the current rate and the state machines are re-timed once it has left
+ * the TX pin, so no sentence is lost beyond the one being received during the switch.
+ * @param gps - The GPS object.
+ * @param baud - The new baud rate (4800 to 115200).
+ * @return NMEA_PARSER_SUCCESS, or NMEA_PARSER_ERROR_UART_INACTIVE.
+ * @see 3.17. Packet Type: 251 PMTK_SET_NMEA_BAUDRATE
+ */
+int GPS_setBaud(CGPS *gps, unsigned long baud)
+{
+    PMTKCommand command;
+    GPS_write(gps, PMTKCommand_baudRate(&command, baud));
+    return NMEAParser_setBaud(&gps->nmeaParser, baud);
+}
+
+/**
+ * @brief Detects the baud rate of the module and re-times the receiver to it.
+ *
+ * If the module was not at the configured rate, the output intervals sent by `GPS_init` were
+ * lost, so they are sent again. Blocks for up to a few seconds; call it once after `GPS_init`.
+ * @param gps - The GPS object.
+ * @return The detected baud rate, or 0 if no valid sentence was received at any rate.
+ */
+unsigned long GPS_detectBaud(CGPS *gps)
+{
+    unsigned long configured = gps->nmeaParser.pico->baud;
+    unsigned long baud = NMEAParser_detectBaud(&gps->nmeaParser);
+    if (baud != 0 && baud != configured)
+    {
+        GPS_updateIntervals(gps);
+    }
+    return baud;
+}
+
 /**
  * @brief Puts the GPS module in standby mode.
  * @param gps - The GPS object.
  */
 void GPS_standby(CGPS *gps)
 {
-    GPS_write(gps, "$PMTK161,0*28");
+    GPS_write(gps, PMTK_STANDBY);
 }
 
 /**
  * @brief Wakes up the GPS module from standby mode.
+ *
+ * Any character wakes the module; a test packet is sent so that `GPS_ack(gps, 0)` confirms it is awake.
+ * The time to first fix is measured from here as a wakeup.
  * @param gps - The GPS object.
  */
 void GPS_wakeup(CGPS *gps)
 {
-    GPS_write(gps, "$PMTK161,0*29");
+    GPS_write(gps, PMTK_TEST);
+    GPSStartup_wakeup(&gps->startup);
+}
+
+/**
+ * @brief Switches the module to a periodic power saving mode, or back to normal mode.
+ * @param gps - The GPS object.
+ * @param mode - The operation mode, e.g. PMTK_PERIODIC_STANDBY.
+ * @param run - Time the module runs and outputs fixes, in milliseconds.
+ * @param sleep - Time the module sleeps afterwards, in milliseconds.
+ * @see Packet Type: 225 PMTK_SET_PERIODIC_MODE
+ */
+void GPS_periodic(CGPS *gps, PMTKPeriodicMode mode, uint32_t run, uint32_t sleep)
+{
+    GPSPower_periodic(&gps->power, mode, run, sleep);
+}
+
+/**
+ * @brief Puts the module in standby mode, sleeps the core for `ms` milliseconds, then wakes both.
+ * @param gps - The GPS object.
+ * @param ms - Time to stay in standby mode in milliseconds.
+ */
+void GPS_suspend(CGPS *gps, uint32_t ms)
+{
+    GPSPower_suspend(&gps->power, ms);
+    GPSStartup_wakeup(&gps->startup);
+}
+
+/**
+ * @brief Sleeps the core until a sentence may be available; call it after reading everything.
+ * @param gps - The GPS object.
+ */
+void GPS_idle(CGPS *gps)
+{
+    GPSPower_idle(&gps->power);
+}
+
+/**
+ * @brief Copies the measured awake time per fix.
+ * @param gps - The GPS object.
+ * @param stats - Receives the statistics.
+ */
+void GPS_powerStats(CGPS *gps, GPSPowerStats *stats)
+{
+    GPSPower_stats(&gps->power, stats);
+}
+
+/**
+ * @brief Aids the module after power-on with the current time and the position saved in flash.
+ * @param gps - The GPS object.
+ * @param utc - Current UTC in seconds since 2000-01-01 (see `GPSStartup_seconds`), or 0 if unknown.
+ * @return true if PMTK740 (and PMTK741 for a recent position) was sent.
+ * @see GPSStartup_aid
+ */
+bool GPS_aid(CGPS *gps, uint32_t utc)
+{
+    return GPSStartup_aid(&gps->startup, utc);
+}
+
+/**
+ * @brief Saves the last fix to flash for the next start; call it before standby or power-off.
+ * @param gps - The GPS object.
+ * @return true if the state was written (at most once every GPS_STARTUP_SAVE_S).
+ */
+bool GPS_saveStartup(CGPS *gps)
+{
+    return GPSStartup_save(&gps->startup);
+}
+
+/**
+ * @brief Starts uploading MTK EPO data, one acknowledged satellite record at a time.
+ * @param gps - The GPS object.
+ * @param data - The EPO file contents; must stay readable until `GPSStartup_uploading` is false.
+ * @param length - Length of `data` in bytes.
+ * @param utc - Current UTC in seconds since 2000-01-01, or 0 to use the time of the last fix.
+ * @return The number of records to upload.
+ * @see GPSStartup_epo
+ */
+uint32_t GPS_uploadEPO(CGPS *gps, const uint8_t *data, size_t length, uint32_t utc)
+{
+    return GPSStartup_epo(&gps->startup, data, length, utc);
+}
+
+/**
+ * @brief Copies the time to first fix of the last start and the startup counters.
+ * @param gps - The GPS object.
+ * @param stats - Receives the statistics.
+ */
+void GPS_startupStats(CGPS *gps, GPSStartupStats *stats)
+{
+    GPSStartup_stats(&gps->startup, stats);
+}
+
+/**
+ * @brief Starts evaluating every committed fix against a set of fences, outside all of them.
+ *
+ * Register a listener for NMEA_EVENT_GEOFENCE with GPS_on and read the transition with
+ * GPS_fenceEvent from it.
+ * @param gps - The GPS object.
+ * @param index - The fences compiled by fences.py, or NULL to stop.
+ * @return GEOFENCE_SUCCESS, GEOFENCE_ERROR_VERSION or GEOFENCE_ERROR_FENCES.
+ */
+int GPS_setFences(CGPS *gps, const GeofenceIndex *index)
+{
+    return Geofence_load(&gps->geofence, index);
+}
+
+/**
+ * @brief Returns the fence entered or left, from an NMEA_EVENT_GEOFENCE listener.
+ * @param gps - The GPS object.
+ * @return The transition being notified.
+ */
+const GeofenceEvent *GPS_fenceEvent(CGPS *gps)
+{
+    return Geofence_event(&gps->geofence);
+}
+
+/**
+ * @brief Checks whether the receiver is in a fence.
+ * @param gps - The GPS object.
+ * @param fence - Number of the fence in the index.
+ * @return true after its GEOFENCE_ENTER event, until its GEOFENCE_EXIT event.
+ */
+bool GPS_inFence(CGPS *gps, uint16_t fence)
+{
+    return Geofence_inside(&gps->geofence, fence);
+}
+
+/**
+ * @brief Copies the counters of the geofence evaluation.
+ * @param gps - The GPS object.
+ * @param stats - Receives the counters.
+ */
+void GPS_fenceStats(CGPS *gps, GeofenceStats *stats)
+{
+    Geofence_stats(&gps->geofence, stats);
 }
@@ -2,15 +2,18 @@
 #define CGPS_H
 
 #include "nmea_parser.h"
+#include "geofence.h"
+#include "pmtk.h"
+#include "power.h"
+#include "rate.h"
+#include "startup.h"
+#include "track.h"
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
-// Default response for setting the NMEA output.
-#define PMTK_RESPONSE "$PMTK001,314,3*36\r\n" // 3.23. Packet Type: 314 PMTK_API_SET_NMEA_OUTPUT
-
 // Default intervals for various NMEA sentence types.
 #define DEFAULT_INTERVALS() \
     {                       \
@@ -24,7 +27,8 @@ extern "C"
 
     /**
      * @brief Represents the configuration for NMEA sentence intervals.
-     *        Controls which NMEA sentences are enabled and their frequency.
+     *        Controls which NMEA sentences are enabled and their frequency:
+     *        0 disables a sentence, N (1 to 5) outputs it once every N fixes.
      */
     typedef struct
     {
@@ -45,6 +49,12 @@ extern "C"
         NMEAParser nmeaParser;   /**< Pointer to the NMEA parser object. */
         IntervalType intervals;  /**< Stores the sentence intervals configuration. */
         unsigned int start_year; /**< The base year (2000) for date calculation. */
+        PMTKAcks acks;           /**< Acknowledgements of the commands sent. */
+        GPSPower power;          /**< Core sleep between the bursts of sentences. */
+        GPSStartup startup;      /**< Saved state, aiding and time to first fix. */
+        GPSRate rate;            /**< High-rate profile and sentence throttling (inactive until GPS_setHighRate). */
+        GPSTrack track;          /**< Fix smoother, predicts the position between epochs. */
+        Geofence geofence;       /**< Zone entry and exit events (no fences until GPS_setFences). */
     } CGPS;
 
     /**
@@ -55,7 +65,10 @@ extern "C"
     int GPS_isAvailable(CGPS *gps);
     char *GPS_read(CGPS *gps);
     void GPS_write(CGPS *gps, const char *str);
+    PMTKAckStatus GPS_ack(CGPS *gps, uint16_t command);
     const GPSData *GPS_getGPSData(CGPS *gps);
+    void GPS_fix(CGPS *gps, NMEAFix *fix);
+    int GPS_on(CGPS *gps, uint32_t events, NMEAParserCallback callback, void *ctx);
     double GPS_latitude(CGPS *gps);
     double GPS_longitude(CGPS *gps);
     long GPS_getDate(CGPS *gps);
@@ -63,12 +76,29 @@ extern "C"
     unsigned char GPS_month(CGPS *gps);
     unsigned char GPS_day(CGPS *gps);
     float GPS_speed(CGPS *gps);
+    bool GPS_predict(CGPS *gps, uint32_t time_us, GPSTrackEstimate *estimate);
 
     void GPS_updateIntervals(CGPS *gps);
     void GPS_setFrequency(CGPS *gps, double hz);
+    unsigned long GPS_setHighRate(CGPS *gps, double hz);
+    void GPS_rateStats(CGPS *gps, GPSRateStats *stats);
     void GPS_setDelay(CGPS *gps, unsigned short seconds);
+    int GPS_setBaud(CGPS *gps, unsigned long baud);
+    unsigned long GPS_detectBaud(CGPS *gps);
     void GPS_standby(CGPS *gps);
     void GPS_wakeup(CGPS *gps);
+    void GPS_periodic(CGPS *gps, PMTKPeriodicMode mode, uint32_t run, uint32_t sleep);
+    void GPS_suspend(CGPS *gps, uint32_t ms);
+    void GPS_idle(CGPS *gps);
+    void GPS_powerStats(CGPS *gps, GPSPowerStats *stats);
+    bool GPS_aid(CGPS *gps, uint32_t utc);
+    bool GPS_saveStartup(CGPS *gps);
+    uint32_t GPS_uploadEPO(CGPS *gps, const uint8_t *data, size_t length, uint32_t utc);
+    void GPS_startupStats(CGPS *gps, GPSStartupStats *stats);
+    int GPS_setFences(CGPS *gps, const GeofenceIndex *index);
+    const GeofenceEvent *GPS_fenceEvent(CGPS *gps);
+    bool GPS_inFence(CGPS *gps, uint16_t fence);
+    void GPS_fenceStats(CGPS *gps, GeofenceStats *stats);
 
 #ifdef __cplusplus
 }
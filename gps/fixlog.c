@@ -0,0 +1,590 @@
+#include "fixlog.h"
+#include "flash_record.h"
+#include <string.h>
+#include <pico/time.h>
+
+#define FIXLOG_PAGES (FIXLOG_SECTORS * FIXLOG_PAGES_PER_SECTOR)
+#define FIXLOG_DAY_MS 86400000u     // Milliseconds per day, the modulus of the time deltas
+#define FIXLOG_SAFE_TIMEOUT_MS 10   // Longest wait for the other core to pause
+#define FIXLOG_MAX_SATELLITES 15    // Satellites field of the tag
+
+// Bits of the tag byte that starts every record
+#define FIXLOG_TAG_SATELLITES 0x0F // SVs in use, at most 15
+#define FIXLOG_TAG_VALID 0x10      // Status of the fix
+#define FIXLOG_TAG_KEY 0x20        // Absolute values follow instead of deltas
+#define FIXLOG_TAG_DATE 0x40       // A delta record with a new date
+
+/**
+ * @brief Returns the contents of the flash at an offset of the ring, through the XIP window.
+ */
+static const uint8_t *_flash(uint32_t page)
+{
+    return FlashRecord_at(FIXLOG_FLASH_OFFSET + page * FLASH_PAGE_SIZE);
+}
+
+/**
+ * @brief Checks the sector header of a ring sector.
+ *
+ * @return True if the sector holds log pages; `sequence` then receives its sequence number.
+ */
+static bool _sector(uint32_t sector, uint32_t *sequence)
+{
+    const uint8_t *header = _flash(sector * FIXLOG_PAGES_PER_SECTOR);
+    if (FlashRecord_get32(header) != FIXLOG_MAGIC || header[8] != FIXLOG_VERSION ||
+        FlashRecord_get16(header + 10) != FlashRecord_crc16(header, FIXLOG_SECTOR_HEADER - 2))
+    {
+        return false;
+    }
+    *sequence = FlashRecord_get32(header + 4);
+    return true;
+}
+
+/**
+ * @brief Returns the offset of the page header in a ring page (after the sector header in the first page).
+ */
+static uint16_t _pageHeader(uint32_t page)
+{
+    return page % FIXLOG_PAGES_PER_SECTOR == 0 ? FIXLOG_SECTOR_HEADER : 0;
+}
+
+/**
+ * @brief Erases the sector of a ring page, or programs the page.
+ *
+ * @return True on success.
+ */
+static bool _write(FixLog *log, const FixLogPage *page, bool erase)
+{
+    uint32_t offset = FIXLOG_FLASH_OFFSET + page->page * FLASH_PAGE_SIZE;
+    if (!FlashRecord_write(offset, erase ? NULL : page->data, FIXLOG_SAFE_TIMEOUT_MS))
+    {
+        log->stats.failures++;
+        return false;
+    }
+    if (erase)
+    {
+        log->stats.erases++;
+    }
+    else
+    {
+        log->stats.pages++;
+    }
+    return true;
+}
+
+/**
+ * @brief Assigns the page being filled the next page of the ring and starts it.
+ */
+static void _startPage(FixLog *log)
+{
+    FixLogPage *page = &log->pages[log->fill];
+    memset(page->data, 0xFF, sizeof(page->data)); // Whatever is not used stays erased
+    page->page = log->next;
+    log->next = (log->next + 1) % FIXLOG_PAGES;
+
+    if (page->page % FIXLOG_PAGES_PER_SECTOR == 0)
+    {
+        log->sequence++;
+        FlashRecord_put32(page->data, FIXLOG_MAGIC);
+        FlashRecord_put32(page->data + 4, log->sequence);
+        page->data[8] = FIXLOG_VERSION;
+        page->data[9] = 0xFF; // Reserved
+        FlashRecord_put16(page->data + 10, FlashRecord_crc16(page->data, FIXLOG_SECTOR_HEADER - 2));
+    }
+    page->payload = _pageHeader(page->page) + FIXLOG_PAGE_HEADER;
+    page->length = page->payload;
+    log->keyed = false; // The first record of a page holds absolute values
+}
+
+/**
+ * @brief Completes the page being filled, queues it for flash and starts the other one.
+ */
+static void _queuePage(FixLog *log)
+{
+    FixLogPage *page = &log->pages[log->fill];
+    uint8_t *header = page->data + page->payload - FIXLOG_PAGE_HEADER;
+    FlashRecord_put16(header, page->length - page->payload);
+    FlashRecord_put16(header + 2, FlashRecord_crc16(page->data + page->payload, page->length - page->payload));
+    page->since = time_us_32() / 1000;
+
+    log->queued = true;
+    log->erased = false;
+    log->fill ^= 1;
+    _startPage(log);
+}
+
+/**
+ * @brief Writes the waiting page, erasing its sector first if it is the first page of the sector.
+ *
+ * @param single If true, runs at most one flash operation (the erase or the program).
+ */
+static void _writeQueued(FixLog *log, bool single)
+{
+    const FixLogPage *page = &log->pages[log->fill ^ 1];
+    if (page->page % FIXLOG_PAGES_PER_SECTOR == 0 && !log->erased)
+    {
+        log->erased = _write(log, page, true);
+        if (single || !log->erased)
+        {
+            return;
+        }
+    }
+    if (_write(log, page, false))
+    {
+        log->queued = false;
+    }
+}
+
+static uint8_t *_putVarint(uint8_t *p, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        *p++ = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+static uint8_t *_putSigned(uint8_t *p, int32_t value)
+{
+    return _putVarint(p, (uint32_t)value << 1 ^ (uint32_t)(value >> 31)); // Zigzag: small magnitudes, short varints
+}
+
+/**
+ * @brief Decodes a varint.
+ *
+ * @return The position after it, or NULL if it runs past `end` or is longer than 5 bytes.
+ */
+static const uint8_t *_getVarint(const uint8_t *p, const uint8_t *end, uint32_t *value)
+{
+    *value = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7)
+    {
+        uint8_t byte = *p++;
+        *value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+static const uint8_t *_getSigned(const uint8_t *p, const uint8_t *end, int32_t *value)
+{
+    uint32_t zigzag = 0;
+    p = p ? _getVarint(p, end, &zigzag) : NULL;
+    *value = (int32_t)(zigzag >> 1 ^ -(zigzag & 1));
+    return p;
+}
+
+/**
+ * @brief Converts an hhmmss * 1000 + milliseconds time to milliseconds since midnight, and back.
+ */
+static uint32_t _dayMs(uint32_t utc_time)
+{
+    return utc_time / 10000000 * 3600000 + utc_time / 100000 % 100 * 60000 + utc_time % 100000;
+}
+
+static uint32_t _utcTime(uint32_t day_ms)
+{
+    return day_ms / 3600000 * 10000000 + day_ms / 60000 % 60 * 100000 + day_ms % 60000;
+}
+
+/**
+ * @brief Encodes a fix as a key record, or as a delta record against `last`.
+ *
+ * @return The length of the record (at most FIXLOG_RECORD_MAX).
+ */
+static size_t _encode(uint8_t *record, const FixLogEntry *entry, const FixLogEntry *last)
+{
+    uint8_t *p = record + 1;
+    uint8_t tag = entry->satellites | (entry->valid ? FIXLOG_TAG_VALID : 0);
+    if (last == NULL)
+    {
+        tag |= FIXLOG_TAG_KEY;
+        p = _putVarint(p, entry->date);
+        p = _putVarint(p, _dayMs(entry->utc_time));
+        p = _putSigned(p, entry->latitude);
+        p = _putSigned(p, entry->longitude);
+        p = _putSigned(p, entry->altitude);
+    }
+    else
+    {
+        if (entry->date != last->date)
+        {
+            tag |= FIXLOG_TAG_DATE;
+            p = _putVarint(p, entry->date);
+        }
+        p = _putVarint(p, (_dayMs(entry->utc_time) + FIXLOG_DAY_MS - _dayMs(last->utc_time)) % FIXLOG_DAY_MS);
+        // Differences wrap like the values they are added back to, so any pair of longitudes fits
+        p = _putSigned(p, (int32_t)((uint32_t)entry->latitude - (uint32_t)last->latitude));
+        p = _putSigned(p, (int32_t)((uint32_t)entry->longitude - (uint32_t)last->longitude));
+        p = _putSigned(p, (int32_t)((uint32_t)entry->altitude - (uint32_t)last->altitude));
+    }
+    record[0] = tag;
+    return p - record;
+}
+
+/**
+ * @brief Decodes a record against the previous one, in place.
+ *
+ * @param entry Holds the previous record (unless the record is a key) and receives the record.
+ * @return The position after the record, or NULL if it is malformed or runs past `end`.
+ */
+static const uint8_t *_decode(const uint8_t *p, const uint8_t *end, FixLogEntry *entry, bool keyed)
+{
+    uint8_t tag = *p++;
+    uint32_t day_ms;
+    int32_t latitude, longitude, altitude;
+    if (tag & FIXLOG_TAG_KEY)
+    {
+        p = _getVarint(p, end, &entry->date);
+        p = p ? _getVarint(p, end, &day_ms) : NULL;
+        p = _getSigned(p, end, &latitude);
+        p = _getSigned(p, end, &longitude);
+        p = _getSigned(p, end, &altitude);
+    }
+    else if (keyed)
+    {
+        uint32_t dt;
+        if (tag & FIXLOG_TAG_DATE)
+        {
+            p = _getVarint(p, end, &entry->date);
+        }
+        p = p ? _getVarint(p, end, &dt) : NULL;
+        p = _getSigned(p, end, &latitude);
+        p = _getSigned(p, end, &longitude);
+        p = _getSigned(p, end, &altitude);
+        day_ms = (_dayMs(entry->utc_time) + dt) % FIXLOG_DAY_MS;
+        latitude = (int32_t)((uint32_t)entry->latitude + (uint32_t)latitude);
+        longitude = (int32_t)((uint32_t)entry->longitude + (uint32_t)longitude);
+        altitude = (int32_t)((uint32_t)entry->altitude + (uint32_t)altitude);
+    }
+    else
+    {
+        return NULL; // A page must start with a key record
+    }
+    if (p == NULL || (tag & 0x80) || day_ms >= FIXLOG_DAY_MS)
+    {
+        return NULL;
+    }
+    entry->utc_time = _utcTime(day_ms);
+    entry->latitude = latitude;
+    entry->longitude = longitude;
+    entry->altitude = altitude;
+    entry->satellites = tag & FIXLOG_TAG_SATELLITES;
+    entry->valid = (tag & FIXLOG_TAG_VALID) != 0;
+    return p;
+}
+
+/**
+ * @brief Logs every committed fix of the parser.
+ */
+static void _onEpoch(NMEAParser *parser, uint32_t event, void *ctx)
+{
+    (void)event; // Registered for NMEA_EVENT_EPOCH only
+    NMEAFix fix;
+    NMEAParser_fix(parser, &fix); // Still the fix of the epoch that just ended
+    FixLog_append((FixLog *)ctx, &fix);
+}
+
+/**
+ * @brief Finds the newest sector of the ring and resumes logging after its last page.
+ *
+ * @param log Pointer to the FixLog structure.
+ * @param parser Parser whose committed fixes are logged, or NULL to append them with `FixLog_append`.
+ *
+ * @return Returns `NMEA_PARSER_SUCCESS` (0), or `NMEA_PARSER_ERROR_LISTENERS_FULL` (2).
+ */
+int FixLog_init(FixLog *log, NMEAParser *parser)
+{
+    memset(log, 0, sizeof(FixLog));
+    log->parser = parser;
+
+    bool found = false;
+    uint32_t newest = 0;
+    for (uint32_t sector = 0; sector < FIXLOG_SECTORS; sector++)
+    {
+        uint32_t sequence;
+        if (_sector(sector, &sequence) && (!found || (int32_t)(sequence - log->sequence) > 0))
+        {
+            found = true;
+            newest = sector;
+            log->sequence = sequence;
+        }
+    }
+    if (found)
+    {
+        // Resume at the first page never programmed; a sector whose first page was torn is left as it is
+        log->next = ((newest + 1) % FIXLOG_SECTORS) * FIXLOG_PAGES_PER_SECTOR;
+        for (uint32_t page = newest * FIXLOG_PAGES_PER_SECTOR + 1; page < (newest + 1) * FIXLOG_PAGES_PER_SECTOR; page++)
+        {
+            if (FlashRecord_get16(_flash(page)) == 0xFFFF &&
+                FlashRecord_get16(_flash(page - 1) + _pageHeader(page - 1)) != 0xFFFF)
+            {
+                log->next = page;
+                break;
+            }
+        }
+    }
+    _startPage(log);
+
+    log->committed = time_us_32() / 1000;
+    return parser != NULL ? NMEAParser_on(parser, NMEA_EVENT_EPOCH, _onEpoch, log) : NMEA_PARSER_SUCCESS;
+}
+
+/**
+ * @brief Stops logging the parser's fixes; fixes not yet in flash are lost (see `FixLog_flush`).
+ *
+ * @param log Pointer to the FixLog structure.
+ */
+void FixLog_free(FixLog *log)
+{
+    if (log->parser != NULL)
+    {
+        NMEAParser_off(log->parser, _onEpoch, log);
+    }
+}
+
+/**
+ * @brief Appends a fix to the page being filled. Never touches the flash.
+ *
+ * Call it right after the fix was committed (the parser's epoch listener does): the time of the
+ * call opens the quiet window of `FixLog_poll`.
+ *
+ * @param log Pointer to the FixLog structure.
+ * @param fix The fix.
+ *
+ * @return True if the fix was logged; false if it has no position or both page buffers are full.
+ */
+bool FixLog_append(FixLog *log, const NMEAFix *fix)
+{
+    log->committed = time_us_32() / 1000;
+    if (!fix->valid && fix->quality == 0)
+    {
+        log->stats.skipped++;
+        return false;
+    }
+
+    FixLogEntry entry = {
+        .date = fix->date,
+        .utc_time = fix->utc_time,
+        .latitude = fix->latitude,
+        .longitude = fix->longitude,
+        .altitude = fix->altitude,
+        .satellites = fix->satellites < FIXLOG_MAX_SATELLITES ? fix->satellites : FIXLOG_MAX_SATELLITES,
+        .valid = fix->valid,
+    };
+    uint8_t record[FIXLOG_RECORD_MAX];
+    size_t length = _encode(record, &entry, log->keyed ? &log->last : NULL);
+
+    FixLogPage *page = &log->pages[log->fill];
+    if (page->length + length > FLASH_PAGE_SIZE)
+    {
+        if (log->queued)
+        {
+            log->stats.dropped++; // The flash has fallen a whole page behind
+            return false;
+        }
+        _queuePage(log);
+        page = &log->pages[log->fill];
+        length = _encode(record, &entry, NULL);
+    }
+
+    memcpy(page->data + page->length, record, length);
+    page->length += length;
+    log->last = entry;
+    log->keyed = true;
+    log->stats.fixes++;
+    log->stats.bytes += length;
+    return true;
+}
+
+/**
+ * @brief Writes the waiting page to flash when the link is quiet; call it from the main loop.
+ *
+ * Runs at most one flash operation per call (a sector erase or a page program), within
+ * FIXLOG_WINDOW_MS of the last committed fix, or at once if a page has waited for
+ * FIXLOG_MAX_DELAY_MS (fix rates or sentence sets that leave no quiet time).
+ *
+ * @param log Pointer to the FixLog structure.
+ */
+void FixLog_poll(FixLog *log)
+{
+    if (!log->queued)
+    {
+        return;
+    }
+    uint32_t now = time_us_32() / 1000;
+    if (now - log->committed >= FIXLOG_WINDOW_MS)
+    {
+        if (now - log->pages[log->fill ^ 1].since < FIXLOG_MAX_DELAY_MS)
+        {
+            return;
+        }
+        log->stats.forced++;
+    }
+    _writeQueued(log, true);
+}
+
+/**
+ * @brief Writes every logged fix to flash now, the partly filled page included.
+ *
+ * The rest of that page stays unused. Call it before a readout or before powering down.
+ *
+ * @param log Pointer to the FixLog structure.
+ */
+void FixLog_flush(FixLog *log)
+{
+    if (log->queued)
+    {
+        _writeQueued(log, false);
+        if (log->queued)
+        {
+            return; // The flash refused; keep both pages
+        }
+    }
+    if (log->keyed)
+    {
+        _queuePage(log);
+        _writeQueued(log, false);
+    }
+}
+
+/**
+ * @brief Erases the whole ring; logging starts again from its first sector.
+ *
+ * @param log Pointer to the FixLog structure.
+ */
+void FixLog_clear(FixLog *log)
+{
+    FixLogPage page;
+    for (uint32_t sector = 0; sector < FIXLOG_SECTORS; sector++)
+    {
+        page.page = sector * FIXLOG_PAGES_PER_SECTOR;
+        _write(log, &page, true);
+    }
+    log->queued = false;
+    log->next = 0;
+    _startPage(log);
+}
+
+/**
+ * @brief Copies the counters of the log.
+ *
+ * @param log Pointer to the FixLog structure.
+ * @param stats Receives the counters.
+ */
+void FixLog_stats(const FixLog *log, FixLogStats *stats)
+{
+    *stats = log->stats;
+}
+
+/**
+ * @brief Starts a readout at the oldest fix in flash.
+ *
+ * Fixes still in RAM are not part of the readout (see `FixLog_flush`). Logging may go on while
+ * the readout is read in batches; a sector erased under the reader is skipped.
+ *
+ * @param log Pointer to the FixLog structure.
+ * @param reader Receives the readout position.
+ */
+void FixLog_open(const FixLog *log, FixLogReader *reader)
+{
+    memset(reader, 0, sizeof(FixLogReader));
+    uint32_t current = log->pages[log->fill].page / FIXLOG_PAGES_PER_SECTOR;
+    reader->page = ((current + 1) % FIXLOG_SECTORS) * FIXLOG_PAGES_PER_SECTOR; // Oldest sector first
+    reader->remaining = FIXLOG_PAGES;
+}
+
+/**
+ * @brief Loads the next page of the readout that holds records.
+ *
+ * @return True if a page was loaded, false at the end of the readout.
+ */
+static bool _nextPage(FixLogReader *reader)
+{
+    for (; reader->remaining > 0; reader->remaining--, reader->page = (reader->page + 1) % FIXLOG_PAGES)
+    {
+        uint32_t sequence;
+        bool first = reader->page % FIXLOG_PAGES_PER_SECTOR == 0;
+        if (!_sector(reader->page / FIXLOG_PAGES_PER_SECTOR, &sequence) ||
+            (first ? (int32_t)(sequence - reader->sequence) <= 0 : sequence != reader->sequence))
+        {
+            // Never written, older than the sector before it (the one about to be reused), or
+            // erased and reused since its first page was read
+            uint32_t skip = FIXLOG_PAGES_PER_SECTOR - reader->page % FIXLOG_PAGES_PER_SECTOR;
+            skip = skip < reader->remaining ? skip : reader->remaining;
+            reader->remaining -= skip - 1;
+            reader->page = (reader->page + skip - 1) % FIXLOG_PAGES;
+            continue;
+        }
+        reader->sequence = sequence;
+
+        const uint8_t *data = _flash(reader->page);
+        uint16_t payload = _pageHeader(reader->page) + FIXLOG_PAGE_HEADER;
+        uint16_t length = FlashRecord_get16(data + payload - FIXLOG_PAGE_HEADER);
+        if (length == 0xFFFF)
+        {
+            continue; // Not programmed yet
+        }
+        if (length > FLASH_PAGE_SIZE - payload ||
+            FlashRecord_get16(data + payload - FIXLOG_PAGE_HEADER + 2) != FlashRecord_crc16(data + payload, length))
+        {
+            reader->corrupt++;
+            continue;
+        }
+        reader->offset = payload;
+        reader->end = payload + length;
+        reader->remaining--;
+        reader->page = (reader->page + 1) % FIXLOG_PAGES;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Reads the next batch of the readout, oldest fix first.
+ *
+ * @param reader The readout position (see `FixLog_open`).
+ * @param entries Receives the fixes.
+ * @param count Capacity of `entries`.
+ *
+ * @return The number of fixes read; 0 at the end of the readout.
+ */
+size_t FixLog_read(FixLogReader *reader, FixLogEntry *entries, size_t count)
+{
+    size_t read = 0;
+    uint32_t sequence;
+    if (reader->end != 0 && (!_sector((reader->page + FIXLOG_PAGES - 1) % FIXLOG_PAGES / FIXLOG_PAGES_PER_SECTOR, &sequence) ||
+                             sequence != reader->sequence))
+    {
+        reader->offset = reader->end; // The sector was erased since the last batch
+    }
+    while (read < count)
+    {
+        if (reader->offset >= reader->end)
+        {
+            reader->end = 0;
+            if (!_nextPage(reader))
+            {
+                break;
+            }
+        }
+        // The page was checked against its CRC when it was loaded; it is decoded from the flash directly
+        uint32_t page = (reader->page + FIXLOG_PAGES - 1) % FIXLOG_PAGES;
+        const uint8_t *data = _flash(page);
+        bool keyed = reader->offset != _pageHeader(page) + FIXLOG_PAGE_HEADER;
+        const uint8_t *next = _decode(data + reader->offset, data + reader->end, &reader->last, keyed);
+        if (next == NULL)
+        {
+            reader->corrupt++;
+            reader->offset = reader->end; // Skip the rest of the page
+            continue;
+        }
+        reader->offset = next - data;
+        entries[read++] = reader->last;
+    }
+    return read;
+}
@@ -0,0 +1,139 @@
+#ifndef GPS_FIXLOG_H
+#define GPS_FIXLOG_H
+
+#include <hardware/flash.h>
+#include "nmea_parser.h"
+
+// Sectors of the log ring (4 KB each); a page holds about 30 fixes, a sector about 480
+#ifndef FIXLOG_SECTORS
+#define FIXLOG_SECTORS 64
+#endif
+
+// Flash offset of the ring (default: the end of the flash, clear of the program)
+#ifndef FIXLOG_FLASH_OFFSET
+#define FIXLOG_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - FIXLOG_SECTORS * FLASH_SECTOR_SIZE)
+#endif
+
+// Time after a committed fix during which the link is quiet and flash may be written (milliseconds)
+#ifndef FIXLOG_WINDOW_MS
+#define FIXLOG_WINDOW_MS 200
+#endif
+
+// Longest a full page waits for a quiet window before it is written anyway (milliseconds)
+#ifndef FIXLOG_MAX_DELAY_MS
+#define FIXLOG_MAX_DELAY_MS 10000
+#endif
+
+#define FIXLOG_MAGIC 0x474C5846u // "FXLG", first word of every sector
+#define FIXLOG_VERSION 1         // Format of the sectors and records
+#define FIXLOG_PAGES_PER_SECTOR (FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE)
+#define FIXLOG_SECTOR_HEADER 12 // Magic, sequence, version, reserved, CRC-16
+#define FIXLOG_PAGE_HEADER 4    // Payload length and CRC-16
+#define FIXLOG_RECORD_MAX 24    // Longest encoded record (a key record)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief One logged fix, as written and read back.
+     */
+    typedef struct
+    {
+        uint32_t date;      /**< UTC date as ddmmyy (see `NMEAFix.date`). */
+        uint32_t utc_time;  /**< UTC time as hhmmss * 1000 + milliseconds. */
+        int32_t latitude;   /**< Degrees * NMEA_DEGREES_SCALE, negative south. */
+        int32_t longitude;  /**< Degrees * NMEA_DEGREES_SCALE, negative west. */
+        int32_t altitude;   /**< Meters * NMEA_ALTITUDE_SCALE. */
+        uint8_t satellites; /**< SVs in use, at most 15. */
+        bool valid;         /**< Status of the fix (see `NMEAFix.valid`). */
+    } FixLogEntry;
+
+    /**
+     * @brief A flash page being assembled in RAM.
+     */
+    typedef struct
+    {
+        uint8_t data[FLASH_PAGE_SIZE]; /**< Image of the page, erased bytes included. */
+        uint16_t length;               /**< Bytes used, headers included. */
+        uint16_t payload;              /**< Offset of the first record. */
+        uint32_t page;                 /**< Page of the ring it is written to. */
+        uint32_t since;                /**< Time it was queued (milliseconds since boot). */
+    } FixLogPage;
+
+    /**
+     * @brief Counters of the log since `FixLog_init`.
+     */
+    typedef struct
+    {
+        uint32_t fixes;    /**< Fixes appended. */
+        uint32_t skipped;  /**< Committed fixes without a position, not logged. */
+        uint32_t dropped;  /**< Fixes lost because both page buffers were full. */
+        uint32_t bytes;    /**< Encoded record bytes. */
+        uint32_t pages;    /**< Pages programmed. */
+        uint32_t erases;   /**< Sectors erased. */
+        uint32_t forced;   /**< Flash operations run outside a quiet window. */
+        uint32_t failures; /**< Flash operations `flash_safe_execute` refused. */
+    } FixLogStats;
+
+    /**
+     * @brief Delta-encoded fix history in a wear-leveled ring of flash sectors.
+     *
+     * Every committed fix is appended to a page buffer in RAM as a record of about 6 to 10 bytes:
+     * the time, latitude, longitude and altitude as varint deltas against the previous record.
+     * The first record of every page holds absolute values, and every page carries its length and
+     * a CRC-16, so each page decodes on its own and a page torn by a power cut loses only itself.
+     * Sectors are filled in ring order and erased just before reuse, each stamped with a growing
+     * sequence number, so all sectors wear evenly and the newest is found again after a reset.
+     *
+     * Flash is written from `FixLog_poll`, in the main loop, right after a committed fix, when the
+     * module has just finished its burst of sentences: while a sector is erased or a page
+     * programmed, the flash cannot be read, so `flash_safe_execute` disables interrupts and pauses
+     * the other core (if it called `flash_safe_execute_core_init`). A second page buffer takes the
+     * next fixes meanwhile.
+     */
+    typedef struct
+    {
+        NMEAParser *parser;   /**< Parser whose epochs are logged, or NULL (see `FixLog_append`). */
+        FixLogPage pages[2];  /**< Page being filled and page waiting for flash. */
+        uint8_t fill;         /**< Index of the page being filled. */
+        bool queued;          /**< True while `pages[fill ^ 1]` waits for flash. */
+        bool erased;          /**< True once the sector of the waiting page has been erased. */
+        bool keyed;           /**< True once the page being filled holds a record (`last` is valid). */
+        FixLogEntry last;     /**< Last record of the page being filled, base of the next delta. */
+        uint32_t next;        /**< Ring page the next page buffer is assigned. */
+        uint32_t sequence;    /**< Sequence number of the newest sector. */
+        uint32_t committed;   /**< Time of the last fix appended (milliseconds since boot). */
+        FixLogStats stats;    /**< Counters. */
+    } FixLog;
+
+    /**
+     * @brief Position of a readout, from the oldest fix in flash to the newest.
+     */
+    typedef struct
+    {
+        uint32_t page;       /**< Ring page being read. */
+        uint32_t remaining;  /**< Pages left after it. */
+        uint32_t sequence;   /**< Sequence number of the sector being read. */
+        uint16_t offset;     /**< Offset of the next record in the page. */
+        uint16_t end;        /**< End of the records of the page (0: page not loaded). */
+        FixLogEntry last;    /**< Last record decoded, base of the next delta. */
+        uint32_t corrupt;    /**< Pages skipped because their CRC or a record was wrong. */
+    } FixLogReader;
+
+    int FixLog_init(FixLog *log, NMEAParser *parser);
+    void FixLog_free(FixLog *log);
+    bool FixLog_append(FixLog *log, const NMEAFix *fix);
+    void FixLog_poll(FixLog *log);
+    void FixLog_flush(FixLog *log);
+    void FixLog_clear(FixLog *log);
+    void FixLog_stats(const FixLog *log, FixLogStats *stats);
+    void FixLog_open(const FixLog *log, FixLogReader *reader);
+    size_t FixLog_read(FixLogReader *reader, FixLogEntry *entries, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GPS_FIXLOG_H
@@ -0,0 +1,123 @@
+#ifndef GPS_FLASH_RECORD_H
+#define GPS_FLASH_RECORD_H
+
+#include <hardware/flash.h>
+#include <pico/flash.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Flash operation run by flash_safe_execute.
+     */
+    typedef struct
+    {
+        uint32_t offset;     /**< Flash offset of the sector or page */
+        const uint8_t *data; /**< Page to program, or NULL to erase the sector */
+    } FlashRecordOperation;
+
+    /**
+     * @brief CRC-16/CCITT-FALSE of a block of bytes, as the fix log and the startup state store it.
+     */
+    static inline uint16_t FlashRecord_crc16(const uint8_t *data, size_t length)
+    {
+        uint16_t crc = 0xFFFF;
+        for (size_t i = 0; i < length; i++)
+        {
+            crc ^= (uint16_t)data[i] << 8;
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+            }
+        }
+        return crc;
+    }
+
+    /**
+     * @brief Stores a 16-bit value little-endian.
+     */
+    static inline void FlashRecord_put16(uint8_t *p, uint16_t value)
+    {
+        p[0] = value;
+        p[1] = value >> 8;
+    }
+
+    /**
+     * @brief Stores a 32-bit value little-endian.
+     */
+    static inline void FlashRecord_put32(uint8_t *p, uint32_t value)
+    {
+        FlashRecord_put16(p, value);
+        FlashRecord_put16(p + 2, value >> 16);
+    }
+
+    /**
+     * @brief Loads a little-endian 16-bit value.
+     */
+    static inline uint16_t FlashRecord_get16(const uint8_t *p)
+    {
+        return p[0] | (uint16_t)p[1] << 8;
+    }
+
+    /**
+     * @brief Loads a little-endian 32-bit value.
+     */
+    static inline uint32_t FlashRecord_get32(const uint8_t *p)
+    {
+        return FlashRecord_get16(p) | (uint32_t)FlashRecord_get16(p + 2) << 16;
+    }
+
+    /**
+     * @brief Returns the contents of the flash at an offset, through the XIP window.
+     */
+    static inline const uint8_t *FlashRecord_at(uint32_t offset)
+    {
+        return (const uint8_t *)(XIP_BASE + offset);
+    }
+
+    /**
+     * @brief Runs with the flash out of use (see flash_safe_execute).
+     */
+    static inline void FlashRecord_operate(void *param)
+    {
+        const FlashRecordOperation *operation = (const FlashRecordOperation *)param;
+        if (operation->data == NULL)
+        {
+            flash_range_erase(operation->offset, FLASH_SECTOR_SIZE);
+        }
+        else
+        {
+            flash_range_program(operation->offset, operation->data, FLASH_PAGE_SIZE);
+        }
+    }
+
+    /**
+     * @brief Erases the sector at `offset` (`data` NULL) or programs the page at `offset`.
+     *
+     * Fails if the other core or the interrupts cannot be paused within `timeout_ms` (see
+     * flash_safe_execute).
+     *
+     * @param offset Flash offset of the sector or page.
+     * @param data The page to program, or NULL to erase the sector.
+     * @param timeout_ms Longest wait for the other core to pause.
+     * @return True on success.
+     */
+    static inline bool FlashRecord_write(uint32_t offset, const uint8_t *data, uint32_t timeout_ms)
+    {
+        FlashRecordOperation operation = {
+            .offset = offset,
+            .data = data,
+        };
+        return flash_safe_execute(FlashRecord_operate, &operation, timeout_ms) == PICO_OK;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GPS_FLASH_RECORD_H
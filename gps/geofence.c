@@ -0,0 +1,273 @@
+#include "geofence.h"
+#include "gps_math.h"
+#include <string.h>
+
+#define GEOFENCE_WORDS ((GEOFENCE_MAX_FENCES + 31) / 32)
+
+// Where a fix is relative to a fence
+typedef enum
+{
+    GEOFENCE_IN,     // Inside by more than the margin
+    GEOFENCE_BORDER, // Within the margin of an edge: the state does not change
+    GEOFENCE_OUT,    // Outside by more than the margin
+} GeofencePlace;
+
+/**
+ * @brief Finds the candidates of the cell of a position with a binary search over the stored cells.
+ *
+ * @return The number of candidates, 0 if the cell has none or the position is off the grid.
+ */
+static uint32_t _cell(const GeofenceIndex *index, int32_t latitude, int32_t longitude, const uint16_t **candidates)
+{
+    int64_t north = (int64_t)latitude - index->latitude;
+    int64_t east = (int64_t)longitude - index->longitude;
+    if (north < 0 || east < 0)
+    {
+        return 0;
+    }
+    uint64_t row = north / index->cell_latitude;
+    uint64_t column = east / index->cell_longitude;
+    if (row >= index->rows || column >= index->columns)
+    {
+        return 0;
+    }
+    uint32_t key = (uint32_t)(row * index->columns + column);
+    uint32_t low = 0;
+    uint32_t high = index->cell_count;
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low) / 2;
+        if (index->cells[middle].key < key)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    if (low == index->cell_count || index->cells[low].key != key)
+    {
+        return 0;
+    }
+    *candidates = index->candidates + index->cells[low].first;
+    return index->cells[low + 1].first - index->cells[low].first;
+}
+
+/**
+ * @brief Places a position relative to a fence: crossing parity for the inside, nearest edge for the margin.
+ *
+ * The distances are measured in latitude units, longitudes being scaled by the cosine of the
+ * fence's latitude, so the margin is the same in every direction.
+ */
+static GeofencePlace _place(const GeofenceIndex *index, const GeofenceFence *fence, int32_t latitude,
+                            int32_t longitude, uint16_t *edges)
+{
+    const GeofenceVertex *ring = index->vertices + fence->first;
+    const int64_t margin = index->margin;
+    bool inside = false;
+    bool near = false;
+    const GeofenceVertex *a = &ring[fence->count - 1];
+    for (uint16_t i = 0; i < fence->count; a = &ring[i++])
+    {
+        const GeofenceVertex *b = &ring[i];
+        int64_t ay = (int64_t)a->latitude - latitude;
+        int64_t by = (int64_t)b->latitude - latitude;
+        int64_t alon = (int64_t)a->longitude - longitude;
+        int64_t blon = (int64_t)b->longitude - longitude;
+
+        // Crossing of the ray going east from the position
+        if ((ay > 0) != (by > 0))
+        {
+            int64_t cross = alon * (by - ay) - (blon - alon) * ay;
+            if ((by > ay) == (cross > 0))
+            {
+                inside = !inside;
+            }
+        }
+
+        // Distance to the edge, only for edges whose bounding box comes within the margin
+        if (near || (ay > margin && by > margin) || (ay < -margin && by < -margin))
+        {
+            continue;
+        }
+        int64_t ax = alon * fence->scale >> 16;
+        int64_t bx = blon * fence->scale >> 16;
+        if ((ax > margin && bx > margin) || (ax < -margin && bx < -margin))
+        {
+            continue;
+        }
+        (*edges)++;
+        int64_t dx = bx - ax;
+        int64_t dy = by - ay;
+        int64_t length2 = dx * dx + dy * dy; // Edges are at most 2^20 units long (see fences.py)
+        int64_t along = -(ax * dx + ay * dy);
+        if (along <= 0 || length2 == 0)
+        {
+            near = ax * ax + ay * ay <= margin * margin; // Nearest to `a` (`b` is the next edge's `a`)
+        }
+        else if (along < length2)
+        {
+            int64_t cross = ax * dy - ay * dx;
+            near = (cross < 0 ? -cross : cross) <= margin * GPSMath_sqrt((uint64_t)length2);
+        }
+    }
+    return near ? GEOFENCE_BORDER : inside ? GEOFENCE_IN : GEOFENCE_OUT;
+}
+
+/**
+ * @brief Records a transition and fires NMEA_EVENT_GEOFENCE.
+ */
+static void _notify(Geofence *geofence, uint16_t fence, uint8_t type, const NMEAFix *fix)
+{
+    uint32_t bit = 1u << (fence % 32);
+    if (type == GEOFENCE_ENTER)
+    {
+        geofence->inside[fence / 32] |= bit;
+        geofence->stats.enters++;
+    }
+    else
+    {
+        geofence->inside[fence / 32] &= ~bit;
+        geofence->stats.exits++;
+    }
+    geofence->event.fence = fence;
+    geofence->event.id = geofence->index->fences[fence].id;
+    geofence->event.type = type;
+    geofence->event.utc_time = fix->utc_time;
+    geofence->event.latitude = fix->latitude;
+    geofence->event.longitude = fix->longitude;
+    if (geofence->parser != NULL)
+    {
+        NMEAParser_notify(geofence->parser, NMEA_EVENT_GEOFENCE);
+    }
+}
+
+/**
+ * @brief Initializes a geofence engine with no fences.
+ *
+ * @param geofence Pointer to the Geofence structure.
+ * @param parser The parser whose listeners get NMEA_EVENT_GEOFENCE, or NULL.
+ */
+void Geofence_init(Geofence *geofence, NMEAParser *parser)
+{
+    memset(geofence, 0, sizeof(Geofence));
+    geofence->parser = parser;
+}
+
+/**
+ * @brief Starts evaluating a set of fences, outside all of them.
+ *
+ * @param geofence Pointer to the Geofence structure.
+ * @param index The fences compiled by fences.py, or NULL to stop.
+ * @return GEOFENCE_SUCCESS, GEOFENCE_ERROR_VERSION or GEOFENCE_ERROR_FENCES.
+ */
+int Geofence_load(Geofence *geofence, const GeofenceIndex *index)
+{
+    if (index != NULL && index->version != GEOFENCE_VERSION)
+    {
+        return GEOFENCE_ERROR_VERSION;
+    }
+    if (index != NULL && index->fence_count > GEOFENCE_MAX_FENCES)
+    {
+        return GEOFENCE_ERROR_FENCES;
+    }
+    geofence->index = index;
+    memset(geofence->inside, 0, sizeof(geofence->inside));
+    memset(&geofence->stats, 0, sizeof(GeofenceStats));
+    return GEOFENCE_SUCCESS;
+}
+
+/**
+ * @brief Evaluates a committed fix and fires an NMEA_EVENT_GEOFENCE for every fence entered or left.
+ *
+ * Fixes neither valid (RMC/GLL 'A') nor with a GGA quality are ignored, as in GPSTrack_fix.
+ * Fences that are not candidates of the fix's cell are more than the margin away, so the fences
+ * the receiver was in are left.
+ *
+ * @param geofence Pointer to the Geofence structure.
+ * @param fix The fix, e.g. from NMEAParser_fix in an NMEA_EVENT_EPOCH listener.
+ * @return The number of events fired.
+ */
+int Geofence_fix(Geofence *geofence, const NMEAFix *fix)
+{
+    const GeofenceIndex *index = geofence->index;
+    if (index == NULL || (!fix->valid && fix->quality == 0))
+    {
+        return 0;
+    }
+    geofence->stats.fixes++;
+    uint32_t seen[GEOFENCE_WORDS] = {0};
+    const uint16_t *candidates = NULL;
+    uint32_t count = _cell(index, fix->latitude, fix->longitude, &candidates);
+    uint16_t edges = 0;
+    int events = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint16_t fence = candidates[i] & GEOFENCE_FENCE_MASK;
+        seen[fence / 32] |= 1u << (fence % 32);
+        GeofencePlace place = (candidates[i] & GEOFENCE_CELL_INSIDE)
+                                  ? GEOFENCE_IN
+                                  : _place(index, &index->fences[fence], fix->latitude, fix->longitude, &edges);
+        bool inside = Geofence_inside(geofence, fence);
+        if (place == GEOFENCE_IN && !inside)
+        {
+            _notify(geofence, fence, GEOFENCE_ENTER, fix);
+            events++;
+        }
+        else if (place == GEOFENCE_OUT && inside)
+        {
+            _notify(geofence, fence, GEOFENCE_EXIT, fix);
+            events++;
+        }
+    }
+    for (uint32_t word = 0; word < (index->fence_count + 31u) / 32; word++)
+    {
+        for (uint32_t left = geofence->inside[word] & ~seen[word]; left != 0; left &= left - 1)
+        {
+            _notify(geofence, word * 32 + __builtin_ctz(left), GEOFENCE_EXIT, fix);
+            events++;
+        }
+    }
+    if (count > geofence->stats.candidates_max)
+    {
+        geofence->stats.candidates_max = count;
+    }
+    if (edges > geofence->stats.edges_max)
+    {
+        geofence->stats.edges_max = edges;
+    }
+    return events;
+}
+
+/**
+ * @brief Returns true if the receiver is in a fence.
+ *
+ * @param geofence Pointer to the Geofence structure.
+ * @param fence Number of the fence in the index.
+ */
+bool Geofence_inside(const Geofence *geofence, uint16_t fence)
+{
+    return fence < GEOFENCE_MAX_FENCES && (geofence->inside[fence / 32] >> (fence % 32) & 1) != 0;
+}
+
+/**
+ * @brief Returns the transition being notified, from an NMEA_EVENT_GEOFENCE listener.
+ *
+ * @param geofence Pointer to the Geofence structure.
+ */
+const GeofenceEvent *Geofence_event(const Geofence *geofence)
+{
+    return &geofence->event;
+}
+
+/**
+ * @brief Copies the counters.
+ *
+ * @param geofence Pointer to the Geofence structure.
+ * @param stats Receives the counters.
+ */
+void Geofence_stats(const Geofence *geofence, GeofenceStats *stats)
+{
+    *stats = geofence->stats;
+}
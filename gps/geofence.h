@@ -0,0 +1,144 @@
+#ifndef GPS_GEOFENCE_H
+#define GPS_GEOFENCE_H
+
+#include "nmea_parser.h"
+
+// Fences a Geofence can track (the inside state is one bit per fence)
+#ifndef GEOFENCE_MAX_FENCES
+#define GEOFENCE_MAX_FENCES 512
+#endif
+
+#define GEOFENCE_VERSION 1           // Layout of a GeofenceIndex, written by fences.py
+#define GEOFENCE_CELL_INSIDE 0x8000u // Candidate flag: the whole cell is inside the fence by more than the margin
+#define GEOFENCE_FENCE_MASK 0x7FFFu  // Candidate: number of the fence in `GeofenceIndex.fences`
+#define GEOFENCE_SCALE_ONE 65535u    // `GeofenceFence.scale` of 1 (Q16, saturated)
+
+#define GEOFENCE_SUCCESS 0
+#define GEOFENCE_ERROR_VERSION 1 // The index was written for another layout
+#define GEOFENCE_ERROR_FENCES 2  // More than GEOFENCE_MAX_FENCES fences
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Vertex of a fence, in degrees * NMEA_DEGREES_SCALE.
+     */
+    typedef struct
+    {
+        int32_t latitude;
+        int32_t longitude;
+    } GeofenceVertex;
+
+    /**
+     * @brief Polygon of a fence: a closed ring of vertices, the last one joined to the first.
+     */
+    typedef struct
+    {
+        uint32_t first; /**< First vertex in `GeofenceIndex.vertices`. */
+        uint16_t count; /**< Vertices of the ring. */
+        uint16_t id;    /**< Application identifier of the fence (the `id` property of the GeoJSON feature). */
+        uint16_t scale; /**< Length of a longitude unit in latitude units at the fence, Q16 (cos of the latitude). */
+    } GeofenceFence;
+
+    /**
+     * @brief Cell of the grid that has candidates; cells are sorted by key and end with a sentinel.
+     */
+    typedef struct
+    {
+        uint32_t key;   /**< row * columns + column. */
+        uint32_t first; /**< First candidate in `GeofenceIndex.candidates`; the next cell's `first` ends them. */
+    } GeofenceCell;
+
+    /**
+     * @brief Fences compiled by fences.py into constant tables, so they stay in flash.
+     *
+     * The area of the fences is cut into a grid, and only the cells within the hysteresis margin
+     * of a fence are stored, with the fences they may be in (the candidates). A candidate flagged
+     * GEOFENCE_CELL_INSIDE is a cell inside the fence by more than the margin, which needs no test.
+     */
+    typedef struct
+    {
+        uint32_t version;                 /**< GEOFENCE_VERSION. */
+        int32_t latitude;                 /**< South edge of the grid, degrees * NMEA_DEGREES_SCALE. */
+        int32_t longitude;                /**< West edge of the grid, degrees * NMEA_DEGREES_SCALE. */
+        int32_t cell_latitude;            /**< Height of a cell, degrees * NMEA_DEGREES_SCALE. */
+        int32_t cell_longitude;           /**< Width of a cell, degrees * NMEA_DEGREES_SCALE. */
+        uint32_t columns;                 /**< Cells from west to east. */
+        uint32_t rows;                    /**< Cells from south to north. */
+        int32_t margin;                   /**< Hysteresis distance, latitude units (about 11 mm). */
+        uint16_t fence_count;             /**< Entries of `fences`. */
+        uint32_t cell_count;              /**< Entries of `cells`, sentinel excluded. */
+        const GeofenceFence *fences;      /**< Fences, by number. */
+        const GeofenceVertex *vertices;   /**< Rings of all fences. */
+        const GeofenceCell *cells;        /**< Cells with candidates, sorted by key, then the sentinel. */
+        const uint16_t *candidates;       /**< Fence numbers, with GEOFENCE_CELL_INSIDE. */
+    } GeofenceIndex;
+
+    typedef enum
+    {
+        GEOFENCE_ENTER, /**< The fix is inside the fence by more than the margin. */
+        GEOFENCE_EXIT,  /**< The fix is outside the fence by more than the margin. */
+    } GeofenceEventType;
+
+    /**
+     * @brief Transition of one fence, read with `Geofence_event` from an NMEA_EVENT_GEOFENCE listener.
+     */
+    typedef struct
+    {
+        uint16_t fence;    /**< Number of the fence in the index. */
+        uint16_t id;       /**< Application identifier of the fence. */
+        uint8_t type;      /**< GeofenceEventType. */
+        uint32_t utc_time; /**< UTC time of the fix (see `NMEAFix.utc_time`). */
+        int32_t latitude;  /**< Position of the fix, degrees * NMEA_DEGREES_SCALE. */
+        int32_t longitude; /**< Position of the fix, degrees * NMEA_DEGREES_SCALE. */
+    } GeofenceEvent;
+
+    /**
+     * @brief Counters of the geofence evaluation.
+     */
+    typedef struct
+    {
+        uint32_t fixes;          /**< Valid fixes evaluated. */
+        uint32_t enters;         /**< GEOFENCE_ENTER events. */
+        uint32_t exits;          /**< GEOFENCE_EXIT events. */
+        uint16_t candidates_max; /**< Most candidates of a fix's cell. */
+        uint16_t edges_max;      /**< Most polygon edges tested for one fix. */
+    } GeofenceStats;
+
+    /**
+     * @brief Geofence engine: evaluates every committed fix against a compiled GeofenceIndex.
+     *
+     * A fix finds its cell with a binary search over the stored cells (O(log n)), then tests
+     * only that cell's candidates: a point-in-polygon test and the distance to the nearest edge,
+     * in integer 1e-7 degree coordinates. A fence is entered once a fix is inside it by more than
+     * the margin and left once a fix is outside it by more than the margin, so a receiver waiting
+     * on the border does not produce events at every fix.
+     *
+     * `Geofence_fix` takes one committed fix per epoch and fires NMEA_EVENT_GEOFENCE for every
+     * transition synchronously, through the parser's listeners (`NMEAParser_notify`), so they run
+     * inside the caller's NMEA_EVENT_EPOCH listener and see the transition in `Geofence_event`.
+     * `Geofence_load` and `Geofence_fix` must be called from the same core.
+     */
+    typedef struct
+    {
+        NMEAParser *parser;                                   /**< Parser whose listeners get the events, or NULL. */
+        const GeofenceIndex *index;                           /**< Fences, or NULL. */
+        uint32_t inside[(GEOFENCE_MAX_FENCES + 31) / 32];     /**< Fences the receiver is in, one bit each. */
+        GeofenceEvent event;                                  /**< Transition being notified. */
+        GeofenceStats stats;                                  /**< Counters. */
+    } Geofence;
+
+    void Geofence_init(Geofence *geofence, NMEAParser *parser);
+    int Geofence_load(Geofence *geofence, const GeofenceIndex *index);
+    int Geofence_fix(Geofence *geofence, const NMEAFix *fix);
+    bool Geofence_inside(const Geofence *geofence, uint16_t fence);
+    const GeofenceEvent *Geofence_event(const Geofence *geofence);
+    void Geofence_stats(const Geofence *geofence, GeofenceStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GPS_GEOFENCE_H
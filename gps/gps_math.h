@@ -0,0 +1,41 @@
+#ifndef GPS_MATH_H
+#define GPS_MATH_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Integer square root, rounded down.
+     *
+     * Shared by the track smoother and the geofence engine, which both work in integer units.
+     *
+     * @param value The value to take the root of.
+     * @return The largest integer whose square does not exceed `value`.
+     */
+    static inline uint32_t GPSMath_sqrt(uint64_t value)
+    {
+        uint64_t root = 0;
+        for (uint64_t bit = 1ull << 62; bit != 0; bit >>= 2)
+        {
+            if (value >= root + bit)
+            {
+                value -= root + bit;
+                root = (root >> 1) + bit;
+            }
+            else
+            {
+                root >>= 1;
+            }
+        }
+        return (uint32_t)root;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GPS_MATH_H
@@ -1,5 +1,7 @@
 #include "cgps.h"
+#include "fixlog.h"
 #include "../nmea/nmea_parser.h"
+#include "trace.h"
 
 #include <stdio.h>
 #include <pico/stdlib.h>
@@ -22,6 +24,49 @@ UART port:
 // Declare a global pointer to the GPS object
 CGPS gps;
 
+// Fix history in flash, read out over USB when 'd' is typed
+#define DUMP_BATCH 16 // Fixes printed per loop pass, so reception goes on during a readout
+FixLog fixLog;
+FixLogReader dump;
+bool dumping = false;
+
+// Current UTC at power-on (seconds since 2000-01-01, see GPSStartup_seconds), e.g. from an RTC;
+// 0 if unknown: the module is not aided and starts cold
+#define BOOT_UTC 0
+uint32_t ttffShown = 0; // Time to first fix of the last start already printed
+
+/**
+ * @brief Prints the fix of every completed epoch (date, latitude, longitude, speed).
+ */
+void printEpoch(NMEAParser *parser, uint32_t event, void *ctx)
+{
+    NMEAFix fix;
+    GPS_fix(&gps, &fix); // Still the fix of the epoch that just ended
+
+    printf("Date: %lu-%lu-%lu\n", (unsigned long)(fix.date % 100 + gps.start_year),
+           (unsigned long)(fix.date / 100 % 100), (unsigned long)(fix.date / 10000));
+    printf("Latitude %f\n", (double)fix.latitude / NMEA_DEGREES_SCALE);
+    printf("Longitude %f\n", (double)fix.longitude / NMEA_DEGREES_SCALE);
+    printf("Speed %f\n", (double)fix.speed / NMEA_SPEED_SCALE);
+
+    GPSPowerStats power;
+    GPS_powerStats(&gps, &power);
+    if (power.fixes != 0)
+    {
+        printf("Awake %lu us of %lu us (%lu%% on average)\n", (unsigned long)power.awake_us,
+               (unsigned long)power.period_us, (unsigned long)(power.awake_total_us * 100 / power.period_total_us));
+    }
+
+    GPSStartupStats startup;
+    GPS_startupStats(&gps, &startup);
+    if (startup.ttff_ms != 0 && startup.starts != ttffShown)
+    {
+        static const char *const kinds[] = {"cold", "aided", "wakeup"};
+        printf("First fix %lu ms after the %s start\n", (unsigned long)startup.ttff_ms, kinds[startup.kind]);
+        ttffShown = startup.starts;
+    }
+}
+
 /**
  * @brief Setup function for initializing the GPS module.
  *
@@ -40,44 +85,37 @@ void setup()
     // Initialize the GPS object with default intervals for sentence output
     IntervalType intervals = DEFAULT_INTERVALS();
     GPS_init(&gps, intervals, TXD2RX, RXD2TX);
+    printf("GPS baud rate: %lu\n", GPS_detectBaud(&gps)); // The module keeps the rate it was last set to
+    GPS_setBaud(&gps, 115200);                             // Leaves more of every second idle at 1 Hz and above
     GPS_setDelay(&gps, 5); // Set the GPS update delay to 5 seconds (200 millihertz).
                            // For optimal performance, it's recommended to use a delay of 1 second (1 Hz) or higher.
+    GPS_on(&gps, NMEA_EVENT_EPOCH, printEpoch, NULL);
+    FixLog_init(&fixLog, &gps.nmeaParser); // Resumes after the newest fix already in flash
+    GPS_aid(&gps, BOOT_UTC);               // Time and last saved position, if the time is known
+    TRACE_INIT(); // Stage timing, printed every RP_PICO_TRACE_PRINT_S seconds when built with RP_PICO_TRACE=1
     printf("GPS Module Initialized.\n");
 }
 
-unsigned long lastTime = 0;          // Variable to store the last time the GPS state was toggled
+unsigned long lastTime = 0;          // Variable to store the last time the GPS module was suspended
 unsigned long pauseInterval = 10000; // Interval for pausing the GPS module (10 seconds)
-bool isPaused = false;               // Flag to track whether the GPS module is in paused state
 
 /**
  * @brief Main loop function to read and display GPS data.
  *
- * The loop checks if it's time to pause or wake up the GPS module based on the interval,
- * reads the GPS data, and prints the results (latitude, longitude, speed, etc.) to the console.
+ * The loop suspends the GPS module and the core every other interval, reads the GPS data and prints
+ * the raw sentences, then sleeps until the next ones arrive; printEpoch prints the parsed results.
  */
 void loop()
 {
     // Get current time in milliseconds
     unsigned long currentTime = time_us_32() / 1000;
 
-    // Check if the time to toggle the GPS state has elapsed
+    // Check if the time to pause the GPS module has elapsed
     if (currentTime - lastTime >= pauseInterval)
     {
-        // Toggle the GPS state between standby and wakeup
-        if (isPaused)
-        {
-            GPS_wakeup(&gps); // Wake up the GPS module
-        }
-        else
-        {
-            GPS_standby(&gps); // Put the GPS module into standby mode
-        }
-
-        // Toggle the paused state
-        isPaused = !isPaused;
-
-        // Update the last time with the current time
-        lastTime = currentTime;
+        GPS_saveStartup(&gps);            // Last fix for the next power-on (at most every GPS_STARTUP_SAVE_S)
+        GPS_suspend(&gps, pauseInterval); // Standby mode, the core sleeps too, then both wake up
+        lastTime = time_us_32() / 1000;
     }
 
     // Read and process GPS data if available
@@ -90,15 +128,40 @@ void loop()
             continue;
         }
 
-        // Print the raw NMEA sentence
+        // Print the raw NMEA sentence (printEpoch runs from GPS_read when an epoch ends)
         printf("\n%s", result);
+    }
+    FixLog_poll(&fixLog); // Writes a full page to flash while the module is quiet
 
-        // Display parsed GPS data (date, latitude, longitude, speed)
-        printf("Date: %d-%d-%d\n", GPS_year(&gps), GPS_month(&gps), GPS_day(&gps));
-        printf("Latitude %f\n", GPS_latitude(&gps));
-        printf("Longitude %f\n", GPS_longitude(&gps));
-        printf("Speed %f\n", GPS_speed(&gps));
+    // A readout prints one batch per pass; fixes logged meanwhile are read in the next one
+    if (getchar_timeout_us(0) == 'd' && !dumping)
+    {
+        FixLog_flush(&fixLog);
+        FixLog_open(&fixLog, &dump);
+        dumping = true;
+        printf("\nFix log (date,time,latitude,longitude,altitude,satellites,valid):\n");
+    }
+    if (dumping)
+    {
+        FixLogEntry entries[DUMP_BATCH];
+        size_t count = FixLog_read(&dump, entries, DUMP_BATCH);
+        for (size_t i = 0; i < count; i++)
+        {
+            printf("%06lu,%09lu,%ld,%ld,%ld,%u,%u\n", (unsigned long)entries[i].date,
+                   (unsigned long)entries[i].utc_time, (long)entries[i].latitude, (long)entries[i].longitude,
+                   (long)entries[i].altitude, entries[i].satellites, entries[i].valid);
+        }
+        if (count == 0)
+        {
+            FixLogStats stats;
+            FixLog_stats(&fixLog, &stats);
+            printf("End of fix log (%lu corrupt pages; %lu fixes, %lu bytes logged since boot)\n",
+                   (unsigned long)dump.corrupt, (unsigned long)stats.fixes, (unsigned long)stats.bytes);
+            dumping = false;
+        }
+        return; // No sleep until the readout is done
     }
+    GPS_idle(&gps); // Sleep until the next character (the 5 s fix interval leaves the core idle most of the time)
 }
 
 /**
@@ -116,6 +179,7 @@ int main()
     while (true)
     {
         loop(); // Continuously call the loop function to process GPS data
+        TRACE_POLL();
     }
     return 0; // Return 0 (although this line is never reached)
 }
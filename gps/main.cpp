@@ -1,5 +1,7 @@
 #include "GPS.h"
 #include "../nmea/nmea_parser.h"
+#include "../nmea/nmea_output.h"
+#include "trace.h"
 
 #include <stdio.h>
 #include <pico/stdlib.h>
@@ -19,9 +21,58 @@ UART port:
 #define TXD2RX 3 // GPS TXD (module transmit) -> SPI0 RX (microcontroller receive)
 #define RXD2TX 4 // GPS RXD (module receive)  -> SPI0 TX (microcontroller transmit)
 
+// Set to 1 to send every fix as a binary frame (decode them with frames.py) instead of printing it
+#ifndef NMEA_BINARY_OUTPUT
+#define NMEA_BINARY_OUTPUT 0
+#endif
+
 // Declare a global pointer to the GPS object
 GPS *gps;
 
+#if NMEA_BINARY_OUTPUT
+NMEAOutput output;
+
+/**
+ * @brief Queues the fix of every completed epoch as a frame; the main loop writes the batch.
+ */
+class EpochSender : public GPSListener
+{
+public:
+    void onEpoch(GPS &gps, const NMEAFix &fix) override
+    {
+        NMEAOutput_fix(&output, &fix);
+    }
+};
+
+EpochSender epochListener;
+#else
+
+/**
+ * @brief Prints the fix of every completed epoch (date, latitude, longitude, speed).
+ */
+class EpochPrinter : public GPSListener
+{
+public:
+    void onEpoch(GPS &gps, const NMEAFix &fix) override
+    {
+        printf("Date: %lu-%lu-%lu\n", (unsigned long)(fix.date % 100 + gps.start_year),
+               (unsigned long)(fix.date / 100 % 100), (unsigned long)(fix.date / 10000));
+        printf("Latitude %f\n", (double)fix.latitude / NMEA_DEGREES_SCALE);
+        printf("Longitude %f\n", (double)fix.longitude / NMEA_DEGREES_SCALE);
+        printf("Speed %f\n", (double)fix.speed / NMEA_SPEED_SCALE);
+
+        GPSPowerStats power = gps.powerStats();
+        if (power.fixes != 0)
+        {
+            printf("Awake %lu us of %lu us (%lu%% on average)\n", (unsigned long)power.awake_us,
+                   (unsigned long)power.period_us, (unsigned long)(power.awake_total_us * 100 / power.period_total_us));
+        }
+    }
+};
+
+EpochPrinter epochListener;
+#endif
+
 /**
  * @brief Setup function for initializing the GPS module.
  *
@@ -38,46 +89,39 @@ void setup()
     sleep_ms(100); // Short delay to ensure proper USB connection
 
     // Initialize the GPS object with default intervals for sentence output
-    gps = new GPS(DEFAULT_INTERVALS()); // By default: .GSA = false and .GSV = false
+    gps = new GPS(DEFAULT_INTERVALS()); // By default: .GSA = 0 and .GSV = 0
     gps->init(TXD2RX, RXD2TX);          // Initialize GPS with RX and TX pin configurations
+    printf("GPS baud rate: %lu\n", gps->detectBaud()); // The module keeps the rate it was last set to
+    gps->setBaud(115200);                               // Leaves more of every second idle at 1 Hz and above
     gps->setDelay(5);                   // Set the GPS update delay to 5 seconds (200 millihertz).
                                         // For optimal performance, it's recommended to use a delay of 1 second (1 Hz) or higher.
+#if NMEA_BINARY_OUTPUT
+    NMEAOutput_init(&output);
+#endif
+    gps->addListener(&epochListener, NMEA_EVENT_EPOCH);
+    TRACE_INIT(); // Stage timing, printed every RP_PICO_TRACE_PRINT_S seconds when built with RP_PICO_TRACE=1
     printf("GPS Module Initialized.\n");
 }
 
-unsigned long lastTime = 0;          // Variable to store the last time the GPS state was toggled
+unsigned long lastTime = 0;          // Variable to store the last time the GPS module was suspended
 unsigned long pauseInterval = 10000; // Interval for pausing the GPS module (10 seconds)
-bool isPaused = false;               // Flag to track whether the GPS module is in paused state
 
 /**
  * @brief Main loop function to read and display GPS data.
  *
- * The loop checks if it's time to pause or wake up the GPS module based on the interval,
- * reads the GPS data, and prints the results (latitude, longitude, speed, etc.) to the console.
+ * The loop suspends the GPS module and the core every other interval, reads the GPS data and prints
+ * the raw sentences, then sleeps until the next ones arrive; epochListener prints the parsed results.
  */
 void loop()
 {
     // Get current time in milliseconds
     unsigned long currentTime = time_us_32() / 1000;
 
-    // Check if the time to toggle the GPS state has elapsed
+    // Check if the time to pause the GPS module has elapsed
     if (currentTime - lastTime >= pauseInterval)
     {
-        // Toggle the GPS state between standby and wakeup
-        if (isPaused)
-        {
-            gps->wakeup(); // Wake up the GPS module
-        }
-        else
-        {
-            gps->standby(); // Put the GPS module into standby mode
-        }
-
-        // Toggle the paused state
-        isPaused = !isPaused;
-
-        // Update the last time with the current time
-        lastTime = currentTime;
+        gps->suspend(pauseInterval); // Standby mode, the core sleeps too, then both wake up
+        lastTime = time_us_32() / 1000;
     }
 
     // Read and process GPS data if available
@@ -90,15 +134,15 @@ void loop()
             continue;
         }
 
-        // Print the raw NMEA sentence
+#if !NMEA_BINARY_OUTPUT
+        // Print the raw NMEA sentence (epochListener runs from read() when an epoch ends)
         printf("\n%s", result);
-
-        // Display parsed GPS data (date, latitude, longitude, speed)
-        printf("Date: %d-%d-%d\n", gps->year(), gps->month(), gps->day());
-        printf("Latitude %f\n", gps->latitude());
-        printf("Longitude %f\n", gps->longitude());
-        printf("Speed %f\n", gps->speed());
+#endif
     }
+#if NMEA_BINARY_OUTPUT
+    NMEAOutput_flush(&output); // One USB write for everything queued during this pass
+#endif
+    gps->idle(); // Sleep until the next character (the 5 s fix interval leaves the core idle most of the time)
 }
 
 /**
@@ -116,6 +160,7 @@ int main()
     while (true)
     {
         loop(); // Continuously call the loop function to process GPS data
+        TRACE_POLL();
     }
     return 0; // Return 0 (although this line is never reached)
 }
@@ -0,0 +1,71 @@
+#include "StaticGPS.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <pico/stdlib.h>
+
+// Pin assignments for GPS
+#define TXD2RX 3 // GPS TXD (module transmit) -> SPI0 RX (microcontroller receive)
+#define RXD2TX 4 // GPS RXD (module receive)  -> SPI0 TX (microcontroller transmit)
+
+// Position and date from RMC, altitude and satellites from GGA, over a 115200 baud link
+StaticGPS<Sentences::RMC | Sentences::GGA, Baud::k115200> gps;
+
+/**
+ * @brief Prints the fix of every completed epoch.
+ */
+void printEpoch(NMEAParser *parser, uint32_t event, void *ctx)
+{
+    (void)parser, (void)event, (void)ctx;
+    NMEAFix fix = gps.fix();
+    printf("Date: %06lu Time: %09lu\n", (unsigned long)fix.date, (unsigned long)fix.utc_time);
+    printf("Latitude %f Longitude %f\n", (double)fix.latitude / NMEA_DEGREES_SCALE,
+           (double)fix.longitude / NMEA_DEGREES_SCALE);
+    printf("Altitude %f Satellites %u\n", (double)fix.altitude / NMEA_ALTITUDE_SCALE, fix.satellites);
+}
+
+/**
+ * @brief Sets up the serial interface and the GPS module.
+ */
+void setup()
+{
+    stdio_init_all();
+    while (!stdio_usb_connected())
+    {
+        tight_loop_contents(); // Wait for USB serial connection to be ready
+    }
+    sleep_ms(100);
+
+    gps.init(TXD2RX, RXD2TX);
+    printf("GPS baud rate: %lu\n", gps.detectBaud()); // Moved to 115200 if it was elsewhere
+    gps.on(NMEA_EVENT_EPOCH, printEpoch, NULL);
+    TRACE_INIT(); // Stage timing, printed every RP_PICO_TRACE_PRINT_S seconds when built with RP_PICO_TRACE=1
+    printf("GPS Module Initialized: %s\n", gps.OUTPUT_COMMAND.text);
+}
+
+/**
+ * @brief Reads every available sentence; printEpoch prints the parsed results.
+ */
+void loop()
+{
+    while (gps.isAvailable())
+    {
+        char *result = gps.read();
+        if (result == NULL)
+        {
+            continue;
+        }
+        printf("\n%s", result);
+    }
+}
+
+int main()
+{
+    setup();
+    while (true)
+    {
+        loop();
+        TRACE_POLL();
+    }
+    return 0;
+}
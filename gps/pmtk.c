@@ -0,0 +1,317 @@
+#include "pmtk.h"
+
+/**
+ * @brief Appends one character to a command and to its checksum.
+ */
+static void _put(PMTKCommand *command, char c)
+{
+    if (command->length < PMTK_MAX_LENGTH - 4) // Room for "*HH" and the terminator
+    {
+        command->text[command->length++] = c;
+        command->checksum ^= (uint8_t)c;
+    }
+}
+
+/**
+ * @brief Appends the decimal digits of a value.
+ */
+static void _putNumber(PMTKCommand *command, uint32_t value)
+{
+    char digits[10];
+    int count = 0;
+    do
+    {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+    while (count > 0)
+    {
+        _put(command, digits[--count]);
+    }
+}
+
+/**
+ * @brief Starts a command of the given packet type ("$PMTKnnn").
+ * @param command - The command to build.
+ * @param type - The packet type, e.g. PMTK_SET_POS_FIX.
+ */
+void PMTKCommand_begin(PMTKCommand *command, uint16_t type)
+{
+    command->text[0] = '$';
+    command->length = 1;
+    command->checksum = 0; // The '$' is not part of the checksum
+    _put(command, 'P');
+    _put(command, 'M');
+    _put(command, 'T');
+    _put(command, 'K');
+    _put(command, '0' + type / 100 % 10);
+    _put(command, '0' + type / 10 % 10);
+    _put(command, '0' + type % 10);
+}
+
+/**
+ * @brief Appends a numeric field (",value").
+ * @param command - The command being built.
+ * @param value - The field value.
+ */
+void PMTKCommand_add(PMTKCommand *command, uint32_t value)
+{
+    _put(command, ',');
+    _putNumber(command, value);
+}
+
+/**
+ * @brief Appends a signed fixed-point field (",-12.345").
+ * @param command - The command being built.
+ * @param value - The field value times 10^decimals.
+ * @param decimals - Digits after the decimal point (0 for an integer).
+ */
+void PMTKCommand_addDecimal(PMTKCommand *command, int32_t value, uint8_t decimals)
+{
+    uint32_t magnitude = value < 0 ? -(uint32_t)value : (uint32_t)value;
+    uint32_t scale = 1;
+    for (uint8_t i = 0; i < decimals; i++)
+    {
+        scale *= 10;
+    }
+    _put(command, ',');
+    if (value < 0)
+    {
+        _put(command, '-');
+    }
+    _putNumber(command, magnitude / scale);
+    if (decimals > 0)
+    {
+        _put(command, '.');
+        for (uint32_t digit = scale / 10; digit > 0; digit /= 10)
+        {
+            _put(command, '0' + magnitude / digit % 10);
+        }
+    }
+}
+
+/**
+ * @brief Appends a UTC date and time as ",YYYY,MM,DD,hh,mm,ss" (the aiding commands).
+ */
+static void _putTime(PMTKCommand *command, uint32_t date, uint32_t utc_time)
+{
+    PMTKCommand_add(command, 2000 + date % 100);
+    PMTKCommand_add(command, date / 100 % 100);
+    PMTKCommand_add(command, date / 10000);
+    PMTKCommand_add(command, utc_time / 10000000);
+    PMTKCommand_add(command, utc_time / 100000 % 100);
+    PMTKCommand_add(command, utc_time / 1000 % 100);
+}
+
+/**
+ * @brief Appends the checksum ("*HH") and terminates the command.
+ * @param command - The command being built.
+ * @return The command string, stored in `command`.
+ */
+const char *PMTKCommand_end(PMTKCommand *command)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    command->text[command->length++] = '*';
+    command->text[command->length++] = hex[command->checksum >> 4];
+    command->text[command->length++] = hex[command->checksum & 15];
+    command->text[command->length] = '\0';
+    return command->text;
+}
+
+/**
+ * @brief Builds a fix interval command.
+ * @param command - The command to build.
+ * @param interval - The fix interval in milliseconds (100 to 10000).
+ * @return The command string, stored in `command`.
+ * @see 3.13. Packet Type: 220 PMTK_SET_POS_FIX
+ */
+const char *PMTKCommand_fixInterval(PMTKCommand *command, uint16_t interval)
+{
+    PMTKCommand_begin(command, PMTK_SET_POS_FIX);
+    PMTKCommand_add(command, interval);
+    return PMTKCommand_end(command);
+}
+
+/**
+ * @brief Builds a baud rate command for the NMEA port.
+ * @param command - The command to build.
+ * @param baud - The new baud rate (4800 to 115200).
+ * @return The command string, stored in `command`.
+ * @see 3.17. Packet Type: 251 PMTK_SET_NMEA_BAUDRATE
+ */
+const char *PMTKCommand_baudRate(PMTKCommand *command, uint32_t baud)
+{
+    PMTKCommand_begin(command, PMTK_SET_NMEA_BAUDRATE);
+    PMTKCommand_add(command, baud);
+    return PMTKCommand_end(command);
+}
+
+/**
+ * @brief Builds a periodic power saving mode command.
+ * @param command - The command to build.
+ * @param mode - The operation mode; PMTK_PERIODIC_NORMAL ignores the durations.
+ * @param run - Time the module runs and outputs fixes, in milliseconds (1000 to 518400000).
+ * @param sleep - Time the module sleeps afterwards, in milliseconds (1000 to 518400000).
+ *                The same durations are sent for the cycles without a fix.
+ * @return The command string, stored in `command`.
+ * @see Packet Type: 225 PMTK_SET_PERIODIC_MODE
+ */
+const char *PMTKCommand_periodic(PMTKCommand *command, PMTKPeriodicMode mode, uint32_t run, uint32_t sleep)
+{
+    PMTKCommand_begin(command, PMTK_SET_PERIODIC_MODE);
+    PMTKCommand_add(command, mode);
+    if (mode != PMTK_PERIODIC_NORMAL)
+    {
+        PMTKCommand_add(command, run);
+        PMTKCommand_add(command, sleep);
+        PMTKCommand_add(command, run);
+        PMTKCommand_add(command, sleep);
+    }
+    return PMTKCommand_end(command);
+}
+
+/**
+ * @brief Builds a sentence output command.
+ * @param command - The command to build.
+ * @param rates - Rate of every sentence in PMTKOutput order: 0 disables it, N outputs it once
+ *                every N fixes (clamped to PMTK_OUTPUT_MAX_RATE).
+ * @return The command string, stored in `command`.
+ * @see 3.23. Packet Type: 314 PMTK_API_SET_NMEA_OUTPUT
+ */
+const char *PMTKCommand_output(PMTKCommand *command, const uint8_t rates[PMTK_OUTPUT_COUNT])
+{
+    PMTKCommand_begin(command, PMTK_SET_NMEA_OUTPUT);
+    for (int i = 0; i < PMTK_OUTPUT_FIELDS; i++)
+    {
+        uint8_t rate = i < PMTK_OUTPUT_COUNT ? rates[i] : 0;
+        PMTKCommand_add(command, rate < PMTK_OUTPUT_MAX_RATE ? rate : PMTK_OUTPUT_MAX_RATE);
+    }
+    return PMTKCommand_end(command);
+}
+
+/**
+ * @brief Builds a time aiding command, so the module does not have to find the time from the satellites.
+ * @param command - The command to build.
+ * @param date - The current UTC date as ddmmyy (see `NMEAFix.date`).
+ * @param utc_time - The current UTC time as hhmmss * 1000 + milliseconds (the milliseconds are dropped).
+ * @return The command string, stored in `command`.
+ * @see Packet Type: 740 PMTK_DT_UTC
+ */
+const char *PMTKCommand_timeAid(PMTKCommand *command, uint32_t date, uint32_t utc_time)
+{
+    PMTKCommand_begin(command, PMTK_SET_TIME_AID);
+    _putTime(command, date, utc_time);
+    return PMTKCommand_end(command);
+}
+
+/**
+ * @brief Builds a position and time aiding command (reference location for the satellite search).
+ * @param command - The command to build.
+ * @param latitude - Degrees * 10^7, negative south (sent with 6 decimals).
+ * @param longitude - Degrees * 10^7, negative west (sent with 6 decimals).
+ * @param altitude - Meters * 100 (sent in whole meters).
+ * @param date - The current UTC date as ddmmyy.
+ * @param utc_time - The current UTC time as hhmmss * 1000 + milliseconds.
+ * @return The command string, stored in `command`.
+ * @see Packet Type: 741 PMTK_DT_POS
+ */
+const char *PMTKCommand_positionAid(PMTKCommand *command, int32_t latitude, int32_t longitude, int32_t altitude,
+                                    uint32_t date, uint32_t utc_time)
+{
+    PMTKCommand_begin(command, PMTK_SET_POSITION_AID);
+    PMTKCommand_addDecimal(command, latitude / 10, 6);
+    PMTKCommand_addDecimal(command, longitude / 10, 6);
+    PMTKCommand_addDecimal(command, altitude / 100, 0);
+    _putTime(command, date, utc_time);
+    return PMTKCommand_end(command);
+}
+
+/**
+ * @brief Clears the acknowledgement table.
+ * @param acks - The table.
+ */
+void PMTKAcks_init(PMTKAcks *acks)
+{
+    for (int i = 0; i < PMTK_ACKS; i++)
+    {
+        acks->acks[i].command = 0;
+        acks->acks[i].status = PMTK_ACK_NONE;
+    }
+    acks->next = 0;
+}
+
+/**
+ * @brief Returns the entry of a packet type, or -1 if it is not tracked.
+ */
+static int _find(const PMTKAcks *acks, uint16_t command)
+{
+    for (int i = 0; i < PMTK_ACKS; i++)
+    {
+        if (acks->acks[i].status != PMTK_ACK_NONE && acks->acks[i].command == command)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Marks a command as waiting for its acknowledgement.
+ *
+ * Strings that are not PMTK commands are ignored, so every line written to the module can be passed.
+ *
+ * @param acks - The table.
+ * @param command - The command string that was sent ("$PMTKnnn...").
+ */
+void PMTKAcks_sent(PMTKAcks *acks, const char *command)
+{
+    if (command[0] != '$' || command[1] != 'P' || command[2] != 'M' || command[3] != 'T' || command[4] != 'K')
+    {
+        return;
+    }
+    uint16_t type = 0;
+    for (int i = 5; i < 8; i++)
+    {
+        if (command[i] < '0' || command[i] > '9')
+        {
+            return;
+        }
+        type = type * 10 + (command[i] - '0');
+    }
+
+    int entry = _find(acks, type);
+    if (entry < 0)
+    {
+        entry = acks->next;
+        acks->next = (acks->next + 1) % PMTK_ACKS;
+    }
+    acks->acks[entry].command = type;
+    acks->acks[entry].status = PMTK_ACK_PENDING;
+}
+
+/**
+ * @brief Records a $PMTK001 reply.
+ * @param acks - The table.
+ * @param command - The acknowledged packet type.
+ * @param flag - The reply flag (PMTK_ACK_INVALID to PMTK_ACK_SUCCESS).
+ */
+void PMTKAcks_receive(PMTKAcks *acks, uint16_t command, uint8_t flag)
+{
+    int entry = _find(acks, command);
+    if (entry >= 0 && flag <= PMTK_ACK_SUCCESS)
+    {
+        acks->acks[entry].status = flag;
+    }
+}
+
+/**
+ * @brief Returns the state of the last command of a packet type.
+ * @param acks - The table.
+ * @param command - The packet type, e.g. PMTK_SET_NMEA_OUTPUT.
+ * @return PMTK_ACK_PENDING until the module replied, then the reply flag; PMTK_ACK_NONE if not tracked.
+ */
+PMTKAckStatus PMTKAcks_status(const PMTKAcks *acks, uint16_t command)
+{
+    int entry = _find(acks, command);
+    return entry < 0 ? PMTK_ACK_NONE : (PMTKAckStatus)acks->acks[entry].status;
+}
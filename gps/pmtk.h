@@ -0,0 +1,229 @@
+#ifndef PMTK_H
+#define PMTK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// https://www.dragino.com/downloads/downloads/datasheet/other_vendors/L80/Quectel_L80_GPS_Protocol_Specification_V1.3.pdf
+
+// Constant commands, checksums included (verified at compile time by any C++ translation unit, see below)
+#define PMTK_TEST "$PMTK000*32"               // 3.1. Packet Type: 000 PMTK_TEST (replied with $PMTK001,0,3)
+#define PMTK_STANDBY "$PMTK161,0*28"          // 3.8. Packet Type: 161 PMTK_CMD_STANDBY_MODE
+#define PMTK_RESPONSE "$PMTK001,314,3*36\r\n" // Default response for setting the NMEA output (3.23. Packet Type: 314)
+
+// Packet types of the parameterized commands
+#define PMTK_SET_POS_FIX 220       // 3.13. Fix interval in milliseconds
+#define PMTK_SET_PERIODIC_MODE 225 // Periodic power saving modes
+#define PMTK_SET_NMEA_BAUDRATE 251 // 3.17. Baud rate of the NMEA port
+#define PMTK_SET_NMEA_OUTPUT 314   // 3.23. Output rate of every sentence type
+#define PMTK_SET_EPO_DATA 721      // One satellite record of MTK EPO (extended prediction orbit) data
+#define PMTK_SET_TIME_AID 740      // UTC time aiding
+#define PMTK_SET_POSITION_AID 741  // Reference position and UTC time aiding
+
+#define PMTK_MAX_LENGTH 64     // Longest command built at run time, with "*HH" and the terminator
+#define PMTK_OUTPUT_FIELDS 19  // Fields of a PMTK314 command
+#define PMTK_OUTPUT_MAX_RATE 5 // Highest PMTK314 rate (once every 5 fixes)
+#define PMTK_ACKS 4            // Commands whose acknowledgement is tracked at the same time
+#define PMTK_MIN_FIX_INTERVAL 100   // Shortest PMTK220 fix interval in milliseconds (10 Hz)
+#define PMTK_MAX_FIX_INTERVAL 10000 // Longest PMTK220 fix interval in milliseconds (0.1 Hz)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Sentences of a PMTK314 command, in field order; the remaining fields are always sent as 0
+    typedef enum
+    {
+        PMTK_OUTPUT_GLL,
+        PMTK_OUTPUT_RMC,
+        PMTK_OUTPUT_VTG,
+        PMTK_OUTPUT_GGA,
+        PMTK_OUTPUT_GSA,
+        PMTK_OUTPUT_GSV,
+        PMTK_OUTPUT_COUNT
+    } PMTKOutput;
+
+    // Operation modes of PMTK225
+    typedef enum
+    {
+        PMTK_PERIODIC_NORMAL = 0,           // Full power, a fix every interval
+        PMTK_PERIODIC_BACKUP = 1,           // Run, then backup mode (wakes on its own)
+        PMTK_PERIODIC_STANDBY = 2,          // Run, then standby mode (wakes on its own)
+        PMTK_PERIODIC_PERPETUAL_BACKUP = 4, // Backup until woken through the FORCE_ON pin
+        PMTK_PERIODIC_ALWAYSLOCATE_STANDBY = 8,
+        PMTK_PERIODIC_ALWAYSLOCATE_BACKUP = 9
+    } PMTKPeriodicMode;
+
+    // State of a command sent to the module; the first four values are the flags of $PMTK001
+    typedef enum
+    {
+        PMTK_ACK_INVALID = 0,     // The module rejected the packet
+        PMTK_ACK_UNSUPPORTED = 1, // The module does not know the command
+        PMTK_ACK_FAILED = 2,      // Valid command, but the action failed
+        PMTK_ACK_SUCCESS = 3,     // Valid command, action succeeded
+        PMTK_ACK_PENDING,         // Sent, no reply yet
+        PMTK_ACK_NONE             // Not sent since tracking started (or its slot was reused)
+    } PMTKAckStatus;
+
+    /**
+     * @brief A command built at run time without any allocation or formatting call.
+     *        The checksum is accumulated while the fields are appended.
+     */
+    typedef struct
+    {
+        char text[PMTK_MAX_LENGTH]; /**< "$PMTKnnn,...*HH", null-terminated once ended. */
+        uint8_t length;             /**< Characters written so far. */
+        uint8_t checksum;           /**< XOR of the characters between '$' and '*'. */
+    } PMTKCommand;
+
+    /**
+     * @brief Latest acknowledgement state of recently sent commands, one entry per packet type.
+     */
+    typedef struct
+    {
+        struct
+        {
+            uint16_t command; /**< Packet type. */
+            uint8_t status;   /**< PMTKAckStatus. */
+        } acks[PMTK_ACKS];
+        uint8_t next; /**< Entry reused by the next new packet type. */
+    } PMTKAcks;
+
+    void PMTKCommand_begin(PMTKCommand *command, uint16_t type);
+    void PMTKCommand_add(PMTKCommand *command, uint32_t value);
+    void PMTKCommand_addDecimal(PMTKCommand *command, int32_t value, uint8_t decimals);
+    const char *PMTKCommand_end(PMTKCommand *command);
+    const char *PMTKCommand_fixInterval(PMTKCommand *command, uint16_t interval);
+    const char *PMTKCommand_baudRate(PMTKCommand *command, uint32_t baud);
+    const char *PMTKCommand_periodic(PMTKCommand *command, PMTKPeriodicMode mode, uint32_t run, uint32_t sleep);
+    const char *PMTKCommand_output(PMTKCommand *command, const uint8_t rates[PMTK_OUTPUT_COUNT]);
+    const char *PMTKCommand_timeAid(PMTKCommand *command, uint32_t date, uint32_t utc_time);
+    const char *PMTKCommand_positionAid(PMTKCommand *command, int32_t latitude, int32_t longitude, int32_t altitude,
+                                        uint32_t date, uint32_t utc_time);
+
+    void PMTKAcks_init(PMTKAcks *acks);
+    void PMTKAcks_sent(PMTKAcks *acks, const char *command);
+    void PMTKAcks_receive(PMTKAcks *acks, uint16_t command, uint8_t flag);
+    PMTKAckStatus PMTKAcks_status(const PMTKAcks *acks, uint16_t command);
+
+#ifdef __cplusplus
+}
+
+/**
+ * @brief A constant command built by the compiler from its body, e.g. `PMTK_constant("PMTK161,0")`.
+ */
+template <size_t N>
+struct PMTKConstant
+{
+    char text[N + 4]; /**< '$', the N - 1 characters of the body, "*HH" and the terminator. */
+};
+
+/**
+ * @brief XOR checksum of the characters of a command body.
+ */
+constexpr uint8_t PMTK_checksum(const char *body, size_t length)
+{
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        checksum ^= (uint8_t)body[i];
+    }
+    return checksum;
+}
+
+/**
+ * @brief Upper-case hex digit of a nibble.
+ */
+constexpr char PMTK_hex(uint8_t nibble)
+{
+    return "0123456789ABCDEF"[nibble & 15];
+}
+
+/**
+ * @brief Builds "$<body>*HH" at compile time.
+ */
+template <size_t N>
+constexpr PMTKConstant<N> PMTK_constant(const char (&body)[N])
+{
+    PMTKConstant<N> command{};
+    uint8_t checksum = PMTK_checksum(body, N - 1);
+    command.text[0] = '$';
+    for (size_t i = 0; i < N - 1; i++)
+    {
+        command.text[1 + i] = body[i];
+    }
+    command.text[N] = '*';
+    command.text[N + 1] = PMTK_hex(checksum >> 4);
+    command.text[N + 2] = PMTK_hex(checksum);
+    command.text[N + 3] = '\0';
+    return command;
+}
+
+// Characters of a PMTK314 body: "PMTK314" and ",r" per field
+constexpr size_t PMTK_OUTPUT_BODY = 7 + 2 * PMTK_OUTPUT_FIELDS;
+
+/**
+ * @brief Builds the PMTK314 command of a set of output rates at compile time (see `PMTKCommand_output`).
+ */
+constexpr PMTKConstant<PMTK_OUTPUT_BODY + 1> PMTK_outputConstant(const uint8_t (&rates)[PMTK_OUTPUT_COUNT])
+{
+    char body[PMTK_OUTPUT_BODY + 1] = {'P', 'M', 'T', 'K', '3', '1', '4'};
+    for (size_t i = 0; i < PMTK_OUTPUT_FIELDS; i++)
+    {
+        uint8_t rate = i < PMTK_OUTPUT_COUNT ? rates[i] : 0;
+        body[7 + 2 * i] = ',';
+        body[8 + 2 * i] = (char)('0' + (rate < PMTK_OUTPUT_MAX_RATE ? rate : PMTK_OUTPUT_MAX_RATE));
+    }
+    return PMTK_constant(body);
+}
+
+/**
+ * @brief Number of decimal digits of a value.
+ */
+constexpr size_t PMTK_digits(uint32_t value)
+{
+    size_t digits = 1;
+    for (; value >= 10; value /= 10)
+    {
+        digits++;
+    }
+    return digits;
+}
+
+/**
+ * @brief Builds the PMTK251 command of a baud rate at compile time (see `PMTKCommand_baudRate`).
+ */
+template <uint32_t Baud>
+constexpr PMTKConstant<9 + PMTK_digits(Baud)> PMTK_baudConstant()
+{
+    char body[9 + PMTK_digits(Baud)] = {'P', 'M', 'T', 'K', '2', '5', '1', ','};
+    uint32_t value = Baud;
+    for (size_t i = PMTK_digits(Baud); i > 0; i--, value /= 10)
+    {
+        body[7 + i] = (char)('0' + value % 10);
+    }
+    return PMTK_constant(body);
+}
+
+/**
+ * @brief Checks the checksum of a complete "$...*HH" command or reply.
+ */
+constexpr bool PMTK_valid(const char *command)
+{
+    size_t star = 1;
+    while (command[star] != '\0' && command[star] != '*')
+    {
+        star++;
+    }
+    uint8_t checksum = PMTK_checksum(command + 1, star - 1);
+    return command[0] == '$' && command[star] == '*' && command[star + 1] == PMTK_hex(checksum >> 4) &&
+           command[star + 2] == PMTK_hex(checksum);
+}
+
+static_assert(PMTK_valid(PMTK_TEST), "PMTK_TEST checksum");
+static_assert(PMTK_valid(PMTK_STANDBY), "PMTK_STANDBY checksum");
+static_assert(PMTK_valid(PMTK_RESPONSE), "PMTK_RESPONSE checksum");
+#endif
+
+#endif // PMTK_H
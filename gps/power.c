@@ -0,0 +1,250 @@
+#include "power.h"
+#include <hardware/sync.h>
+#include <pico/time.h>
+
+// Sentence events that belong to a burst ($PMTK001 replies can arrive at any time)
+#define GPS_POWER_EVENTS ((NMEA_SENTENCES_ALL & ~NMEA_SENTENCE_BIT(NMEA_SENTENCE_ACK)) | NMEA_EVENT_EPOCH)
+
+/**
+ * @brief Sends a command to the module, tracking its acknowledgement like `GPS_write`.
+ */
+static void _send(GPSPower *power, const char *command)
+{
+    if (power->acks != NULL)
+    {
+        PMTKAcks_sent(power->acks, command);
+    }
+    UartTx_println(power->parser->uart_tx, command);
+}
+
+/**
+ * @brief Follows the bursts of sentences and measures the awake time of every fix period.
+ */
+static void _onEvent(NMEAParser *parser, uint32_t event, void *ctx)
+{
+    (void)parser;
+    GPSPower *power = (GPSPower *)ctx;
+    if (event == NMEA_EVENT_EPOCH)
+    {
+        uint32_t now = time_us_32();
+        if (power->measuring)
+        {
+            uint32_t period = now - power->epoch_us;
+            uint32_t slept = power->slept_us < period ? power->slept_us : period;
+            power->stats.period_us = period;
+            power->stats.awake_us = period - slept;
+            power->stats.period_total_us += period;
+            power->stats.awake_total_us += period - slept;
+            power->stats.fixes++;
+        }
+        power->measuring = true;
+        power->epoch_us = now;
+        power->slept_us = 0;
+        power->in_burst = false;
+        return;
+    }
+
+    if (!power->in_burst)
+    {
+        uint32_t now = time_us_32() / 1000;
+        // A periodic run window starts with the first burst after the module slept
+        if (power->run != 0 && (!power->scheduled || now - power->burst_start > 2u * power->interval))
+        {
+            power->run_start = now;
+        }
+        power->burst_start = now;
+        power->in_burst = true;
+        power->scheduled = true;
+    }
+}
+
+/**
+ * @brief Alarm callback: the interrupt itself ends `__wfi`.
+ */
+static int64_t _wake(alarm_id_t id, void *ctx)
+{
+    (void)id, (void)ctx;
+    return 0; // Do not reschedule
+}
+
+/**
+ * @brief Returns when the next burst is due, in milliseconds since boot, but never in the past.
+ */
+static uint32_t _nextBurst(const GPSPower *power, uint32_t now)
+{
+    uint32_t next = power->burst_start + power->interval;
+    if (power->run != 0 && next - power->run_start >= power->run)
+    {
+        next = power->run_start + power->run + power->sleep; // The module sleeps until the next window
+    }
+    if ((int32_t)(next - GPS_POWER_GUARD_MS - now) <= 0)
+    {
+        next += ((now + GPS_POWER_GUARD_MS - next) / power->interval + 1) * power->interval; // Late: look again
+    }
+    return next;
+}
+
+/**
+ * @brief Starts managing the power of a module.
+ *
+ * @param power Pointer to the GPSPower structure.
+ * @param parser Parser of the module (initialized).
+ * @param acks Acknowledgement table the commands are tracked in, or NULL.
+ * @param interval The fix interval in milliseconds (1000 unless changed with PMTK220); 0 counts as 1.
+ *
+ * @return Returns `NMEA_PARSER_SUCCESS` (0), or `NMEA_PARSER_ERROR_LISTENERS_FULL` (2).
+ */
+int GPSPower_init(GPSPower *power, NMEAParser *parser, PMTKAcks *acks, uint16_t interval)
+{
+    memset(power, 0, sizeof(GPSPower));
+    power->parser = parser;
+    power->acks = acks;
+    power->interval = interval > 0 ? interval : 1; // The burst schedule divides by it
+    return NMEAParser_on(parser, GPS_POWER_EVENTS, _onEvent, power);
+}
+
+/**
+ * @brief Stops managing the power of a module.
+ *
+ * @param power Pointer to the GPSPower structure.
+ */
+void GPSPower_free(GPSPower *power)
+{
+    NMEAParser_off(power->parser, _onEvent, power);
+}
+
+/**
+ * @brief Tells the manager the fix interval sent to the module (PMTK220).
+ *
+ * @param power Pointer to the GPSPower structure.
+ * @param interval The fix interval in milliseconds; 0 counts as 1.
+ */
+void GPSPower_setInterval(GPSPower *power, uint16_t interval)
+{
+    power->interval = interval > 0 ? interval : 1; // The burst schedule divides by it
+}
+
+/**
+ * @brief Switches the module to a periodic power saving mode, or back to normal mode.
+ *
+ * In the periodic standby and backup modes the module runs for `run` milliseconds and then
+ * sleeps for `sleep` milliseconds on its own; the core sleeps through the whole sleep window.
+ *
+ * @param power Pointer to the GPSPower structure.
+ * @param mode The operation mode.
+ * @param run Run time in milliseconds (ignored in normal mode).
+ * @param sleep Sleep time in milliseconds (ignored in normal mode).
+ * @see Packet Type: 225 PMTK_SET_PERIODIC_MODE
+ */
+void GPSPower_periodic(GPSPower *power, PMTKPeriodicMode mode, uint32_t run, uint32_t sleep)
+{
+    PMTKCommand command;
+    _send(power, PMTKCommand_periodic(&command, mode, run, sleep));
+
+    // Only the self-timed modes have a known schedule; the others wake on the RX interrupt alone
+    bool timed = mode == PMTK_PERIODIC_BACKUP || mode == PMTK_PERIODIC_STANDBY;
+    power->run = timed ? run : 0;
+    power->sleep = timed ? sleep : 0;
+    power->scheduled = false;
+}
+
+/**
+ * @brief Sleeps the core until there is something to read.
+ *
+ * Call it from the main loop once everything available has been read. Returns at the latest
+ * shortly before the next burst is due, when the current epoch times out, or on any other
+ * interrupt (e.g. USB), and at once if a character is already waiting.
+ *
+ * @param power Pointer to the GPSPower structure.
+ */
+void GPSPower_idle(GPSPower *power)
+{
+    NMEAParser *parser = power->parser;
+    UartRx *rx = parser->uart_rx;
+    uint32_t now = time_us_32() / 1000;
+    int64_t delay = -1; // No timer: the RX interrupt ends the sleep
+
+    if (rx->dma_chan >= 0)
+    {
+        // No interrupt per character: wake before the burst, and during it before the DMA ring wraps
+        if (power->scheduled && !power->in_burst)
+        {
+            delay = (int64_t)(_nextBurst(power, now) - GPS_POWER_GUARD_MS - now) * 1000;
+        }
+        else
+        {
+            delay = (int64_t)rx->dma_size * (1 + parser->pico->bits + parser->pico->stop) * 1000000 /
+                    parser->pico->baud / 2;
+        }
+    }
+    if (parser->epoch.state == NMEA_EPOCH_OPEN)
+    {
+        // The parser commits a silent epoch from NMEAParser_available only
+        int64_t expire = (int64_t)(int32_t)(parser->epoch.updated + NMEA_EPOCH_TIMEOUT_MS - now) * 1000;
+        expire = expire < 0 ? 0 : expire; // Overdue: return at once so the reader commits it
+        delay = delay < 0 || expire < delay ? expire : delay;
+    }
+
+    alarm_id_t alarm = 0;
+    if (delay >= 0)
+    {
+        if (delay < GPS_POWER_MIN_SLEEP_US)
+        {
+            return;
+        }
+        alarm = add_alarm_in_us(delay, _wake, NULL, false);
+        if (alarm <= 0)
+        {
+            return; // No alarm, nothing would wake the core in time
+        }
+    }
+
+    uint32_t start = time_us_32();
+    uint32_t status = save_and_disable_interrupts();
+    if (UartRx_available(rx) == 0)
+    {
+        __wfi(); // A pending interrupt ends __wfi even while masked; it runs once they are restored
+    }
+    restore_interrupts(status);
+    if (alarm > 0)
+    {
+        cancel_alarm(alarm);
+    }
+    power->slept_us += time_us_32() - start;
+}
+
+/**
+ * @brief Puts the module in standby mode and sleeps the core for a while, then wakes both.
+ *
+ * The module keeps its ephemeris in standby mode, so the first fix after waking is a hot start.
+ * The schedule is learned again from the next burst.
+ *
+ * @param power Pointer to the GPSPower structure.
+ * @param ms Time to stay in standby mode in milliseconds.
+ * @see 3.8. Packet Type: 161 PMTK_CMD_STANDBY_MODE
+ */
+void GPSPower_suspend(GPSPower *power, uint32_t ms)
+{
+    _send(power, PMTK_STANDBY);
+    UartTx_flush(power->parser->uart_tx);
+
+    uint32_t start = time_us_32();
+    sleep_ms(ms); // Waits for a timer event
+    power->slept_us += time_us_32() - start;
+
+    UartRx_clear(power->parser->uart_rx); // Whatever arrived while the module went down
+    _send(power, PMTK_TEST);              // Any character wakes the module; the test packet is acknowledged
+    power->in_burst = false;
+    power->scheduled = false;
+}
+
+/**
+ * @brief Copies the measured duty cycle.
+ *
+ * @param power Pointer to the GPSPower structure.
+ * @param stats Receives the statistics.
+ */
+void GPSPower_stats(const GPSPower *power, GPSPowerStats *stats)
+{
+    *stats = power->stats;
+}
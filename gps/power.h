@@ -0,0 +1,73 @@
+#ifndef GPS_POWER_H
+#define GPS_POWER_H
+
+#include "nmea_parser.h"
+#include "pmtk.h"
+
+// Time the core wakes before the next burst of sentences is due (milliseconds)
+#ifndef GPS_POWER_GUARD_MS
+#define GPS_POWER_GUARD_MS 20
+#endif
+
+// Shortest sleep worth arming a timer for (microseconds)
+#define GPS_POWER_MIN_SLEEP_US 200
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Measured duty cycle of the core.
+     *
+     * A fix period runs from one committed epoch to the next; the core is awake whenever it is
+     * not inside `GPSPower_idle` or `GPSPower_suspend`.
+     */
+    typedef struct
+    {
+        uint32_t awake_us;        /**< Time awake during the last fix period. */
+        uint32_t period_us;       /**< Length of the last fix period. */
+        uint64_t awake_total_us;  /**< Time awake during every fix period. */
+        uint64_t period_total_us; /**< Length of every fix period. */
+        uint32_t fixes;           /**< Fix periods measured. */
+    } GPSPowerStats;
+
+    /**
+     * @brief Sleeps the core between the bursts of sentences of a GPS module.
+     *
+     * The epochs of the parser tell when a burst ends, and the fix interval (PMTK220) and the
+     * periodic mode (PMTK225) tell when the next one is due. In between, the core waits in
+     * `__wfi`: in IRQ receive mode the first character of the next burst wakes it; in DMA receive
+     * mode, which raises no interrupt per character, a timer wakes it shortly before the burst
+     * and before the DMA ring can wrap.
+     */
+    typedef struct
+    {
+        NMEAParser *parser;   /**< Parser of the module. */
+        PMTKAcks *acks;       /**< Acknowledgements of the commands sent, or NULL. */
+        uint16_t interval;    /**< Fix interval in milliseconds. */
+        uint32_t run;         /**< Run time of the periodic mode in milliseconds (0: normal mode). */
+        uint32_t sleep;       /**< Sleep time of the periodic mode in milliseconds. */
+        bool scheduled;       /**< True once a burst has been seen since the last change of mode. */
+        bool in_burst;        /**< True from the first sentence of an epoch until it is committed. */
+        uint32_t burst_start; /**< Time of the first sentence of the last burst (milliseconds). */
+        uint32_t run_start;   /**< Time of the first burst of the current run window (milliseconds). */
+        bool measuring;       /**< True once an epoch has been committed. */
+        uint32_t epoch_us;    /**< Time the last epoch was committed (microseconds). */
+        uint32_t slept_us;    /**< Time slept since then. */
+        GPSPowerStats stats;  /**< Measured duty cycle. */
+    } GPSPower;
+
+    int GPSPower_init(GPSPower *power, NMEAParser *parser, PMTKAcks *acks, uint16_t interval);
+    void GPSPower_free(GPSPower *power);
+    void GPSPower_setInterval(GPSPower *power, uint16_t interval);
+    void GPSPower_periodic(GPSPower *power, PMTKPeriodicMode mode, uint32_t run, uint32_t sleep);
+    void GPSPower_idle(GPSPower *power);
+    void GPSPower_suspend(GPSPower *power, uint32_t ms);
+    void GPSPower_stats(const GPSPower *power, GPSPowerStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GPS_POWER_H
@@ -0,0 +1,235 @@
+#include "rate.h"
+#include <string.h>
+
+#define GPS_RATE_CHAR_BITS 10 // Start, 8 data and stop bits of the module's 8N1 port
+
+// Typical longest sentence of every type, CR LF included, in PMTKOutput order (GSV: 3 sentences for 12 satellites)
+static const uint16_t gps_rate_bytes[PMTK_OUTPUT_COUNT] = {51, 70, 42, 74, 66, 210};
+
+// Baud rates of PMTK251, slowest first
+static const uint32_t gps_rate_bauds[] = {9600, 19200, 38400, 57600, 115200};
+
+// Sentences that may be shed, first shed first
+static const uint8_t gps_rate_shed[] = {PMTK_OUTPUT_GSV, PMTK_OUTPUT_GLL, PMTK_OUTPUT_GSA, PMTK_OUTPUT_VTG};
+#define GPS_RATE_SHED_COUNT (sizeof(gps_rate_shed) / sizeof(gps_rate_shed[0]))
+
+/**
+ * @brief Returns true if the sentences of an epoch take at most GPS_RATE_LOAD_PERCENT of the fix interval at a baud rate.
+ */
+static bool _fits(const uint8_t rates[PMTK_OUTPUT_COUNT], uint16_t interval, uint32_t baud)
+{
+    uint64_t bits = (uint64_t)GPSRate_epochBytes(rates) * GPS_RATE_CHAR_BITS * 1000 * 100;
+    return bits <= (uint64_t)baud * interval * GPS_RATE_LOAD_PERCENT;
+}
+
+/**
+ * @brief Sheds one step: doubles the divisor of the first sentence still output, or disables it.
+ *
+ * @return False if only RMC and GGA are left.
+ */
+static bool _shed(uint8_t rates[PMTK_OUTPUT_COUNT])
+{
+    for (size_t i = 0; i < GPS_RATE_SHED_COUNT; i++)
+    {
+        uint8_t *rate = &rates[gps_rate_shed[i]];
+        if (*rate != 0)
+        {
+            *rate = *rate * 2 > PMTK_OUTPUT_MAX_RATE ? 0 : *rate * 2;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Undoes one shed step, last shed sentence first, if the link budget allows it.
+ *
+ * @return False if nothing was shed or the step does not fit.
+ */
+static bool _restore(GPSRate *rate)
+{
+    for (size_t i = GPS_RATE_SHED_COUNT; i-- > 0;)
+    {
+        uint8_t type = gps_rate_shed[i];
+        if (rate->rates[type] == rate->requested[type])
+        {
+            continue;
+        }
+        uint8_t rates[PMTK_OUTPUT_COUNT];
+        memcpy(rates, rate->rates, sizeof(rates));
+        uint8_t next = rates[type] == 0 ? 4 : rates[type] / 2;
+        rates[type] = next < rate->requested[type] ? rate->requested[type] : next;
+        if (!_fits(rates, rate->interval, rate->baud))
+        {
+            return false;
+        }
+        memcpy(rate->rates, rates, sizeof(rates));
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Sheds sentences until an epoch fits the link at a baud rate, or only RMC and GGA are left.
+ */
+static void _fit(GPSRate *rate)
+{
+    while (!_fits(rate->rates, rate->interval, rate->baud) && _shed(rate->rates))
+    {
+    }
+    rate->stats.epoch_bytes = GPSRate_epochBytes(rate->rates);
+}
+
+/**
+ * @brief Estimates the bytes an epoch takes on the link, averaged over the PMTK314 divisors.
+ *
+ * @param rates Rate of every sentence in PMTKOutput order (0: disabled, N: once every N fixes).
+ * @return Bytes per epoch, rounded up.
+ */
+uint32_t GPSRate_epochBytes(const uint8_t rates[PMTK_OUTPUT_COUNT])
+{
+    uint32_t bytes = 0;
+    for (int i = 0; i < PMTK_OUTPUT_COUNT; i++)
+    {
+        if (rates[i] != 0)
+        {
+            bytes += (gps_rate_bytes[i] + rates[i] - 1) / rates[i];
+        }
+    }
+    return bytes;
+}
+
+/**
+ * @brief Plans a high-rate profile and starts the throttling.
+ *
+ * Picks the slowest baud rate up to `max_baud` at which the requested sentences fit the link
+ * budget; if none does, sheds sentences at `max_baud` until they fit. The caller sends the
+ * resulting `rates` (PMTK314), `baud` (PMTK251) and the fix interval (PMTK220), in that order,
+ * so the module never outputs more than the current baud rate carries (see `GPS_setHighRate`).
+ *
+ * @param rate Pointer to the GPSRate structure.
+ * @param rx The receiver of the module, whose overflow counters are watched from now on.
+ * @param interval The fix interval in milliseconds (100 for 10 Hz).
+ * @param requested Rate of every sentence in PMTKOutput order.
+ * @param max_baud Highest baud rate to use (at most GPS_RATE_MAX_BAUD).
+ * @return The baud rate picked.
+ */
+uint32_t GPSRate_plan(GPSRate *rate, UartRx *rx, uint16_t interval, const uint8_t requested[PMTK_OUTPUT_COUNT],
+                      uint32_t max_baud)
+{
+    memset(rate, 0, sizeof(GPSRate));
+    rate->overflows = rx->ring.overflows + rx->dma_overflows;
+    memcpy(rate->requested, requested, sizeof(rate->requested));
+    memcpy(rate->rates, requested, sizeof(rate->rates));
+    rate->interval = interval;
+    rate->baud = gps_rate_bauds[0];
+    for (size_t i = 0; i < sizeof(gps_rate_bauds) / sizeof(gps_rate_bauds[0]) && gps_rate_bauds[i] <= max_baud; i++)
+    {
+        rate->baud = gps_rate_bauds[i];
+        if (_fits(requested, interval, rate->baud))
+        {
+            break;
+        }
+    }
+    _fit(rate);
+    rate->cooldown = GPS_RATE_COOLDOWN_EPOCHS;
+    rate->active = true;
+    return rate->baud;
+}
+
+/**
+ * @brief Changes the requested rates of an active profile, keeping its baud rate and interval.
+ *
+ * The rates are shed again if they do not fit; send `rates` to the module afterwards.
+ *
+ * @param rate Pointer to the GPSRate structure.
+ * @param requested Rate of every sentence in PMTKOutput order.
+ */
+void GPSRate_request(GPSRate *rate, const uint8_t requested[PMTK_OUTPUT_COUNT])
+{
+    memcpy(rate->requested, requested, sizeof(rate->requested));
+    memcpy(rate->rates, requested, sizeof(rate->rates));
+    _fit(rate);
+    rate->quiet = 0;
+    rate->cooldown = GPS_RATE_COOLDOWN_EPOCHS;
+}
+
+/**
+ * @brief Samples the occupancy of the receive ring; call it before every read.
+ *
+ * @param rate Pointer to the GPSRate structure.
+ * @param rx The receiver of the module.
+ */
+void GPSRate_sample(GPSRate *rate, UartRx *rx)
+{
+    uint8_t fill = RingBuffer_available(&rx->ring) * 100 / RingBuffer_capacity(&rx->ring);
+    if (fill > rate->peak)
+    {
+        rate->peak = fill;
+    }
+}
+
+/**
+ * @brief Checks the backpressure of the last epoch and sheds or restores one step.
+ *
+ * @param rate Pointer to the GPSRate structure.
+ * @param rx The receiver of the module.
+ * @return True if `rates` changed and must be sent to the module (PMTK314).
+ */
+bool GPSRate_epoch(GPSRate *rate, UartRx *rx)
+{
+    uint32_t overflows = rx->ring.overflows + rx->dma_overflows;
+    bool lost = overflows != rate->overflows;
+    rate->stats.overflows += overflows - rate->overflows;
+    rate->overflows = overflows;
+    uint8_t peak = rate->peak;
+    rate->peak = 0;
+    if (peak > rate->stats.peak)
+    {
+        rate->stats.peak = peak;
+    }
+
+    if (!rate->active)
+    {
+        return false;
+    }
+    if (rate->cooldown > 0)
+    {
+        rate->cooldown--;
+        return false;
+    }
+    bool changed = false;
+    if (lost || peak >= GPS_RATE_HIGH_PERCENT)
+    {
+        rate->quiet = 0;
+        changed = _shed(rate->rates);
+        rate->stats.sheds += changed;
+    }
+    else if (peak < GPS_RATE_LOW_PERCENT && ++rate->quiet >= GPS_RATE_RESTORE_EPOCHS)
+    {
+        rate->quiet = 0;
+        changed = _restore(rate);
+        rate->stats.restores += changed;
+    }
+    else if (peak >= GPS_RATE_LOW_PERCENT)
+    {
+        rate->quiet = 0;
+    }
+    if (changed)
+    {
+        rate->cooldown = GPS_RATE_COOLDOWN_EPOCHS;
+        rate->stats.epoch_bytes = GPSRate_epochBytes(rate->rates);
+    }
+    return changed;
+}
+
+/**
+ * @brief Copies the counters.
+ *
+ * @param rate Pointer to the GPSRate structure.
+ * @param stats Receives the counters.
+ */
+void GPSRate_stats(const GPSRate *rate, GPSRateStats *stats)
+{
+    *stats = rate->stats;
+}
@@ -0,0 +1,89 @@
+#ifndef GPS_RATE_H
+#define GPS_RATE_H
+
+#include "pmtk.h"
+#include "../uart/uart_rx.h"
+
+// Share of the link an epoch's sentences may take, so every burst ends well before the next fix (percent)
+#ifndef GPS_RATE_LOAD_PERCENT
+#define GPS_RATE_LOAD_PERCENT 50
+#endif
+
+// Receive ring occupancy that sheds a sentence, and below which shed sentences come back (percent)
+#ifndef GPS_RATE_HIGH_PERCENT
+#define GPS_RATE_HIGH_PERCENT 75
+#endif
+#ifndef GPS_RATE_LOW_PERCENT
+#define GPS_RATE_LOW_PERCENT 25
+#endif
+
+// Quiet epochs before one shed step is undone
+#ifndef GPS_RATE_RESTORE_EPOCHS
+#define GPS_RATE_RESTORE_EPOCHS 100
+#endif
+
+// Epochs after a change during which no other change is made (the module applies PMTK314 from the next fix)
+#define GPS_RATE_COOLDOWN_EPOCHS 5
+
+// Highest baud rate of the module (3.17. Packet Type: 251)
+#define GPS_RATE_MAX_BAUD 115200
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Counters of the sentence throttling.
+     */
+    typedef struct
+    {
+        uint32_t sheds;       /**< Times a sentence was slowed down or disabled. */
+        uint32_t restores;    /**< Times a shed sentence was sped up again. */
+        uint32_t overflows;   /**< Characters or samples lost while the profile was active. */
+        uint8_t peak;         /**< Highest ring occupancy seen at a read (percent). */
+        uint32_t epoch_bytes; /**< Estimated bytes per epoch at the current rates. */
+    } GPSRateStats;
+
+    /**
+     * @brief High-rate profile: link budget planning and backpressure-aware sentence throttling.
+     *
+     * `GPSRate_plan` works out the bytes per epoch of the enabled sentences from their typical
+     * lengths and the PMTK314 divisors, then picks the lowest baud rate at which an epoch takes
+     * at most GPS_RATE_LOAD_PERCENT of the fix interval. If even GPS_RATE_MAX_BAUD is too slow,
+     * low-priority sentences are shed in the order GSV, GLL, GSA, VTG: their divisor is doubled
+     * (1, 2, 4), then they are disabled. RMC and GGA are never shed.
+     *
+     * While the profile runs, the occupancy of the receive ring is sampled at every read
+     * (`GPSRate_sample`) and checked at every epoch with the overflow counters
+     * (`GPSRate_epoch`): a lost character or an occupancy of GPS_RATE_HIGH_PERCENT sheds one step
+     * before more data is lost, and GPS_RATE_RESTORE_EPOCHS epochs below GPS_RATE_LOW_PERCENT undo
+     * one step if the link budget allows it.
+     */
+    typedef struct
+    {
+        bool active;                          /**< True once `GPSRate_plan` ran: throttling is on. */
+        uint8_t requested[PMTK_OUTPUT_COUNT]; /**< Rates asked for, in PMTKOutput order. */
+        uint8_t rates[PMTK_OUTPUT_COUNT];     /**< Rates sent to the module. */
+        uint16_t interval;                    /**< Fix interval in milliseconds. */
+        uint32_t baud;                        /**< Baud rate picked by the plan. */
+        uint32_t overflows;                   /**< Overflow counters of the receiver at the last epoch. */
+        uint8_t peak;                         /**< Ring occupancy since the last epoch (percent). */
+        uint16_t quiet;                       /**< Epochs in a row below GPS_RATE_LOW_PERCENT. */
+        uint8_t cooldown;                     /**< Epochs left before the next change. */
+        GPSRateStats stats;                   /**< Counters. */
+    } GPSRate;
+
+    uint32_t GPSRate_epochBytes(const uint8_t rates[PMTK_OUTPUT_COUNT]);
+    uint32_t GPSRate_plan(GPSRate *rate, UartRx *rx, uint16_t interval, const uint8_t requested[PMTK_OUTPUT_COUNT],
+                          uint32_t max_baud);
+    void GPSRate_request(GPSRate *rate, const uint8_t requested[PMTK_OUTPUT_COUNT]);
+    void GPSRate_sample(GPSRate *rate, UartRx *rx);
+    bool GPSRate_epoch(GPSRate *rate, UartRx *rx);
+    void GPSRate_stats(const GPSRate *rate, GPSRateStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GPS_RATE_H
@@ -0,0 +1,518 @@
+#include "startup.h"
+#include "flash_record.h"
+#include "trace.h"
+#include <string.h>
+#include <pico/time.h>
+
+#define GPS_STARTUP_PAGES (FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE) // Saves between two erases
+#define GPS_STARTUP_SAFE_TIMEOUT_MS 10                          // Longest wait for the other core to pause
+#define GPS_STARTUP_GPS_2000 630720000u                         // GPS time (1980-01-06) of 2000-01-01, in seconds
+#define GPS_STARTUP_LEAP_SECONDS 18                             // GPS time minus UTC since 2017
+#define GPS_STARTUP_EPO_LINE 192                                // "$PMTK721,SS", 18 words, "*HH\r\n"
+
+/**
+ * @brief Returns the contents of a page of the state sector, through the XIP window.
+ */
+static const uint8_t *_flash(uint8_t page)
+{
+    return FlashRecord_at(GPS_STARTUP_FLASH_OFFSET + page * FLASH_PAGE_SIZE);
+}
+
+/**
+ * @brief Decodes the saved state of a page.
+ *
+ * @return True if the page holds a valid state; `state` and `sequence` then receive it.
+ */
+static bool _load(uint8_t page, GPSStartupState *state, uint32_t *sequence)
+{
+    const uint8_t *record = _flash(page);
+    if (FlashRecord_get32(record) != GPS_STARTUP_MAGIC || record[28] != GPS_STARTUP_VERSION ||
+        FlashRecord_get16(record + 30) != FlashRecord_crc16(record, GPS_STARTUP_RECORD - 2))
+    {
+        return false;
+    }
+    *sequence = FlashRecord_get32(record + 4);
+    state->utc = FlashRecord_get32(record + 8);
+    state->latitude = (int32_t)FlashRecord_get32(record + 12);
+    state->longitude = (int32_t)FlashRecord_get32(record + 16);
+    state->altitude = (int32_t)FlashRecord_get32(record + 20);
+    state->epo_end = FlashRecord_get32(record + 24);
+    return true;
+}
+
+/**
+ * @brief Returns true if the record area of a page is erased, so it can be programmed.
+ */
+static bool _erased(uint8_t page)
+{
+    const uint8_t *record = _flash(page);
+    for (int i = 0; i < GPS_STARTUP_RECORD; i++)
+    {
+        if (record[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Erases the state sector (`data` NULL) or programs one of its pages.
+ *
+ * @return True on success.
+ */
+static bool _write(GPSStartup *startup, uint8_t page, const uint8_t *data)
+{
+    if (!FlashRecord_write(GPS_STARTUP_FLASH_OFFSET + page * FLASH_PAGE_SIZE, data, GPS_STARTUP_SAFE_TIMEOUT_MS))
+    {
+        startup->stats.failures++;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Converts a UTC time in seconds since 2000-01-01 to a date (ddmmyy) and a time (hhmmss * 1000).
+ */
+static void _civil(uint32_t seconds, uint32_t *date, uint32_t *utc_time)
+{
+    // Days since 0000-03-01 in eras of 400 years (H. Hinnant's civil_from_days)
+    uint32_t days = seconds / 86400 + 730425;
+    uint32_t era = days / 146097;
+    uint32_t doe = days - era * 146097;
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    uint32_t day = doy - (153 * mp + 2) / 5 + 1;
+    uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+    uint32_t year = yoe + era * 400 + (month <= 2);
+
+    uint32_t time = seconds % 86400;
+    *date = day * 10000 + month * 100 + year % 100;
+    *utc_time = (time / 3600 * 10000 + time / 60 % 60 * 100 + time % 60) * 1000;
+}
+
+/**
+ * @brief Starts measuring the time to first fix of a start.
+ */
+static void _start(GPSStartup *startup, GPSStartKind kind)
+{
+    startup->stats.kind = kind;
+    startup->stats.ttff_ms = 0;
+    startup->start_ms = time_us_32() / 1000;
+    startup->starting = true;
+}
+
+/**
+ * @brief Sends a command to the module, tracking its acknowledgement like `GPS_write`.
+ */
+static void _send(GPSStartup *startup, const char *command)
+{
+    if (startup->acks != NULL)
+    {
+        PMTKAcks_sent(startup->acks, command);
+    }
+    UartTx_println(startup->tx, command);
+}
+
+/**
+ * @brief Returns true if an EPO record holds no orbit (satellite missing from the file).
+ */
+static bool _epoEmpty(const uint8_t *record)
+{
+    for (int i = 0; i < GPS_STARTUP_EPO_RECORD; i++)
+    {
+        if (record[i] != 0x00 && record[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the start of the validity of an EPO record in UTC seconds since 2000 (0 if earlier).
+ *
+ * The first 3 bytes of a record are the GPS hour its segment starts at.
+ */
+static uint32_t _epoStart(const uint8_t *record)
+{
+    uint32_t gps = (record[0] | (uint32_t)record[1] << 8 | (uint32_t)record[2] << 16) * 3600;
+    return gps > GPS_STARTUP_GPS_2000 + GPS_STARTUP_LEAP_SECONDS ? gps - GPS_STARTUP_GPS_2000 - GPS_STARTUP_LEAP_SECONDS
+                                                               : 0;
+}
+
+/**
+ * @brief Queues the next EPO record that holds an orbit, or ends the upload after the last one.
+ *
+ * The record goes out as "$PMTK721,<satellite>,<W0>,...,<W17>*HH": its 18 little-endian words
+ * in hex. It is queued on the transmitter (asynchronous in DMA transmit mode) and the next one
+ * only follows its $PMTK001,721,3, so the module's receive buffer never overflows.
+ */
+static void _epoSend(GPSStartup *startup)
+{
+    while (startup->epo_next < startup->epo_count &&
+           _epoEmpty(startup->epo + startup->epo_next * GPS_STARTUP_EPO_RECORD))
+    {
+        startup->epo_next++;
+    }
+    if (startup->epo_next == startup->epo_count)
+    {
+        startup->epo = NULL;
+        startup->state.epo_end = startup->epo_end;
+        startup->dirty = true;
+        return;
+    }
+
+    static const char hex[] = "0123456789ABCDEF";
+    const uint8_t *record = startup->epo + startup->epo_next * GPS_STARTUP_EPO_RECORD;
+    uint8_t satellite = startup->epo_next % GPS_STARTUP_EPO_SATELLITES + 1;
+    char line[GPS_STARTUP_EPO_LINE];
+    memcpy(line, "$PMTK721,", 9);
+    size_t length = 9;
+    line[length++] = hex[satellite >> 4];
+    line[length++] = hex[satellite & 15];
+    for (int word = 0; word < GPS_STARTUP_EPO_RECORD / 4; word++)
+    {
+        uint32_t value = FlashRecord_get32(record + word * 4);
+        line[length++] = ',';
+        for (int shift = 28; shift >= 0; shift -= 4)
+        {
+            line[length++] = hex[(value >> shift) & 15];
+        }
+    }
+    uint8_t checksum = 0;
+    for (size_t i = 1; i < length; i++)
+    {
+        checksum ^= (uint8_t)line[i];
+    }
+    line[length++] = '*';
+    line[length++] = hex[checksum >> 4];
+    line[length++] = hex[checksum & 15];
+    line[length] = '\0';
+
+    _send(startup, line);
+    startup->epo_sent_ms = time_us_32() / 1000;
+}
+
+/**
+ * @brief Sends the waiting EPO record again, or gives up on the upload after GPS_STARTUP_EPO_RETRIES.
+ */
+static void _epoRetry(GPSStartup *startup)
+{
+    if (startup->epo_retries++ == GPS_STARTUP_EPO_RETRIES)
+    {
+        startup->epo = NULL; // The EPO data in the module is left as it is
+        return;
+    }
+    startup->stats.epo_retry++;
+    _epoSend(startup);
+}
+
+/**
+ * @brief Starts the startup accelerator and loads the state saved in flash.
+ *
+ * The time to first fix is measured from here as a cold start until `GPSStartup_aid` or
+ * `GPSStartup_wakeup` restarts it.
+ *
+ * @param startup Pointer to the GPSStartup structure.
+ * @param tx Transmitter of the module (activated).
+ * @param acks Acknowledgement table the commands are tracked in, or NULL.
+ */
+void GPSStartup_init(GPSStartup *startup, UartTx *tx, PMTKAcks *acks)
+{
+    memset(startup, 0, sizeof(GPSStartup));
+    startup->tx = tx;
+    startup->acks = acks;
+
+    bool found = false;
+    for (uint8_t page = 0; page < GPS_STARTUP_PAGES; page++)
+    {
+        GPSStartupState state;
+        uint32_t sequence;
+        if (_load(page, &state, &sequence) && (!found || (int32_t)(sequence - startup->sequence) > 0))
+        {
+            found = true;
+            startup->state = state;
+            startup->sequence = sequence;
+            startup->page = page + 1;
+        }
+    }
+    startup->saved = startup->state;
+    _start(startup, GPS_START_COLD);
+}
+
+/**
+ * @brief Aids the module after power-on with the current time and the last known position.
+ *
+ * Sends PMTK740 (time), then PMTK741 (position and time) if the position is not older than
+ * GPS_STARTUP_POSITION_AGE_S, and restarts the time to first fix as an aided start. Without a
+ * time, nothing is sent and the start is measured as a cold one.
+ *
+ * @param startup Pointer to the GPSStartup structure.
+ * @param utc Current UTC in seconds since 2000-01-01 (see `GPSStartup_seconds`), e.g. from an
+ *            RTC or the host, or 0 to use `GPSStartup_utc` (known once a fix of this boot was seen).
+ * @return True if the module was aided.
+ * @see Packet Types: 740 PMTK_DT_UTC, 741 PMTK_DT_POS
+ */
+bool GPSStartup_aid(GPSStartup *startup, uint32_t utc)
+{
+    if (utc == 0)
+    {
+        utc = GPSStartup_utc(startup);
+    }
+    if (utc == 0)
+    {
+        _start(startup, GPS_START_COLD);
+        return false;
+    }
+
+    uint32_t date;
+    uint32_t utc_time;
+    _civil(utc, &date, &utc_time);
+    PMTKCommand command;
+    _send(startup, PMTKCommand_timeAid(&command, date, utc_time));
+    const GPSStartupState *state = &startup->state;
+    if (state->utc != 0 && utc >= state->utc && utc - state->utc <= GPS_STARTUP_POSITION_AGE_S)
+    {
+        _send(startup, PMTKCommand_positionAid(&command, state->latitude, state->longitude, state->altitude, date,
+                                               utc_time));
+    }
+    startup->stats.aided++;
+    _start(startup, GPS_START_AIDED);
+    return true;
+}
+
+/**
+ * @brief Restarts the time to first fix as a wakeup from standby (see `GPS_wakeup`, `GPS_suspend`).
+ *
+ * @param startup Pointer to the GPSStartup structure.
+ */
+void GPSStartup_wakeup(GPSStartup *startup)
+{
+    _start(startup, GPS_START_WAKEUP);
+}
+
+/**
+ * @brief Takes the fix of a committed epoch: records the time to first fix and the state to save.
+ *
+ * Also sends an unacknowledged EPO record again once GPS_STARTUP_EPO_TIMEOUT_MS have passed.
+ *
+ * @param startup Pointer to the GPSStartup structure.
+ * @param fix The fix, e.g. from NMEAParser_fix in an NMEA_EVENT_EPOCH listener.
+ */
+void GPSStartup_fix(GPSStartup *startup, const NMEAFix *fix)
+{
+    uint32_t now = time_us_32() / 1000;
+    if (startup->epo != NULL && now - startup->epo_sent_ms >= GPS_STARTUP_EPO_TIMEOUT_MS)
+    {
+        _epoRetry(startup);
+    }
+    if (!fix->valid || fix->date == 0)
+    {
+        return;
+    }
+
+    startup->state.utc = GPSStartup_seconds(fix->date, fix->utc_time);
+    startup->state.latitude = fix->latitude;
+    startup->state.longitude = fix->longitude;
+    startup->state.altitude = fix->altitude;
+    startup->state_ms = now - fix->utc_time % 1000;
+    startup->live = true;
+    startup->dirty = true;
+
+    if (startup->starting)
+    {
+        uint32_t ttff = now - startup->start_ms;
+        startup->starting = false;
+        startup->stats.ttff_ms = ttff != 0 ? ttff : 1;
+        startup->stats.starts++;
+        TRACE_SPAN((TraceSpan)(TRACE_SPAN_TTFF_COLD + startup->stats.kind), ttff);
+    }
+}
+
+/**
+ * @brief Takes a $PMTK001 reply: moves the EPO upload on once its record is acknowledged.
+ *
+ * @param startup Pointer to the GPSStartup structure.
+ * @param command The acknowledged packet type.
+ * @param flag The reply flag (PMTK_ACK_INVALID to PMTK_ACK_SUCCESS).
+ */
+void GPSStartup_ack(GPSStartup *startup, uint16_t command, uint8_t flag)
+{
+    if (command != PMTK_SET_EPO_DATA || startup->epo == NULL)
+    {
+        return;
+    }
+    if (flag == PMTK_ACK_SUCCESS)
+    {
+        startup->stats.epo_sent++;
+        startup->epo_next++;
+        startup->epo_retries = 0;
+        _epoSend(startup);
+    }
+    else if (flag == PMTK_ACK_UNSUPPORTED)
+    {
+        startup->epo = NULL; // No EPO support in this firmware
+    }
+    else
+    {
+        _epoRetry(startup);
+    }
+}
+
+/**
+ * @brief Saves the state to flash, e.g. before the module is put in standby or the power is cut.
+ *
+ * Nothing is written if the state did not change or if the last save is less than
+ * GPS_STARTUP_SAVE_S old (of UTC) with the same EPO data. Programming a page pauses the flash
+ * for about a millisecond (about 50 ms when the sector has to be erased first), so call it while
+ * the module is quiet, e.g. right after an epoch.
+ *
+ * @param startup Pointer to the GPSStartup structure.
+ * @return True if the state was written.
+ */
+bool GPSStartup_save(GPSStartup *startup)
+{
+    const GPSStartupState *state = &startup->state;
+    if (!startup->dirty || (startup->saved.utc != 0 && state->utc - startup->saved.utc < GPS_STARTUP_SAVE_S &&
+                            state->epo_end == startup->saved.epo_end))
+    {
+        return false;
+    }
+
+    if (startup->page == GPS_STARTUP_PAGES || !_erased(startup->page))
+    {
+        if (!_write(startup, 0, NULL))
+        {
+            return false;
+        }
+        startup->page = 0;
+    }
+
+    uint8_t data[FLASH_PAGE_SIZE];
+    memset(data, 0xFF, sizeof(data));
+    FlashRecord_put32(data, GPS_STARTUP_MAGIC);
+    FlashRecord_put32(data + 4, startup->sequence + 1);
+    FlashRecord_put32(data + 8, state->utc);
+    FlashRecord_put32(data + 12, (uint32_t)state->latitude);
+    FlashRecord_put32(data + 16, (uint32_t)state->longitude);
+    FlashRecord_put32(data + 20, (uint32_t)state->altitude);
+    FlashRecord_put32(data + 24, state->epo_end);
+    data[28] = GPS_STARTUP_VERSION;
+    FlashRecord_put16(data + 30, FlashRecord_crc16(data, GPS_STARTUP_RECORD - 2));
+    if (!_write(startup, startup->page, data))
+    {
+        return false;
+    }
+
+    startup->sequence++;
+    startup->page++;
+    startup->saved = *state;
+    startup->dirty = false;
+    startup->stats.saves++;
+    return true;
+}
+
+/**
+ * @brief Starts uploading MTK EPO data (e.g. MTK7d.EPO, stored in flash and read through XIP).
+ *
+ * The data are segments of 32 satellite records of 72 bytes, each valid for 6 hours. Segments
+ * that have already expired are skipped. The records are sent one at a time as the module
+ * acknowledges them (see `GPSStartup_ack`); aid the time first (`GPSStartup_aid`). Once the last
+ * record is acknowledged, the end of the uploaded validity is kept in `state.epo_end` and saved
+ * with the state, so the next boot can tell whether a new upload is needed.
+ *
+ * @param startup Pointer to the GPSStartup structure.
+ * @param data The EPO records; must stay readable until the upload ends.
+ * @param length Length of `data` in bytes.
+ * @param utc Current UTC in seconds since 2000-01-01, or 0 to use `GPSStartup_utc` (0 there too: nothing is skipped).
+ * @return The number of records to upload (0: nothing left, or no acknowledgement table to pace them).
+ */
+uint32_t GPSStartup_epo(GPSStartup *startup, const uint8_t *data, size_t length, uint32_t utc)
+{
+    const size_t segment = GPS_STARTUP_EPO_SATELLITES * GPS_STARTUP_EPO_RECORD;
+    const uint32_t validity = GPS_STARTUP_EPO_HOURS * 3600;
+    if (utc == 0)
+    {
+        utc = GPSStartup_utc(startup);
+    }
+    size_t first = 0;
+    while (first + segment <= length && utc != 0 && _epoStart(data + first) + validity <= utc)
+    {
+        first += segment;
+    }
+    uint32_t count = (length - first) / GPS_STARTUP_EPO_RECORD;
+    if (count == 0 || startup->acks == NULL)
+    {
+        startup->epo = NULL;
+        return 0;
+    }
+
+    startup->epo = data + first;
+    startup->epo_count = count;
+    startup->epo_next = 0;
+    startup->epo_retries = 0;
+    startup->epo_end = _epoStart(data + first + (count - 1) / GPS_STARTUP_EPO_SATELLITES * segment) + validity;
+    _epoSend(startup);
+    return count;
+}
+
+/**
+ * @brief Returns true while an EPO upload is running.
+ *
+ * @param startup Pointer to the GPSStartup structure.
+ */
+bool GPSStartup_uploading(const GPSStartup *startup)
+{
+    return startup->epo != NULL;
+}
+
+/**
+ * @brief Returns the current UTC, carried forward from the last fix of this boot by the system timer.
+ *
+ * @param startup Pointer to the GPSStartup structure.
+ * @return UTC in seconds since 2000-01-01, or 0 if no fix has been seen since boot.
+ */
+uint32_t GPSStartup_utc(const GPSStartup *startup)
+{
+    if (!startup->live)
+    {
+        return 0;
+    }
+    return startup->state.utc + (time_us_32() / 1000 - startup->state_ms) / 1000;
+}
+
+/**
+ * @brief Copies the counters.
+ *
+ * @param startup Pointer to the GPSStartup structure.
+ * @param stats Receives the counters.
+ */
+void GPSStartup_stats(const GPSStartup *startup, GPSStartupStats *stats)
+{
+    *stats = startup->stats;
+}
+
+/**
+ * @brief Converts a UTC date and time as found in `NMEAFix` to seconds since 2000-01-01.
+ *
+ * @param date Date as ddmmyy (years 2000 to 2099).
+ * @param utc_time Time as hhmmss * 1000 + milliseconds (the milliseconds are dropped).
+ * @return Seconds since 2000-01-01 00:00:00 UTC.
+ */
+uint32_t GPSStartup_seconds(uint32_t date, uint32_t utc_time)
+{
+    // Days since 0000-03-01 in eras of 400 years (H. Hinnant's days_from_civil), then since 2000-01-01
+    uint32_t day = date / 10000;
+    uint32_t month = date / 100 % 100;
+    uint32_t year = 2000 + date % 100 - (month <= 2);
+    uint32_t era = year / 400;
+    uint32_t yoe = year - era * 400;
+    uint32_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    uint32_t days = era * 146097 + doe - 730425;
+
+    uint32_t time = utc_time / 1000;
+    return days * 86400 + time / 10000 * 3600 + time / 100 % 100 * 60 + time % 100;
+}
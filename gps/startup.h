@@ -0,0 +1,135 @@
+#ifndef GPS_STARTUP_H
+#define GPS_STARTUP_H
+
+#include "fixlog.h"
+#include "pmtk.h"
+#include "../uart/uart_tx.h"
+
+// Flash offset of the sector holding the saved state (default: the sector just below the fix log)
+#ifndef GPS_STARTUP_FLASH_OFFSET
+#define GPS_STARTUP_FLASH_OFFSET (FIXLOG_FLASH_OFFSET - FLASH_SECTOR_SIZE)
+#endif
+
+// Shortest time between two saves of a changed state (seconds of UTC), which bounds the flash wear
+#ifndef GPS_STARTUP_SAVE_S
+#define GPS_STARTUP_SAVE_S 300
+#endif
+
+// Oldest saved position still sent as a reference position (seconds); older ones only aid the time
+#ifndef GPS_STARTUP_POSITION_AGE_S
+#define GPS_STARTUP_POSITION_AGE_S (7 * 86400)
+#endif
+
+// Time the module has to acknowledge an EPO record before it is sent again (milliseconds)
+#ifndef GPS_STARTUP_EPO_TIMEOUT_MS
+#define GPS_STARTUP_EPO_TIMEOUT_MS 2000
+#endif
+
+#define GPS_STARTUP_MAGIC 0x41545347u // "GSTA", first word of every saved state
+#define GPS_STARTUP_VERSION 1         // Layout of the saved state
+#define GPS_STARTUP_RECORD 32         // Bytes of a saved state, CRC-16 included (one per flash page)
+#define GPS_STARTUP_EPO_RECORD 72     // Bytes of an EPO satellite record
+#define GPS_STARTUP_EPO_SATELLITES 32 // Records of an EPO segment, one per GPS satellite
+#define GPS_STARTUP_EPO_HOURS 6       // Validity of an EPO segment
+#define GPS_STARTUP_EPO_RETRIES 3     // Times an unacknowledged or failed record is sent again
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // How the module was last started, i.e. which TTFF is being measured
+    typedef enum
+    {
+        GPS_START_COLD,   /**< Power-on without aiding. */
+        GPS_START_AIDED,  /**< Power-on with time and position aiding (PMTK740/741). */
+        GPS_START_WAKEUP, /**< Wakeup from standby, ephemeris kept by the module. */
+    } GPSStartKind;
+
+    /**
+     * @brief What a start needs to be fast, as saved in flash.
+     */
+    typedef struct
+    {
+        uint32_t utc;      /**< UTC of the last valid fix, in seconds since 2000-01-01 (0: none). */
+        int32_t latitude;  /**< Degrees * NMEA_DEGREES_SCALE, negative south. */
+        int32_t longitude; /**< Degrees * NMEA_DEGREES_SCALE, negative west. */
+        int32_t altitude;  /**< Meters * NMEA_ALTITUDE_SCALE. */
+        uint32_t epo_end;  /**< End of the EPO data last uploaded, in UTC seconds since 2000 (0: none). */
+    } GPSStartupState;
+
+    /**
+     * @brief Counters of the startup accelerator since `GPSStartup_init`.
+     */
+    typedef struct
+    {
+        uint8_t kind;       /**< GPSStartKind of the last start. */
+        uint32_t ttff_ms;   /**< Time to first fix of the last start (0 while it is still running). */
+        uint32_t starts;    /**< Starts measured. */
+        uint32_t aided;     /**< Starts aided with PMTK740/741. */
+        uint32_t epo_sent;  /**< EPO records acknowledged by the module. */
+        uint32_t epo_retry; /**< EPO records sent again after a timeout or a failure. */
+        uint32_t saves;     /**< States written to flash. */
+        uint32_t failures;  /**< Flash operations `flash_safe_execute` refused. */
+    } GPSStartupStats;
+
+    /**
+     * @brief Startup accelerator: hot-start state in flash, time and position aiding, EPO upload.
+     *
+     * The last valid fix is kept in RAM and saved to flash by `GPSStartup_save`, typically before
+     * the module is put in standby or the device is switched off. Each save programs the next page
+     * of one flash sector, which is only erased once all its pages are used, and at most one save
+     * per GPS_STARTUP_SAVE_S is written. After power-on, `GPSStartup_aid` sends the current time
+     * (PMTK740) and the saved position (PMTK741) so the module searches the satellites that are
+     * actually in view; `GPSStartup_epo` uploads MTK EPO orbit predictions one satellite record at
+     * a time, each acknowledged before the next is queued.
+     *
+     * The time to first fix of every start is measured from `GPSStartup_aid` or
+     * `GPSStartup_wakeup` to the first valid fix, kept in the statistics and recorded as a trace
+     * span (TRACE_SPAN_TTFF_COLD, _AIDED or _WAKEUP), so aided and unaided starts can be compared.
+     *
+     * `GPSStartup_fix` takes every committed fix and `GPSStartup_ack` every $PMTK001 reply; both
+     * run on the core that reads the parser, from its NMEA_EVENT_EPOCH and ACK listeners, where
+     * the next EPO record is queued. Nothing is locked, so `GPSStartup_save` and
+     * `GPSStartup_epo` belong to that core's main loop too; a save pauses the other core while the
+     * flash is programmed.
+     */
+    typedef struct
+    {
+        UartTx *tx;              /**< Transmitter of the module. */
+        PMTKAcks *acks;          /**< Acknowledgements of the commands sent, or NULL. */
+        GPSStartupState state;   /**< Latest state: the last fix of this boot, or the one loaded from flash. */
+        uint32_t state_ms;       /**< Time `state.utc` was current (ms since boot; only if `live`). */
+        bool live;               /**< True once a fix of this boot updated `state`. */
+        bool dirty;              /**< True while `state` differs from the saved one. */
+        GPSStartupState saved;   /**< State in flash. */
+        uint32_t sequence;       /**< Sequence number of the newest saved state. */
+        uint8_t page;            /**< Page of the sector the next save programs. */
+        uint32_t start_ms;       /**< Time the running start began (ms since boot). */
+        bool starting;           /**< True until the running start got its first valid fix. */
+        const uint8_t *epo;      /**< EPO records being uploaded, or NULL. */
+        uint32_t epo_next;       /**< Record sent and waiting for its acknowledgement. */
+        uint32_t epo_count;      /**< Records to upload. */
+        uint32_t epo_end;        /**< End of the validity of the uploaded segments (UTC seconds since 2000). */
+        uint32_t epo_sent_ms;    /**< Time the waiting record was sent (ms since boot). */
+        uint8_t epo_retries;     /**< Times the waiting record was sent again. */
+        GPSStartupStats stats;   /**< Counters. */
+    } GPSStartup;
+
+    void GPSStartup_init(GPSStartup *startup, UartTx *tx, PMTKAcks *acks);
+    bool GPSStartup_aid(GPSStartup *startup, uint32_t utc);
+    void GPSStartup_wakeup(GPSStartup *startup);
+    void GPSStartup_fix(GPSStartup *startup, const NMEAFix *fix);
+    void GPSStartup_ack(GPSStartup *startup, uint16_t command, uint8_t flag);
+    bool GPSStartup_save(GPSStartup *startup);
+    uint32_t GPSStartup_epo(GPSStartup *startup, const uint8_t *data, size_t length, uint32_t utc);
+    bool GPSStartup_uploading(const GPSStartup *startup);
+    uint32_t GPSStartup_utc(const GPSStartup *startup);
+    void GPSStartup_stats(const GPSStartup *startup, GPSStartupStats *stats);
+    uint32_t GPSStartup_seconds(uint32_t date, uint32_t utc_time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GPS_STARTUP_H
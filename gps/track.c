@@ -0,0 +1,266 @@
+#include "track.h"
+#include "gps_math.h"
+#include "pico/stdlib.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GPS_TRACK_MM_PER_UNIT 728728   // Millimeters per 1e-7 degree of a great circle (mean earth radius), Q16
+#define GPS_TRACK_KNOT_MM_S 514444     // Millimeters per second of a knot, * 1e6
+#define GPS_TRACK_US_Q32 4295          // 1e-6 * 2^32: microseconds to seconds, Q32
+#define GPS_TRACK_DAY_MS 86400000      // Wrap of the UTC time of day
+#define GPS_TRACK_MIN_HDOP 50          // Lowest HDOP trusted (0.5), the module reports 0.0 when unknown
+#define GPS_TRACK_UNKNOWN_HDOP 200     // HDOP used until a GGA sentence reported one (2.0)
+#define GPS_TRACK_DEGREES (360ll * NMEA_DEGREES_SCALE) // A turn of longitude
+
+/**
+ * @brief Difference of two longitudes, across the antimeridian if shorter.
+ */
+static int32_t _longitudeDelta(int64_t longitude, int32_t origin)
+{
+    int64_t delta = longitude - origin;
+    if (delta > GPS_TRACK_DEGREES / 2)
+    {
+        delta -= GPS_TRACK_DEGREES;
+    }
+    else if (delta < -GPS_TRACK_DEGREES / 2)
+    {
+        delta += GPS_TRACK_DEGREES;
+    }
+    return (int32_t)delta;
+}
+
+/**
+ * @brief Moves the origin of the local plane, with the length of a longitude unit there.
+ */
+static void _anchor(GPSTrack *track, int32_t latitude, int32_t longitude)
+{
+    track->latitude = latitude;
+    track->longitude = longitude;
+    track->north_mm = GPS_TRACK_MM_PER_UNIT;
+    float scale = cosf((float)latitude * (float)(M_PI / 180.0 / NMEA_DEGREES_SCALE));
+    track->east_mm = (int32_t)(GPS_TRACK_MM_PER_UNIT * (scale > 0.001f ? scale : 0.001f)); // Clamped at the poles
+}
+
+/**
+ * @brief Restarts an axis at a measured velocity, at the origin.
+ */
+static void _start(GPSTrackAxis *axis, int32_t velocity, int64_t position_variance, int64_t velocity_variance)
+{
+    axis->position = 0;
+    axis->velocity = velocity;
+    axis->pp = position_variance;
+    axis->pv = 0;
+    axis->vv = velocity_variance;
+}
+
+/**
+ * @brief Moves an axis forward by `dt` milliseconds and grows its covariance by the process noise.
+ */
+static void _predict(GPSTrackAxis *axis, int64_t dt)
+{
+    const int64_t q = (int64_t)GPS_TRACK_ACCEL_MM_S2 * GPS_TRACK_ACCEL_MM_S2; // White acceleration, mm^2/s^3
+    int64_t pp = axis->pp, pv = axis->pv, vv = axis->vv;
+    axis->position += (int32_t)(axis->velocity * dt / 1000);
+    axis->pp = pp + 2 * pv * dt / 1000 + vv * dt * dt / 1000000 + q * dt * dt * dt / 3000000000;
+    axis->pv = pv + vv * dt / 1000 + q * dt * dt / 2000000;
+    axis->vv = vv + q * dt / 1000;
+}
+
+/**
+ * @brief Updates an axis with a measured position (millimeters) of variance `r`.
+ */
+static void _measurePosition(GPSTrackAxis *axis, int32_t position, int64_t r)
+{
+    int64_t s = axis->pp + r;
+    int64_t k0 = (axis->pp << 16) / s; // Q16 gains
+    int64_t k1 = (axis->pv << 16) / s;
+    int64_t y = (int64_t)position - axis->position;
+    axis->position += (int32_t)((k0 * y) >> 16);
+    axis->velocity += (int32_t)((k1 * y) >> 16);
+    axis->vv -= (k1 * axis->pv) >> 16;
+    axis->pv -= (k0 * axis->pv) >> 16;
+    axis->pp -= (k0 * axis->pp) >> 16;
+    axis->pp = axis->pp > 0 ? axis->pp : 1; // Rounding must not make a variance negative
+    axis->vv = axis->vv > 0 ? axis->vv : 1;
+}
+
+/**
+ * @brief Updates an axis with a measured velocity (millimeters per second) of variance `r`.
+ */
+static void _measureVelocity(GPSTrackAxis *axis, int32_t velocity, int64_t r)
+{
+    int64_t s = axis->vv + r;
+    int64_t k0 = (axis->pv << 16) / s; // Q16 gains
+    int64_t k1 = (axis->vv << 16) / s;
+    int64_t y = (int64_t)velocity - axis->velocity;
+    axis->position += (int32_t)((k0 * y) >> 16);
+    axis->velocity += (int32_t)((k1 * y) >> 16);
+    axis->pp -= (k0 * axis->pv) >> 16;
+    axis->pv -= (k0 * axis->vv) >> 16;
+    axis->vv -= (k1 * axis->vv) >> 16;
+    axis->pp = axis->pp > 0 ? axis->pp : 1;
+    axis->vv = axis->vv > 0 ? axis->vv : 1;
+}
+
+/**
+ * @brief Publishes the state of the filter to `GPSTrack_predict` (sequence latch over two copies).
+ */
+static void _publish(GPSTrack *track, uint32_t time_us)
+{
+    GPSTrackSnapshot snapshot;
+    snapshot.time_us = time_us;
+    snapshot.latitude = track->latitude;
+    snapshot.longitude = track->longitude;
+    snapshot.north_degree = (int32_t)((1ll << 40) / track->north_mm);
+    snapshot.east_degree = (int32_t)((1ll << 40) / track->east_mm);
+    snapshot.north = track->north.position;
+    snapshot.east = track->east.position;
+    snapshot.north_speed = track->north.velocity;
+    snapshot.east_speed = track->east.velocity;
+    snapshot.accuracy = GPSMath_sqrt((uint64_t)(track->north.pp + track->east.pp));
+    snapshot.valid = true;
+
+    track->sequence++; // Readers move to slots[1]
+    __dmb();
+    track->slots[0] = snapshot;
+    __dmb();
+    track->sequence++; // Readers move back to slots[0]
+    __dmb();
+    track->slots[1] = snapshot;
+    __dmb();
+}
+
+/**
+ * @brief Initializes a fix smoother with no track.
+ *
+ * @param track Pointer to the GPSTrack structure.
+ */
+void GPSTrack_init(GPSTrack *track)
+{
+    memset(track, 0, sizeof(GPSTrack));
+}
+
+/**
+ * @brief Updates the filter with a committed fix; call it once per epoch.
+ *
+ * A fix counts as valid when its RMC/GLL status is 'A' or its GGA quality is non-zero (as in
+ * FixLog_append), so GGA-only epochs are kept; other fixes are ignored, so predictions keep extrapolating the last valid
+ * one up to GPS_TRACK_HORIZON_MS. A fix without HDOP is weighted as GPS_TRACK_UNKNOWN_HDOP. A fix
+ * more than GPS_TRACK_RESET_MS after the previous one, or before it, restarts the filter at its
+ * position.
+ *
+ * @param track Pointer to the GPSTrack structure.
+ * @param fix The fix, e.g. from NMEAParser_fix in an NMEA_EVENT_EPOCH listener.
+ */
+void GPSTrack_fix(GPSTrack *track, const NMEAFix *fix)
+{
+    if (!fix->valid && fix->quality == 0)
+    {
+        return;
+    }
+    uint32_t hhmmss = fix->utc_time / 1000;
+    uint32_t utc_ms = ((hhmmss / 10000) * 3600 + (hhmmss / 100 % 100) * 60 + hhmmss % 100) * 1000 + fix->utc_time % 1000;
+    uint32_t dt = (utc_ms + GPS_TRACK_DAY_MS - track->utc_ms) % GPS_TRACK_DAY_MS;
+    if (track->tracking && dt == 0)
+    {
+        return; // Same epoch again
+    }
+
+    // Measurement errors grow with the HDOP
+    uint32_t hdop = fix->hdop == 0 ? GPS_TRACK_UNKNOWN_HDOP : fix->hdop < GPS_TRACK_MIN_HDOP ? GPS_TRACK_MIN_HDOP : fix->hdop;
+    int64_t position_sigma = (int64_t)GPS_TRACK_UERE_MM * hdop / NMEA_DOP_SCALE;
+    int64_t velocity_sigma = (int64_t)GPS_TRACK_SPEED_MM_S * hdop / NMEA_DOP_SCALE;
+    float speed = (float)((int64_t)fix->speed * GPS_TRACK_KNOT_MM_S / 1000000);
+    float course = (float)fix->course * (float)(M_PI / 180.0 / NMEA_ANGLE_SCALE);
+    int32_t north_speed = (int32_t)(speed * cosf(course));
+    int32_t east_speed = (int32_t)(speed * sinf(course));
+
+    if (!track->tracking || dt > GPS_TRACK_RESET_MS)
+    {
+        int64_t start_sigma = speed >= GPS_TRACK_MIN_SPEED_MM_S ? velocity_sigma : GPS_TRACK_MIN_SPEED_MM_S;
+        _anchor(track, fix->latitude, fix->longitude);
+        _start(&track->north, north_speed, position_sigma * position_sigma, start_sigma * start_sigma);
+        _start(&track->east, east_speed, position_sigma * position_sigma, start_sigma * start_sigma);
+        track->tracking = true;
+        track->resets++;
+    }
+    else
+    {
+        _predict(&track->north, dt);
+        _predict(&track->east, dt);
+        int32_t north = (int32_t)(((int64_t)fix->latitude - track->latitude) * track->north_mm >> 16);
+        int32_t east = (int32_t)((int64_t)_longitudeDelta(fix->longitude, track->longitude) * track->east_mm >> 16);
+        _measurePosition(&track->north, north, position_sigma * position_sigma);
+        _measurePosition(&track->east, east, position_sigma * position_sigma);
+        if (speed >= GPS_TRACK_MIN_SPEED_MM_S)
+        {
+            _measureVelocity(&track->north, north_speed, velocity_sigma * velocity_sigma);
+            _measureVelocity(&track->east, east_speed, velocity_sigma * velocity_sigma);
+        }
+
+        if (abs(track->north.position) > GPS_TRACK_ANCHOR_MM || abs(track->east.position) > GPS_TRACK_ANCHOR_MM)
+        {
+            // Keep the plane small enough for int32 millimeters and a constant longitude scale
+            int32_t latitude = track->latitude + (int32_t)(((int64_t)track->north.position << 16) / track->north_mm);
+            int64_t longitude = track->longitude + ((int64_t)track->east.position << 16) / track->east_mm;
+            _anchor(track, latitude, _longitudeDelta(longitude, 0));
+            track->north.position = 0;
+            track->east.position = 0;
+        }
+    }
+    track->utc_ms = utc_ms;
+    track->updates++;
+    _publish(track, fix->start_us); // The state belongs to the fix's UTC instant, not to the commit
+}
+
+/**
+ * @brief Estimates the position and velocity at any time, in O(1); safe from any core or interrupt.
+ *
+ * The estimate of the last valid fix is extrapolated at its velocity, so an application can
+ * read positions at its own rate between the epochs of the module instead of waiting for the
+ * next sentence.
+ *
+ * @param track Pointer to the GPSTrack structure.
+ * @param time_us The time of the estimate in microseconds since boot (`time_us_32()`).
+ * @param estimate Receives the estimate.
+ * @return False before the first valid fix, or if `time_us` is more than GPS_TRACK_HORIZON_MS
+ *         from the last one (the estimate then stops at the horizon).
+ */
+bool GPSTrack_predict(const GPSTrack *track, uint32_t time_us, GPSTrackEstimate *estimate)
+{
+    GPSTrackSnapshot snapshot;
+    uint32_t sequence;
+    do
+    {
+        sequence = track->sequence;
+        __dmb();
+        snapshot = track->slots[sequence & 1];
+        __dmb();
+    } while (track->sequence != sequence);
+    if (!snapshot.valid)
+    {
+        memset(estimate, 0, sizeof(GPSTrackEstimate));
+        return false;
+    }
+
+    int32_t age = (int32_t)(time_us - snapshot.time_us);
+    int32_t elapsed = age;
+    if (elapsed > GPS_TRACK_HORIZON_MS * 1000)
+    {
+        elapsed = GPS_TRACK_HORIZON_MS * 1000;
+    }
+    else if (elapsed < -GPS_TRACK_HORIZON_MS * 1000)
+    {
+        elapsed = -GPS_TRACK_HORIZON_MS * 1000;
+    }
+    int64_t north = snapshot.north + (((int64_t)snapshot.north_speed * elapsed * GPS_TRACK_US_Q32) >> 32);
+    int64_t east = snapshot.east + (((int64_t)snapshot.east_speed * elapsed * GPS_TRACK_US_Q32) >> 32);
+    estimate->latitude = snapshot.latitude + (int32_t)((north * snapshot.north_degree) >> 24);
+    estimate->longitude = _longitudeDelta(snapshot.longitude + ((east * snapshot.east_degree) >> 24), 0);
+    estimate->north = snapshot.north_speed;
+    estimate->east = snapshot.east_speed;
+    estimate->accuracy = snapshot.accuracy;
+    estimate->age_us = age;
+    return elapsed == age;
+}
@@ -0,0 +1,132 @@
+#ifndef GPS_TRACK_H
+#define GPS_TRACK_H
+
+#include "../nmea/nmea_fix.h"
+
+// Horizontal error of a position at an HDOP of 1 (millimeters, one sigma)
+#ifndef GPS_TRACK_UERE_MM
+#define GPS_TRACK_UERE_MM 3000
+#endif
+
+// Error of the speed over the ground at an HDOP of 1 (millimeters per second, one sigma)
+#ifndef GPS_TRACK_SPEED_MM_S
+#define GPS_TRACK_SPEED_MM_S 100
+#endif
+
+// Speed below which the velocity of a fix is ignored: the track is noise there, or frozen by static navigation
+#ifndef GPS_TRACK_MIN_SPEED_MM_S
+#define GPS_TRACK_MIN_SPEED_MM_S 1000
+#endif
+
+// Accelerations the receiver is expected to see (millimeters per second squared, one sigma)
+#ifndef GPS_TRACK_ACCEL_MM_S2
+#define GPS_TRACK_ACCEL_MM_S2 2000
+#endif
+
+// Longest gap between two valid fixes the filter bridges; a longer one restarts it at the next fix
+#ifndef GPS_TRACK_RESET_MS
+#define GPS_TRACK_RESET_MS 5000
+#endif
+
+// Longest extrapolation from the last valid fix; later predictions stay where it ends
+#ifndef GPS_TRACK_HORIZON_MS
+#define GPS_TRACK_HORIZON_MS 2000
+#endif
+
+// Distance from the local origin at which the origin moves to the current position (millimeters)
+#define GPS_TRACK_ANCHOR_MM 100000000
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Position and velocity estimated for a point in time.
+     */
+    typedef struct
+    {
+        int32_t latitude;  /**< Degrees * NMEA_DEGREES_SCALE, negative south. */
+        int32_t longitude; /**< Degrees * NMEA_DEGREES_SCALE, negative west. */
+        int32_t north;     /**< Northward velocity in millimeters per second. */
+        int32_t east;      /**< Eastward velocity in millimeters per second. */
+        uint32_t accuracy; /**< Horizontal error of the position at the last fix (millimeters, one sigma). */
+        int32_t age_us;    /**< Time from the last valid fix to the estimate (microseconds, negative before it). */
+    } GPSTrackEstimate;
+
+    /**
+     * @brief Constant-velocity Kalman filter of one horizontal axis, in a local plane.
+     */
+    typedef struct
+    {
+        int32_t position; /**< Millimeters from the origin. */
+        int32_t velocity; /**< Millimeters per second. */
+        int64_t pp;       /**< Variance of the position (mm^2). */
+        int64_t pv;       /**< Covariance of the position and the velocity (mm^2/s). */
+        int64_t vv;       /**< Variance of the velocity (mm^2/s^2). */
+    } GPSTrackAxis;
+
+    /**
+     * @brief What `GPSTrack_predict` needs, published once per fix.
+     */
+    typedef struct
+    {
+        uint32_t time_us;     /**< Time the first sentence of the epoch started to arrive (us since boot, `NMEAFix.start_us`). */
+        int32_t latitude;     /**< Origin of the local plane, degrees * NMEA_DEGREES_SCALE. */
+        int32_t longitude;    /**< Origin of the local plane, degrees * NMEA_DEGREES_SCALE. */
+        int32_t north_degree; /**< Latitude units per millimeter north, Q24. */
+        int32_t east_degree;  /**< Longitude units per millimeter east, Q24. */
+        int32_t north;        /**< Position north of the origin (millimeters). */
+        int32_t east;         /**< Position east of the origin (millimeters). */
+        int32_t north_speed;  /**< Northward velocity (millimeters per second). */
+        int32_t east_speed;   /**< Eastward velocity (millimeters per second). */
+        uint32_t accuracy;    /**< Horizontal error of the position (millimeters, one sigma). */
+        bool valid;           /**< False until the first valid fix. */
+    } GPSTrackSnapshot;
+
+    /**
+     * @brief Fix smoother: a constant-velocity Kalman filter updated once per epoch.
+     *
+     * Every valid fix is projected on a plane tangent to the earth at a local origin, both axes
+     * are predicted to the UTC time of the fix and then updated with the position, weighted by
+     * GPS_TRACK_UERE_MM times the HDOP, and with the velocity from the speed and the track,
+     * weighted by GPS_TRACK_SPEED_MM_S times the HDOP (above GPS_TRACK_MIN_SPEED_MM_S only). The state is integer millimeters, the
+     * covariances 64-bit integers and the gains Q16; the only floating-point operations are one
+     * sine and one cosine per fix, and one cosine when the origin moves.
+     *
+     * `GPSTrack_predict` extrapolates the last update to any time with a few multiplications and
+     * a sequence latch, so it can run at any rate, from any core or interrupt, between epochs.
+     * An update is dated by the arrival of the epoch's first sentence, not by the commit after its
+     * last one, so predictions do not lag by the time the module takes to send the epoch (100 to
+     * 400 ms at 9600 baud). The bias left is the module's output delay after the UTC instant, plus
+     * the time the first sentence waits in the receive ring when the reader is late.
+     *
+     * `GPSTrack_fix` is the only writer: one call per committed fix, from the NMEA_EVENT_EPOCH
+     * listener of the core that reads the parser. It never waits for the readers; a prediction
+     * that overlaps an update is read again.
+     */
+    typedef struct
+    {
+        GPSTrackAxis north;           /**< Filter of the northward axis. */
+        GPSTrackAxis east;            /**< Filter of the eastward axis. */
+        int32_t latitude;             /**< Latitude of the origin, degrees * NMEA_DEGREES_SCALE. */
+        int32_t longitude;            /**< Longitude of the origin, degrees * NMEA_DEGREES_SCALE. */
+        int32_t north_mm;             /**< Millimeters per latitude unit, Q16. */
+        int32_t east_mm;              /**< Millimeters per longitude unit at the origin, Q16. */
+        uint32_t utc_ms;              /**< UTC of the last update, milliseconds of the day. */
+        bool tracking;                /**< True once a valid fix started the filter. */
+        uint32_t updates;             /**< Fixes the filter was updated with. */
+        uint32_t resets;              /**< Times the filter was restarted. */
+        volatile uint32_t sequence;   /**< Even: readers use slots[0]; odd: readers use slots[1]. */
+        GPSTrackSnapshot slots[2];    /**< Both copies hold the latest snapshot between updates. */
+    } GPSTrack;
+
+    void GPSTrack_init(GPSTrack *track);
+    void GPSTrack_fix(GPSTrack *track, const NMEAFix *fix);
+    bool GPSTrack_predict(const GPSTrack *track, uint32_t time_us, GPSTrackEstimate *estimate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GPS_TRACK_H
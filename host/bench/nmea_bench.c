@@ -0,0 +1,306 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "nmea_output.h"
+#include "nmea_parser.h"
+#include "nmea_legacy.h"
+
+// Default number of times the sample epoch is parsed per implementation
+#define BENCH_ROUNDS 100000
+
+// One epoch as sent by an L80 with all sentences enabled
+static const char *const epoch[] = {
+    "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n",
+    "$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0A\r\n",
+    "$GPGSV,3,1,11,10,63,137,17,07,61,098,15,05,59,290,20,08,54,157,30*70\r\n",
+    "$GPGSV,3,2,11,02,39,223,19,13,28,070,17,26,23,252,,04,14,186,14*79\r\n",
+    "$GPGSV,3,3,11,29,09,301,24,16,09,020,,36,,,*76\r\n",
+    "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n",
+    "$GPVTG,31.66,T,,M,0.02,N,0.04,K,A*09\r\n",
+    "$GPGLL,5321.6802,N,00630.3372,W,092750.000,A,A*4B\r\n",
+};
+
+#define EPOCH_SENTENCES (sizeof(epoch) / sizeof(epoch[0]))
+
+/**
+ * @brief Returns a monotonic timestamp in nanoseconds.
+ */
+static uint64_t now_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/**
+ * @brief Parses one sentence `rounds` times with the legacy parser, which needs a writable copy.
+ */
+static uint64_t bench_legacy(NMEALegacyParser *parser, const char *sentence, long rounds)
+{
+  char copy[UART_MAX_BUFFER_LENGTH];
+  uint64_t start = now_ns();
+  for (long r = 0; r < rounds; r++)
+  {
+    strcpy(copy, sentence); // NMEAParser_read used to copy every line before tokenizing it
+    NMEALegacy_rest(parser, copy);
+  }
+  return now_ns() - start;
+}
+
+/**
+ * @brief Parses one sentence `rounds` times with the single-pass parser, in place.
+ *
+ * The checksum is computed once up front, as `UartRx_readSentence` does while framing the line;
+ * the timed path validates it and parses the fields.
+ */
+static uint64_t bench_parse(NMEAParser *parser, const char *sentence, long rounds)
+{
+  UartRxLine line = {sentence, strlen(sentence), 0};
+  for (size_t i = 0; i < line.length && sentence[i] != '\n'; i++)
+  {
+    line.checksum ^= sentence[i];
+  }
+  uint64_t start = now_ns();
+  for (long r = 0; r < rounds; r++)
+  {
+    NMEAParser_parseLine(parser, &line);
+  }
+  return now_ns() - start;
+}
+
+/**
+ * @brief Formats the GGA and RMC fields and the line statistics of one epoch, as the text
+ *        output of nmea/main.c does (one formatting call per field), `rounds` times.
+ *
+ * @param bytes Receives the length of the text of one epoch.
+ */
+static uint64_t bench_text(const NMEAParser *parser, long rounds, size_t *bytes)
+{
+  static char text[2048];
+  const GPGGA_Data *gga = &parser->data.gpgga;
+  const GPRMC_Data *rmc = &parser->data.gprmc;
+  const NMEAParserStats *stats = &parser->stats;
+  uint64_t start = now_ns();
+  for (long r = 0; r < rounds; r++)
+  {
+    size_t n = 0;
+    n += snprintf(text + n, sizeof(text) - n, "Time: %s\n", gga->utc_time);
+    n += snprintf(text + n, sizeof(text) - n, "Latitude: %.7f\n", (double)gga->latitude / NMEA_DEGREES_SCALE);
+    n += snprintf(text + n, sizeof(text) - n, "Latitude Dir: %s\n", gga->latitude_dir);
+    n += snprintf(text + n, sizeof(text) - n, "Longitude: %.7f\n", (double)gga->longitude / NMEA_DEGREES_SCALE);
+    n += snprintf(text + n, sizeof(text) - n, "Longitude Dir: %s\n", gga->longitude_dir);
+    n += snprintf(text + n, sizeof(text) - n, "Fix status: %d\n", gga->fix_status);
+    n += snprintf(text + n, sizeof(text) - n, "Number of satellites: %d\n", gga->num_satellites);
+    n += snprintf(text + n, sizeof(text) - n, "HDOP: %.2f\n", (double)gga->hdop / NMEA_DOP_SCALE);
+    n += snprintf(text + n, sizeof(text) - n, "Altitude: %.2f\n", (double)gga->altitude / NMEA_ALTITUDE_SCALE);
+    n += snprintf(text + n, sizeof(text) - n, "Altitude Unit: %s\n", gga->altitude_unit);
+    n += snprintf(text + n, sizeof(text) - n, "Geoid: %.2f\n", (double)gga->geoid_separation / NMEA_ALTITUDE_SCALE);
+    n += snprintf(text + n, sizeof(text) - n, "Geoid Unit: %s\n", gga->geoid_unit);
+    n += snprintf(text + n, sizeof(text) - n, "Last Time: %d\n", gga->last_time);
+    n += snprintf(text + n, sizeof(text) - n, "Date: %s\n", rmc->date);
+    n += snprintf(text + n, sizeof(text) - n, "Time: %s\n", rmc->utc_time);
+    n += snprintf(text + n, sizeof(text) - n, "Latitude: %.7f\n", (double)rmc->latitude / NMEA_DEGREES_SCALE);
+    n += snprintf(text + n, sizeof(text) - n, "Latitude Dir: %s\n", rmc->latitude_dir);
+    n += snprintf(text + n, sizeof(text) - n, "Longitude: %.7f\n", (double)rmc->longitude / NMEA_DEGREES_SCALE);
+    n += snprintf(text + n, sizeof(text) - n, "Longitude Dir: %s\n", rmc->longitude_dir);
+    n += snprintf(text + n, sizeof(text) - n, "Status: %s\n", rmc->status);
+    n += snprintf(text + n, sizeof(text) - n, "Speed (Knots): %.3f\n", (double)rmc->speed / NMEA_SPEED_SCALE);
+    n += snprintf(text + n, sizeof(text) - n, "Track (True): %.2f\n", (double)rmc->track / NMEA_ANGLE_SCALE);
+    n += snprintf(text + n, sizeof(text) - n, "Magnetic variation: %.2f\n", (double)rmc->variation / NMEA_ANGLE_SCALE);
+    n += snprintf(text + n, sizeof(text) - n, "Sentences: %lu accepted, %lu truncated, %lu bytes overrun\n",
+                  (unsigned long)stats->accepted[NMEA_SENTENCE_GGA], (unsigned long)stats->line_truncations,
+                  (unsigned long)stats->ring_overflows);
+    *bytes = n;
+  }
+  return now_ns() - start;
+}
+
+/**
+ * @brief Serializes the fix and the statistics of one epoch as binary frames `rounds` times.
+ *
+ * @param bytes Receives the length of the frames of one epoch.
+ */
+static uint64_t bench_binary(NMEAParser *parser, long rounds, size_t *bytes)
+{
+  static NMEAOutput output;
+  NMEAOutput_init(&output);
+  uint64_t start = now_ns();
+  for (long r = 0; r < rounds; r++)
+  {
+    NMEAFix fix;
+    NMEAParser_fix(parser, &fix);
+    output.length = 0; // As written by NMEAOutput_flush
+    NMEAOutput_fix(&output, &fix);
+    NMEAOutput_stats(&output, &parser->stats);
+    *bytes = output.length;
+  }
+  return now_ns() - start;
+}
+
+/**
+ * @brief Enables every sentence type of the legacy parser, as NMEAParser_init used to.
+ */
+static void enable_legacy(NMEALegacyParser *parser)
+{
+  parser->GPGGA_ENABLED = true;
+  parser->GPGLL_ENABLED = true;
+  parser->GPRMC_ENABLED = true;
+  parser->GPGSA_ENABLED = true;
+  parser->GPVTG_ENABLED = true;
+  parser->GPGSV_ENABLED = true;
+}
+
+/**
+ * @brief Checks a fixed-point value against the floating-point value of the legacy parser.
+ */
+static bool same_fixed(double legacy, int32_t value, int32_t scale)
+{
+  return llround(legacy * scale) == value;
+}
+
+/**
+ * @brief Checks a fixed-point coordinate against the raw ddmm.mmmm value of the legacy parser.
+ *
+ * The legacy conversion goes through doubles, so the last unit (1e-7 degrees) may differ.
+ */
+static bool same_degrees(double legacy, const char *dir, int32_t value)
+{
+  double degrees = (int)(legacy / 100);
+  degrees += (legacy - degrees * 100) / 60;
+  if (dir[0] == 'S' || dir[0] == 'W')
+  {
+    degrees = -degrees;
+  }
+  return llabs(llround(degrees * NMEA_DEGREES_SCALE) - value) <= 1;
+}
+
+/**
+ * @brief Checks that both parsers stored the same values, ignoring the time stamps.
+ */
+static bool same_results(const NMEALegacyParser *a, const NMEAParser *b)
+{
+  const LegacyGPGGA_Data *lgga = &a->data.gpgga;
+  const GPGGA_Data *gga = &b->data.gpgga;
+  bool same = strcmp(lgga->utc_time, gga->utc_time) == 0 &&
+              same_degrees(lgga->latitude, lgga->latitude_dir, gga->latitude) &&
+              same_degrees(lgga->longitude, lgga->longitude_dir, gga->longitude) &&
+              lgga->fix_status == gga->fix_status && lgga->num_satellites == gga->num_satellites &&
+              same_fixed(lgga->hdop, gga->hdop, NMEA_DOP_SCALE) &&
+              same_fixed(lgga->altitude, gga->altitude, NMEA_ALTITUDE_SCALE) &&
+              same_fixed(lgga->geoid_separation, gga->geoid_separation, NMEA_ALTITUDE_SCALE);
+
+  const LegacyGPGLL_Data *lgll = &a->data.gpgll;
+  const GPGLL_Data *gll = &b->data.gpgll;
+  same = same && same_degrees(lgll->latitude, lgll->latitude_dir, gll->latitude) &&
+         same_degrees(lgll->longitude, lgll->longitude_dir, gll->longitude) &&
+         strcmp(lgll->utc_time, gll->utc_time) == 0 && strcmp(lgll->status, gll->status) == 0;
+
+  const LegacyGPRMC_Data *lrmc = &a->data.gprmc;
+  const GPRMC_Data *rmc = &b->data.gprmc;
+  same = same && strcmp(lrmc->utc_time, rmc->utc_time) == 0 && strcmp(lrmc->status, rmc->status) == 0 &&
+         same_degrees(lrmc->latitude, lrmc->latitude_dir, rmc->latitude) &&
+         same_degrees(lrmc->longitude, lrmc->longitude_dir, rmc->longitude) &&
+         same_fixed(lrmc->speed, rmc->speed, NMEA_SPEED_SCALE) &&
+         same_fixed(lrmc->track, rmc->track, NMEA_ANGLE_SCALE) && strcmp(lrmc->date, rmc->date) == 0 &&
+         same_fixed(lrmc->variation, rmc->variation, NMEA_ANGLE_SCALE);
+
+  const LegacyGPVTG_Data *lvtg = &a->data.gpvtg;
+  const GPVTG_Data *vtg = &b->data.gpvtg;
+  same = same && same_fixed(lvtg->track1, vtg->track1, NMEA_ANGLE_SCALE) &&
+         same_fixed(lvtg->track2, vtg->track2, NMEA_ANGLE_SCALE) &&
+         same_fixed(lvtg->speed1, vtg->speed1, NMEA_SPEED_SCALE) &&
+         same_fixed(lvtg->speed2, vtg->speed2, NMEA_SPEED_SCALE);
+
+  const LegacyGPGSV_Data *lgsv = &a->data.gpgsv;
+  const GPGSV_Data *gsv = &b->data.gpgsv;
+  const NMEASatellite *sv = &gsv->satellites[0]; // The legacy parser kept the first satellite only
+  same = same && lgsv->total == gsv->total && lgsv->count == gsv->count && lgsv->total_sv == gsv->total_sv &&
+         lgsv->prn_sv == sv->prn && lgsv->elevation == sv->elevation &&
+         lgsv->azimuth == (uint8_t)sv->azimuth && // Stored in a uint8_t by the legacy parser
+         lgsv->snr == sv->snr;
+  return same;
+}
+
+/**
+ * @brief Host benchmark: legacy strchr/strcmp parser vs the single-pass table-driven parser.
+ *
+ * Every sentence of a sample epoch is timed on its own, then the whole epoch. Note that the
+ * single-pass parser does more work than the legacy parser ever did: it checks checksums,
+ * maintains the compact `NMEAFix`, assembles the satellite table from all four satellites of
+ * every GSV message, parses GSA, and converts numbers to fixed point instead of raw doubles.
+ *
+ * Usage: nmea_bench [rounds]
+ *
+ * @return 0 on success, 1 if the sample epoch fails its checksums or the two parsers disagree.
+ */
+int main(int argc, char **argv)
+{
+  long rounds = argc > 1 ? atol(argv[1]) : BENCH_ROUNDS;
+  static NMEALegacyParser legacy;
+  static NMEAParser parser;
+  enable_legacy(&legacy);
+  parser.enabled = NMEA_SENTENCES_ALL;
+
+  // Warm up and compare the results of one epoch
+  for (size_t s = 0; s < EPOCH_SENTENCES; s++)
+  {
+    bench_legacy(&legacy, epoch[s], 1);
+    bench_parse(&parser, epoch[s], 1);
+  }
+  NMEAParserStats stats;
+  NMEAParser_stats(&parser, &stats);
+  uint32_t rejected = 0;
+  for (int type = 0; type < NMEA_SENTENCE_COUNT; type++)
+  {
+    rejected += stats.rejected[type];
+  }
+  if (rejected != 0)
+  {
+    fprintf(stderr, "nmea_bench: sample epoch failed the checksum check\n");
+    return 1;
+  }
+  const NMEASatelliteTable *satellites = NMEAParser_satellites(&parser);
+  if (!satellites->complete || satellites->count != satellites->in_view)
+  {
+    fprintf(stderr, "nmea_bench: GSV sequence of the sample epoch not assembled\n");
+    return 1;
+  }
+  if (!same_results(&legacy, &parser))
+  {
+    fprintf(stderr, "nmea_bench: parsers disagree on the sample epoch\n");
+    return 1;
+  }
+
+  uint64_t legacy_total = 0;
+  uint64_t parse_total = 0;
+  printf("%ld rounds, ns/sentence\n", rounds);
+  printf("%-8s %10s %10s %8s\n", "sentence", "legacy", "single", "speedup");
+  for (size_t s = 0; s < EPOCH_SENTENCES; s++)
+  {
+    uint64_t legacy_ns = bench_legacy(&legacy, epoch[s], rounds);
+    uint64_t parse_ns = bench_parse(&parser, epoch[s], rounds);
+    legacy_total += legacy_ns;
+    parse_total += parse_ns;
+    printf("%-8.6s %10.1f %10.1f %7.2fx\n", epoch[s], (double)legacy_ns / rounds, (double)parse_ns / rounds,
+           (double)legacy_ns / parse_ns);
+  }
+
+  double sentences = (double)rounds * EPOCH_SENTENCES;
+  printf("epoch of %zu sentences:\n", EPOCH_SENTENCES);
+  printf("  legacy (strchr/strcmp/atof) %10.0f sentences/s\n", sentences * 1e9 / legacy_total);
+  printf("  single pass (table driven)  %10.0f sentences/s\n", sentences * 1e9 / parse_total);
+  printf("  speedup %.2fx\n", (double)legacy_total / parse_total);
+
+  size_t text_bytes;
+  size_t binary_bytes;
+  uint64_t text_ns = bench_text(&parser, rounds, &text_bytes);
+  uint64_t binary_ns = bench_binary(&parser, rounds, &binary_bytes);
+  printf("output of one epoch (GGA, RMC and line statistics):\n");
+  printf("  text (printf per field)  %8.1f ns %5zu bytes, %6zu bytes/s at 10 Hz\n", (double)text_ns / rounds, text_bytes,
+         text_bytes * 10);
+  printf("  binary (COBS frames)     %8.1f ns %5zu bytes, %6zu bytes/s at 10 Hz\n", (double)binary_ns / rounds,
+         binary_bytes, binary_bytes * 10);
+  return 0;
+}
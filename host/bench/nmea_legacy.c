@@ -0,0 +1,131 @@
+#include "nmea_legacy.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Frozen copy of the strchr/strcmp/atof parser that the table-driven NMEAParser_parse replaced,
+// with the floating-point structures it filled. It is only built into the host benchmark, as the
+// reference the new parser is measured against and checked with.
+
+uint32_t _millis();
+
+/**
+ * @brief Extracts a token from the comma-separated string and updates the pointer to the remaining string.
+ *
+ * This function locates the next comma in the string, null-terminates the token, and updates the
+ * `rest` pointer to the position after the comma. If no comma is found, it returns the full string.
+ *
+ * @param rest Pointer to the string to tokenize. On output, points to the remaining string after the token.
+ *
+ * @return Returns the extracted token as a string.
+ */
+static char *getToken(char **rest)
+{
+  char *start = *rest;
+  char *token;
+  if (start == NULL || *start == '\0')
+  {
+    return NULL;
+  }
+
+  token = strchr(start, ','); // Find the position of the next comma (or end of string)
+
+  if (token) // If a comma is found, null-terminate the token and move the rest pointer
+  {
+    *token = '\0';     // Null-terminate the token
+    *rest = token + 1; // Move the rest pointer to the character after the comma
+  }
+  else
+  {
+    *rest = NULL; // If no more commas, rest becomes NULL (end of string)
+  }
+  return start;
+}
+
+/**
+ * @brief Parses the NMEA sentence and updates the parser with the extracted data.
+ *
+ * This function processes a comma-separated NMEA sentence, extracting relevant tokens and storing
+ * them into the appropriate fields in the `NMEALegacyParser` structure. It supports multiple types of NMEA sentences,
+ * such as GPGGA, GPGLL, GPRMC, etc., and updates the respective data structures with the parsed values.
+ *
+ * @param parser Pointer to the NMEALegacyParser structure.
+ * @param rest The comma-separated string containing the NMEA sentence to be parsed.
+ */
+void NMEALegacy_rest(NMEALegacyParser *parser, char *rest)
+{
+  char *token = getToken(&rest); // Tokenize the rest by commas
+  if (token == NULL)
+  {
+    return;
+  }
+
+  // Check rest type and parse accordingly
+  if (parser->GPGGA_ENABLED && strcmp(token, "$GPGGA") == 0)
+  {
+    LegacyGPGGA_Data *gpgga = &parser->data.gpgga;
+    strcpy(parser->data.utc_time = gpgga->utc_time, getToken(&rest));           // UTC of position fix
+    parser->data.latitude = gpgga->latitude = atof(getToken(&rest));            // Latitude
+    strcpy(parser->data.latitude_dir = gpgga->latitude_dir, getToken(&rest));   // Direction of latitude: (N: North, S: South)
+    parser->data.longitude = gpgga->longitude = atof(getToken(&rest));          // Longitude
+    strcpy(parser->data.longitude_dir = gpgga->longitude_dir, getToken(&rest)); // Direction of longitude: (E: East, W: West)
+    gpgga->fix_status = atoi(getToken(&rest));                                  // GPS Quality indicator
+    gpgga->num_satellites = atoi(getToken(&rest));                              // Number of SVs in use, range from 00 through to 24+
+    gpgga->hdop = atof(getToken(&rest));                                        // Horizontal Dilution of Precision
+    gpgga->altitude = atof(getToken(&rest));                                    // Orthometric height (MSL reference)
+    strcpy(gpgga->altitude_unit, getToken(&rest));                              // M: unit of measure for orthometric height is meters
+    gpgga->geoid_separation = atof(getToken(&rest));                            // Geoid separation
+    strcpy(gpgga->geoid_unit, getToken(&rest));                                 // M: geoid separation measured in meters
+    gpgga->last_time = _millis();                                               // Store the current time (e.g., from a timer)
+  }
+  else if (parser->GPGLL_ENABLED && strcmp(token, "$GPGLL") == 0)
+  {
+    LegacyGPGLL_Data *gpgll = &parser->data.gpgll;
+    parser->data.latitude = gpgll->latitude = atof(getToken(&rest));            // Latitude in dd mm,mmmm format (0-7 decimal places)
+    strcpy(parser->data.latitude_dir = gpgll->latitude_dir, getToken(&rest));   // Direction of latitude N: North S: South
+    parser->data.longitude = gpgll->longitude = atof(getToken(&rest));          // Longitude in ddd mm,mmmm format (0-7 decimal places)
+    strcpy(parser->data.longitude_dir = gpgll->longitude_dir, getToken(&rest)); // Direction of longitude E: East W: West
+    strcpy(parser->data.utc_time = gpgll->utc_time, getToken(&rest));           // UTC of position in hhmmss.ss format
+    strcpy(gpgll->status, getToken(&rest));                                     // Status indicator: (A: Data valid, V: Data not valid)
+    gpgll->last_time = _millis();                                               // Store the current time (e.g., from a timer)
+  }
+  else if (parser->GPRMC_ENABLED && strcmp(token, "$GPRMC") == 0)
+  {
+    LegacyGPRMC_Data *gprmc = &parser->data.gprmc;
+    strcpy(parser->data.utc_time = gprmc->utc_time, getToken(&rest));           // UTC of position fix
+    strcpy(gprmc->status, getToken(&rest));                                     // Status (A=active or V=void)
+    parser->data.latitude = gprmc->latitude = atof(getToken(&rest));            // Latitude in dd mm,mmmm format (0-7 decimal places)
+    strcpy(parser->data.latitude_dir = gprmc->latitude_dir, getToken(&rest));   // Direction of latitude N: North S: South
+    parser->data.longitude = gprmc->longitude = atof(getToken(&rest));          // Longitude in ddd mm,mmmm format (0-7 decimal places)
+    strcpy(parser->data.longitude_dir = gprmc->longitude_dir, getToken(&rest)); // Direction of longitude E: East W: West
+    parser->data.speed = gprmc->speed = atof(getToken(&rest));                  // Speed over the ground in knots
+    gprmc->track = atof(getToken(&rest));                                       // Track angle in degrees (True)
+    strcpy(gprmc->date, getToken(&rest));                                       // Date
+    gprmc->variation = atof(getToken(&rest));                                   // Magnetic variation, in degrees
+    gprmc->last_time = _millis();                                               // Store the current time (e.g., from a timer)
+  }
+  else if (parser->GPVTG_ENABLED && strcmp(token, "$GPVTG") == 0)
+  {
+    LegacyGPVTG_Data *gpvtg = &parser->data.gpvtg;
+    gpvtg->track1 = atof(getToken(&rest));                      // Track made good (degrees true)
+    strcpy(gpvtg->track1_id, getToken(&rest));                  // T: track made good is relative to true north
+    gpvtg->track2 = atof(getToken(&rest));                      // Track made good (degrees magnetic)
+    strcpy(gpvtg->track2_id, getToken(&rest));                  // M: track made good is relative to magnetic north
+    parser->data.speed = gpvtg->speed1 = atof(getToken(&rest)); // Speed, in knots
+    strcpy(gpvtg->speed1_id, getToken(&rest));                  // N: speed is measured in knots
+    gpvtg->speed2 = atof(getToken(&rest));                      // Speed over ground in kilometers/hour (kph)
+    strcpy(gpvtg->speed2_id, getToken(&rest));                  // K: speed over ground is measured in kph
+    gpvtg->last_time = _millis();                               // Store the current time (e.g., from a timer)
+  }
+  else if (parser->GPGSV_ENABLED && strcmp(token, "$GPGSV") == 0)
+  {
+    LegacyGPGSV_Data *gpgsv = &parser->data.gpgsv;
+    gpgsv->total = atoi(getToken(&rest));     // Total number of messages of this type in this cycle
+    gpgsv->count = atoi(getToken(&rest));     // Message number
+    gpgsv->total_sv = atoi(getToken(&rest));  // Total number of SVs visible
+    gpgsv->prn_sv = atoi(getToken(&rest));    // SV PRN number
+    gpgsv->elevation = atoi(getToken(&rest)); // Elevation, in degrees, 90° maximum
+    gpgsv->azimuth = atoi(getToken(&rest));   // Azimuth, degrees from True North, 000° through 359°
+    gpgsv->snr = atoi(getToken(&rest));       // SNR, 00 through 99 dB (null when not tracking)
+    gpgsv->last_time = _millis();             // Store the current time (e.g., from a timer)
+  }
+}
@@ -0,0 +1,89 @@
+// Generated by fences.py from host/replay/fences.geojson: 4 fences, 23 vertices, 283 cells, 295 candidates
+#include "geofence.h"
+
+static const GeofenceFence fences[] = {
+    {0, 4, 1, 39110},
+    {4, 4, 2, 39109},
+    {8, 12, 3, 39109},
+    {20, 3, 4, 39102},
+};
+
+static const GeofenceVertex vertices[] = {
+    {533600000, -65080000}, {533600000, -65040000}, {533630000, -65040000}, {533630000, -65080000},
+    {533615000, -65060000}, {533615000, -65056000}, {533617000, -65056000}, {533617000, -65060000},
+    {533620032, -65059583}, {533619851, -65058453}, {533619357, -65057625}, {533618683, -65057322}, {533618009, -65057625}, {533617515, -65058453}, {533617334, -65059583}, {533617515, -65060713}, {533618009, -65061541}, {533618683, -65061844}, {533619357, -65061541}, {533619851, -65060713},
+    {533690000, -65010000}, {533690000, -64990000}, {533705000, -65000000},
+};
+
+static const GeofenceCell cells[] = {
+    {0, 0}, {1, 1}, {2, 2}, {3, 3}, {4, 4}, {5, 5}, {6, 6}, {7, 7}, {8, 8}, {9, 9}, {10, 10},
+    {11, 11}, {12, 12}, {13, 13}, {31, 14}, {32, 15}, {33, 16}, {34, 17}, {35, 18}, {36, 19},
+    {37, 20}, {38, 21}, {39, 22}, {40, 23}, {41, 24}, {42, 25}, {43, 26}, {44, 27}, {62, 28},
+    {63, 29}, {64, 30}, {65, 31}, {66, 32}, {67, 33}, {68, 34}, {69, 35}, {70, 36}, {71, 37},
+    {72, 38}, {73, 39}, {74, 40}, {75, 41}, {93, 42}, {94, 43}, {95, 44}, {96, 45}, {97, 46},
+    {98, 47}, {99, 48}, {100, 49}, {101, 50}, {102, 51}, {103, 52}, {104, 53}, {105, 54}, {106, 55},
+    {124, 56}, {125, 57}, {126, 58}, {127, 59}, {128, 60}, {129, 61}, {130, 62}, {131, 63},
+    {132, 64}, {133, 65}, {134, 66}, {135, 67}, {136, 68}, {137, 69}, {155, 70}, {156, 71},
+    {157, 72}, {158, 73}, {159, 74}, {160, 75}, {161, 76}, {162, 77}, {163, 78}, {164, 79},
+    {165, 80}, {166, 81}, {167, 82}, {168, 83}, {186, 84}, {187, 85}, {188, 86}, {189, 87},
+    {190, 88}, {191, 89}, {192, 90}, {193, 91}, {194, 92}, {195, 93}, {196, 94}, {197, 95},
+    {198, 96}, {199, 97}, {217, 98}, {218, 99}, {219, 100}, {220, 101}, {221, 102}, {222, 103},
+    {223, 104}, {224, 105}, {225, 106}, {226, 107}, {227, 108}, {228, 109}, {229, 110}, {230, 111},
+    {248, 112}, {249, 113}, {250, 114}, {251, 115}, {252, 116}, {253, 117}, {254, 118}, {255, 120},
+    {256, 122}, {257, 124}, {258, 125}, {259, 126}, {260, 127}, {261, 128}, {279, 129}, {280, 130},
+    {281, 131}, {282, 132}, {283, 133}, {284, 134}, {285, 135}, {286, 138}, {287, 141}, {288, 143},
+    {289, 144}, {290, 145}, {291, 146}, {292, 147}, {310, 148}, {311, 149}, {312, 150}, {313, 151},
+    {314, 152}, {315, 153}, {316, 154}, {317, 156}, {318, 158}, {319, 159}, {320, 160}, {321, 161},
+    {322, 162}, {323, 163}, {341, 164}, {342, 165}, {343, 166}, {344, 167}, {345, 168}, {346, 169},
+    {347, 170}, {348, 172}, {349, 174}, {350, 175}, {351, 176}, {352, 177}, {353, 178}, {354, 179},
+    {372, 180}, {373, 181}, {374, 182}, {375, 183}, {376, 184}, {377, 185}, {378, 186}, {379, 187},
+    {380, 188}, {381, 189}, {382, 190}, {383, 191}, {384, 192}, {385, 193}, {403, 194}, {404, 195},
+    {405, 196}, {406, 197}, {407, 198}, {408, 199}, {409, 200}, {410, 201}, {411, 202}, {412, 203},
+    {413, 204}, {414, 205}, {415, 206}, {416, 207}, {434, 208}, {435, 209}, {436, 210}, {437, 211},
+    {438, 212}, {439, 213}, {440, 214}, {441, 215}, {442, 216}, {443, 217}, {444, 218}, {445, 219},
+    {446, 220}, {447, 221}, {465, 222}, {466, 223}, {467, 224}, {468, 225}, {469, 226}, {470, 227},
+    {471, 228}, {472, 229}, {473, 230}, {474, 231}, {475, 232}, {476, 233}, {477, 234}, {478, 235},
+    {496, 236}, {497, 237}, {498, 238}, {499, 239}, {500, 240}, {501, 241}, {502, 242}, {503, 243},
+    {504, 244}, {505, 245}, {506, 246}, {507, 247}, {508, 248}, {509, 249}, {1573, 250},
+    {1574, 251}, {1575, 252}, {1576, 253}, {1577, 254}, {1578, 255}, {1579, 256}, {1580, 257},
+    {1604, 258}, {1605, 259}, {1606, 260}, {1607, 261}, {1608, 262}, {1609, 263}, {1610, 264},
+    {1635, 265}, {1636, 266}, {1637, 267}, {1638, 268}, {1639, 269}, {1640, 270}, {1641, 271},
+    {1667, 272}, {1668, 273}, {1669, 274}, {1670, 275}, {1671, 276}, {1672, 277}, {1698, 278},
+    {1699, 279}, {1700, 280}, {1701, 281}, {1702, 282}, {1730, 283}, {1731, 284}, {1732, 285},
+    {1733, 286}, {1761, 287}, {1762, 288}, {1763, 289}, {1792, 290}, {1793, 291}, {1794, 292},
+    {1824, 293}, {1825, 294},
+    {0xFFFFFFFF, 295}, // Sentinel
+};
+
+static const uint16_t candidates[] = {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000,
+    0x8000, 0x8000, 0x8000, 0x0000, 0x0000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000,
+    0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x0000, 0x0000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000,
+    0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x0000, 0x0000, 0x8000, 0x8000, 0x8000,
+    0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x0000, 0x0000, 0x8000,
+    0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x0000,
+    0x0000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000,
+    0x8000, 0x0000, 0x0000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000,
+    0x8000, 0x8000, 0x8000, 0x0000, 0x0000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x0001, 0x8000,
+    0x0001, 0x8000, 0x0001, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x0000, 0x0000, 0x8000, 0x8000,
+    0x8000, 0x8000, 0x8000, 0x0001, 0x0002, 0x8000, 0x0001, 0x0002, 0x8000, 0x0001, 0x8000, 0x8000,
+    0x8000, 0x8000, 0x8000, 0x0000, 0x0000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x0002, 0x8000,
+    0x0002, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x0000, 0x0000, 0x8000, 0x8000, 0x8000,
+    0x8000, 0x8000, 0x0002, 0x8000, 0x0002, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x0000,
+    0x0000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000,
+    0x8000, 0x0000, 0x0000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000,
+    0x8000, 0x8000, 0x8000, 0x0000, 0x0000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000,
+    0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x0000, 0x0000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000,
+    0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x8000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0003, 0x0003,
+    0x0003, 0x0003, 0x0003, 0x0003, 0x0003, 0x0003, 0x0003, 0x0003, 0x8003, 0x8003, 0x8003, 0x8003,
+    0x0003, 0x0003, 0x0003, 0x8003, 0x8003, 0x8003, 0x0003, 0x0003, 0x0003, 0x0003, 0x8003, 0x8003,
+    0x0003, 0x0003, 0x0003, 0x0003, 0x8003, 0x0003, 0x0003, 0x0003, 0x8003, 0x0003, 0x0003, 0x0003,
+    0x0003, 0x0003, 0x0003, 0x0003, 0x0003, 0x0003, 0x0003,
+};
+
+const GeofenceIndex replay_fences = {
+    GEOFENCE_VERSION, 533599728, -65080456, 1799, 3014, 31, 59, 270,
+    4, 283, fences, vertices, cells, candidates,
+};
@@ -0,0 +1,1012 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cgps.h"
+#include "fixlog.h"
+#include "nmea_output.h"
+#include "pico/stdlib.h"
+#include "uart_bridge.h"
+#include "uart_rx.h"
+
+// Fences along the log's track, compiled from fences.geojson:
+//   python fences.py host/replay/fences.geojson -o host/replay/fences.c --margin 3 --cell 20 --name replay_fences
+extern const GeofenceIndex replay_fences;
+
+// Default number of times every log is replayed
+#define REPLAY_ROUNDS 200
+
+#if NMEA_REPLAY_COUNT_ALLOCATIONS
+// Heap requests, counted through the linker's --wrap option (see host/CMakeLists.txt)
+static unsigned long allocations;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void *__real_aligned_alloc(size_t alignment, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+  allocations++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+  allocations++;
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+  allocations++;
+  return __real_realloc(ptr, size);
+}
+
+void *__wrap_aligned_alloc(size_t alignment, size_t size)
+{
+  allocations++;
+  return __real_aligned_alloc(alignment, size);
+}
+#endif
+
+/**
+ * @brief Returns a monotonic timestamp in nanoseconds.
+ */
+static uint64_t now_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/**
+ * @brief Counts the committed epochs.
+ */
+static void count_epoch(NMEAParser *parser, uint32_t event, void *ctx)
+{
+  (void)parser, (void)event;
+  (*(unsigned long *)ctx)++;
+}
+
+/**
+ * @brief Encodes a character as the word the RX state machine pushes for it.
+ *
+ * The delay-loop program takes two samples per bit, starting with the start bit, and the
+ * clock-divider program one sample per data bit followed by the stop bit; either way the last
+ * sample ends up in bit 31.
+ */
+static uint32_t encode(const UartRx *rx, uint8_t c)
+{
+  const UartPico *pico = rx->pico;
+  uint32_t word = 0;
+#if UART_PIO_CLKDIV
+  for (int k = 0; k < rx->rxBits; k++)
+  {
+    uint32_t level = k < pico->bits ? (c >> k) & 1 : 1;
+    word |= level << (32 - rx->rxBits + k);
+  }
+#else
+  for (int k = 0; k <= rx->rxBits; k++)
+  {
+    int bit = k / 2 - 1; // -1: start bit
+    uint32_t level = bit < 0 ? 0 : bit < pico->bits ? (c >> bit) & 1 : 1;
+    word |= level << (31 - rx->rxBits + k);
+  }
+#endif
+  return word;
+}
+
+/**
+ * @brief Reads every complete sentence, as the main loop of an application does.
+ */
+static unsigned long drain(CGPS *gps)
+{
+  unsigned long lines = 0;
+  while (GPS_isAvailable(gps) && GPS_read(gps) != NULL)
+  {
+    lines++;
+  }
+  return lines;
+}
+
+/**
+ * @brief Feeds the encoded log through the PIO RX FIFO, the RX interrupt, the framing and the parser.
+ *
+ * @return The number of lines read.
+ */
+static unsigned long feed(CGPS *gps, const uint32_t *words, size_t count)
+{
+  UartRx *rx = gps->nmeaParser.uart_rx;
+  unsigned long lines = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    if (!host_pio_rx_push(rx->pio, rx->sm, words[i]))
+    {
+      UartRx_handleIRQ(); // The FIFO is full: its interrupt drains it
+      lines += drain(gps);
+      host_pio_rx_push(rx->pio, rx->sm, words[i]);
+    }
+  }
+  UartRx_handleIRQ();
+  return lines + drain(gps);
+}
+
+/**
+ * @brief What every check run after the timed replay works on (see `replay_sections`).
+ */
+typedef struct
+{
+  CGPS *gps;             // The replayed GPS, its parser holding the last fix
+  const char *log;       // Contents of the log file
+  size_t length;         // Characters in `log`
+  const uint32_t *words; // `log` encoded as RX samples (see `encode`), one per character
+  const char *frames;    // File the binary frames are written to (-o), or NULL
+} ReplayContext;
+
+/**
+ * @brief Replays the log once more with a FixLog attached and reads the log back from the shim's flash.
+ *
+ * @return 0 if every fix logged was read back and the last one matches the parser's fix, 1 otherwise.
+ */
+static int replay_fixlog(const ReplayContext *context)
+{
+  CGPS *gps = context->gps;
+  size_t length = context->length;
+  static FixLog log;
+  FixLog_init(&log, &gps->nmeaParser);
+  FixLog_clear(&log);
+  feed(gps, context->words, length);
+  FixLog_flush(&log);
+  FixLog_free(&log);
+
+  FixLogStats stats;
+  FixLog_stats(&log, &stats);
+  FixLogReader reader;
+  FixLog_open(&log, &reader);
+  FixLogEntry entries[16];
+  FixLogEntry last = {0};
+  unsigned long read = 0;
+  size_t count;
+  while ((count = FixLog_read(&reader, entries, 16)) > 0)
+  {
+    read += count;
+    last = entries[count - 1];
+  }
+
+  NMEAFix fix;
+  GPS_fix(gps, &fix);
+  printf("  fix log: %lu fixes in %lu bytes (%.1f bytes/fix, %.1f bytes of NMEA), %lu pages, %lu read back\n",
+         (unsigned long)stats.fixes, (unsigned long)stats.bytes, (double)stats.bytes / stats.fixes,
+         (double)length / (stats.fixes + stats.skipped), (unsigned long)stats.pages, read);
+  bool matches = last.utc_time == fix.utc_time && last.latitude == fix.latitude && last.longitude == fix.longitude;
+  if (read != stats.fixes || reader.corrupt != 0 || stats.fixes == 0 || !matches)
+  {
+    fprintf(stderr, "nmea_replay: fix log read back %lu of %lu fixes, %lu corrupt pages\n", read,
+            (unsigned long)stats.fixes, (unsigned long)reader.corrupt);
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Saves the startup state of the replayed fixes and loads it back from the shim's flash, then
+ *        uploads a synthetic EPO segment whose records are acknowledged through the receive path.
+ *
+ * @return 0 if the state read back matches the last fix and every EPO record was acknowledged, 1 otherwise.
+ */
+static int replay_startup(const ReplayContext *context)
+{
+  CGPS *gps = context->gps;
+  NMEAFix fix;
+  GPS_fix(gps, &fix);
+  GPSStartupStats stats;
+  GPS_startupStats(gps, &stats);
+  bool saved = GPS_saveStartup(gps);
+  static GPSStartup loaded;
+  GPSStartup_init(&loaded, gps->nmeaParser.uart_tx, NULL);
+  bool matches = loaded.state.utc == GPSStartup_seconds(fix.date, fix.utc_time) &&
+                 loaded.state.latitude == fix.latitude && loaded.state.longitude == fix.longitude;
+
+  // One segment valid from the GPS hour of the last fix (GPS time counts from 1980-01-06, 18 s ahead of UTC)
+  static uint8_t epo[GPS_STARTUP_EPO_SATELLITES * GPS_STARTUP_EPO_RECORD];
+  uint32_t hour = (loaded.state.utc + 630720000u + 18) / 3600;
+  for (size_t i = 0; i < sizeof(epo); i++)
+  {
+    epo[i] = i % GPS_STARTUP_EPO_RECORD < 3 ? (uint8_t)(hour >> (8 * (i % GPS_STARTUP_EPO_RECORD))) : (uint8_t)i;
+  }
+  uint32_t queued = GPS_uploadEPO(gps, epo, sizeof(epo), 0);
+
+  static const char ack[] = "$PMTK001,721,3*34\r\n";
+  uint32_t words[sizeof(ack) - 1];
+  for (size_t i = 0; i < sizeof(ack) - 1; i++)
+  {
+    words[i] = encode(gps->nmeaParser.uart_rx, (uint8_t)ack[i]);
+  }
+  for (uint32_t i = 0; i < queued && GPSStartup_uploading(&gps->startup); i++)
+  {
+    feed(gps, words, sizeof(ack) - 1);
+  }
+  GPSStartupStats after;
+  GPS_startupStats(gps, &after);
+
+  printf("  startup: first fix %lu ms after the start, state %s and read back, %lu of %lu EPO records acknowledged\n",
+         (unsigned long)stats.ttff_ms, saved ? "saved" : "not saved", (unsigned long)after.epo_sent,
+         (unsigned long)queued);
+  if (!saved || !matches || stats.starts == 0 || queued == 0 || after.epo_sent != queued ||
+      GPSStartup_uploading(&gps->startup) || gps->startup.state.epo_end != hour * 3600 - 630720000u - 18 + GPS_STARTUP_EPO_HOURS * 3600)
+  {
+    fprintf(stderr, "nmea_replay: startup state or EPO upload failed\n");
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Replays the log with a reader that lags behind, then with one that keeps up, under the
+ *        high-rate profile's throttling.
+ *
+ * The lagging reader only reads a sentence once the receive ring is three quarters full, so the
+ * throttling must shed sentences without a character being lost; the reader that keeps up must
+ * get them back.
+ *
+ * @return 0 if sentences were shed without any overflow and restored afterwards, 1 otherwise.
+ */
+static int replay_rate(const ReplayContext *context)
+{
+  CGPS *gps = context->gps;
+  const uint32_t *words = context->words;
+  size_t length = context->length;
+  UartRx *rx = gps->nmeaParser.uart_rx;
+  const uint8_t rates[PMTK_OUTPUT_COUNT] = {gps->intervals.GLL, gps->intervals.RMC, gps->intervals.VTG,
+                                            gps->intervals.GGA, gps->intervals.GSA, gps->intervals.GSV};
+  GPSRate_plan(&gps->rate, rx, 1000, rates, gps->nmeaParser.pico->baud); // The log's 1 Hz, at the current baud rate
+
+  size_t quarter = RingBuffer_capacity(&rx->ring) / 4;
+  for (size_t i = 0; i < length; i++)
+  {
+    host_pio_rx_push(rx->pio, rx->sm, words[i]);
+    UartRx_handleIRQ();
+    while (RingBuffer_available(&rx->ring) >= 3 * quarter && GPS_isAvailable(gps))
+    {
+      GPS_read(gps);
+    }
+  }
+  drain(gps);
+  GPSRateStats lagging;
+  GPS_rateStats(gps, &lagging);
+  uint8_t shed[PMTK_OUTPUT_COUNT];
+  memcpy(shed, gps->rate.rates, sizeof(shed));
+
+  // Every step comes back after GPS_RATE_RESTORE_EPOCHS quiet epochs; bound the passes in case one never does
+  for (uint32_t round = 0;
+       memcmp(gps->rate.rates, rates, sizeof(rates)) != 0 && round <= lagging.sheds * GPS_RATE_RESTORE_EPOCHS; round++)
+  {
+    feed(gps, words, length);
+  }
+  GPSRateStats after;
+  GPS_rateStats(gps, &after);
+  gps->rate.active = false;
+
+  printf("  throttling: lagging reader %u%% ring peak, %lu sheds (PMTK314 GLL %u, VTG %u), %lu overflows; %lu restores\n",
+         lagging.peak, (unsigned long)lagging.sheds, shed[PMTK_OUTPUT_GLL], shed[PMTK_OUTPUT_VTG],
+         (unsigned long)after.overflows, (unsigned long)after.restores);
+  if (lagging.sheds == 0 || after.overflows != 0 || after.restores == 0 ||
+      memcmp(gps->rate.rates, rates, sizeof(rates)) != 0)
+  {
+    fprintf(stderr, "nmea_replay: throttling did not shed, lost characters or did not restore\n");
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Checks the fix smoother against the last fix of the replay and times its predictions.
+ *
+ * @return 0 if the estimate at the last epoch is within three sigma of the fix and moves
+ *         with its velocity between epochs, 1 otherwise.
+ */
+static int replay_track(const ReplayContext *context)
+{
+  CGPS *gps = context->gps;
+  NMEAFix fix;
+  GPS_fix(gps, &fix);
+  uint32_t epoch = gps->track.slots[0].time_us;
+  GPSTrackEstimate now, later;
+  bool tracking = GPS_predict(gps, epoch, &now);
+  GPS_predict(gps, epoch + 500000, &later);
+
+  const double meters = 6371008.8 * M_PI / 180 / NMEA_DEGREES_SCALE; // Of a latitude unit
+  double scale = cos((double)fix.latitude / NMEA_DEGREES_SCALE * M_PI / 180);
+  double error = hypot((now.latitude - fix.latitude) * meters, (now.longitude - fix.longitude) * meters * scale);
+  double moved = hypot((later.latitude - now.latitude) * meters, (later.longitude - now.longitude) * meters * scale);
+  double expected = hypot(now.north, now.east) / 1000 * 0.5;
+
+  const int calls = 1000000;
+  int64_t latitudes = 0; // Checked below, so the calls are kept
+  uint64_t start = now_ns();
+  for (int i = 0; i < calls; i++)
+  {
+    GPSTrackEstimate estimate;
+    GPS_predict(gps, epoch + (uint32_t)i, &estimate);
+    latitudes += estimate.latitude;
+  }
+  double ns = (double)(now_ns() - start) / calls;
+  double drift = fabs((double)latitudes / calls - now.latitude) * meters; // Mean over one second: half of it
+
+  printf("  track: %lu updates, %lu resets, estimate %.2f m from the last fix (sigma %.2f m), %.2f m/s, "
+         "%.1f ns/predict\n",
+         (unsigned long)gps->track.updates, (unsigned long)gps->track.resets, error, now.accuracy / 1000.0,
+         hypot(now.north, now.east) / 1000, ns);
+  if (!tracking || error > 3 * now.accuracy / 1000.0 || fabs(moved - expected) > 0.05 || drift > moved + 0.05)
+  {
+    fprintf(stderr, "nmea_replay: the fix smoother does not follow the fixes\n");
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Counts the geofence transitions by fence and keeps the UTC time of the first ones.
+ */
+typedef struct
+{
+  CGPS *gps;
+  unsigned long enters[4];
+  unsigned long exits[4];
+  uint32_t entered[4];
+  uint32_t left[4];
+} FenceLog;
+
+static void record_fence(NMEAParser *parser, uint32_t event, void *ctx)
+{
+  (void)parser, (void)event;
+  FenceLog *log = (FenceLog *)ctx;
+  const GeofenceEvent *fence = GPS_fenceEvent(log->gps);
+  if (fence->fence >= 4)
+  {
+    return;
+  }
+  unsigned long *count = fence->type == GEOFENCE_ENTER ? log->enters : log->exits;
+  uint32_t *time = fence->type == GEOFENCE_ENTER ? log->entered : log->left;
+  if (count[fence->fence]++ == 0)
+  {
+    time[fence->fence] = fence->utc_time / 1000;
+  }
+}
+
+/**
+ * @brief Replays the log twice through the replay fences and times the evaluation of a fix.
+ *
+ * The track starts in the depot, crosses the gate and ends in the pickup zone, and never comes
+ * near the yard; the second pass jumps back to the start, out of the pickup zone.
+ *
+ * @return 0 if every fence saw the expected transitions, 1 otherwise.
+ */
+static int replay_geofence(const ReplayContext *context)
+{
+  CGPS *gps = context->gps;
+  static FenceLog log;
+  memset(&log, 0, sizeof(log));
+  log.gps = gps;
+  if (GPS_setFences(gps, &replay_fences) != GEOFENCE_SUCCESS ||
+      GPS_on(gps, NMEA_EVENT_GEOFENCE, record_fence, &log) != NMEA_PARSER_SUCCESS)
+  {
+    fprintf(stderr, "nmea_replay: cannot load the replay fences\n");
+    return 1;
+  }
+  feed(gps, context->words, context->length);
+  feed(gps, context->words, context->length);
+  drain(gps);
+  NMEAParser_off(&gps->nmeaParser, record_fence, &log);
+  GeofenceStats stats;
+  GPS_fenceStats(gps, &stats);
+  GPS_setFences(gps, NULL);
+
+  // Evaluation alone, without listeners, at the fixes of both ends of the track
+  static Geofence geofence;
+  Geofence_init(&geofence, NULL);
+  Geofence_load(&geofence, &replay_fences);
+  NMEAFix fixes[2];
+  GPS_fix(gps, &fixes[0]);
+  fixes[1] = fixes[0];
+  fixes[1].latitude = 533613367;
+  fixes[1].longitude = -65056200;
+  const int calls = 1000000;
+  uint64_t start = now_ns();
+  for (int i = 0; i < calls; i++)
+  {
+    Geofence_fix(&geofence, &fixes[i & 1]);
+  }
+  double ns = (double)(now_ns() - start) / calls;
+
+  printf("  geofence: gate %06lu-%06lu, pickup from %06lu; %lu events in 2 passes, at most %u candidates and "
+         "%u edges per fix, %.1f ns/fix\n",
+         (unsigned long)log.entered[1], (unsigned long)log.left[1], (unsigned long)log.entered[2],
+         (unsigned long)(stats.enters + stats.exits), stats.candidates_max, stats.edges_max, ns);
+  static const unsigned long enters[4] = {1, 2, 2, 0};
+  static const unsigned long exits[4] = {0, 2, 1, 0};
+  if (memcmp(log.enters, enters, sizeof(enters)) != 0 || memcmp(log.exits, exits, sizeof(exits)) != 0)
+  {
+    fprintf(stderr, "nmea_replay: geofence events: enters %lu %lu %lu %lu, exits %lu %lu %lu %lu\n", log.enters[0],
+            log.enters[1], log.enters[2], log.enters[3], log.exits[0], log.exits[1], log.exits[2], log.exits[3]);
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Characters sent by a transmitter, decoded from the words written to its PIO FIFO.
+ */
+typedef struct
+{
+  uint8_t *data;
+  size_t length;
+  size_t capacity;
+} Capture;
+
+static void capture_word(uint32_t word, void *ctx)
+{
+  Capture *capture = (Capture *)ctx;
+#if UART_PIO_CLKDIV
+  uint8_t c = (uint8_t)(word >> 23); // See UartTx_frame
+#else
+  uint8_t c = (uint8_t)(word >> 1);
+#endif
+  if (capture->length < capture->capacity)
+  {
+    capture->data[capture->length++] = c;
+  }
+}
+
+#if UART_PIO_CLKDIV
+// Words written to a TX FIFO, recorded by record_word
+typedef struct
+{
+  uint32_t words[8];
+  size_t count;
+} WordTrace;
+
+static void record_word(uint32_t word, void *ctx)
+{
+  WordTrace *trace = (WordTrace *)ctx;
+  if (trace->count < sizeof(trace->words) / sizeof(trace->words[0]))
+  {
+    trace->words[trace->count++] = word;
+  }
+}
+
+/**
+ * @brief Checks that back-to-back frames on the line last exactly 1 + bits + stop bits and carry `text`.
+ *
+ * @return 0 if every bit of every frame has the expected level for a whole bit time, 1 otherwise.
+ */
+static int check_line(UartTx *tx, const uint32_t *words, const uint8_t *text, size_t count, long *period)
+{
+  const int bit = UART_PIO_CYCLES_PER_BIT;
+  const int frame = 1 + tx->pico->bits + tx->pico->stop;
+  uint8_t levels[1024];
+  long cycles = host_pio_sm_run(tx->pio, tx->sm, words, count, levels, sizeof(levels));
+  long start = 0;
+  while (start < cycles && levels[start] != 0)
+  {
+    start++; // First start bit
+  }
+  *period = cycles < 0 ? -1 : (cycles + 1 - start) / (long)count; // The run ends stalled on the next frame's `out`
+  if (cycles < 0 || (size_t)cycles > sizeof(levels) || cycles + 1 != start + (long)count * frame * bit)
+  {
+    return 1;
+  }
+  for (long t = start; t < cycles; t++)
+  {
+    long k = (t - start) / bit % frame; // Bit of the frame: start, data, stop
+    uint8_t c = text[(t - start) / bit / frame];
+    uint8_t level = k == 0 ? 0 : k <= tx->pico->bits ? (c >> (k - 1)) & 1 : 1;
+    if (levels[t] != level)
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Runs the clock-divider TX program on the shim and checks the frames it puts on the line.
+ *
+ * Both the words UartTx formats and the RX samples the zero-copy bridge writes to the TX FIFO
+ * unchanged are sent, with one and two stop bits. Back-to-back frames must take exactly
+ * 1 + bits + stop bits, so with one stop bit the transmitter keeps up with a receiver at the same
+ * rate, which is what the zero-copy bridge relies on.
+ *
+ * @return 0 if every frame has the expected length and bits, 1 otherwise.
+ */
+static int replay_tx(const ReplayContext *context)
+{
+  static const uint8_t text[4] = {'U', 0x00, 0xFF, 0xA5};
+  static UartPico picos[2] = {UART_PICO(), UART_PICO()};
+  long periods[2][2] = {{0}};
+  int result = 0;
+  for (int k = 0; k < 2; k++)
+  {
+    picos[k].baud = 115200;
+    picos[k].stop = (uint8_t)(k + 1);
+    UartTx *tx = UartTx_init(&picos[k], 12);
+    if (tx == NULL || UartTx_activate(tx) != 0)
+    {
+      fprintf(stderr, "nmea_replay: cannot start the transmitter\n");
+      return 1;
+    }
+    WordTrace formatted = {{0}, 0};
+    host_pio_tx_listen(tx->pio, tx->sm, record_word, &formatted);
+    for (size_t i = 0; i < sizeof(text); i++)
+    {
+      UartTx_write(tx, text[i]);
+    }
+    host_pio_tx_listen(tx->pio, tx->sm, NULL, NULL);
+    uint32_t samples[4];
+    for (size_t i = 0; i < sizeof(text); i++)
+    {
+      samples[i] = encode(context->gps->nmeaParser.uart_rx, text[i]);
+    }
+    if (formatted.count != sizeof(text) || check_line(tx, formatted.words, text, sizeof(text), &periods[k][0]) != 0 ||
+        check_line(tx, samples, text, sizeof(text), &periods[k][1]) != 0)
+    {
+      fprintf(stderr, "nmea_replay: %d stop bit(s): TX frames of %ld and %ld cycles (words, RX samples), "
+                      "expected %d with the right bits\n",
+              k + 1, periods[k][0], periods[k][1], (10 + k) * UART_PIO_CYCLES_PER_BIT);
+      result = 1;
+    }
+    UartTx_free(tx);
+  }
+  printf("  tx: %ld cycles per 8N1 frame, %ld per 8N2 frame (RX samples %ld, %ld); an RX frame takes %d\n",
+         periods[0][0], periods[1][0], periods[0][1], periods[1][1], 10 * UART_PIO_CYCLES_PER_BIT);
+  return result;
+}
+#endif
+
+/**
+ * @brief Appends one synthetic RTCM 3 frame of a message number and payload length to a stream.
+ */
+static size_t rtcm3_frame(uint8_t *out, uint16_t number, uint16_t payload, uint32_t seed)
+{
+  out[0] = UART_BRIDGE_RTCM3_PREAMBLE;
+  out[1] = (uint8_t)(payload >> 8);
+  out[2] = (uint8_t)payload;
+  for (uint16_t i = 0; i < payload + 3; i++)
+  {
+    seed = seed * 1103515245u + 12345u;
+    out[3 + i] = (uint8_t)(seed >> 16); // Payload and CRC; the bridge does not check the CRC
+  }
+  out[3] = (uint8_t)(number >> 4);
+  out[4] = (uint8_t)(number << 4 | (out[4] & 0x0F));
+  return payload + 6u;
+}
+
+/**
+ * @brief Mirrors the log to a logger through a bridge while the parser reads it, then forwards
+ *        synthetic RTCM 3 corrections from a second receiver to the module's transmitter.
+ *
+ * The host has no DMA channel, so both bridges take the copy path: the mirror reads a tap of
+ * the parser's receiver, the corrections bridge is the only reader of its receiver.
+ *
+ * @return 0 if the logger got exactly the GGA and RMC sentences, the module exactly the RTCM
+ *         frames that pass the filter, each whole, and the parser still read every line; 1 otherwise.
+ */
+static int replay_bridge(const ReplayContext *context)
+{
+  CGPS *gps = context->gps;
+  const char *log = context->log;
+  size_t length = context->length;
+  const uint32_t *words = context->words;
+  UartRx *rx = gps->nmeaParser.uart_rx;
+  static UartPico logger_pico = UART_PICO();
+  logger_pico.baud = 115200;
+  UartTx *logger = UartTx_init(&logger_pico, 10);
+  UartBridge *mirror = logger ? UartBridge_init(rx, logger, UART_BRIDGE_NMEA) : NULL;
+  if (mirror == NULL || UartTx_activate(logger) != 0 || UartBridge_filter(mirror, "GGA,RMC", true) != 0 ||
+      UartBridge_activate(mirror, UART_BRIDGE_STATIC_TAP_SIZE) != 0)
+  {
+    fprintf(stderr, "nmea_replay: cannot start the mirror bridge\n");
+    return 1;
+  }
+
+  // What the logger should get: the GGA and RMC lines of the log
+  Capture expected = {(uint8_t *)malloc(length), 0, length};
+  Capture logged = {(uint8_t *)malloc(length + 1), 0, length + 1};
+  for (size_t i = 0; i < length;)
+  {
+    const char *end = memchr(log + i, '\n', length - i);
+    size_t line = end ? (size_t)(end - (log + i)) + 1 : length - i;
+    size_t first = i + line;
+    while (first > i && log[first - 1] != '$' && log[first - 1] != '!')
+    {
+      first--; // A sentence cut short by another one starts again at its '$'
+    }
+    size_t sentence = i + line - first + 1;
+    if (end != NULL && first > i && sentence > 6 &&
+        (memcmp(log + first + 2, "GGA", 3) == 0 || memcmp(log + first + 2, "RMC", 3) == 0))
+    {
+      memcpy(expected.data + expected.length, log + first - 1, sentence);
+      expected.length += sentence;
+    }
+    i += line;
+  }
+
+  host_pio_tx_listen(logger->pio, logger->sm, capture_word, &logged);
+  unsigned long lines = 0;
+  uint64_t polling = 0;
+  for (size_t i = 0; i <= length; i++)
+  {
+    if (i == length || !host_pio_rx_push(rx->pio, rx->sm, words[i]))
+    {
+      UartRx_handleIRQ(); // The FIFO is full: its interrupt drains it, then the main loop runs
+      lines += drain(gps);
+      uint64_t start = now_ns();
+      UartBridge_poll(mirror);
+      polling += now_ns() - start;
+      if (i < length)
+      {
+        host_pio_rx_push(rx->pio, rx->sm, words[i]);
+      }
+    }
+  }
+  host_pio_tx_listen(logger->pio, logger->sm, NULL, NULL);
+  UartBridgeStats mirrored;
+  UartBridge_stats(mirror, &mirrored);
+  UartBridge_free(mirror);
+  UartTx_free(logger);
+
+  // Corrections from a base link: frames of four message numbers with noise between them
+  static UartPico base_pico = UART_PICO();
+  base_pico.baud = 115200;
+  UartRx *base = UartRx_init(&base_pico, 11);
+  UartBridge *corrections = base ? UartBridge_init(base, gps->nmeaParser.uart_tx, UART_BRIDGE_RTCM3) : NULL;
+  if (corrections == NULL || UartRx_activate(base) != 0 || UartBridge_filter(corrections, "1005,1077", true) != 0 ||
+      UartBridge_activate(corrections, 0) != 0)
+  {
+    fprintf(stderr, "nmea_replay: cannot start the corrections bridge\n");
+    return 1;
+  }
+  static const uint16_t numbers[4] = {1005, 1077, 1087, 1230};
+  // The longest frame and the characters received between two polls fit the default 128-character
+  // ring, which is also the largest one of the static build (UART_RX_STATIC_FIFO_SIZE)
+  static const uint16_t payloads[4] = {19, 96, 72, 8};
+  const int frames = 64;
+  uint8_t *stream = (uint8_t *)malloc(frames * 136);
+  Capture wanted = {(uint8_t *)malloc(frames * 136), 0, (size_t)frames * 136};
+  Capture received = {(uint8_t *)malloc(frames * 136), 0, (size_t)frames * 136};
+  size_t size = 0;
+  for (int k = 0; k < frames; k++)
+  {
+    size_t frame = rtcm3_frame(stream + size, numbers[k % 4], payloads[k % 4], k);
+    if (k % 4 < 2)
+    {
+      memcpy(wanted.data + wanted.length, stream + size, frame);
+      wanted.length += frame;
+    }
+    size += frame;
+    if (k % 5 == 0)
+    {
+      stream[size++] = 0xD3; // A preamble with the reserved bits set, then noise
+      stream[size++] = 0xFF;
+      stream[size++] = 0x00;
+    }
+  }
+
+  host_pio_tx_listen(gps->nmeaParser.uart_tx->pio, gps->nmeaParser.uart_tx->sm, capture_word, &received);
+  size_t command = size / 2;
+  for (size_t i = 0; i <= size; i++)
+  {
+    if (i == size || !host_pio_rx_push(base->pio, base->sm, encode(base, stream[i])))
+    {
+      UartRx_handleIRQ();
+      UartBridge_poll(corrections);
+      if (i < size)
+      {
+        host_pio_rx_push(base->pio, base->sm, encode(base, stream[i]));
+      }
+    }
+    if (i == command)
+    {
+      UartTx_print(gps->nmeaParser.uart_tx, PMTK_TEST "\r\n"); // Queued between two whole frames
+    }
+  }
+  host_pio_tx_listen(gps->nmeaParser.uart_tx->pio, gps->nmeaParser.uart_tx->sm, NULL, NULL);
+  UartBridgeStats forwarded;
+  UartBridge_stats(corrections, &forwarded);
+  UartBridge_free(corrections);
+  UartRx_free(base);
+
+  // The command must sit whole between two frames: take it out, the rest must be the frames
+  const char *pmtk = PMTK_TEST "\r\n";
+  size_t pmtk_length = strlen(pmtk);
+  bool whole = false;
+  for (size_t i = 0, offset = 0; i + pmtk_length <= received.length && offset <= wanted.length;)
+  {
+    if (memcmp(received.data + i, pmtk, pmtk_length) == 0)
+    {
+      memmove(received.data + i, received.data + i + pmtk_length, received.length - i - pmtk_length);
+      received.length -= pmtk_length;
+      whole = i == offset; // Nothing before it but whole frames
+      break;
+    }
+    if (received.data[i] == UART_BRIDGE_RTCM3_PREAMBLE && i == offset)
+    {
+      offset += ((received.data[i + 1] & 3) << 8 | received.data[i + 2]) + 6u;
+    }
+    i++;
+  }
+
+  printf("  bridge: mirrored %lu of %lu lines (GGA,RMC), %lu filtered, %lu bytes dropped, %.1f ns/byte polled; "
+         "%lu RTCM frames (1005,1077), %lu filtered, %lu bytes of noise dropped\n",
+         (unsigned long)mirrored.messages, lines, (unsigned long)mirrored.filtered, (unsigned long)mirrored.dropped,
+         (double)polling / length, (unsigned long)forwarded.messages, (unsigned long)forwarded.filtered,
+         (unsigned long)forwarded.dropped);
+  int result = 0;
+  if (logged.length != expected.length || memcmp(logged.data, expected.data, expected.length) != 0 ||
+      mirrored.overruns != 0 || mirrored.messages + mirrored.filtered != lines)
+  {
+    fprintf(stderr, "nmea_replay: the mirror sent %zu bytes instead of %zu (%lu overruns)\n", logged.length,
+            expected.length, (unsigned long)mirrored.overruns);
+    result = 1;
+  }
+  if (!whole || received.length != wanted.length || memcmp(received.data, wanted.data, wanted.length) != 0 ||
+      forwarded.overruns != 0)
+  {
+    fprintf(stderr, "nmea_replay: the corrections bridge sent %zu bytes instead of %zu (command %s)\n",
+            received.length, wanted.length, whole ? "whole" : "split");
+    result = 1;
+  }
+  free(expected.data);
+  free(logged.data);
+  free(stream);
+  free(wanted.data);
+  free(received.data);
+  return result;
+}
+
+/**
+ * @brief Queues the fix and the statistics of every epoch and writes them in one batch, as the
+ *        examples do with NMEA_BINARY_OUTPUT.
+ */
+static void output_epoch(NMEAParser *parser, uint32_t event, void *ctx)
+{
+  (void)event;
+  NMEAOutput *output = (NMEAOutput *)ctx;
+  NMEAFix fix;
+  NMEAParser_fix(parser, &fix);
+  NMEAOutput_fix(output, &fix);
+  NMEAOutput_stats(output, &parser->stats);
+  NMEAOutput_flush(output);
+}
+
+/**
+ * @brief Replays the log once more and writes the binary frames of every epoch to a file (see frames.py).
+ *
+ * @return 0 on success or without -o, 1 if the file cannot be written.
+ */
+static int replay_frames(const ReplayContext *context)
+{
+  const char *path = context->frames;
+  if (path == NULL)
+  {
+    return 0; // Only with -o
+  }
+  FILE *file = fopen(path, "wb");
+  if (file == NULL)
+  {
+    fprintf(stderr, "nmea_replay: cannot write %s\n", path);
+    return 1;
+  }
+  static NMEAOutput output;
+  NMEAOutput_init(&output);
+  host_stdio_redirect(file);
+  CGPS *gps = context->gps;
+  GPS_on(gps, NMEA_EVENT_EPOCH, output_epoch, &output);
+  feed(gps, context->words, context->length);
+  NMEAParser_off(&gps->nmeaParser, output_epoch, &output);
+  host_stdio_redirect(NULL);
+  long bytes = ftell(file);
+  fclose(file);
+  printf("  binary output: %lu frames in %ld bytes (%lu batches) written to %s\n", (unsigned long)output.frames,
+         bytes, (unsigned long)output.batches, path);
+  return 0;
+}
+
+/**
+ * @brief A check run after the timed replay; returns 0 if it passed, 1 otherwise.
+ */
+typedef struct
+{
+  const char *name;
+  int (*run)(const ReplayContext *context);
+} ReplaySection;
+
+// Checks run after the timed replay, in this order: each one leaves the GPS as the next expects it
+static const ReplaySection replay_sections[] = {
+    {"track", replay_track},
+    {"fix log", replay_fixlog},
+    {"startup", replay_startup},
+    {"binary output", replay_frames},
+    {"throttling", replay_rate},
+    {"geofence", replay_geofence},
+    {"bridge", replay_bridge},
+#if UART_PIO_CLKDIV
+    {"tx", replay_tx},
+#endif
+};
+
+/**
+ * @brief Loads a log file into memory.
+ *
+ * @return The contents, or NULL if the file cannot be read.
+ */
+static char *load(const char *path, size_t *length)
+{
+  FILE *file = fopen(path, "rb");
+  if (file == NULL)
+  {
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *data = size > 0 ? (char *)malloc(size) : NULL;
+  if (data != NULL && fread(data, 1, size, file) != (size_t)size)
+  {
+    free(data);
+    data = NULL;
+  }
+  fclose(file);
+  *length = size > 0 ? (size_t)size : 0;
+  return data;
+}
+
+/**
+ * @brief Replays one log `rounds` times and prints the results.
+ *
+ * @return 0 on success, 1 if the log cannot be read, nothing was accepted, the replay allocated
+ *         memory, or fewer than `min_rate` sentences per second were processed.
+ */
+static int replay(const char *path, long rounds, double min_rate, const char *frames)
+{
+  size_t length;
+  char *log = load(path, &length);
+  if (log == NULL)
+  {
+    fprintf(stderr, "nmea_replay: cannot read %s\n", path);
+    return 1;
+  }
+
+  static CGPS gps;
+  IntervalType intervals = DEFAULT_INTERVALS();
+  unsigned long epochs = 0;
+#if NMEA_REPLAY_COUNT_ALLOCATIONS
+  unsigned long allocations_init = allocations;
+#endif
+  GPS_init(&gps, intervals, 3, 4);
+#if NMEA_REPLAY_COUNT_ALLOCATIONS
+  allocations_init = allocations - allocations_init;
+#endif
+  GPS_on(&gps, NMEA_EVENT_EPOCH, count_epoch, &epochs);
+  gps.nmeaParser.enabled = NMEA_SENTENCES_ALL;
+
+  uint32_t *words = (uint32_t *)malloc(length * sizeof(uint32_t));
+  for (size_t i = 0; i < length; i++)
+  {
+    words[i] = encode(gps.nmeaParser.uart_rx, (uint8_t)log[i]);
+  }
+
+#if NMEA_REPLAY_COUNT_ALLOCATIONS
+  unsigned long allocations_before = allocations;
+#endif
+  unsigned long lines = 0;
+  uint64_t start = now_ns();
+  for (long r = 0; r < rounds; r++)
+  {
+    lines += feed(&gps, words, length);
+  }
+  uint64_t elapsed = now_ns() - start;
+#if NMEA_REPLAY_COUNT_ALLOCATIONS
+  unsigned long allocated = allocations - allocations_before;
+#endif
+
+  NMEAParserStats stats;
+  NMEAParser_stats(&gps.nmeaParser, &stats);
+  unsigned long accepted = 0;
+  unsigned long rejected = 0;
+  for (int type = 0; type < NMEA_SENTENCE_COUNT; type++)
+  {
+    accepted += stats.accepted[type];
+    rejected += stats.rejected[type];
+  }
+  NMEAFix fix;
+  GPS_fix(&gps, &fix);
+
+  double rate = lines * 1e9 / elapsed;
+  printf("%s: %zu bytes, %ld rounds\n", path, length, rounds);
+  printf("  per pass: %lu lines, %lu accepted, %lu bad checksum, %lu truncated, %lu overrun, %lu epochs\n",
+         lines / rounds, accepted / rounds, rejected / rounds, (unsigned long)stats.line_truncations / rounds,
+         (unsigned long)stats.ring_overflows / rounds, epochs / rounds);
+  printf("  last fix: %06lu.%03lu %.7f %.7f\n", (unsigned long)(fix.utc_time / 1000),
+         (unsigned long)(fix.utc_time % 1000), (double)fix.latitude / NMEA_DEGREES_SCALE,
+         (double)fix.longitude / NMEA_DEGREES_SCALE);
+  printf("  %.0f sentences/s, %.1f ns/sentence (decode, framing and parse)\n", rate, (double)elapsed / lines);
+
+  int result = accepted == 0 ? 1 : 0;
+#if NMEA_REPLAY_COUNT_ALLOCATIONS
+  printf("  %.2f allocations/sentence, %lu during GPS_init\n", (double)allocated / lines, allocations_init);
+  result |= allocated != 0;
+  result |= RP_PICO_STATIC_ALLOC && allocations_init != 0; // The static build must not allocate at all
+#else
+  printf("  allocations/sentence not counted (needs GNU ld --wrap)\n");
+#endif
+  if (rate < min_rate)
+  {
+    fprintf(stderr, "nmea_replay: %s: %.0f sentences/s, below the minimum of %.0f\n", path, rate, min_rate);
+    result = 1;
+  }
+
+  const ReplayContext context = {&gps, log, length, words, frames};
+  for (size_t i = 0; i < sizeof(replay_sections) / sizeof(replay_sections[0]); i++)
+  {
+    if (replay_sections[i].run(&context) != 0)
+    {
+      fprintf(stderr, "nmea_replay: %s: %s check failed\n", path, replay_sections[i].name);
+      result = 1;
+    }
+  }
+
+  GPS_free(&gps);
+  free(words);
+  free(log);
+  return result;
+}
+
+/**
+ * @brief Replays recorded NMEA logs through the whole receive path on the host.
+ *
+ * Every byte of a log is encoded as the raw sample of the PIO RX program and pushed into the
+ * shim's RX FIFO, so the replay runs the interrupt handler, the decoder, the ring, the line
+ * framing, the checksum check, the parser, the epoch assembler and the `CGPS` accessors; corrupt
+ * and truncated lines take the same paths as on the device.
+ *
+ * Usage: nmea_replay [-r rounds] [-m min_sentences_per_s] [-o frames_file] log...
+ *
+ * @return 0 on success, 1 if any log fails (see `replay`) or on a usage error.
+ */
+int main(int argc, char **argv)
+{
+  long rounds = REPLAY_ROUNDS;
+  double min_rate = 0;
+  const char *frames = NULL;
+  int arg = 1;
+  for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2)
+  {
+    if (strcmp(argv[arg], "-r") == 0)
+    {
+      rounds = atol(argv[arg + 1]);
+    }
+    else if (strcmp(argv[arg], "-m") == 0)
+    {
+      min_rate = atof(argv[arg + 1]);
+    }
+    else if (strcmp(argv[arg], "-o") == 0)
+    {
+      frames = argv[arg + 1]; // Each log overwrites it: pass one log with -o
+    }
+  }
+  if (arg == argc || rounds <= 0)
+  {
+    fprintf(stderr, "usage: nmea_replay [-r rounds] [-m min_sentences_per_s] [-o frames_file] log...\n");
+    return 1;
+  }
+
+  int result = 0;
+  for (; arg < argc; arg++)
+  {
+    result |= replay(argv[arg], rounds, min_rate, frames);
+  }
+  return result;
+}
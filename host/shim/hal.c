@@ -0,0 +1,653 @@
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "hardware/sync.h"
+#include "hardware/structs/systick.h"
+#include "pico/flash.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// Host implementation of the SDK subset used by the uart, nmea and gps modules.
+// Resource allocation (instruction memory, state machines) behaves like the SDK so the
+// drivers take their normal paths; everything that would touch hardware is inert.
+
+pio_hw_t host_pio_hw[NUM_PIOS];
+systick_hw_t host_systick_hw;
+
+static uint32_t host_pio_used_instructions[NUM_PIOS]; // Bit per occupied instruction slot
+static uint8_t host_pio_claimed_sms[NUM_PIOS];        // Bit per claimed state machine
+
+// RX FIFO of one state machine, filled by host_pio_rx_push
+typedef struct
+{
+  uint32_t words[HOST_PIO_RX_FIFO_DEPTH];
+  uint8_t head;
+  uint8_t count;
+} host_pio_rx_fifo_t;
+
+static host_pio_rx_fifo_t host_pio_rx_fifos[NUM_PIOS][NUM_PIO_STATE_MACHINES];
+
+// Observer of the words written to a TX FIFO, set by host_pio_tx_listen
+typedef struct
+{
+  host_pio_tx_listener_t listener;
+  void *ctx;
+} host_pio_tx_tap_t;
+
+static host_pio_tx_tap_t host_pio_tx_taps[NUM_PIOS][NUM_PIO_STATE_MACHINES];
+
+// Registers of a state machine, as far as host_pio_sm_run and pio_sm_exec model them
+typedef struct
+{
+  pio_sm_config config;
+  uint8_t pc;
+  uint32_t x, y, isr, osr;
+  uint8_t osr_count; // Bits shifted out of OSR since it was filled; at the threshold it is empty
+  uint8_t level;     // Level of the pin driven by OUT, SET and side-set
+} host_pio_sm_t;
+
+static host_pio_sm_t host_pio_sms[NUM_PIOS][NUM_PIO_STATE_MACHINES];
+
+uint64_t time_us_64(void)
+{
+  static uint64_t origin;
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  uint64_t us = (uint64_t)now.tv_sec * 1000000u + now.tv_nsec / 1000;
+  if (origin == 0)
+  {
+    origin = us;
+  }
+  return us - origin;
+}
+
+uint32_t time_us_32(void)
+{
+  return (uint32_t)time_us_64();
+}
+
+void sleep_us(uint64_t us)
+{
+  struct timespec delay = {(time_t)(us / 1000000u), (long)(us % 1000000u) * 1000};
+  nanosleep(&delay, NULL);
+}
+
+void sleep_ms(uint32_t ms)
+{
+  sleep_us((uint64_t)ms * 1000);
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past)
+{
+  (void)us, (void)callback, (void)user_data, (void)fire_if_past;
+  return 1;
+}
+
+bool cancel_alarm(alarm_id_t alarm_id)
+{
+  (void)alarm_id;
+  return true;
+}
+
+bool stdio_init_all(void) { return true; }
+bool stdio_usb_connected(void) { return true; }
+
+static FILE *host_stdio; // Redirected output of stdio_put_string, or NULL for stdout
+
+void host_stdio_redirect(void *file)
+{
+  host_stdio = (FILE *)file;
+}
+
+int stdio_put_string(const char *s, int len, bool newline, bool cr_translation)
+{
+  (void)cr_translation; // Nothing is translated on the host
+  FILE *file = host_stdio != NULL ? host_stdio : stdout;
+  fwrite(s, 1, len, file);
+  if (newline)
+  {
+    fputc('\n', file);
+  }
+  return len;
+}
+
+uint32_t clock_get_hz(enum clock_index clk_index)
+{
+  (void)clk_index;
+  return 125000000;
+}
+
+void gpio_init(uint gpio) { (void)gpio; }
+void gpio_set_dir(uint gpio, bool out) { (void)gpio, (void)out; }
+void gpio_pull_up(uint gpio) { (void)gpio; }
+void gpio_set_inover(uint gpio, uint value) { (void)gpio, (void)value; }
+void gpio_set_outover(uint gpio, uint value) { (void)gpio, (void)value; }
+
+uint32_t save_and_disable_interrupts(void) { return 0; }
+void restore_interrupts(uint32_t status) { (void)status; }
+
+// Spin locks are claimed like the SDK does (32 of them); taking one cannot contend on one thread
+static spin_lock_t host_spin_locks[32];
+static uint32_t host_spin_locks_claimed;
+
+int spin_lock_claim_unused(bool required)
+{
+  (void)required;
+  for (int i = 0; i < 32; i++)
+  {
+    if (!(host_spin_locks_claimed & (1u << i)))
+    {
+      host_spin_locks_claimed |= 1u << i;
+      return i;
+    }
+  }
+  return -1;
+}
+
+spin_lock_t *spin_lock_instance(uint lock_num) { return &host_spin_locks[lock_num]; }
+uint32_t spin_lock_blocking(spin_lock_t *lock)
+{
+  *lock = 1;
+  return 0;
+}
+void spin_unlock(spin_lock_t *lock, uint32_t saved_irq)
+{
+  (void)saved_irq;
+  *lock = 0;
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) { (void)num, (void)handler; }
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority) { (void)num, (void)handler, (void)order_priority; }
+void irq_set_enabled(uint num, bool enabled) { (void)num, (void)enabled; }
+
+int dma_claim_unused_channel(bool required)
+{
+  if (required)
+  {
+    abort(); // Matches the SDK's panic when no channel is free
+  }
+  return -1;
+}
+
+static dma_channel_hw_t host_dma_hw[NUM_DMA_CHANNELS];
+
+void dma_channel_unclaim(uint channel) { (void)channel; }
+dma_channel_config dma_channel_get_default_config(uint channel)
+{
+  (void)channel;
+  dma_channel_config c = {0};
+  return c;
+}
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) { (void)c, (void)size; }
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) { (void)c, (void)incr; }
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) { (void)c, (void)incr; }
+void channel_config_set_dreq(dma_channel_config *c, uint dreq) { (void)c, (void)dreq; }
+void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits) { (void)c, (void)write, (void)size_bits; }
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger)
+{
+  (void)channel, (void)config, (void)write_addr, (void)read_addr, (void)transfer_count, (void)trigger;
+}
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count)
+{
+  (void)channel, (void)read_addr, (void)transfer_count;
+}
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger) { (void)channel, (void)trans_count, (void)trigger; }
+void dma_channel_abort(uint channel) { (void)channel; }
+bool dma_channel_is_busy(uint channel)
+{
+  (void)channel;
+  return false;
+}
+dma_channel_hw_t *dma_channel_hw_addr(uint channel)
+{
+  return &host_dma_hw[channel];
+}
+void dma_channel_set_irq0_enabled(uint channel, bool enabled) { (void)channel, (void)enabled; }
+bool dma_channel_get_irq0_status(uint channel)
+{
+  (void)channel;
+  return false;
+}
+void dma_channel_acknowledge_irq0(uint channel) { (void)channel; }
+
+uint pio_encode_set(enum pio_src_dest dest, uint value)
+{
+  return 0xe000u | (dest & 7u) << 5 | (value & 0x1fu);
+}
+
+uint pio_encode_mov(enum pio_src_dest dest, enum pio_src_dest src)
+{
+  return 0xa000u | (dest & 7u) << 5 | (src & 7u);
+}
+
+uint pio_encode_pull(bool if_empty, bool block)
+{
+  return 0x8080u | (if_empty ? 0x40u : 0) | (block ? 0x20u : 0);
+}
+
+uint pio_encode_jmp(uint addr)
+{
+  return addr & 0x1fu;
+}
+
+uint pio_encode_out(enum pio_src_dest dest, uint count)
+{
+  return 0x6000u | (dest & 7u) << 5 | (count & 0x1fu);
+}
+
+PIO pio_get_instance(uint instance)
+{
+  return &host_pio_hw[instance];
+}
+
+uint pio_get_index(PIO pio)
+{
+  return (uint)(pio - host_pio_hw);
+}
+
+/**
+ * @brief Finds the highest offset a program fits at, or -1; programs are placed top-down like the SDK.
+ */
+static int host_pio_find_offset(PIO pio, const pio_program_t *program)
+{
+  uint32_t mask = (1u << program->length) - 1;
+  for (int offset = PIO_INSTRUCTION_COUNT - program->length; offset >= 0; offset--)
+  {
+    if (program->origin >= 0 && offset != program->origin)
+    {
+      continue;
+    }
+    if (!(host_pio_used_instructions[pio_get_index(pio)] & (mask << offset)))
+    {
+      return offset;
+    }
+  }
+  return -1;
+}
+
+bool pio_can_add_program(PIO pio, const pio_program_t *program)
+{
+  return host_pio_find_offset(pio, program) >= 0;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program)
+{
+  int offset = host_pio_find_offset(pio, program);
+  if (offset < 0)
+  {
+    abort(); // Matches the SDK's panic when there is no room
+  }
+  host_pio_used_instructions[pio_get_index(pio)] |= ((1u << program->length) - 1) << offset;
+  for (uint i = 0; i < program->length; i++)
+  {
+    uint16_t instr = program->instructions[i];
+    pio->instr_mem[offset + i] = (instr & 0xe000u) == 0 ? instr + offset : instr; // Relocates JMPs like the SDK
+  }
+  return (uint)offset;
+}
+
+void pio_remove_program(PIO pio, const pio_program_t *program, uint loaded_offset)
+{
+  host_pio_used_instructions[pio_get_index(pio)] &= ~(((1u << program->length) - 1) << loaded_offset);
+}
+
+int pio_claim_unused_sm(PIO pio, bool required)
+{
+  uint index = pio_get_index(pio);
+  for (int sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++)
+  {
+    if (!(host_pio_claimed_sms[index] & (1u << sm)))
+    {
+      host_pio_claimed_sms[index] |= 1u << sm;
+      return sm;
+    }
+  }
+  if (required)
+  {
+    abort();
+  }
+  return -1;
+}
+
+void pio_sm_unclaim(PIO pio, uint sm)
+{
+  host_pio_claimed_sms[pio_get_index(pio)] &= ~(1u << sm);
+}
+
+pio_sm_config pio_get_default_sm_config(void)
+{
+  pio_sm_config c = {0, 31, 0, false, true, false, 32};
+  return c;
+}
+void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap)
+{
+  c->wrap_target = (uint8_t)wrap_target;
+  c->wrap = (uint8_t)wrap;
+}
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base) { (void)c, (void)in_base; }
+void sm_config_set_jmp_pin(pio_sm_config *c, uint pin) { (void)c, (void)pin; }
+void sm_config_set_in_shift(pio_sm_config *c, bool shift_right, bool autopush, uint push_threshold) { (void)c, (void)shift_right, (void)autopush, (void)push_threshold; }
+void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold)
+{
+  c->out_shift_right = shift_right;
+  c->autopull = autopull;
+  c->pull_threshold = (uint8_t)pull_threshold;
+}
+void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count) { (void)c, (void)out_base, (void)out_count; }
+void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base) { (void)c, (void)sideset_base; }
+void sm_config_set_sideset(pio_sm_config *c, uint bit_count, bool optional, bool pindirs)
+{
+  (void)pindirs;
+  c->sideset_bits = (uint8_t)bit_count;
+  c->sideset_optional = optional;
+}
+void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join) { (void)c, (void)join; }
+void pio_gpio_init(PIO pio, uint pin) { (void)pio, (void)pin; }
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out) { (void)pio, (void)sm, (void)pin_base, (void)pin_count, (void)is_out; }
+void pio_sm_set_set_pins(PIO pio, uint sm, uint set_base, uint set_count) { (void)pio, (void)sm, (void)set_base, (void)set_count; }
+int pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config)
+{
+  host_pio_sm_t *state = &host_pio_sms[pio_get_index(pio)][sm];
+  memset(state, 0, sizeof(host_pio_sm_t));
+  state->config = *config;
+  state->pc = (uint8_t)initial_pc;
+  state->osr_count = 32; // Empty, as after a restart
+  state->level = 1;      // Pulled up
+  return 0;
+}
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) { (void)pio, (void)sm, (void)enabled; }
+void pio_sm_restart(PIO pio, uint sm) { (void)pio, (void)sm; }
+void pio_sm_set_clkdiv(PIO pio, uint sm, float div) { (void)pio, (void)sm, (void)div; }
+void pio_sm_clkdiv_restart(PIO pio, uint sm) { (void)pio, (void)sm; }
+/**
+ * @brief Reads a source of MOV (PINS, STATUS and the operations are not modelled and read as 0).
+ */
+static uint32_t host_pio_read(const host_pio_sm_t *state, uint source)
+{
+  switch (source)
+  {
+  case pio_x:
+    return state->x;
+  case pio_y:
+    return state->y;
+  case pio_isr:
+    return state->isr;
+  case pio_osr:
+    return state->osr;
+  default:
+    return 0;
+  }
+}
+
+/**
+ * @brief Writes a destination of OUT, MOV or SET; returns false for PC and EXEC, which are not modelled.
+ */
+static bool host_pio_write(host_pio_sm_t *state, uint dest, uint32_t value)
+{
+  switch (dest)
+  {
+  case pio_pins:
+    state->level = value & 1;
+    return true;
+  case pio_x:
+    state->x = value;
+    return true;
+  case pio_y:
+    state->y = value;
+    return true;
+  case pio_null:
+    return true;
+  case pio_isr:
+    state->isr = value;
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * @brief Runs one instruction: returns its cycles (with the delay), 0 if it stalls on an empty FIFO,
+ *        or -1 if it is not modelled. `fifo`/`count` stand for the TX FIFO.
+ */
+static int host_pio_step(host_pio_sm_t *state, uint16_t instr, const uint32_t **fifo, size_t *count, bool exec)
+{
+  const pio_sm_config *c = &state->config;
+  uint side_bits = c->sideset_bits;
+  uint delay = (instr >> 8) & (0x1fu >> side_bits);
+  bool pull = c->autopull && state->osr_count >= c->pull_threshold;
+  uint8_t pc = state->pc == c->wrap ? c->wrap_target : (uint8_t)((state->pc + 1) & 0x1f);
+
+  uint op = instr >> 13;
+  if (side_bits > 0 && (!c->sideset_optional || (instr & 0x1000)))
+  {
+    state->level = (instr >> (13 - side_bits)) & 1; // Side-set takes effect even if the instruction stalls
+  }
+  bool blocking = op == 4 && (instr & 0x80) && (instr & 0x20);
+  if (*count == 0 && ((op == 3 && pull) || blocking))
+  {
+    return 0; // Stalls on the empty FIFO (autopull OUT, or PULL BLOCK)
+  }
+  uint dest = (instr >> 5) & 7;
+  uint field = instr & 0x1f;
+  switch (op)
+  {
+  case 0: // JMP
+  {
+    bool taken;
+    switch (dest)
+    {
+    case 0:
+      taken = true;
+      break;
+    case 1:
+      taken = state->x == 0;
+      break;
+    case 2:
+      taken = state->x-- != 0;
+      break;
+    case 3:
+      taken = state->y == 0;
+      break;
+    case 4:
+      taken = state->y-- != 0;
+      break;
+    default:
+      return -1;
+    }
+    pc = taken ? (uint8_t)field : pc;
+    break;
+  }
+  case 3: // OUT
+  {
+    if (pull)
+    {
+      state->osr = *(*fifo)++;
+      (*count)--;
+      state->osr_count = 0;
+    }
+    uint bits = field == 0 ? 32 : field;
+    uint32_t mask = bits == 32 ? ~0u : (1u << bits) - 1;
+    uint32_t value = c->out_shift_right ? state->osr & mask : (state->osr >> (32 - bits)) & mask;
+    state->osr = bits == 32 ? 0 : c->out_shift_right ? state->osr >> bits : state->osr << bits;
+    state->osr_count = (uint8_t)(state->osr_count + bits > 32 ? 32 : state->osr_count + bits);
+    if (!host_pio_write(state, dest, value))
+    {
+      return -1;
+    }
+    if (c->autopull && state->osr_count >= c->pull_threshold && *count > 0)
+    {
+      state->osr = *(*fifo)++; // Refilled at the end of the OUT
+      (*count)--;
+      state->osr_count = 0;
+    }
+    break;
+  }
+  case 4: // PULL (PUSH is not modelled)
+    if (!(instr & 0x80))
+    {
+      return -1;
+    }
+    if (*count > 0)
+    {
+      state->osr = *(*fifo)++;
+      (*count)--;
+    }
+    else
+    {
+      state->osr = state->x; // Non-blocking PULL on an empty FIFO copies X
+    }
+    state->osr_count = 0;
+    break;
+  case 5: // MOV
+    if ((instr & 0x18) != 0 || !host_pio_write(state, dest, host_pio_read(state, field & 7)))
+    {
+      return -1;
+    }
+    break;
+  case 7: // SET
+    if (!host_pio_write(state, dest, field))
+    {
+      return -1;
+    }
+    break;
+  default:
+    return -1;
+  }
+  if (!exec)
+  {
+    state->pc = pc;
+  }
+  return (int)(1 + delay);
+}
+
+void pio_sm_exec(PIO pio, uint sm, uint instr)
+{
+  host_pio_sm_t *state = &host_pio_sms[pio_get_index(pio)][sm];
+  uint32_t word = pio->txf[sm]; // PULL takes the last word written, nothing else reads the FIFO
+  const uint32_t *fifo = &word;
+  size_t count = (instr >> 13) == 4 ? 1 : 0;
+  if ((instr & 0xe000u) == 0 && ((instr >> 5) & 7) == 0)
+  {
+    state->pc = (uint8_t)(instr & 0x1f); // Unconditional JMP
+    return;
+  }
+  host_pio_step(state, (uint16_t)instr, &fifo, &count, true);
+}
+
+long host_pio_sm_run(PIO pio, uint sm, const uint32_t *words, size_t count, uint8_t *levels, size_t max)
+{
+  host_pio_sm_t state = host_pio_sms[pio_get_index(pio)][sm];
+  long cycles = 0;
+  while (cycles < 1000000)
+  {
+    int taken = host_pio_step(&state, (uint16_t)pio->instr_mem[state.pc], &words, &count, false);
+    if (taken <= 0)
+    {
+      return taken == 0 ? cycles : -1;
+    }
+    for (int i = 0; i < taken; i++, cycles++)
+    {
+      if (levels != NULL && (size_t)cycles < max)
+      {
+        levels[cycles] = state.level;
+      }
+    }
+  }
+  return -1;
+}
+void pio_sm_clear_fifos(PIO pio, uint sm) { (void)pio, (void)sm; }
+void pio_set_irq0_source_enabled(PIO pio, pio_interrupt_source_t source, bool enabled) { (void)pio, (void)source, (void)enabled; }
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx)
+{
+  return pio_get_index(pio) * 8 + sm + (is_tx ? 0 : 4);
+}
+
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm)
+{
+  host_pio_rx_fifo_t *fifo = &host_pio_rx_fifos[pio_get_index(pio)][sm];
+  if (fifo->count == 0)
+  {
+    return true;
+  }
+  pio->rxf[sm] = fifo->words[fifo->head];
+  fifo->head = (fifo->head + 1) % HOST_PIO_RX_FIFO_DEPTH;
+  fifo->count--;
+  return false;
+}
+
+bool host_pio_rx_push(PIO pio, uint sm, uint32_t word)
+{
+  host_pio_rx_fifo_t *fifo = &host_pio_rx_fifos[pio_get_index(pio)][sm];
+  if (fifo->count == HOST_PIO_RX_FIFO_DEPTH)
+  {
+    return false;
+  }
+  fifo->words[(fifo->head + fifo->count) % HOST_PIO_RX_FIFO_DEPTH] = word;
+  fifo->count++;
+  return true;
+}
+
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm)
+{
+  (void)pio, (void)sm;
+  return true; // Words are consumed as soon as they are written
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data)
+{
+  pio->txf[sm] = data;
+  host_pio_tx_tap_t *tap = &host_pio_tx_taps[pio_get_index(pio)][sm];
+  if (tap->listener != NULL)
+  {
+    tap->listener(data, tap->ctx);
+  }
+}
+
+void host_pio_tx_listen(PIO pio, uint sm, host_pio_tx_listener_t listener, void *ctx)
+{
+  host_pio_tx_taps[pio_get_index(pio)][sm].listener = listener;
+  host_pio_tx_taps[pio_get_index(pio)][sm].ctx = ctx;
+}
+
+uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+
+/**
+ * @brief Sets the flash to its erased state before main runs, as a new device ships.
+ */
+__attribute__((constructor)) static void host_flash_init(void)
+{
+  memset(host_flash, 0xFF, sizeof(host_flash));
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count)
+{
+  if (flash_offs % FLASH_SECTOR_SIZE == 0 && count % FLASH_SECTOR_SIZE == 0 && flash_offs + count <= sizeof(host_flash))
+  {
+    memset(host_flash + flash_offs, 0xFF, count);
+  }
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count)
+{
+  if (flash_offs % FLASH_PAGE_SIZE == 0 && count % FLASH_PAGE_SIZE == 0 && flash_offs + count <= sizeof(host_flash))
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      host_flash[flash_offs + i] &= data[i];
+    }
+  }
+}
+
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms)
+{
+  (void)enter_exit_timeout_ms;
+  func(param);
+  return PICO_OK;
+}
+
+bool flash_safe_execute_core_init(void) { return true; }
@@ -0,0 +1,22 @@
+#ifndef HOST_HARDWARE_CLOCKS_H
+#define HOST_HARDWARE_CLOCKS_H
+
+#include <stdint.h>
+
+enum clock_index
+{
+  clk_sys = 5,
+};
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  uint32_t clock_get_hz(enum clock_index clk_index); // 125 MHz, the RP2040 default
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_CLOCKS_H
@@ -0,0 +1,59 @@
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/platform.h"
+
+#define NUM_DMA_CHANNELS 12
+
+enum dma_channel_transfer_size
+{
+  DMA_SIZE_8 = 0,
+  DMA_SIZE_16 = 1,
+  DMA_SIZE_32 = 2,
+};
+
+typedef struct
+{
+  uint32_t ctrl;
+} dma_channel_config;
+
+typedef struct
+{
+  volatile uint32_t read_addr;
+  volatile uint32_t write_addr;
+  volatile uint32_t transfer_count;
+  volatile uint32_t ctrl_trig;
+} dma_channel_hw_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  // No channel is ever available on the host, so callers take their non-DMA paths
+  int dma_claim_unused_channel(bool required);
+  void dma_channel_unclaim(uint channel);
+  dma_channel_config dma_channel_get_default_config(uint channel);
+  void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size);
+  void channel_config_set_read_increment(dma_channel_config *c, bool incr);
+  void channel_config_set_write_increment(dma_channel_config *c, bool incr);
+  void channel_config_set_dreq(dma_channel_config *c, uint dreq);
+  void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits);
+  void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                             const volatile void *read_addr, uint transfer_count, bool trigger);
+  void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count);
+  void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger);
+  void dma_channel_abort(uint channel);
+  bool dma_channel_is_busy(uint channel);
+  dma_channel_hw_t *dma_channel_hw_addr(uint channel);
+  void dma_channel_set_irq0_enabled(uint channel, bool enabled);
+  bool dma_channel_get_irq0_status(uint channel);
+  void dma_channel_acknowledge_irq0(uint channel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_DMA_H
@@ -0,0 +1,29 @@
+#ifndef HOST_HARDWARE_FLASH_H
+#define HOST_HARDWARE_FLASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FLASH_PAGE_SIZE (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+#define PICO_FLASH_SIZE_BYTES (2u * 1024 * 1024) // The Pico's W25Q16
+
+// The flash is a process array; XIP reads of it are plain reads
+#define XIP_BASE ((uintptr_t)host_flash)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  extern uint8_t host_flash[PICO_FLASH_SIZE_BYTES]; // Starts erased (0xFF)
+
+  // NOR semantics: erasing sets whole sectors to 0xFF, programming can only clear bits
+  void flash_range_erase(uint32_t flash_offs, size_t count);
+  void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_FLASH_H
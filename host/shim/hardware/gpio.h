@@ -0,0 +1,25 @@
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+#include <stdbool.h>
+#include "pico/platform.h"
+
+#define GPIO_IN 0
+#define GPIO_OUT 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  void gpio_init(uint gpio);
+  void gpio_set_dir(uint gpio, bool out);
+  void gpio_pull_up(uint gpio);
+  void gpio_set_inover(uint gpio, uint value);
+  void gpio_set_outover(uint gpio, uint value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_GPIO_H
@@ -0,0 +1,37 @@
+#ifndef HOST_HARDWARE_IRQ_H
+#define HOST_HARDWARE_IRQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/platform.h"
+
+enum irq_num
+{
+  PIO0_IRQ_0 = 7,
+  PIO0_IRQ_1 = 8,
+  PIO1_IRQ_0 = 9,
+  PIO1_IRQ_1 = 10,
+  DMA_IRQ_0 = 11,
+  DMA_IRQ_1 = 12,
+  SIO_IRQ_PROC0 = 15,
+  SIO_IRQ_PROC1 = 16,
+};
+
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+typedef void (*irq_handler_t)(void);
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+  void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority);
+  void irq_set_enabled(uint num, bool enabled);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_IRQ_H
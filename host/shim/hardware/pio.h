@@ -0,0 +1,150 @@
+#ifndef HOST_HARDWARE_PIO_H
+#define HOST_HARDWARE_PIO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "pico/platform.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+#define NUM_PIOS 2
+#define NUM_PIO_STATE_MACHINES 4
+#define PIO_INSTRUCTION_COUNT 32
+#define PIO_FDEBUG_TXSTALL_LSB 24
+#define HOST_PIO_RX_FIFO_DEPTH 4 // Words a state machine can push before its RX FIFO is full
+
+/**
+ * @brief Register block of one PIO, reduced to the registers the drivers touch and backed by memory.
+ */
+typedef struct
+{
+  volatile uint32_t fdebug;
+  volatile uint32_t txf[NUM_PIO_STATE_MACHINES];
+  volatile uint32_t rxf[NUM_PIO_STATE_MACHINES];
+  volatile uint32_t instr_mem[PIO_INSTRUCTION_COUNT]; // Written by pio_add_program, with jumps relocated
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t host_pio_hw[NUM_PIOS];
+#define pio0 (&host_pio_hw[0])
+#define pio1 (&host_pio_hw[1])
+
+typedef struct pio_program
+{
+  const uint16_t *instructions;
+  uint8_t length;
+  int8_t origin;
+} pio_program_t;
+
+// Configuration of a state machine, reduced to what host_pio_sm_run needs to run a TX program
+typedef struct
+{
+  uint8_t wrap_target;
+  uint8_t wrap;
+  uint8_t sideset_bits;   // Including the enable bit when optional
+  bool sideset_optional;
+  bool out_shift_right;
+  bool autopull;
+  uint8_t pull_threshold; // 1 to 32
+} pio_sm_config;
+
+enum pio_src_dest
+{
+  pio_pins = 0,
+  pio_x = 1,
+  pio_y = 2,
+  pio_null = 3,
+  pio_pindirs = 4,
+  pio_status = 5,
+  pio_isr = 6,
+  pio_osr = 7,
+};
+
+enum pio_fifo_join
+{
+  PIO_FIFO_JOIN_NONE = 0,
+  PIO_FIFO_JOIN_TX = 1,
+  PIO_FIFO_JOIN_RX = 2,
+};
+
+typedef enum
+{
+  pis_sm0_rx_fifo_not_empty = 0,
+  pis_sm1_rx_fifo_not_empty = 1,
+  pis_sm2_rx_fifo_not_empty = 2,
+  pis_sm3_rx_fifo_not_empty = 3,
+} pio_interrupt_source_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  // Instruction encoding, as in the SDK
+  uint pio_encode_set(enum pio_src_dest dest, uint value);
+  uint pio_encode_mov(enum pio_src_dest dest, enum pio_src_dest src);
+  uint pio_encode_pull(bool if_empty, bool block);
+  uint pio_encode_jmp(uint addr);
+  uint pio_encode_out(enum pio_src_dest dest, uint count);
+
+  // Instruction memory and state machine allocation, tracked like the SDK does
+  PIO pio_get_instance(uint instance);
+  uint pio_get_index(PIO pio);
+  bool pio_can_add_program(PIO pio, const pio_program_t *program);
+  uint pio_add_program(PIO pio, const pio_program_t *program);
+  void pio_remove_program(PIO pio, const pio_program_t *program, uint loaded_offset);
+  int pio_claim_unused_sm(PIO pio, bool required);
+  void pio_sm_unclaim(PIO pio, uint sm);
+
+  // Configuration calls are accepted; only what host_pio_sm_run needs is kept
+  pio_sm_config pio_get_default_sm_config(void);
+  void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap);
+  void sm_config_set_in_pins(pio_sm_config *c, uint in_base);
+  void sm_config_set_jmp_pin(pio_sm_config *c, uint pin);
+  void sm_config_set_in_shift(pio_sm_config *c, bool shift_right, bool autopush, uint push_threshold);
+  void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold);
+  void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count);
+  void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base);
+  void sm_config_set_sideset(pio_sm_config *c, uint bit_count, bool optional, bool pindirs);
+  void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join);
+  void pio_gpio_init(PIO pio, uint pin);
+  void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out);
+  void pio_sm_set_set_pins(PIO pio, uint sm, uint set_base, uint set_count);
+  int pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config);
+  void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+  void pio_sm_restart(PIO pio, uint sm);
+  void pio_sm_set_clkdiv(PIO pio, uint sm, float div);
+  void pio_sm_clkdiv_restart(PIO pio, uint sm);
+  void pio_sm_exec(PIO pio, uint sm, uint instr);
+  void pio_sm_clear_fifos(PIO pio, uint sm);
+  void pio_set_irq0_source_enabled(PIO pio, pio_interrupt_source_t source, bool enabled);
+  uint pio_get_dreq(PIO pio, uint sm, bool is_tx);
+
+  // FIFOs: the TX side swallows words, the RX side holds what host_pio_rx_push queued
+  bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm);
+  bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm);
+  void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+
+  // Host only: queues a word as if the state machine had pushed it; false if the RX FIFO is full.
+  // `pio_sm_is_rx_fifo_empty` moves the oldest queued word into `rxf[sm]`, since the drivers
+  // always check the FIFO before reading it.
+  bool host_pio_rx_push(PIO pio, uint sm, uint32_t word);
+
+  // Host only: calls `listener` with every word written to the TX FIFO of a state machine, or stops with NULL
+  typedef void (*host_pio_tx_listener_t)(uint32_t word, void *ctx);
+  void host_pio_tx_listen(PIO pio, uint sm, host_pio_tx_listener_t listener, void *ctx);
+
+  // Host only: runs the program of a state machine from its current state, on a copy of it, as if
+  // `words` were in its TX FIFO, until it stalls on the empty FIFO. Supports the instructions of the
+  // TX programs (JMP, OUT, MOV, SET, PULL) with delays, side-set and autopull; `levels` (may be NULL)
+  // receives the level of the TX pin in every cycle, up to `max` cycles.
+  // Returns the number of cycles run, or -1 if the program uses another instruction or does not stall.
+  long host_pio_sm_run(PIO pio, uint sm, const uint32_t *words, size_t count, uint8_t *levels, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_PIO_H
@@ -0,0 +1,28 @@
+#ifndef HOST_HARDWARE_STRUCTS_SYSTICK_H
+#define HOST_HARDWARE_STRUCTS_SYSTICK_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  // SysTick registers; on the host the counter never moves, so cycle counts read as 0
+  typedef struct
+  {
+    volatile uint32_t csr;
+    volatile uint32_t rvr;
+    volatile uint32_t cvr;
+    volatile uint32_t calib;
+  } systick_hw_t;
+
+  extern systick_hw_t host_systick_hw;
+
+#define systick_hw (&host_systick_hw)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_STRUCTS_SYSTICK_H
@@ -0,0 +1,29 @@
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The host runs everything on one thread; barriers only need to stop compiler reordering
+static inline void __dmb(void) { __asm volatile("" ::: "memory"); }
+static inline void __wfi(void) {}
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  uint32_t save_and_disable_interrupts(void);
+  void restore_interrupts(uint32_t status);
+
+  typedef volatile uint32_t spin_lock_t;
+  int spin_lock_claim_unused(bool required);
+  spin_lock_t *spin_lock_instance(unsigned int lock_num);
+  uint32_t spin_lock_blocking(spin_lock_t *lock);
+  void spin_unlock(spin_lock_t *lock, uint32_t saved_irq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_SYNC_H
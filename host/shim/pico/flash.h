@@ -0,0 +1,24 @@
+#ifndef HOST_PICO_FLASH_H
+#define HOST_PICO_FLASH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef PICO_OK
+#define PICO_OK 0
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  // There is no other core and no XIP to stop: the function runs at once
+  int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms);
+  bool flash_safe_execute_core_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_PICO_FLASH_H
@@ -0,0 +1,14 @@
+#ifndef HOST_PICO_PLATFORM_H
+#define HOST_PICO_PLATFORM_H
+
+// Host stand-in for the Pico SDK platform header: no sections, no core-specific code
+
+typedef unsigned int uint;
+
+#define __not_in_flash(group)
+#define __not_in_flash_func(func_name) func_name
+#define __time_critical_func(func_name) func_name
+
+static inline void tight_loop_contents(void) {}
+
+#endif // HOST_PICO_PLATFORM_H
@@ -0,0 +1,31 @@
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+// Host stand-in for pico/stdlib.h, including the C headers the SDK pulls in transitively
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/platform.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  bool stdio_init_all(void);
+  bool stdio_usb_connected(void); // Always true on the host
+  int stdio_put_string(const char *s, int len, bool newline, bool cr_translation);
+
+  // Sends what the SDK would write to USB CDC to a file instead of stdout (NULL: back to stdout)
+  void host_stdio_redirect(void *file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_PICO_STDLIB_H
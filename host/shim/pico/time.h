@@ -0,0 +1,28 @@
+#ifndef HOST_PICO_TIME_H
+#define HOST_PICO_TIME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  typedef int32_t alarm_id_t;
+  typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+
+  uint32_t time_us_32(void); // Microseconds since the process started
+  uint64_t time_us_64(void);
+  void sleep_ms(uint32_t ms);
+  void sleep_us(uint64_t us);
+
+  // Alarms never fire on the host (__wfi returns at once); the ids are only handed back
+  alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+  bool cancel_alarm(alarm_id_t alarm_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_PICO_TIME_H
@@ -1,6 +1,20 @@
 #include <stdio.h>
 #include <pico/stdlib.h>
+#include "nmea_output.h"
 #include "nmea_parser.h"
+#include "nmea_pipeline.h"
+#include "trace.h"
+
+// Set to 1 to run UART intake and parsing on core1 and only read snapshots on core0
+#ifndef NMEA_PIPELINE
+#define NMEA_PIPELINE 0
+#endif
+
+// Set to 1 to send every fix and the line statistics as binary frames (decode them with frames.py)
+// instead of printing every field; single-core mode only
+#ifndef NMEA_BINARY_OUTPUT
+#define NMEA_BINARY_OUTPUT 0
+#endif
 
 // https://www.dragino.com/downloads/downloads/datasheet/other_vendors/L80-R/Quectel_L80-R_Hardware_Design_V1.2.pdf
 /*
@@ -19,6 +33,16 @@ UART port:
 
 NMEAParser nmeaParser;
 
+#if NMEA_PIPELINE
+NMEAPipeline pipeline;
+#elif NMEA_BINARY_OUTPUT
+NMEAOutput output;
+void sendEpoch(NMEAParser *parser, uint32_t event, void *ctx);
+#else
+void printSentence(NMEAParser *parser, uint32_t event, void *ctx);
+void printEpoch(NMEAParser *parser, uint32_t event, void *ctx);
+#endif
+
 void setup()
 {
     stdio_init_all();
@@ -28,115 +52,226 @@ void setup()
     }
     sleep_ms(100);
 
+#if NMEA_PIPELINE
+    // Core1 now owns the parser, so the sentence mask goes through the pipeline
+    NMEAPipeline_start(&pipeline, &nmeaParser, TXD2RX, RXD2TX,
+                       NMEA_SENTENCES_ALL & ~NMEA_SENTENCE_BIT(NMEA_SENTENCE_GSV));
+#elif NMEA_BINARY_OUTPUT
+    NMEAParser_init(&nmeaParser, TXD2RX, RXD2TX);
+    NMEAOutput_init(&output);
+    NMEAParser_on(&nmeaParser, NMEA_EVENT_EPOCH, sendEpoch, &output);
+#else
     NMEAParser_init(&nmeaParser, TXD2RX, RXD2TX);
-    // nmeaParser.GPGGA_ENABLED = false;
-    // nmeaParser.GPGLL_ENABLED = false;
-    // nmeaParser.GPRMC_ENABLED = false;
-    // nmeaParser.GPGSA_ENABLED = false;
-    // nmeaParser.GPVTG_ENABLED = false;
-    nmeaParser.GPGSV_ENABLED = false;
+    NMEAParser_on(&nmeaParser, NMEA_SENTENCES_ALL, printSentence, NULL);
+    NMEAParser_on(&nmeaParser, NMEA_EVENT_EPOCH, printEpoch, NULL);
+#endif
+#if !NMEA_PIPELINE
+    // nmeaParser.enabled &= ~NMEA_SENTENCE_BIT(NMEA_SENTENCE_GGA);
+    // nmeaParser.enabled &= ~NMEA_SENTENCE_BIT(NMEA_SENTENCE_GLL);
+    // nmeaParser.enabled &= ~NMEA_SENTENCE_BIT(NMEA_SENTENCE_RMC);
+    // nmeaParser.enabled &= ~NMEA_SENTENCE_BIT(NMEA_SENTENCE_GSA);
+    // nmeaParser.enabled &= ~NMEA_SENTENCE_BIT(NMEA_SENTENCE_VTG);
+    nmeaParser.enabled &= ~NMEA_SENTENCE_BIT(NMEA_SENTENCE_GSV);
+#endif
 
+    TRACE_INIT(); // Stage timing, printed every RP_PICO_TRACE_PRINT_S seconds when built with RP_PICO_TRACE=1
     printf("GPS Module Initialized.\n");
 }
 
+#if NMEA_PIPELINE
+uint32_t lastSentences = 0;  // Sentences seen by core0 so far
+uint32_t latencyMin = ~0u;   // Shortest LF-to-visible latency on core0 (us)
+uint32_t latencyMax = 0;     // Longest LF-to-visible latency on core0 (us)
+uint64_t latencySum = 0;     // Sum of latencies for the average
+uint32_t latencyCount = 0;   // Number of latency samples
+
 void loop()
 {
-    while (NMEAParser_available(&nmeaParser))
+    uint32_t sentences = NMEAPipeline_sentences(&pipeline);
+    if (sentences == lastSentences)
     {
-        char *result = NMEAParser_read(&nmeaParser);
-        if (result != NULL)
-        {
-            printf("\n%s\n", result);
-        }
+        return; // Nothing new from core1
+    }
+    lastSentences = sentences;
 
-        // Print the parsed data
-        GPGGA_Data *gpgga = &nmeaParser.data.gpgga;
-        if (gpgga->last_time)
-        {
-            printf("Time: %s\n", gpgga->utc_time);
-            printf("Latitude: %f\n", gpgga->latitude);
-            printf("Latitude Dir: %s\n", gpgga->latitude_dir);
-            printf("Longitude: %f\n", gpgga->longitude);
-            printf("Longitude Dir: %s\n", gpgga->longitude_dir);
-            printf("Fix status: %d\n", gpgga->fix_status);
-            printf("Number of satellites: %d\n", gpgga->num_satellites);
-            printf("HDOP: %f\n", gpgga->hdop);
-            printf("Altitude: %f\n", gpgga->altitude);
-            printf("Altitude Unit: %s\n", gpgga->altitude_unit);
-            printf("Geoid: %f\n", gpgga->geoid_separation);
-            printf("Geoid Unit: %s\n", gpgga->geoid_unit);
-            printf("Last Time: %d\n", gpgga->last_time);
-            gpgga->last_time = 0; // Reset last_time to 0 to indicate that the GPGGA data has been processed
-        }
+    GPSData data;
+    uint32_t received;
+    NMEAPipeline_latest(&pipeline, &data, &received);
+    uint32_t latency = time_us_32() - received;
+    latencyMin = latency < latencyMin ? latency : latencyMin;
+    latencyMax = latency > latencyMax ? latency : latencyMax;
+    latencySum += latency;
+    latencyCount++;
 
-        GPGLL_Data *gpgll = &nmeaParser.data.gpgll;
-        if (gpgll->last_time)
-        {
-            printf("Time: %s\n", gpgll->utc_time);
-            printf("Latitude: %f\n", gpgll->latitude);
-            printf("Latitude Dir: %s\n", gpgll->latitude_dir);
-            printf("Longitude: %f\n", gpgll->longitude);
-            printf("Longitude Dir: %s\n", gpgll->longitude_dir);
-            printf("Status indicator: %s\n", gpgll->status);
-            gpgll->last_time = 0; // Reset last_time to 0 to indicate that the GPGLL data has been processed
-        }
+    if (data.gpgga.last_time)
+    {
+        printf("Time: %s Latitude: %.7f Longitude: %.7f\n", data.utc_time ? data.utc_time : "",
+               (double)data.latitude / NMEA_DEGREES_SCALE, (double)data.longitude / NMEA_DEGREES_SCALE);
+    }
+    if (latencyCount % 50 == 0)
+    {
+        printf("LF -> core0 latency (us): min %lu avg %lu max %lu\n",
+               (unsigned long)latencyMin, (unsigned long)(latencySum / latencyCount), (unsigned long)latencyMax);
+    }
+}
+#elif NMEA_BINARY_OUTPUT
+/**
+ * @brief Queues the fix and the line statistics of every epoch as two frames.
+ */
+void sendEpoch(NMEAParser *parser, uint32_t event, void *ctx)
+{
+    NMEAFix fix;
+    NMEAParser_fix(parser, &fix);
+    NMEAParserStats stats;
+    NMEAParser_stats(parser, &stats);
+    NMEAOutput_fix((NMEAOutput *)ctx, &fix);
+    NMEAOutput_stats((NMEAOutput *)ctx, &stats);
+}
 
-        GPRMC_Data *gprmc = &nmeaParser.data.gprmc;
-        if (gprmc->last_time && strcmp(gprmc->status, "A") == 0)
+void loop()
+{
+    while (NMEAParser_available(&nmeaParser))
+    {
+        NMEAParser_read(&nmeaParser); // sendEpoch runs from here when an epoch ends
+    }
+    NMEAOutput_flush(&output); // One USB write for everything queued during this pass
+}
+#else
+/**
+ * @brief Prints every parsed sentence (registered for all sentence types).
+ */
+void printSentence(NMEAParser *parser, uint32_t event, void *ctx)
+{
+    switch (event)
+    {
+    case NMEA_SENTENCE_BIT(NMEA_SENTENCE_GGA):
+    {
+        GPGGA_Data *gpgga = &parser->data.gpgga;
+        printf("Time: %s\n", gpgga->utc_time);
+        printf("Latitude: %.7f\n", (double)gpgga->latitude / NMEA_DEGREES_SCALE);
+        printf("Latitude Dir: %s\n", gpgga->latitude_dir);
+        printf("Longitude: %.7f\n", (double)gpgga->longitude / NMEA_DEGREES_SCALE);
+        printf("Longitude Dir: %s\n", gpgga->longitude_dir);
+        printf("Fix status: %d\n", gpgga->fix_status);
+        printf("Number of satellites: %d\n", gpgga->num_satellites);
+        printf("HDOP: %.2f\n", (double)gpgga->hdop / NMEA_DOP_SCALE);
+        printf("Altitude: %.2f\n", (double)gpgga->altitude / NMEA_ALTITUDE_SCALE);
+        printf("Altitude Unit: %s\n", gpgga->altitude_unit);
+        printf("Geoid: %.2f\n", (double)gpgga->geoid_separation / NMEA_ALTITUDE_SCALE);
+        printf("Geoid Unit: %s\n", gpgga->geoid_unit);
+        printf("Last Time: %d\n", gpgga->last_time);
+        break;
+    }
+    case NMEA_SENTENCE_BIT(NMEA_SENTENCE_GLL):
+    {
+        GPGLL_Data *gpgll = &parser->data.gpgll;
+        printf("Time: %s\n", gpgll->utc_time);
+        printf("Latitude: %.7f\n", (double)gpgll->latitude / NMEA_DEGREES_SCALE);
+        printf("Latitude Dir: %s\n", gpgll->latitude_dir);
+        printf("Longitude: %.7f\n", (double)gpgll->longitude / NMEA_DEGREES_SCALE);
+        printf("Longitude Dir: %s\n", gpgll->longitude_dir);
+        printf("Status indicator: %s\n", gpgll->status);
+        break;
+    }
+    case NMEA_SENTENCE_BIT(NMEA_SENTENCE_RMC):
+    {
+        GPRMC_Data *gprmc = &parser->data.gprmc;
+        if (strcmp(gprmc->status, "A") == 0)
         {
             printf("Date: %s\n", gprmc->date);
             printf("Time: %s\n", gprmc->utc_time);
-            printf("Latitude: %f\n", gprmc->latitude);
+            printf("Latitude: %.7f\n", (double)gprmc->latitude / NMEA_DEGREES_SCALE);
             printf("Latitude Dir: %s\n", gprmc->latitude_dir);
-            printf("Longitude: %f\n", gprmc->longitude);
+            printf("Longitude: %.7f\n", (double)gprmc->longitude / NMEA_DEGREES_SCALE);
             printf("Longitude Dir: %s\n", gprmc->longitude_dir);
             printf("Status: %s\n", gprmc->status);
-            printf("Speed (Knots): %f\n", gprmc->speed);
-            printf("Track (True): %f\n", gprmc->track);
-            printf("Magnetic variation: %f\n", gprmc->variation);
-            gprmc->last_time = 0; // Reset last_time to 0 to indicate that the GPRMC data has been processed
+            printf("Speed (Knots): %.3f\n", (double)gprmc->speed / NMEA_SPEED_SCALE);
+            printf("Track (True): %.2f\n", (double)gprmc->track / NMEA_ANGLE_SCALE);
+            printf("Magnetic variation: %.2f\n", (double)gprmc->variation / NMEA_ANGLE_SCALE);
         }
-
-        GPGSA_Data *gpgsa = &nmeaParser.data.gpgsa;
-        if (gpgsa->last_time)
+        break;
+    }
+    case NMEA_SENTENCE_BIT(NMEA_SENTENCE_GSA):
+    {
+        GPGSA_Data *gpgsa = &parser->data.gpgsa;
+        printf("Mode 1: %s\n", gpgsa->mode1);
+        printf("Mode 2: %d\n", gpgsa->mode2);
+        printf("PRN numbers:");
+        for (int i = 0; i < NMEA_GSA_PRNS && gpgsa->prn[i] != 0; i++)
         {
-            printf("Mode 1: %s\n", gpgsa->mode1);
-            printf("Mode 2: %d\n", gpgsa->mode2);
-            printf("PRN number: %d\n", gpgsa->prn);
-            printf("PDOP: %d\n", gpgsa->pdop);
-            printf("HDOP: %d\n", gpgsa->hdop);
-            printf("VDOP: %d\n", gpgsa->vdop);
-            gpgsa->last_time = 0; // Reset last_time to 0 to indicate that the GPGSA data has been processed
+            printf(" %d", gpgsa->prn[i]);
         }
-
-        GPVTG_Data *gpvtg = &nmeaParser.data.gpvtg;
-        if (gpvtg->last_time)
+        printf("\n");
+        printf("PDOP: %.2f\n", (double)gpgsa->pdop / NMEA_DOP_SCALE);
+        printf("HDOP: %.2f\n", (double)gpgsa->hdop / NMEA_DOP_SCALE);
+        printf("VDOP: %.2f\n", (double)gpgsa->vdop / NMEA_DOP_SCALE);
+        break;
+    }
+    case NMEA_SENTENCE_BIT(NMEA_SENTENCE_VTG):
+    {
+        GPVTG_Data *gpvtg = &parser->data.gpvtg;
+        printf("Track (degrees true): %.2f\n", (double)gpvtg->track1 / NMEA_ANGLE_SCALE);
+        printf("T - (true north): %s\n", gpvtg->track1_id);
+        printf("Track (degrees magnetic): %.2f\n", (double)gpvtg->track2 / NMEA_ANGLE_SCALE);
+        printf("M - (magnetic north): %s\n", gpvtg->track2_id);
+        printf("Speed (in knots): %.3f\n", (double)gpvtg->speed1 / NMEA_SPEED_SCALE);
+        printf("N - (in knots): %s\n", gpvtg->speed1_id);
+        printf("Speed (in kph): %.3f\n", (double)gpvtg->speed2 / NMEA_SPEED_SCALE);
+        printf("K - (in kph): %s\n", gpvtg->speed2_id);
+        break;
+    }
+    case NMEA_SENTENCE_BIT(NMEA_SENTENCE_GSV):
+    {
+        NMEASatelliteTable *satellites = &parser->satellites;
+        if (satellites->complete)
         {
-            printf("Track (degrees true): %f\n", gpvtg->track1);
-            printf("T - (true north): %s\n", gpvtg->track1_id);
-            printf("Track (degrees magnetic): %f\n", gpvtg->track2);
-            printf("M - (magnetic north): %s\n", gpvtg->track2_id);
-            printf("Speed (in knots): %f\n", gpvtg->speed1);
-            printf("N - (in knots): %s\n", gpvtg->speed1_id);
-            printf("Speed (in kph): %f\n", gpvtg->speed2);
-            printf("K - (in kph): %s\n", gpvtg->speed2_id);
-            gpvtg->last_time = 0; // Reset last_time to 0 to indicate that the GPVTG data has been processed
+            printf("Satellites in view: %d\n", satellites->in_view);
+            for (int i = 0; i < satellites->count; i++)
+            {
+                NMEASatellite *sv = &satellites->satellites[i];
+                printf("PRN %2d elevation %2d azimuth %3d SNR %2d%s\n", sv->prn, sv->elevation, sv->azimuth, sv->snr,
+                       sv->used ? " (used)" : "");
+            }
         }
+        break;
+    }
+    }
+}
+
+/**
+ * @brief Prints the line quality once per epoch.
+ */
+void printEpoch(NMEAParser *parser, uint32_t event, void *ctx)
+{
+    NMEAParserStats stats;
+    NMEAParser_stats(parser, &stats);
+    uint32_t accepted = 0;
+    uint32_t rejected = 0;
+    for (int type = 0; type < NMEA_SENTENCE_COUNT; type++)
+    {
+        accepted += stats.accepted[type];
+        rejected += stats.rejected[type];
+    }
+    printf("Sentences: %lu accepted, %lu bad checksum, %lu truncated, %lu bytes overrun, %lu framing errors\n",
+           (unsigned long)accepted, (unsigned long)rejected, (unsigned long)stats.line_truncations,
+           (unsigned long)stats.ring_overflows, (unsigned long)stats.framing_errors);
+    printf("Parse cycles: last %lu max %lu avg %lu\n", (unsigned long)stats.parse_cycles,
+           (unsigned long)stats.parse_cycles_max, (unsigned long)(stats.parse_cycles_total / accepted));
+}
 
-        GPGSV_Data *gpgsv = &nmeaParser.data.gpgsv;
-        if (gpgsv->last_time)
+void loop()
+{
+    // The callbacks run from NMEAParser_read, only for sentences that were actually parsed
+    while (NMEAParser_available(&nmeaParser))
+    {
+        char *result = NMEAParser_read(&nmeaParser);
+        if (result != NULL)
         {
-            printf("Total number of messages: %d\n", gpgsv->total);
-            printf("Message number: %d\n", gpgsv->count);
-            printf("Total number of SVs: %d\n", gpgsv->total_sv);
-            printf("SV PRN number: %d\n", gpgsv->prn_sv);
-            printf("Elevation, in degrees: %d\n", gpgsv->elevation);
-            printf("Azimuth, degrees: %d\n", gpgsv->azimuth);
-            printf("SNR: %d\n", gpgsv->snr);
-            gpgsv->last_time = 0; // Reset last_time to 0 to indicate that the GPGSV data has been processed
+            printf("\n%s\n", result);
         }
     }
 }
+#endif
 
 int main()
 {
@@ -144,6 +279,7 @@ int main()
     while (true)
     {
         loop();
+        TRACE_POLL();
     }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,125 @@
+#ifndef NMEA_FIX_H
+#define NMEA_FIX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <hardware/sync.h>
+
+// Fixed-point scales of the parsed values: a field holds the value times its scale
+#define NMEA_DEGREES_SCALE 10000000 // Latitude and longitude (1e-7 degrees)
+#define NMEA_SPEED_SCALE 1000       // Speeds (thousandths of a knot or of a km/h)
+#define NMEA_ANGLE_SCALE 100        // Tracks and magnetic variation (hundredths of a degree)
+#define NMEA_ALTITUDE_SCALE 100     // Altitudes and geoid separation (centimeters)
+#define NMEA_DOP_SCALE 100          // Dilutions of precision (hundredths)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  // Talker ID of a sentence (the first two characters of its address)
+  typedef enum
+  {
+    NMEA_TALKER_UNKNOWN,
+    NMEA_TALKER_GP, // GPS
+    NMEA_TALKER_GL, // GLONASS
+    NMEA_TALKER_GA, // Galileo
+    NMEA_TALKER_GB, // BeiDou (also sent as "BD")
+    NMEA_TALKER_GQ, // QZSS
+    NMEA_TALKER_GN, // Combined solution of several constellations
+    NMEA_TALKER_COUNT
+  } NMEATalker;
+
+  /**
+   * @brief Compact record of the current fix, already converted to application units.
+   *
+   * Assembled by the parser from all the sentences of one UTC time with integer arithmetic
+   * only, so readers never convert, compare strings, copy the full `GPSData`, or see the
+   * position of one second with the speed of the previous one.
+   */
+  typedef struct
+  {
+    uint32_t time;       // Time of the last update in milliseconds since boot
+    uint32_t utc_time;   // UTC time of the fix as hhmmss * 1000 + milliseconds
+    uint32_t start_us;   // Microseconds since boot (time_us_32) at which the epoch's first timed sentence started to arrive
+    uint32_t date;       // UTC date as ddmmyy of the last RMC sentence (0 until one has been seen)
+    int32_t latitude;    // Latitude in degrees * NMEA_DEGREES_SCALE, negative south
+    int32_t longitude;   // Longitude in degrees * NMEA_DEGREES_SCALE, negative west
+    int32_t speed;       // Speed over the ground in knots * NMEA_SPEED_SCALE
+    int32_t altitude;    // Orthometric height (MSL reference) in meters * NMEA_ALTITUDE_SCALE
+    uint16_t course;     // Track made good (true) in degrees * NMEA_ANGLE_SCALE
+    uint16_t hdop;       // Horizontal Dilution of Precision * NMEA_DOP_SCALE
+    uint16_t pdop;       // Position Dilution of Precision * NMEA_DOP_SCALE (from GSA)
+    uint16_t vdop;       // Vertical Dilution of Precision * NMEA_DOP_SCALE (from GSA)
+    uint8_t quality;     // GGA quality indicator (0: fix not valid)
+    uint8_t mode;        // GSA fix type (1: no fix, 2: 2D, 3: 3D; 0 if the epoch had no GSA sentence)
+    uint8_t satellites;  // Number of SVs in use
+    uint8_t talker;      // NMEATalker of the last sentence that updated the fix
+    bool valid;          // Status of the epoch's RMC/GLL sentence (true: 'A', data valid; false if it had none)
+  } NMEAFix;
+
+  /**
+   * @brief Single-writer publication of an `NMEAFix` (sequence latch over two copies).
+   *
+   * The writer updates one copy while readers are steered to the other by the low bit of
+   * `sequence`, so a reader never waits for a writer, even when it interrupts the writer on
+   * the same core, and no interrupts are disabled. A reader only retries if a whole update
+   * completed while it was copying. Safe across cores.
+   */
+  typedef struct
+  {
+    volatile uint32_t sequence; // Even: readers use slots[0]; odd: readers use slots[1]
+    NMEAFix slots[2];           // Both copies hold the latest fix between updates
+  } NMEAFixLatch;
+
+  /**
+   * @brief Publishes a new fix (writer side).
+   *
+   * @param latch Pointer to the NMEAFixLatch structure.
+   * @param fix The new fix.
+   */
+  static inline void NMEAFixLatch_publish(NMEAFixLatch *latch, const NMEAFix *fix)
+  {
+    latch->sequence++; // Readers move to slots[1]
+    __dmb();
+    latch->slots[0] = *fix;
+    __dmb();
+    latch->sequence++; // Readers move back to slots[0]
+    __dmb();
+    latch->slots[1] = *fix;
+    __dmb();
+  }
+
+  /**
+   * @brief Returns the latest fix as seen by the writer (writer side only, no copy).
+   *
+   * @param latch Pointer to the NMEAFixLatch structure.
+   */
+  static inline const NMEAFix *NMEAFixLatch_current(const NMEAFixLatch *latch)
+  {
+    return &latch->slots[0];
+  }
+
+  /**
+   * @brief Copies a consistent snapshot of the latest fix (reader side, any core or interrupt).
+   *
+   * @param latch Pointer to the NMEAFixLatch structure.
+   * @param fix Receives the snapshot.
+   */
+  static inline void NMEAFixLatch_read(const NMEAFixLatch *latch, NMEAFix *fix)
+  {
+    uint32_t sequence;
+    do
+    {
+      sequence = latch->sequence;
+      __dmb();
+      *fix = latch->slots[sequence & 1];
+      __dmb();
+    } while (latch->sequence != sequence);
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NMEA_FIX_H
@@ -0,0 +1,203 @@
+#include "nmea_output.h"
+#include "pico/stdlib.h"
+#include <stdio.h>
+#include <string.h>
+
+// CRC-16/CCITT-FALSE of every nibble value, in the high nibble of the CRC
+static const uint16_t crc16_nibbles[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+/**
+ * @brief CRC-16/CCITT-FALSE of a block of bytes, a nibble at a time (two lookups per byte, 32-byte table).
+ */
+static uint16_t crc16(const uint8_t *data, size_t length)
+{
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; i++)
+  {
+    crc = (crc << 4) ^ crc16_nibbles[(crc >> 12) ^ (data[i] >> 4)];
+    crc = (crc << 4) ^ crc16_nibbles[(crc >> 12) ^ (data[i] & 0x0F)];
+  }
+  return crc;
+}
+
+static uint8_t *put16(uint8_t *p, uint16_t value)
+{
+  p[0] = value;
+  p[1] = value >> 8;
+  return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t value)
+{
+  return put16(put16(p, value), value >> 16);
+}
+
+/**
+ * @brief Builds a complete frame: header, body and CRC, COBS-encoded and terminated by a zero byte.
+ *
+ * @param frame Receives the frame (at least NMEA_OUTPUT_FRAME_MAX bytes).
+ * @param type The NMEAOutputType of the body.
+ * @param sequence Sequence number of the frame.
+ * @param body The body.
+ * @param length Length of the body (at most NMEA_OUTPUT_BODY_MAX).
+ *
+ * @return The length of the frame, delimiter included.
+ */
+size_t NMEAOutput_encode(uint8_t *frame, uint8_t type, uint16_t sequence, const uint8_t *body, size_t length)
+{
+  uint8_t raw[NMEA_OUTPUT_HEADER + NMEA_OUTPUT_BODY_MAX + 2];
+  raw[0] = NMEA_OUTPUT_VERSION;
+  raw[1] = type;
+  put16(raw + 2, sequence);
+  memcpy(raw + NMEA_OUTPUT_HEADER, body, length);
+  length += NMEA_OUTPUT_HEADER;
+  put16(raw + length, crc16(raw, length));
+  length += 2;
+
+  // COBS: every zero becomes the distance to the next one, so the only zero left is the delimiter
+  size_t code = 0; // Position of the pending distance byte
+  size_t out = 1;
+  for (size_t i = 0; i < length; i++)
+  {
+    if (raw[i] != 0)
+    {
+      frame[out++] = raw[i];
+    }
+    if (raw[i] == 0 || out - code == 0xFF)
+    {
+      frame[code] = out - code;
+      code = out++;
+    }
+  }
+  frame[code] = out - code;
+  frame[out++] = 0;
+  return out;
+}
+
+/**
+ * @brief Serializes a fix as the body of an NMEA_OUTPUT_FIX frame.
+ *
+ * @param body Receives NMEA_OUTPUT_FIX_BODY bytes.
+ * @param fix The fix.
+ *
+ * @return NMEA_OUTPUT_FIX_BODY.
+ */
+size_t NMEAOutput_fixBody(uint8_t *body, const NMEAFix *fix)
+{
+  uint8_t *p = put32(body, fix->time);
+  p = put32(p, fix->utc_time);
+  p = put32(p, fix->date);
+  p = put32(p, (uint32_t)fix->latitude);
+  p = put32(p, (uint32_t)fix->longitude);
+  p = put32(p, (uint32_t)fix->altitude);
+  p = put32(p, (uint32_t)fix->speed);
+  p = put16(p, fix->course);
+  p = put16(p, fix->hdop);
+  p = put16(p, fix->pdop);
+  p = put16(p, fix->vdop);
+  *p++ = fix->quality;
+  *p++ = fix->mode;
+  *p++ = fix->satellites;
+  *p++ = (fix->valid ? 1 : 0) | fix->talker << 4; // Bit 0: valid, bits 4-7: NMEATalker
+  return p - body;
+}
+
+/**
+ * @brief Serializes the parser statistics as the body of an NMEA_OUTPUT_STATS frame.
+ *
+ * @param body Receives NMEA_OUTPUT_STATS_BODY bytes.
+ * @param stats The statistics.
+ *
+ * @return NMEA_OUTPUT_STATS_BODY.
+ */
+size_t NMEAOutput_statsBody(uint8_t *body, const NMEAParserStats *stats)
+{
+  uint32_t accepted = 0;
+  uint32_t rejected = 0;
+  for (int type = 0; type < NMEA_SENTENCE_COUNT; type++)
+  {
+    accepted += stats->accepted[type];
+    rejected += stats->rejected[type];
+  }
+  uint8_t *p = put32(body, accepted);
+  p = put32(p, rejected);
+  p = put32(p, stats->ring_overflows);
+  p = put32(p, stats->dma_overflows);
+  p = put32(p, stats->line_truncations);
+  p = put32(p, stats->framing_errors);
+  p = put32(p, stats->parse_cycles_max);
+  p = put32(p, accepted != 0 ? (uint32_t)(stats->parse_cycles_total / accepted) : 0);
+  return p - body;
+}
+
+/**
+ * @brief Initializes an output with an empty batch.
+ *
+ * @param output Pointer to the NMEAOutput structure.
+ */
+void NMEAOutput_init(NMEAOutput *output)
+{
+  output->length = 0;
+  output->sequence = 0;
+  output->frames = 0;
+  output->batches = 0;
+}
+
+/**
+ * @brief Adds a frame to the batch, writing the batch first if the frame does not fit.
+ */
+static void queue(NMEAOutput *output, uint8_t type, const uint8_t *body, size_t length)
+{
+  if (output->length + NMEA_OUTPUT_FRAME_MAX > NMEA_OUTPUT_BATCH_SIZE)
+  {
+    NMEAOutput_flush(output);
+  }
+  output->length += NMEAOutput_encode((uint8_t *)output->batch + output->length, type, output->sequence++, body,
+                                      length);
+  output->frames++;
+}
+
+/**
+ * @brief Queues a fix frame.
+ *
+ * @param output Pointer to the NMEAOutput structure.
+ * @param fix The fix, e.g. from NMEAParser_fix in an NMEA_EVENT_EPOCH listener.
+ */
+void NMEAOutput_fix(NMEAOutput *output, const NMEAFix *fix)
+{
+  uint8_t body[NMEA_OUTPUT_FIX_BODY];
+  queue(output, NMEA_OUTPUT_FIX, body, NMEAOutput_fixBody(body, fix));
+}
+
+/**
+ * @brief Queues a stats frame.
+ *
+ * @param output Pointer to the NMEAOutput structure.
+ * @param stats The statistics, e.g. from NMEAParser_stats.
+ */
+void NMEAOutput_stats(NMEAOutput *output, const NMEAParserStats *stats)
+{
+  uint8_t body[NMEA_OUTPUT_STATS_BODY];
+  queue(output, NMEA_OUTPUT_STATS, body, NMEAOutput_statsBody(body, stats));
+}
+
+/**
+ * @brief Writes the queued frames to stdio in one call, without newline or CR translation.
+ *
+ * Call it once the frames of an epoch are queued, e.g. at the end of a main loop pass.
+ *
+ * @param output Pointer to the NMEAOutput structure.
+ */
+void NMEAOutput_flush(NMEAOutput *output)
+{
+  if (output->length == 0)
+  {
+    return;
+  }
+  stdio_put_string(output->batch, (int)output->length, false, false);
+  output->length = 0;
+  output->batches++;
+}
@@ -0,0 +1,66 @@
+#ifndef NMEA_OUTPUT_H
+#define NMEA_OUTPUT_H
+
+#include "nmea_parser.h"
+
+// Layout of the frame bodies; decoders reject frames of another version (see frames.py)
+#define NMEA_OUTPUT_VERSION 1
+
+#define NMEA_OUTPUT_HEADER 4      // Version, type and sequence number
+#define NMEA_OUTPUT_FIX_BODY 40   // Body of a fix frame
+#define NMEA_OUTPUT_STATS_BODY 32 // Body of a stats frame
+#define NMEA_OUTPUT_BODY_MAX NMEA_OUTPUT_FIX_BODY
+
+// Longest frame on the wire: header, body and CRC-16, COBS overhead (one byte per 254) and delimiter
+#define NMEA_OUTPUT_FRAME_MAX (NMEA_OUTPUT_HEADER + NMEA_OUTPUT_BODY_MAX + 2 + 1 + 1)
+
+// Frames collected before a write to stdio (USB CDC in the examples)
+#ifndef NMEA_OUTPUT_BATCH_SIZE
+#define NMEA_OUTPUT_BATCH_SIZE 512
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  // Type of a frame (second byte of the header)
+  typedef enum
+  {
+    NMEA_OUTPUT_FIX = 1,   // An NMEAFix
+    NMEA_OUTPUT_STATS = 2, // Line quality and parse load (NMEAParserStats, summed over the types)
+  } NMEAOutputType;
+
+  /**
+   * @brief Binary output of fixes and statistics in COBS frames, written to stdio in batches.
+   *
+   * Each frame is a little-endian body behind a header (version, type, sequence number) and is
+   * followed by a CRC-16/CCITT-FALSE of both. The frame is COBS-encoded and ends with a zero
+   * byte, so a reader resynchronizes on the next zero after a lost byte, and text printed in
+   * between is easy to tell apart. Frames are collected in `batch` and written with one
+   * `stdio_put_string` call per batch instead of one formatting call per field: no soft-float
+   * formatting, and one USB transfer for all the frames of an epoch.
+   */
+  typedef struct
+  {
+    char batch[NMEA_OUTPUT_BATCH_SIZE]; // Encoded frames not written yet
+    size_t length;                      // Bytes used in `batch`
+    uint16_t sequence;                  // Sequence number of the next frame (gaps show lost frames)
+    uint32_t frames;                    // Frames queued since NMEAOutput_init
+    uint32_t batches;                   // Writes to stdio since NMEAOutput_init
+  } NMEAOutput;
+
+  size_t NMEAOutput_encode(uint8_t *frame, uint8_t type, uint16_t sequence, const uint8_t *body, size_t length);
+  size_t NMEAOutput_fixBody(uint8_t *body, const NMEAFix *fix);
+  size_t NMEAOutput_statsBody(uint8_t *body, const NMEAParserStats *stats);
+
+  void NMEAOutput_init(NMEAOutput *output);
+  void NMEAOutput_fix(NMEAOutput *output, const NMEAFix *fix);
+  void NMEAOutput_stats(NMEAOutput *output, const NMEAParserStats *stats);
+  void NMEAOutput_flush(NMEAOutput *output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NMEA_OUTPUT_H
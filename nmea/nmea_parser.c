@@ -1,35 +1,66 @@
 #include "nmea_parser.h"
+#include "trace.h"
 #include "pico/stdlib.h"
+#include <hardware/structs/systick.h>
+#include <stddef.h>
 
 #define NMEA_PARSER_SUCCESS 0
 #define NMEA_PARSER_ERROR_MEMORY_ALLOCATION 1
 
+static void expireEpoch(NMEAParser *parser);
+
+#if RP_PICO_STATIC_ALLOC
+// UART settings of the parsers initialized without their own; a slot is free while its baud is 0
+static UartPico nmea_parser_picos[NMEA_PARSER_MAX_INSTANCES];
+#endif
+
 /**
  * @brief Initializes the NMEAParser structure with required UART communication settings.
  *
  * This function configures the UART receiver and transmitter, and sets the flags to enable parsing
  * of specific NMEA sentence types (e.g., GPGGA, GPGLL, etc.). If the `UartPico` structure is not already
- * initialized, memory is dynamically allocated for it.
+ * initialized, memory is dynamically allocated for it (with `RP_PICO_STATIC_ALLOC`, it is taken from a
+ * static pool of `NMEA_PARSER_MAX_INSTANCES` instead, as are the receiver and the transmitter).
  *
  * @param parser Pointer to the NMEAParser structure to initialize.
  * @param rx The RX pin number for UART communication.
  * @param tx The TX pin number for UART communication.
  *
- * @return Returns `NMEA_PARSER_SUCCESS` (0) on success, or `NMEA_PARSER_ERROR_MEMORY_ALLOCATION` (1) if memory allocation fails.
+ * @return Returns `NMEA_PARSER_SUCCESS` (0) on success, `NMEA_PARSER_ERROR_MEMORY_ALLOCATION` (1) if memory allocation
+ *         fails or a static pool is exhausted, or `NMEA_PARSER_ERROR_UART_INACTIVE` (3) if the transmitter cannot be
+ *         started even in blocking mode (no free state machine or instruction memory).
  */
 int NMEAParser_init(NMEAParser *parser, int rx, int tx)
 {
-  parser->GPGGA_ENABLED = true;
-  parser->GPGLL_ENABLED = true;
-  parser->GPRMC_ENABLED = true;
-  parser->GPGSA_ENABLED = true;
-  parser->GPVTG_ENABLED = true;
-  parser->GPGSV_ENABLED = true;
+  parser->enabled = NMEA_SENTENCES_ALL;
+  memset(&parser->fix, 0, sizeof(parser->fix));
+  memset(&parser->stats, 0, sizeof(parser->stats));
+  memset(&parser->satellites, 0, sizeof(parser->satellites));
+  parser->listener_count = 0;
+  memset(&parser->epoch, 0, sizeof(parser->epoch));
+
+  // Parse times are taken from SysTick; start it free-running unless the application already uses it
+  if (!(systick_hw->csr & 1))
+  {
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5; // Enable, processor clock, no interrupt
+  }
 
   // Initialize UartPico dynamically
   if (parser->pico == NULL)
   {
+#if RP_PICO_STATIC_ALLOC
+    for (int i = 0; i < NMEA_PARSER_MAX_INSTANCES && parser->pico == NULL; i++)
+    {
+      if (nmea_parser_picos[i].baud == 0)
+      {
+        parser->pico = &nmea_parser_picos[i];
+      }
+    }
+#else
     parser->pico = (UartPico *)malloc(sizeof(UartPico));
+#endif
     if (parser->pico == NULL)
     {
       return NMEA_PARSER_ERROR_MEMORY_ALLOCATION; // Return error code
@@ -41,14 +72,30 @@ int NMEAParser_init(NMEAParser *parser, int rx, int tx)
   // Initialize UART Tx if TX pin is provided
   if (tx > 0)
   {
+    // Commands are queued and sent by DMA so they never hold up NMEA intake
     parser->uart_tx = UartTx_init(parser->pico, tx);
-    UartTx_activate(parser->uart_tx);
+    if (parser->uart_tx == NULL)
+    {
+      return NMEA_PARSER_ERROR_MEMORY_ALLOCATION;
+    }
+    if (UartTx_activateDMA(parser->uart_tx, NMEA_PARSER_TX_QUEUE_SIZE) != 0)
+    {
+      // No queue, spin lock or DMA channel left: fall back to blocking transmission
+      if (UartTx_activate(parser->uart_tx) != 0)
+      {
+        return NMEA_PARSER_ERROR_UART_INACTIVE;
+      }
+    }
   }
 
   // Initialize UART Rx if RX pin is provided
   if (rx > 0)
   {
     parser->uart_rx = UartRx_init(parser->pico, rx);
+    if (parser->uart_rx == NULL)
+    {
+      return NMEA_PARSER_ERROR_MEMORY_ALLOCATION;
+    }
     UartRx_activate(parser->uart_rx);
   }
 
@@ -77,7 +124,11 @@ void NMEAParser_free(NMEAParser *parser)
 
   if (parser->pico != NULL)
   {
+#if RP_PICO_STATIC_ALLOC
+    parser->pico->baud = 0; // Back to the pool
+#else
     free(parser->pico); // Free dynamically allocated memory for UartPico
+#endif
     parser->pico = NULL;
   }
 }
@@ -86,6 +137,7 @@ void NMEAParser_free(NMEAParser *parser)
  * @brief Checks if there is available data to be read from the UART receiver.
  *
  * This function calls `UartRx_available()` to determine if new data is available for processing.
+ * When the receiver is empty, an epoch left open for `NMEA_EPOCH_TIMEOUT_MS` is committed here.
  *
  * @param parser Pointer to the NMEAParser structure.
  *
@@ -93,7 +145,12 @@ void NMEAParser_free(NMEAParser *parser)
  */
 int NMEAParser_available(NMEAParser *parser)
 {
-  return UartRx_available(parser->uart_rx);
+  int available = UartRx_available(parser->uart_rx);
+  if (available == 0)
+  {
+    expireEpoch(parser);
+  }
+  return available;
 }
 
 /**
@@ -108,133 +165,982 @@ uint32_t _millis()
   return time_us_32() / 1000;
 }
 
+// Maximum number of fields kept per sentence, including the address field ($GPGSV has 20)
+#define NMEA_MAX_FIELDS 24
+
+// Packs the 3-character sentence type of an address (e.g. "GGA" of "GNGGA") into one integer for dispatch
+#define NMEA_KEY(a, b, c) ((uint32_t)(((a) - '0') & 63) << 12 | (uint32_t)(((b) - '0') & 63) << 6 | (uint32_t)(((c) - '0') & 63))
+
+// Packs the 2-character talker ID of an address (e.g. "GN" of "GNGGA")
+#define NMEA_TALKER_KEY(a, b) ((uint16_t)(uint8_t)(a) << 8 | (uint8_t)(b))
+
+/**
+ * @brief A field of a sentence, referenced in place (not null-terminated).
+ */
+typedef struct
+{
+  const char *start; // First character of the field
+  size_t length;     // Number of characters in the field
+} NMEAToken;
+
+/**
+ * @brief Field boundaries of one sentence, found in a single pass.
+ */
+typedef struct
+{
+  const char *sentence;                 // First character of the sentence
+  uint8_t count;                        // Number of fields, including the address field
+  uint16_t start[NMEA_MAX_FIELDS + 1];  // Offset of each field; start[count] is one past the last field's end
+} NMEAFields;
+
+/**
+ * @brief Types a field can be converted to by `fillFields`.
+ */
+typedef enum
+{
+  NMEA_FIELD_STRING,  // Null-terminated copy, truncated to the destination size
+  NMEA_FIELD_UINT8,   // uint8_t
+  NMEA_FIELD_UINT16,  // uint16_t
+  NMEA_FIELD_FIXED,   // int32_t, the decimal value times the descriptor's scale
+  NMEA_FIELD_DEGREES, // int32_t, ddmm.mmmm in degrees * NMEA_DEGREES_SCALE, signed by the hemisphere in the next field
+} NMEAFieldType;
+
+/**
+ * @brief Describes where one field of a sentence is stored in its data structure.
+ */
+typedef struct
+{
+  uint8_t index;   // Field number in the sentence (the address field is 0)
+  uint8_t type;    // NMEAFieldType of the destination
+  uint8_t size;    // Size of the destination in bytes
+  uint16_t offset; // Offset of the destination in the data structure
+  uint16_t scale;  // Fixed-point scale of NMEA_FIELD_FIXED fields (a power of ten)
+} NMEAFieldDescriptor;
+
+#define NMEA_COUNT(table) (sizeof(table) / sizeof(table[0]))
+
+#define NMEA_FIELD(index, type, data, member) {index, type, sizeof(((data *)0)->member), offsetof(data, member), 1}
+#define NMEA_FIXED(index, data, member, scale) {index, NMEA_FIELD_FIXED, sizeof(((data *)0)->member), offsetof(data, member), scale}
+
+// https://receiverhelp.trimble.com/alloy-gnss/en-us/NMEA-0183messages_GGA.html
+static const NMEAFieldDescriptor gpgga_fields[] = {
+    NMEA_FIELD(1, NMEA_FIELD_STRING, GPGGA_Data, utc_time),
+    NMEA_FIELD(2, NMEA_FIELD_DEGREES, GPGGA_Data, latitude),
+    NMEA_FIELD(3, NMEA_FIELD_STRING, GPGGA_Data, latitude_dir),
+    NMEA_FIELD(4, NMEA_FIELD_DEGREES, GPGGA_Data, longitude),
+    NMEA_FIELD(5, NMEA_FIELD_STRING, GPGGA_Data, longitude_dir),
+    NMEA_FIELD(6, NMEA_FIELD_UINT8, GPGGA_Data, fix_status),
+    NMEA_FIELD(7, NMEA_FIELD_UINT8, GPGGA_Data, num_satellites),
+    NMEA_FIXED(8, GPGGA_Data, hdop, NMEA_DOP_SCALE),
+    NMEA_FIXED(9, GPGGA_Data, altitude, NMEA_ALTITUDE_SCALE),
+    NMEA_FIELD(10, NMEA_FIELD_STRING, GPGGA_Data, altitude_unit),
+    NMEA_FIXED(11, GPGGA_Data, geoid_separation, NMEA_ALTITUDE_SCALE),
+    NMEA_FIELD(12, NMEA_FIELD_STRING, GPGGA_Data, geoid_unit),
+};
+
+// https://receiverhelp.trimble.com/alloy-gnss/en-us/NMEA-0183messages_GLL.html
+static const NMEAFieldDescriptor gpgll_fields[] = {
+    NMEA_FIELD(1, NMEA_FIELD_DEGREES, GPGLL_Data, latitude),
+    NMEA_FIELD(2, NMEA_FIELD_STRING, GPGLL_Data, latitude_dir),
+    NMEA_FIELD(3, NMEA_FIELD_DEGREES, GPGLL_Data, longitude),
+    NMEA_FIELD(4, NMEA_FIELD_STRING, GPGLL_Data, longitude_dir),
+    NMEA_FIELD(5, NMEA_FIELD_STRING, GPGLL_Data, utc_time),
+    NMEA_FIELD(6, NMEA_FIELD_STRING, GPGLL_Data, status),
+};
+
+// https://receiverhelp.trimble.com/alloy-gnss/en-us/NMEA-0183messages_RMC.html
+static const NMEAFieldDescriptor gprmc_fields[] = {
+    NMEA_FIELD(1, NMEA_FIELD_STRING, GPRMC_Data, utc_time),
+    NMEA_FIELD(2, NMEA_FIELD_STRING, GPRMC_Data, status),
+    NMEA_FIELD(3, NMEA_FIELD_DEGREES, GPRMC_Data, latitude),
+    NMEA_FIELD(4, NMEA_FIELD_STRING, GPRMC_Data, latitude_dir),
+    NMEA_FIELD(5, NMEA_FIELD_DEGREES, GPRMC_Data, longitude),
+    NMEA_FIELD(6, NMEA_FIELD_STRING, GPRMC_Data, longitude_dir),
+    NMEA_FIXED(7, GPRMC_Data, speed, NMEA_SPEED_SCALE),
+    NMEA_FIXED(8, GPRMC_Data, track, NMEA_ANGLE_SCALE),
+    NMEA_FIELD(9, NMEA_FIELD_STRING, GPRMC_Data, date),
+    NMEA_FIXED(10, GPRMC_Data, variation, NMEA_ANGLE_SCALE),
+};
+
+// https://receiverhelp.trimble.com/alloy-gnss/en-us/NMEA-0183messages_VTG.html
+static const NMEAFieldDescriptor gpvtg_fields[] = {
+    NMEA_FIXED(1, GPVTG_Data, track1, NMEA_ANGLE_SCALE),
+    NMEA_FIELD(2, NMEA_FIELD_STRING, GPVTG_Data, track1_id),
+    NMEA_FIXED(3, GPVTG_Data, track2, NMEA_ANGLE_SCALE),
+    NMEA_FIELD(4, NMEA_FIELD_STRING, GPVTG_Data, track2_id),
+    NMEA_FIXED(5, GPVTG_Data, speed1, NMEA_SPEED_SCALE),
+    NMEA_FIELD(6, NMEA_FIELD_STRING, GPVTG_Data, speed1_id),
+    NMEA_FIXED(7, GPVTG_Data, speed2, NMEA_SPEED_SCALE),
+    NMEA_FIELD(8, NMEA_FIELD_STRING, GPVTG_Data, speed2_id),
+};
+
+// https://receiverhelp.trimble.com/alloy-gnss/en-us/NMEA-0183messages_GSA.html
+static const NMEAFieldDescriptor gpgsa_fields[] = {
+    NMEA_FIELD(1, NMEA_FIELD_STRING, GPGSA_Data, mode1),
+    NMEA_FIELD(2, NMEA_FIELD_UINT8, GPGSA_Data, mode2),
+    NMEA_FIELD(3, NMEA_FIELD_UINT8, GPGSA_Data, prn[0]),
+    NMEA_FIELD(4, NMEA_FIELD_UINT8, GPGSA_Data, prn[1]),
+    NMEA_FIELD(5, NMEA_FIELD_UINT8, GPGSA_Data, prn[2]),
+    NMEA_FIELD(6, NMEA_FIELD_UINT8, GPGSA_Data, prn[3]),
+    NMEA_FIELD(7, NMEA_FIELD_UINT8, GPGSA_Data, prn[4]),
+    NMEA_FIELD(8, NMEA_FIELD_UINT8, GPGSA_Data, prn[5]),
+    NMEA_FIELD(9, NMEA_FIELD_UINT8, GPGSA_Data, prn[6]),
+    NMEA_FIELD(10, NMEA_FIELD_UINT8, GPGSA_Data, prn[7]),
+    NMEA_FIELD(11, NMEA_FIELD_UINT8, GPGSA_Data, prn[8]),
+    NMEA_FIELD(12, NMEA_FIELD_UINT8, GPGSA_Data, prn[9]),
+    NMEA_FIELD(13, NMEA_FIELD_UINT8, GPGSA_Data, prn[10]),
+    NMEA_FIELD(14, NMEA_FIELD_UINT8, GPGSA_Data, prn[11]),
+    NMEA_FIXED(15, GPGSA_Data, pdop, NMEA_DOP_SCALE),
+    NMEA_FIXED(16, GPGSA_Data, hdop, NMEA_DOP_SCALE),
+    NMEA_FIXED(17, GPGSA_Data, vdop, NMEA_DOP_SCALE),
+};
+
+// Fields of the n-th satellite of a GSV message
+#define NMEA_GSV_SATELLITE(n)                                                     \
+  NMEA_FIELD(4 + 4 * (n), NMEA_FIELD_UINT8, GPGSV_Data, satellites[n].prn),       \
+  NMEA_FIELD(5 + 4 * (n), NMEA_FIELD_UINT8, GPGSV_Data, satellites[n].elevation), \
+  NMEA_FIELD(6 + 4 * (n), NMEA_FIELD_UINT16, GPGSV_Data, satellites[n].azimuth),  \
+  NMEA_FIELD(7 + 4 * (n), NMEA_FIELD_UINT8, GPGSV_Data, satellites[n].snr)
+
+// https://receiverhelp.trimble.com/alloy-gnss/en-us/NMEA-0183messages_GSV.html
+static const NMEAFieldDescriptor gpgsv_fields[] = {
+    NMEA_FIELD(1, NMEA_FIELD_UINT8, GPGSV_Data, total),
+    NMEA_FIELD(2, NMEA_FIELD_UINT8, GPGSV_Data, count),
+    NMEA_FIELD(3, NMEA_FIELD_UINT8, GPGSV_Data, total_sv),
+    NMEA_GSV_SATELLITE(0),
+    NMEA_GSV_SATELLITE(1),
+    NMEA_GSV_SATELLITE(2),
+    NMEA_GSV_SATELLITE(3),
+};
+
+// Quectel L80 protocol specification, 2.1 Packet Type: 001 PMTK_ACK
+static const NMEAFieldDescriptor pmtk001_fields[] = {
+    NMEA_FIELD(1, NMEA_FIELD_UINT16, PMTK001_Data, command),
+    NMEA_FIELD(2, NMEA_FIELD_UINT8, PMTK001_Data, flag),
+};
+
+// Splits the sentence and stores its fields. Tables list their fields in sentence order, so the
+// last entry gives the number of fields to split; sentences that are not parsed are never split.
+#define FILL_FIELDS(data, table)                                                  \
+  splitFields(sentence, length, table[NMEA_COUNT(table) - 1].index + 1, &fields); \
+  fillFields(data, table, NMEA_COUNT(table), &fields)
+
+// A case of parseSentence whose body is only compiled in if its type is in NMEA_PARSER_SENTENCES
+#define NMEA_CASE(type) \
+  case type:            \
+    if (!(NMEA_PARSER_SENTENCES & NMEA_SENTENCE_BIT(type))) return;
+
+// Characters that end a field: the comma, the '*' before the checksum and the line ending
+static const bool nmea_delimiter[256] = {[','] = true, ['*'] = true, ['\r'] = true, ['\n'] = true};
+
+/**
+ * @brief Splits a sentence into fields in one pass, without modifying it.
+ *
+ * The sentence ends at the '*' that introduces the checksum or at the end of the line.
+ * Scanning stops once `needed` fields are known, so trailing fields nobody stores are skipped.
+ *
+ * @param sentence First character of the sentence.
+ * @param length Number of characters in the sentence.
+ * @param needed Number of fields to find (at most `NMEA_MAX_FIELDS`), including the address field.
+ * @param fields Receives the field boundaries.
+ */
+static void splitFields(const char *sentence, size_t length, uint8_t needed, NMEAFields *fields)
+{
+  const uint8_t *p = (const uint8_t *)sentence;
+  const uint8_t *end = p + length;
+  uint8_t count = 0;
+  fields->sentence = sentence;
+  fields->start[0] = 0;
+  while (true)
+  {
+    while (p < end && !nmea_delimiter[*p])
+    {
+      p++;
+    }
+    if (p == end || *p != ',')
+    {
+      break; // End of the data fields
+    }
+    p++;
+    fields->start[++count] = p - (const uint8_t *)sentence;
+    if (count == needed)
+    {
+      fields->count = count;
+      return; // Later fields are not needed
+    }
+  }
+  fields->start[++count] = p - (const uint8_t *)sentence + 1; // As if the sentence ended with a comma
+  fields->count = count;
+}
+
+/**
+ * @brief Returns a field of a split sentence; fields past the end read as empty.
+ */
+static NMEAToken getField(const NMEAFields *fields, uint8_t index)
+{
+  NMEAToken token = {fields->sentence, 0};
+  if (index < fields->count)
+  {
+    token.start += fields->start[index];
+    token.length = fields->start[index + 1] - fields->start[index] - 1;
+  }
+  return token;
+}
+
+/**
+ * @brief Copies a field into a fixed-size, null-terminated buffer, truncating if needed.
+ */
+static void tokenCopy(char *dest, size_t size, NMEAToken token)
+{
+  size_t length = token.length < size - 1 ? token.length : size - 1;
+  memcpy(dest, token.start, length);
+  dest[length] = '\0';
+}
+
+/**
+ * @brief Converts an unsigned integer field, straight from the sentence (no copy, no `atoi`).
+ */
+static int tokenToInt(NMEAToken token)
+{
+  int value = 0;
+  for (const char *p = token.start; p < token.start + token.length && *p >= '0' && *p <= '9'; p++)
+  {
+    value = value * 10 + (*p - '0');
+  }
+  return value;
+}
+
 /**
- * @brief Extracts a token from the comma-separated string and updates the pointer to the remaining string.
+ * @brief Converts a decimal field to fixed point, straight from the sentence with integer math.
  *
- * This function locates the next comma in the string, null-terminates the token, and updates the
- * `rest` pointer to the position after the comma. If no comma is found, it returns the full string.
+ * Digits beyond the precision of `scale` are rounded (half up). An empty field reads as 0.
  *
- * @param rest Pointer to the string to tokenize. On output, points to the remaining string after the token.
+ * @param token The field, e.g. "61.7".
+ * @param scale The fixed-point scale, a power of ten (e.g. 100 gives 6170).
  *
- * @return Returns the extracted token as a string.
+ * @return Returns the value times `scale`.
  */
-static char *getToken(char **rest)
+static int32_t tokenToFixed(NMEAToken token, uint32_t scale)
 {
-  char *start = *rest;
-  char *token;
-  if (start == NULL || *start == '\0')
+  const char *p = token.start;
+  const char *end = p + token.length;
+  bool negative = p < end && *p == '-';
+  p += negative;
+  uint32_t value = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; p++)
   {
-    return NULL;
+    value = value * 10 + (*p - '0');
+  }
+  uint32_t unit = 1; // Scale of the digits accumulated so far
+  if (p < end && *p == '.')
+  {
+    for (p++; p < end && *p >= '0' && *p <= '9'; p++)
+    {
+      if (unit == scale)
+      {
+        value += *p >= '5'; // First digit past the precision rounds
+        break;
+      }
+      value = value * 10 + (*p - '0');
+      unit *= 10;
+    }
+  }
+  for (; unit < scale; unit *= 10)
+  {
+    value *= 10;
   }
+  return negative ? -(int32_t)value : (int32_t)value;
+}
 
-  token = strchr(start, ','); // Find the position of the next comma (or end of string)
+/**
+ * @brief Converts a ddmm.mmmm coordinate and its hemisphere to degrees * NMEA_DEGREES_SCALE.
+ *
+ * Integer only: the minutes are taken with 5 decimals and scaled by 100 / 60 = 5 / 3, rounded.
+ *
+ * @param token The coordinate in DDMM format (degrees and minutes, e.g., 12345.67 for 123° 45.67').
+ * @param hemisphere The direction field ('N', 'S', 'E' or 'W').
+ *
+ * @return Returns the coordinate in degrees * NMEA_DEGREES_SCALE, negative south or west.
+ */
+static int32_t tokenToDegrees(NMEAToken token, NMEAToken hemisphere)
+{
+  uint32_t minutes = tokenToFixed(token, 100000); // dddmm.mmmmm * 1e5
+  uint32_t degrees = minutes / 10000000;
+  minutes -= degrees * 10000000; // mm.mmmmm * 1e5
+  int32_t value = degrees * NMEA_DEGREES_SCALE + (minutes * 5 + 1) / 3;
+  bool negative = hemisphere.length > 0 && (hemisphere.start[0] == 'S' || hemisphere.start[0] == 'W');
+  return negative ? -value : value;
+}
 
-  if (token) // If a comma is found, null-terminate the token and move the rest pointer
+/**
+ * @brief Stores the fields of a split sentence into a data structure, as described by a table.
+ *
+ * @param data The sentence data structure (e.g. `GPGGA_Data`).
+ * @param table The field descriptors of the sentence.
+ * @param count Number of descriptors in the table.
+ * @param fields The split sentence.
+ */
+static void fillFields(void *data, const NMEAFieldDescriptor *table, size_t count, const NMEAFields *fields)
+{
+  for (const NMEAFieldDescriptor *field = table; field < table + count; field++)
   {
-    *token = '\0';     // Null-terminate the token
-    *rest = token + 1; // Move the rest pointer to the character after the comma
+    NMEAToken token = getField(fields, field->index);
+    uint8_t *dest = (uint8_t *)data + field->offset;
+    switch (field->type)
+    {
+    case NMEA_FIELD_STRING:
+      tokenCopy((char *)dest, field->size, token);
+      break;
+    case NMEA_FIELD_UINT8:
+      *dest = tokenToInt(token);
+      break;
+    case NMEA_FIELD_UINT16:
+      *(uint16_t *)dest = tokenToInt(token);
+      break;
+    case NMEA_FIELD_FIXED:
+      *(int32_t *)dest = tokenToFixed(token, field->scale);
+      break;
+    case NMEA_FIELD_DEGREES:
+      *(int32_t *)dest = tokenToDegrees(token, getField(fields, field->index + 1));
+      break;
+    }
   }
-  else
+}
+
+/**
+ * @brief Converts a copied hhmmss.sss field to hhmmss * 1000 + milliseconds.
+ */
+static uint32_t toFixTime(const char *utc_time)
+{
+  uint32_t time = 0;
+  while (*utc_time >= '0' && *utc_time <= '9')
   {
-    *rest = NULL; // If no more commas, rest becomes NULL (end of string)
+    time = time * 10 + (*utc_time++ - '0');
   }
-  return start;
+  uint32_t scale = 1000;
+  if (*utc_time == '.')
+  {
+    utc_time++;
+    while (scale > 1 && *utc_time >= '0' && *utc_time <= '9')
+    {
+      time = time * 10 + (*utc_time++ - '0');
+      scale /= 10;
+    }
+  }
+  return time * scale;
+}
+
+/**
+ * @brief Returns the value of a hexadecimal digit, or -1 if the character is not one.
+ */
+static int hexDigit(char c)
+{
+  if (c >= '0' && c <= '9')
+  {
+    return c - '0';
+  }
+  if (c >= 'A' && c <= 'F')
+  {
+    return c - 'A' + 10;
+  }
+  if (c >= 'a' && c <= 'f')
+  {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+/**
+ * @brief Checks the `*hh` checksum of a sentence against the XOR computed while it was framed.
+ *
+ * The framing XOR covers the whole line ("$" through "\r"); the characters that are not part of
+ * the checksummed body ('$', '*', the two digits and '\r') are taken back out here, so the
+ * sentence is not scanned again.
+ *
+ * @param sentence First character of the sentence, e.g. "$GPGLL,...*4B\r\n".
+ * @param length Number of characters in the sentence.
+ * @param checksum XOR of every character of the sentence except a terminating '\n'.
+ *
+ * @return Returns `true` if the sentence ends with a matching checksum.
+ */
+static bool checkSentence(const char *sentence, size_t length, uint8_t checksum)
+{
+  if (length > 0 && sentence[length - 1] == '\n')
+  {
+    length--;
+  }
+  if (length > 0 && sentence[length - 1] == '\r')
+  {
+    length--;
+    checksum ^= '\r';
+  }
+  if (length < 4 || sentence[0] != '$' || sentence[length - 3] != '*')
+  {
+    return false;
+  }
+  int high = hexDigit(sentence[length - 2]);
+  int low = hexDigit(sentence[length - 1]);
+  checksum ^= '$' ^ '*' ^ sentence[length - 2] ^ sentence[length - 1];
+  return high >= 0 && low >= 0 && checksum == (high << 4 | low);
 }
 
 /**
- * @brief Parses the NMEA sentence and updates the parser with the extracted data.
+ * @brief Returns the type of a sentence from its address, whatever the talker.
  *
- * This function processes a comma-separated NMEA sentence, extracting relevant tokens and storing
- * them into the appropriate fields in the `NMEAParser` structure. It supports multiple types of NMEA sentences,
- * such as GPGGA, GPGLL, GPRMC, etc., and updates the respective data structures with the parsed values.
+ * @param sentence First character of the sentence, e.g. "$GNGGA,...".
+ * @param length Number of characters in the sentence.
+ *
+ * @return Returns the sentence type, or `NMEA_SENTENCE_OTHER` for unknown or malformed addresses.
+ */
+static NMEASentenceType sentenceType(const char *sentence, size_t length)
+{
+  if (length > 9 && memcmp(sentence, "$PMTK001,", 9) == 0)
+  {
+    return NMEA_SENTENCE_ACK; // Proprietary address, no talker
+  }
+  if (length < 7 || sentence[0] != '$' || sentence[6] != ',')
+  {
+    return NMEA_SENTENCE_OTHER;
+  }
+  const char *a = sentence + 3; // Skip "$" and the talker ID
+  switch (NMEA_KEY(a[0], a[1], a[2]))
+  {
+  case NMEA_KEY('G', 'G', 'A'):
+    return NMEA_SENTENCE_GGA;
+  case NMEA_KEY('G', 'L', 'L'):
+    return NMEA_SENTENCE_GLL;
+  case NMEA_KEY('R', 'M', 'C'):
+    return NMEA_SENTENCE_RMC;
+  case NMEA_KEY('G', 'S', 'A'):
+    return NMEA_SENTENCE_GSA;
+  case NMEA_KEY('V', 'T', 'G'):
+    return NMEA_SENTENCE_VTG;
+  case NMEA_KEY('G', 'S', 'V'):
+    return NMEA_SENTENCE_GSV;
+  default:
+    return NMEA_SENTENCE_OTHER;
+  }
+}
+
+/**
+ * @brief Returns the talker of a sentence whose address has already been checked by `sentenceType`.
+ */
+static NMEATalker sentenceTalker(const char *sentence)
+{
+  switch (NMEA_TALKER_KEY(sentence[1], sentence[2]))
+  {
+  case NMEA_TALKER_KEY('G', 'P'):
+    return NMEA_TALKER_GP;
+  case NMEA_TALKER_KEY('G', 'L'):
+    return NMEA_TALKER_GL;
+  case NMEA_TALKER_KEY('G', 'A'):
+    return NMEA_TALKER_GA;
+  case NMEA_TALKER_KEY('G', 'B'):
+  case NMEA_TALKER_KEY('B', 'D'):
+    return NMEA_TALKER_GB;
+  case NMEA_TALKER_KEY('G', 'Q'):
+    return NMEA_TALKER_GQ;
+  case NMEA_TALKER_KEY('G', 'N'):
+    return NMEA_TALKER_GN;
+  default:
+    return NMEA_TALKER_UNKNOWN;
+  }
+}
+
+/**
+ * @brief Appends the satellites of one GSV message to the satellite table.
+ *
+ * Every talker (GPS, GLONASS, ...) sends its own GSV sequence, so sequences are followed per
+ * talker: the first message of a sequence replaces that talker's satellites only.
  *
  * @param parser Pointer to the NMEAParser structure.
- * @param rest The comma-separated string containing the NMEA sentence to be parsed.
+ * @param talker Talker of the message.
+ * @param gpgsv The message, already parsed.
  */
-void NMEAParser_rest(NMEAParser *parser, char *rest)
+static void assembleSatellites(NMEAParser *parser, NMEATalker talker, const GPGSV_Data *gpgsv)
 {
-  char *token = getToken(&rest); // Tokenize the rest by commas
-  if (token == NULL)
+  NMEASatelliteTable *table = &parser->satellites;
+  if (gpgsv->count == 1)
+  {
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < table->count; i++)
+    {
+      if (table->satellites[i].talker != talker)
+      {
+        table->satellites[kept++] = table->satellites[i];
+      }
+    }
+    table->count = kept;
+    table->next[talker] = 1;
+    table->complete = false;
+  }
+  if (gpgsv->count != table->next[talker])
   {
+    table->next[talker] = 0; // A message was lost: wait for the talker's next sequence
     return;
   }
 
-  // Check rest type and parse accordingly
-  if (parser->GPGGA_ENABLED && strcmp(token, "$GPGGA") == 0)
+  const GPGSA_Data *gpgsa = &parser->data.gpgsa;
+  for (const NMEASatellite *sv = gpgsv->satellites; sv < gpgsv->satellites + gpgsv->satellite_count; sv++)
+  {
+    if (table->count == NMEA_MAX_SATELLITES)
+    {
+      break;
+    }
+    NMEASatellite *entry = &table->satellites[table->count++];
+    *entry = *sv;
+    entry->talker = talker;
+    entry->used = false;
+    for (int i = 0; i < NMEA_GSA_PRNS && gpgsa->prn[i] != 0; i++)
+    {
+      if (gpgsa->prn[i] == sv->prn)
+      {
+        entry->used = true;
+        break;
+      }
+    }
+  }
+
+  table->announced[talker] = gpgsv->total_sv;
+  table->next[talker]++;
+  if (gpgsv->count == gpgsv->total)
+  {
+    table->next[talker] = 0;
+    table->in_view = 0;
+    table->complete = true;
+    for (int t = 0; t < NMEA_TALKER_COUNT; t++)
+    {
+      table->in_view += table->announced[t];
+      table->complete = table->complete && table->next[t] == 0; // No other sequence still open
+    }
+    table->last_time = gpgsv->last_time;
+  }
+}
+
+/**
+ * @brief Calls every listener registered for an event.
+ */
+static void notify(NMEAParser *parser, uint32_t event)
+{
+  TRACE_BEGIN(start);
+  const NMEAParserListener *end = parser->listeners + parser->listener_count;
+  for (const NMEAParserListener *listener = parser->listeners; listener < end; listener++)
+  {
+    if (listener->events & event)
+    {
+      listener->callback(parser, event, listener->ctx);
+    }
+  }
+  TRACE_END(TRACE_STAGE_DISPATCH, start);
+}
+
+/**
+ * @brief Publishes the epoch being assembled and fires `NMEA_EVENT_EPOCH`.
+ *
+ * An epoch that ended by itself (new UTC time or timeout) shows the module's output order: it is
+ * learned if none is known yet, or if two epochs in a row ended without the learned last sentence
+ * (a single lost sentence does not change what the module sends).
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ * @param learn Whether the epoch ended by itself rather than on the learned last sentence.
+ */
+static void commitEpoch(NMEAParser *parser, bool learn)
+{
+  NMEAEpoch *epoch = &parser->epoch;
+  if (!learn)
+  {
+    epoch->misses = 0;
+  }
+  else if (epoch->length == 0 || ++epoch->misses == 2)
+  {
+    epoch->length = epoch->sentences;
+    epoch->end = epoch->last;
+    epoch->misses = 0;
+  }
+  epoch->state = NMEA_EPOCH_COMMITTED;
+  NMEAFixLatch_publish(&parser->fix, &epoch->fix);
+  notify(parser, NMEA_EVENT_EPOCH);
+}
+
+/**
+ * @brief Clears the fix being assembled for a new epoch, the date excepted.
+ *
+ * Fields no sentence of the new epoch carries are then left empty instead of showing the
+ * previous epoch.
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ */
+static void clearEpoch(NMEAParser *parser)
+{
+  NMEAEpoch *epoch = &parser->epoch;
+  uint32_t date = epoch->fix.date;
+  memset(&epoch->fix, 0, sizeof(NMEAFix));
+  epoch->fix.date = date;
+  epoch->sentences = 0;
+}
+
+/**
+ * @brief Places a sentence without a UTC time in the current epoch.
+ *
+ * While an epoch is open the sentence belongs to it. Once the epoch was published (or before the
+ * first UTC time), the sentence is held for the next epoch instead: the fix is cleared and the
+ * held sentences are merged into it, and the next sentence with a UTC time adopts them (see
+ * `openEpoch`). Held sentences are not counted in the epoch's learned order.
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ */
+static void joinEpoch(NMEAParser *parser)
+{
+  NMEAEpoch *epoch = &parser->epoch;
+  if (epoch->state == NMEA_EPOCH_NONE || epoch->state == NMEA_EPOCH_COMMITTED)
+  {
+    clearEpoch(parser);
+    epoch->state = NMEA_EPOCH_NEXT;
+  }
+}
+
+/**
+ * @brief Places a sentence with a UTC time in its epoch, committing the previous one if the time changed.
+ *
+ * Called before the sentence is merged, so the committed fix holds only the previous epoch. A new
+ * epoch starts from a cleared fix (see `clearEpoch`), or adopts the sentences held for it (see
+ * `joinEpoch`). A sentence of an epoch already published is left out of it, which is not
+ * committed again: it means the module's output changed, so the order is learned anew from the
+ * next epochs.
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ * @param utc_time UTC time of the sentence being parsed (see `toFixTime`).
+ * @param length Number of characters in the sentence.
+ * @return True if the sentence is to be merged into the epoch's fix.
+ */
+static bool openEpoch(NMEAParser *parser, uint32_t utc_time, size_t length)
+{
+  NMEAEpoch *epoch = &parser->epoch;
+  if (epoch->state != NMEA_EPOCH_NONE && utc_time == epoch->time)
+  {
+    if (epoch->state == NMEA_EPOCH_OPEN)
+    {
+      return true;
+    }
+    epoch->length = 0; // Late sentence of a published epoch
+    epoch->misses = 0;
+    return false;
+  }
+  if (epoch->state == NMEA_EPOCH_OPEN)
+  {
+    commitEpoch(parser, true);
+  }
+  if (epoch->state != NMEA_EPOCH_NEXT)
+  {
+    clearEpoch(parser);
+  }
+  epoch->fix.utc_time = utc_time;
+  epoch->fix.start_us = time_us_32();
+  const UartPico *pico = parser->pico;
+  if (pico != NULL && pico->baud != 0)
+  {
+    // The sentence is parsed once its LF arrived: go back to its '$' (plus CR LF, start and stop bits)
+    epoch->fix.start_us -= (uint32_t)((uint64_t)(length + 2) * (1 + pico->bits + pico->stop) * 1000000u / pico->baud);
+  }
+  epoch->state = NMEA_EPOCH_OPEN;
+  epoch->time = utc_time;
+  return true;
+}
+
+/**
+ * @brief Counts a merged sentence and commits the epoch if it was the last one of the learned order.
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ * @param key Type and talker of the sentence (`type | talker << 8`).
+ */
+static void closeSentence(NMEAParser *parser, uint16_t key)
+{
+  NMEAEpoch *epoch = &parser->epoch;
+  epoch->updated = _millis();
+  if (epoch->state != NMEA_EPOCH_OPEN)
+  {
+    return; // Nothing with a UTC time yet
+  }
+  epoch->last = key;
+  epoch->sentences++;
+  if (epoch->length != 0 && epoch->sentences == epoch->length && key == epoch->end)
+  {
+    commitEpoch(parser, false);
+  }
+}
+
+/**
+ * @brief Commits the open epoch once the receiver has been silent for `NMEA_EPOCH_TIMEOUT_MS`.
+ *
+ * Covers the last sentence of an epoch being lost, or the first epochs before the order is learned.
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ */
+static void expireEpoch(NMEAParser *parser)
+{
+  NMEAEpoch *epoch = &parser->epoch;
+  if (epoch->state == NMEA_EPOCH_OPEN && _millis() - epoch->updated >= NMEA_EPOCH_TIMEOUT_MS)
+  {
+    commitEpoch(parser, true);
+  }
+}
+
+/**
+ * @brief Parses one NMEA sentence of a known type and updates the parser with the extracted data.
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ * @param type Type of the sentence, from `sentenceType`.
+ * @param sentence First character of the sentence (not necessarily null-terminated).
+ * @param length Number of characters in the sentence.
+ */
+static void parseSentence(NMEAParser *parser, NMEASentenceType type, const char *sentence, size_t length)
+{
+  if (!(parser->enabled & NMEA_PARSER_SENTENCES & NMEA_SENTENCE_BIT(type)))
+  {
+    return; // Disabled, compiled out, or not a sentence the parser knows
+  }
+  NMEATalker talker = sentenceTalker(sentence);
+  NMEAFields fields;
+
+  // Sentences are merged into the epoch's fix, which is published as a whole (see NMEAEpoch)
+  NMEAFix *fix = &parser->epoch.fix;
+  bool fixed = true;
+
+  switch (type)
+  {
+  NMEA_CASE(NMEA_SENTENCE_GGA)
   {
     GPGGA_Data *gpgga = &parser->data.gpgga;
-    strcpy(parser->data.utc_time = gpgga->utc_time, getToken(&rest));           // UTC of position fix
-    parser->data.latitude = gpgga->latitude = atof(getToken(&rest));            // Latitude
-    strcpy(parser->data.latitude_dir = gpgga->latitude_dir, getToken(&rest));   // Direction of latitude: (N: North, S: South)
-    parser->data.longitude = gpgga->longitude = atof(getToken(&rest));          // Longitude
-    strcpy(parser->data.longitude_dir = gpgga->longitude_dir, getToken(&rest)); // Direction of longitude: (E: East, W: West)
-    gpgga->fix_status = atoi(getToken(&rest));                                  // GPS Quality indicator
-    gpgga->num_satellites = atoi(getToken(&rest));                              // Number of SVs in use, range from 00 through to 24+
-    gpgga->hdop = atof(getToken(&rest));                                        // Horizontal Dilution of Precision
-    gpgga->altitude = atof(getToken(&rest));                                    // Orthometric height (MSL reference)
-    strcpy(gpgga->altitude_unit, getToken(&rest));                              // M: unit of measure for orthometric height is meters
-    gpgga->geoid_separation = atof(getToken(&rest));                            // Geoid separation
-    strcpy(gpgga->geoid_unit, getToken(&rest));                                 // M: geoid separation measured in meters
-    gpgga->last_time = _millis();                                               // Store the current time (e.g., from a timer)
-  }
-  else if (parser->GPGLL_ENABLED && strcmp(token, "$GPGLL") == 0)
+    FILL_FIELDS(gpgga, gpgga_fields);
+    parser->data.utc_time = gpgga->utc_time;
+    parser->data.latitude = gpgga->latitude;
+    parser->data.latitude_dir = gpgga->latitude_dir;
+    parser->data.longitude = gpgga->longitude;
+    parser->data.longitude_dir = gpgga->longitude_dir;
+    gpgga->last_time = _millis(); // Store the current time (e.g., from a timer)
+
+    fixed = openEpoch(parser, toFixTime(gpgga->utc_time), length);
+    if (!fixed)
+    {
+      break; // Late sentence of a committed epoch
+    }
+    fix->latitude = gpgga->latitude;
+    fix->longitude = gpgga->longitude;
+    fix->quality = gpgga->fix_status;
+    fix->satellites = gpgga->num_satellites;
+    fix->hdop = gpgga->hdop;
+    fix->altitude = gpgga->altitude;
+    fix->time = gpgga->last_time;
+    break;
+  }
+  NMEA_CASE(NMEA_SENTENCE_GLL)
   {
     GPGLL_Data *gpgll = &parser->data.gpgll;
-    parser->data.latitude = gpgll->latitude = atof(getToken(&rest));            // Latitude in dd mm,mmmm format (0-7 decimal places)
-    strcpy(parser->data.latitude_dir = gpgll->latitude_dir, getToken(&rest));   // Direction of latitude N: North S: South
-    parser->data.longitude = gpgll->longitude = atof(getToken(&rest));          // Longitude in ddd mm,mmmm format (0-7 decimal places)
-    strcpy(parser->data.longitude_dir = gpgll->longitude_dir, getToken(&rest)); // Direction of longitude E: East W: West
-    strcpy(parser->data.utc_time = gpgll->utc_time, getToken(&rest));           // UTC of position in hhmmss.ss format
-    strcpy(gpgll->status, getToken(&rest));                                     // Status indicator: (A: Data valid, V: Data not valid)
-    gpgll->last_time = _millis();                                               // Store the current time (e.g., from a timer)
+    FILL_FIELDS(gpgll, gpgll_fields);
+    parser->data.latitude = gpgll->latitude;
+    parser->data.latitude_dir = gpgll->latitude_dir;
+    parser->data.longitude = gpgll->longitude;
+    parser->data.longitude_dir = gpgll->longitude_dir;
+    parser->data.utc_time = gpgll->utc_time;
+    gpgll->last_time = _millis(); // Store the current time (e.g., from a timer)
+
+    fixed = openEpoch(parser, toFixTime(gpgll->utc_time), length);
+    if (!fixed)
+    {
+      break; // Late sentence of a committed epoch
+    }
+    fix->latitude = gpgll->latitude;
+    fix->longitude = gpgll->longitude;
+    fix->valid = gpgll->status[0] == 'A';
+    fix->time = gpgll->last_time;
+    break;
   }
-  else if (parser->GPRMC_ENABLED && strcmp(token, "$GPRMC") == 0)
+  NMEA_CASE(NMEA_SENTENCE_RMC)
   {
     GPRMC_Data *gprmc = &parser->data.gprmc;
-    strcpy(parser->data.utc_time = gprmc->utc_time, getToken(&rest));           // UTC of position fix
-    strcpy(gprmc->status, getToken(&rest));                                     // Status (A=active or V=void)
-    parser->data.latitude = gprmc->latitude = atof(getToken(&rest));            // Latitude in dd mm,mmmm format (0-7 decimal places)
-    strcpy(parser->data.latitude_dir = gprmc->latitude_dir, getToken(&rest));   // Direction of latitude N: North S: South
-    parser->data.longitude = gprmc->longitude = atof(getToken(&rest));          // Longitude in ddd mm,mmmm format (0-7 decimal places)
-    strcpy(parser->data.longitude_dir = gprmc->longitude_dir, getToken(&rest)); // Direction of longitude E: East W: West
-    parser->data.speed = gprmc->speed = atof(getToken(&rest));                  // Speed over the ground in knots
-    gprmc->track = atof(getToken(&rest));                                       // Track angle in degrees (True)
-    strcpy(gprmc->date, getToken(&rest));                                       // Date
-    gprmc->variation = atof(getToken(&rest));                                   // Magnetic variation, in degrees
-    gprmc->last_time = _millis();                                               // Store the current time (e.g., from a timer)
-  }
-  else if (parser->GPVTG_ENABLED && strcmp(token, "$GPVTG") == 0)
+    FILL_FIELDS(gprmc, gprmc_fields);
+    parser->data.utc_time = gprmc->utc_time;
+    parser->data.latitude = gprmc->latitude;
+    parser->data.latitude_dir = gprmc->latitude_dir;
+    parser->data.longitude = gprmc->longitude;
+    parser->data.longitude_dir = gprmc->longitude_dir;
+    parser->data.speed = gprmc->speed;
+    gprmc->last_time = _millis(); // Store the current time (e.g., from a timer)
+
+    fixed = openEpoch(parser, toFixTime(gprmc->utc_time), length);
+    if (!fixed)
+    {
+      break; // Late sentence of a committed epoch
+    }
+    fix->date = atol(gprmc->date);
+    fix->latitude = gprmc->latitude;
+    fix->longitude = gprmc->longitude;
+    fix->speed = gprmc->speed;
+    fix->course = gprmc->track;
+    fix->valid = gprmc->status[0] == 'A';
+    fix->time = gprmc->last_time;
+    break;
+  }
+  NMEA_CASE(NMEA_SENTENCE_VTG)
   {
     GPVTG_Data *gpvtg = &parser->data.gpvtg;
-    gpvtg->track1 = atof(getToken(&rest));                      // Track made good (degrees true)
-    strcpy(gpvtg->track1_id, getToken(&rest));                  // T: track made good is relative to true north
-    gpvtg->track2 = atof(getToken(&rest));                      // Track made good (degrees magnetic)
-    strcpy(gpvtg->track2_id, getToken(&rest));                  // M: track made good is relative to magnetic north
-    parser->data.speed = gpvtg->speed1 = atof(getToken(&rest)); // Speed, in knots
-    strcpy(gpvtg->speed1_id, getToken(&rest));                  // N: speed is measured in knots
-    gpvtg->speed2 = atof(getToken(&rest));                      // Speed over ground in kilometers/hour (kph)
-    strcpy(gpvtg->speed2_id, getToken(&rest));                  // K: speed over ground is measured in kph
-    gpvtg->last_time = _millis();                               // Store the current time (e.g., from a timer)
-  }
-  else if (parser->GPGSV_ENABLED && strcmp(token, "$GPGSV") == 0)
+    FILL_FIELDS(gpvtg, gpvtg_fields);
+    parser->data.speed = gpvtg->speed1;
+    gpvtg->last_time = _millis(); // Store the current time (e.g., from a timer)
+
+    joinEpoch(parser);
+    fix->speed = gpvtg->speed1;
+    fix->course = gpvtg->track1;
+    fix->time = gpvtg->last_time;
+    break;
+  }
+  NMEA_CASE(NMEA_SENTENCE_GSV)
   {
     GPGSV_Data *gpgsv = &parser->data.gpgsv;
-    gpgsv->total = atoi(getToken(&rest));     // Total number of messages of this type in this cycle
-    gpgsv->count = atoi(getToken(&rest));     // Message number
-    gpgsv->total_sv = atoi(getToken(&rest));  // Total number of SVs visible
-    gpgsv->prn_sv = atoi(getToken(&rest));    // SV PRN number
-    gpgsv->elevation = atoi(getToken(&rest)); // Elevation, in degrees, 90° maximum
-    gpgsv->azimuth = atoi(getToken(&rest));   // Azimuth, degrees from True North, 000° through 359°
-    gpgsv->snr = atoi(getToken(&rest));       // SNR, 00 through 99 dB (null when not tracking)
-    gpgsv->last_time = _millis();             // Store the current time (e.g., from a timer)
+    FILL_FIELDS(gpgsv, gpgsv_fields);
+    uint8_t satellites = fields.count > 4 ? (fields.count - 4) / 4 : 0; // Four fields per satellite
+    gpgsv->satellite_count = satellites < NMEA_GSV_SATELLITES ? satellites : NMEA_GSV_SATELLITES;
+    gpgsv->last_time = _millis(); // Store the current time (e.g., from a timer)
+    assembleSatellites(parser, talker, gpgsv);
+
+    joinEpoch(parser);
+    fixed = false;
+    break;
+  }
+  NMEA_CASE(NMEA_SENTENCE_GSA)
+  {
+    GPGSA_Data *gpgsa = &parser->data.gpgsa;
+    FILL_FIELDS(gpgsa, gpgsa_fields);
+    gpgsa->last_time = _millis(); // Store the current time (e.g., from a timer)
+
+    joinEpoch(parser);
+    fix->mode = gpgsa->mode2;
+    fix->pdop = gpgsa->pdop;
+    fix->hdop = gpgsa->hdop;
+    fix->vdop = gpgsa->vdop;
+    fix->time = gpgsa->last_time;
+    break;
+  }
+  NMEA_CASE(NMEA_SENTENCE_ACK)
+  {
+    PMTK001_Data *pmtk001 = &parser->data.pmtk001;
+    FILL_FIELDS(pmtk001, pmtk001_fields);
+    pmtk001->last_time = _millis(); // Store the current time (e.g., from a timer)
+    notify(parser, NMEA_SENTENCE_BIT(type));
+    return; // Replies to commands are not part of the module's output order
+  }
+  default:
+    return;
+  }
+
+  if (fixed)
+  {
+    fix->talker = talker;
+  }
+  notify(parser, NMEA_SENTENCE_BIT(type));
+  closeSentence(parser, type | talker << 8);
+}
+
+/**
+ * @brief Parses one NMEA sentence in place and updates the parser with the extracted data.
+ *
+ * The sentence is dispatched on the type in its address (e.g. "GGA"), whatever the talker
+ * (GP, GN, GL, ...), split into fields in a single pass and stored field by field as described
+ * by the sentence's descriptor table. The sentence is neither modified nor copied, so it may
+ * point straight into the receive ring. The checksum is not verified; see `NMEAParser_parseLine`.
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ * @param sentence First character of the sentence (not necessarily null-terminated).
+ * @param length Number of characters in the sentence.
+ */
+void NMEAParser_parse(NMEAParser *parser, const char *sentence, size_t length)
+{
+  parseSentence(parser, sentenceType(sentence, length), sentence, length);
+}
+
+/**
+ * @brief Validates the checksum of a framed sentence and parses it if it is intact.
+ *
+ * Sentences with a bad or missing checksum are counted as rejected and never reach the field
+ * parser, so a corrupted line cannot overwrite a good fix. Accepted sentences are counted and
+ * their parse time is measured in processor cycles.
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ * @param line The sentence and the XOR computed while it was framed (see `UartRx_readSentence`).
+ *
+ * @return Returns `true` if the checksum matched and the sentence was parsed.
+ */
+bool NMEAParser_parseLine(NMEAParser *parser, const UartRxLine *line)
+{
+  NMEAParserStats *stats = &parser->stats;
+  NMEASentenceType type = sentenceType(line->data, line->length); // Looked up once for the counters and the dispatch
+  if (!checkSentence(line->data, line->length, line->checksum))
+  {
+    stats->rejected[type]++;
+    return false;
   }
+  stats->accepted[type]++;
+
+  uint32_t start = systick_hw->cvr;
+  parseSentence(parser, type, line->data, line->length);
+  TRACE_END(TRACE_STAGE_PARSE, start);
+  uint32_t cycles = (start - systick_hw->cvr) & 0x00FFFFFF; // SysTick counts down
+  stats->parse_cycles = cycles;
+  stats->parse_cycles_total += cycles;
+  if (cycles > stats->parse_cycles_max)
+  {
+    stats->parse_cycles_max = cycles;
+  }
+  return true;
+}
+
+/**
+ * @brief Parses a null-terminated NMEA sentence.
+ *
+ * The checksum is computed here, as the string did not come through `UartRx_readSentence`.
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ * @param rest The comma-separated string containing the NMEA sentence to be parsed.
+ */
+void NMEAParser_rest(NMEAParser *parser, char *rest)
+{
+  UartRxLine line = {rest, 0, 0};
+  for (; rest[line.length] != '\0' && rest[line.length] != '\n'; line.length++)
+  {
+    line.checksum ^= rest[line.length];
+  }
+  NMEAParser_parseLine(parser, &line);
+}
+
+/**
+ * @brief Reads the next complete sentence and parses it without copying it.
+ *
+ * The view is returned even if the sentence was rejected for a bad checksum; see `stats`.
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ * @param line On success, receives a view of the sentence that stays valid until the next read.
+ *
+ * @return Returns `true` if a sentence was read, `false` if no complete sentence is available.
+ */
+bool NMEAParser_readSentence(NMEAParser *parser, UartRxLine *line)
+{
+  if (!UartRx_readSentence(parser->uart_rx, line))
+  {
+    if (UartRx_available(parser->uart_rx) == 0)
+    {
+      expireEpoch(parser); // Nothing on the way: the module is done with this epoch
+    }
+    return false;
+  }
+  NMEAParser_parseLine(parser, line);
+  return true;
 }
 
 /**
  * @brief Reads a line of data from the UART receiver and processes the NMEA sentence.
  *
- * This function reads a complete line of data from the UART receiver, tokenizes it, and processes it.
- * It stores the result in the parser's data structure and frees any allocated memory for temporary storage.
+ * This function reads a complete line of data from the UART receiver and parses it in place,
+ * without any temporary allocation. The returned string lives in the receiver's line buffer.
  *
  * @param parser Pointer to the NMEAParser structure.
  *
@@ -242,18 +1148,208 @@ void NMEAParser_rest(NMEAParser *parser, char *rest)
  */
 char *NMEAParser_read(NMEAParser *parser)
 {
-  // Read the next available data (single character)
-  char *result = UartRx_readLine(parser->uart_rx);
-  if (result == NULL)
+  // Read and parse the next available line, then hand it out as a string
+  UartRxLine line;
+  if (!NMEAParser_readSentence(parser, &line))
   {
     return NULL;
   }
-  char *copy = malloc(strlen(result) + 1);
-  if (copy != NULL)
+  return UartRx_lineString(parser->uart_rx, &line);
+}
+
+/**
+ * @brief Copies a consistent snapshot of the current fix.
+ *
+ * Safe to call from another core or from an interrupt while the parser is updating the fix;
+ * the copy is a few dozen bytes instead of the whole `GPSData`.
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ * @param fix Receives the snapshot.
+ */
+void NMEAParser_fix(NMEAParser *parser, NMEAFix *fix)
+{
+  NMEAFixLatch_read(&parser->fix, fix);
+}
+
+/**
+ * @brief Copies the sentence counters and parse timing, with the receiver's error counters.
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ * @param stats Receives the statistics.
+ */
+void NMEAParser_stats(NMEAParser *parser, NMEAParserStats *stats)
+{
+  *stats = parser->stats;
+  if (parser->uart_rx != NULL)
+  {
+    stats->ring_overflows = parser->uart_rx->ring.overflows;
+    stats->dma_overflows = parser->uart_rx->dma_overflows;
+    stats->line_truncations = parser->uart_rx->line_truncations;
+    stats->framing_errors = parser->uart_rx->framing_errors;
+  }
+}
+
+/**
+ * @brief Returns the satellite table assembled from GSV sequences.
+ *
+ * The table is updated in place by the parser; read it from the core that parses and check
+ * `complete` before using it.
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ */
+const NMEASatelliteTable *NMEAParser_satellites(NMEAParser *parser)
+{
+  return &parser->satellites;
+}
+
+/**
+ * @brief Registers a callback for parsed sentences and completed epochs.
+ *
+ * The callback fires once per parsed sentence whose `NMEA_SENTENCE_BIT` is set in `events`, after
+ * the sentence's data has been updated, and once per epoch if `NMEA_EVENT_EPOCH` is set, right
+ * after the epoch's fix has been published (see `NMEAEpoch`), so `NMEAParser_fix` returns the
+ * completed epoch. Callbacks run in the context that
+ * reads the parser (main loop or pipeline core) and must not read from the parser themselves.
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ * @param events Sentence bits (`NMEA_SENTENCE_BIT`, `NMEA_SENTENCES_ALL`), `NMEA_EVENT_EPOCH` and/or
+ *               the events of modules built on the parser (`NMEA_EVENT_GEOFENCE`).
+ * @param callback Function to call.
+ * @param ctx Passed back to the callback.
+ *
+ * @return Returns `NMEA_PARSER_SUCCESS` (0), or `NMEA_PARSER_ERROR_LISTENERS_FULL` (2) if
+ *         `NMEA_PARSER_LISTENERS` callbacks are already registered.
+ */
+int NMEAParser_on(NMEAParser *parser, uint32_t events, NMEAParserCallback callback, void *ctx)
+{
+  if (parser->listener_count == NMEA_PARSER_LISTENERS)
   {
-    strcpy(copy, result);
-    NMEAParser_rest(parser, copy);
-    free(copy);
+    return NMEA_PARSER_ERROR_LISTENERS_FULL;
+  }
+  NMEAParserListener *listener = &parser->listeners[parser->listener_count++];
+  listener->events = events;
+  listener->callback = callback;
+  listener->ctx = ctx;
+  return NMEA_PARSER_SUCCESS;
+}
+
+/**
+ * @brief Removes a callback registered with `NMEAParser_on` (with the same `ctx`).
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ * @param callback Function that was registered.
+ * @param ctx Pointer that was registered with it.
+ */
+void NMEAParser_off(NMEAParser *parser, NMEAParserCallback callback, void *ctx)
+{
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < parser->listener_count; i++)
+  {
+    NMEAParserListener *listener = &parser->listeners[i];
+    if (listener->callback != callback || listener->ctx != ctx)
+    {
+      parser->listeners[kept++] = *listener;
+    }
+  }
+  parser->listener_count = kept;
+}
+
+/**
+ * @brief Fires an event of a module built on the parser (e.g. `NMEA_EVENT_GEOFENCE`) to its listeners.
+ *
+ * The listeners registered for the event are called at once, in the caller's context; modules
+ * call it from the callbacks that feed them, so the events arrive like the parser's own.
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ * @param event The event bit.
+ */
+void NMEAParser_notify(NMEAParser *parser, uint32_t event)
+{
+  notify(parser, event);
+}
+
+/**
+ * @brief Changes the baud rate of the receiver and the transmitter in place.
+ *
+ * Both state machines keep their programs and their IRQ or DMA mode; only their bit timing is
+ * reloaded. Queued commands are sent at the old rate first, and characters received before the
+ * switch are discarded. Tell the module first (PMTK251), or use `NMEAParser_detectBaud`.
+ *
+ * @param parser Pointer to the NMEAParser structure.
+ * @param baud The new baud rate.
+ *
+ * @return Returns `NMEA_PARSER_SUCCESS` (0), or `NMEA_PARSER_ERROR_UART_INACTIVE` (3) if the
+ *         receiver or the transmitter is not running.
+ */
+int NMEAParser_setBaud(NMEAParser *parser, unsigned long baud)
+{
+  parser->pico->baud = baud;
+  int result = 0;
+  if (parser->uart_tx != NULL)
+  {
+    result |= UartTx_reconfigure(parser->uart_tx);
+  }
+  if (parser->uart_rx != NULL)
+  {
+    result |= UartRx_reconfigure(parser->uart_rx);
+    UartRx_clear(parser->uart_rx);
+  }
+  return result == 0 ? NMEA_PARSER_SUCCESS : NMEA_PARSER_ERROR_UART_INACTIVE;
+}
+
+/**
+ * @brief Listens at one baud rate until a sentence with a valid checksum arrives.
+ *
+ * Lines framed at the wrong rate are noise: they rarely start with a '$', and practically never
+ * with a '$' and a matching checksum. The lines are only checked, not parsed.
+ */
+static bool listenAt(NMEAParser *parser, unsigned long baud)
+{
+  NMEAParser_setBaud(parser, baud);
+  uint32_t start = _millis();
+  while (_millis() - start < NMEA_PARSER_DETECT_MS)
+  {
+    UartRxLine line;
+    if (UartRx_readSentence(parser->uart_rx, &line) && checkSentence(line.data, line.length, line.checksum))
+    {
+      return true;
+    }
+    tight_loop_contents();
+  }
+  return false;
+}
+
+/**
+ * @brief Detects the baud rate the module is sending at and re-times the receiver to it.
+ *
+ * The current rate is tried first, then every rate of `NMEA_PARSER_BAUDS`, listening up to
+ * `NMEA_PARSER_DETECT_MS` at each. This blocks for a few seconds in the worst case, so call it
+ * once at startup, before registering callbacks or relying on the statistics.
+ *
+ * @param parser Pointer to the NMEAParser structure (initialized, with a receiver).
+ *
+ * @return Returns the detected baud rate, or 0 if no rate carried a valid sentence (the
+ *         original rate is then restored).
+ */
+unsigned long NMEAParser_detectBaud(NMEAParser *parser)
+{
+  static const unsigned long bauds[] = NMEA_PARSER_BAUDS;
+  unsigned long current = parser->pico->baud;
+  if (parser->uart_rx == NULL)
+  {
+    return 0;
+  }
+  if (listenAt(parser, current))
+  {
+    return current;
+  }
+  for (size_t i = 0; i < sizeof(bauds) / sizeof(bauds[0]); i++)
+  {
+    if (bauds[i] != current && listenAt(parser, bauds[i]))
+    {
+      return bauds[i];
+    }
   }
-  return result;
+  NMEAParser_setBaud(parser, current);
+  return 0;
 }
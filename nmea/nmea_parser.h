@@ -4,9 +4,38 @@
 #include "../uart/uart_pico.h"
 #include "../uart/uart_rx.h"
 #include "../uart/uart_tx.h"
+#include "nmea_fix.h"
 
 #define NMEA_PARSER_SUCCESS 0
 #define NMEA_PARSER_ERROR_MEMORY_ALLOCATION 1
+#define NMEA_PARSER_ERROR_LISTENERS_FULL 2
+#define NMEA_PARSER_ERROR_UART_INACTIVE 3
+
+// Size of the asynchronous command queue towards the module (power of two)
+#define NMEA_PARSER_TX_QUEUE_SIZE 256
+
+// Parsers whose `UartPico` comes from the static pool (RP_PICO_STATIC_ALLOC only)
+#ifndef NMEA_PARSER_MAX_INSTANCES
+#define NMEA_PARSER_MAX_INSTANCES 2
+#endif
+
+#define NMEA_GSA_PRNS 12        // PRN slots of a GSA sentence
+#define NMEA_GSV_SATELLITES 4   // Satellites described by one GSV message
+#define NMEA_MAX_SATELLITES 48  // Satellites in view kept by the table (32 GPS plus SBAS/GLONASS)
+#define NMEA_PARSER_LISTENERS 4 // Callbacks that can be registered with NMEAParser_on
+
+// Baud rates of the module's NMEA port tried by NMEAParser_detectBaud, most likely first
+#define NMEA_PARSER_BAUDS {9600, 115200, 57600, 38400, 19200, 4800}
+
+// Time spent listening at each baud rate by NMEAParser_detectBaud (the module sends at least one epoch per second)
+#ifndef NMEA_PARSER_DETECT_MS
+#define NMEA_PARSER_DETECT_MS 1200
+#endif
+
+// Silence after the last sentence of an open epoch before it is committed anyway (milliseconds)
+#ifndef NMEA_EPOCH_TIMEOUT_MS
+#define NMEA_EPOCH_TIMEOUT_MS 200
+#endif
 
 #ifdef __cplusplus
 extern "C"
@@ -17,9 +46,9 @@ extern "C"
   typedef struct
   {
     char utc_time[11];     // UTC of position fix (hhmmss.sss)
-    double latitude;       // Latitude
+    int32_t latitude;      // Latitude in degrees * NMEA_DEGREES_SCALE, negative south
     char latitude_dir[2];  // Direction of latitude: (N: North, S: South)
-    double longitude;      // Longitude
+    int32_t longitude;     // Longitude in degrees * NMEA_DEGREES_SCALE, negative west
     char longitude_dir[2]; // Direction of longitude: (E: East, W: West)
     uint8_t fix_status;    // GPS Quality indicator:
     /**
@@ -30,21 +59,21 @@ extern "C"
       5: RTK Float, OmniSTAR XP/HP, Location RTK, RTX
       6: INS Dead reckoning
     */
-    uint8_t num_satellites;  // Number of SVs in use, range from 00 through to 24+
-    float hdop;              // Horizontal Dilution of Precision
-    float altitude;          // Orthometric height (MSL reference)
-    char altitude_unit[2];   // M: unit of measure for orthometric height is meters
-    double geoid_separation; // Geoid separation
-    char geoid_unit[2];      // M: geoid separation measured in meters
-    uint32_t last_time;      // Store the current time (e.g., from a timer)
+    uint8_t num_satellites;   // Number of SVs in use, range from 00 through to 24+
+    int32_t hdop;             // Horizontal Dilution of Precision * NMEA_DOP_SCALE
+    int32_t altitude;         // Orthometric height (MSL reference) * NMEA_ALTITUDE_SCALE
+    char altitude_unit[2];    // M: unit of measure for orthometric height is meters
+    int32_t geoid_separation; // Geoid separation * NMEA_ALTITUDE_SCALE
+    char geoid_unit[2];       // M: geoid separation measured in meters
+    uint32_t last_time;       // Store the current time (e.g., from a timer)
   } GPGGA_Data;
 
   // https://receiverhelp.trimble.com/alloy-gnss/en-us/NMEA-0183messages_GLL.html
   typedef struct
   {
-    double latitude;       // Latitude in dd mm,mmmm format (0-7 decimal places)
+    int32_t latitude;      // Latitude in degrees * NMEA_DEGREES_SCALE, negative south
     char latitude_dir[2];  // Direction of latitude N: North S: South
-    double longitude;      // Longitude in ddd mm,mmmm format (0-7 decimal places)
+    int32_t longitude;     // Longitude in degrees * NMEA_DEGREES_SCALE, negative west
     char longitude_dir[2]; // Direction of longitude E: East W: West
     char utc_time[11];     // UTC of position in hhmmss.ss format
     char status[2];        // Status indicator: (A: Data valid, V: Data not valid)
@@ -56,93 +85,234 @@ extern "C"
   {
     char utc_time[11];     // UTC of position fix
     char status[2];        // Status (A=active or V=void)
-    double latitude;       // Latitude in dd mm,mmmm format (0-7 decimal places)
+    int32_t latitude;      // Latitude in degrees * NMEA_DEGREES_SCALE, negative south
     char latitude_dir[2];  // Direction of latitude N: North S: South
-    double longitude;      // Longitude in ddd mm,mmmm format (0-7 decimal places)
+    int32_t longitude;     // Longitude in degrees * NMEA_DEGREES_SCALE, negative west
     char longitude_dir[2]; // Direction of longitude E: East W: West
-    float speed;           // Speed over the ground in knots
-    float track;           // Track angle in degrees (True)
+    int32_t speed;         // Speed over the ground in knots * NMEA_SPEED_SCALE
+    int32_t track;         // Track angle in degrees (True) * NMEA_ANGLE_SCALE
     char date[7];          // Date
-    float variation;       // Magnetic variation, in degrees
+    int32_t variation;     // Magnetic variation, in degrees * NMEA_ANGLE_SCALE
     uint32_t last_time;    // Store the current time (e.g., from a timer)
   } GPRMC_Data;
 
   // https://receiverhelp.trimble.com/alloy-gnss/en-us/NMEA-0183messages_GSA.html
   typedef struct
   {
-    char mode1[2];      // Mode 1: (M = Manual, A = Automatic)
-    uint8_t mode2;      // Mode 2: Fix type: (1 = not available, 2 = 2D, 3 = 3D)
-    uint8_t prn;        // PRN number: (01 to 32 for GPS, 33 to 64 for SBAS, 64+ for GLONASS)
-    uint8_t pdop;       // PDOP: 0.5 to 99.9
-    uint8_t hdop;       // HDOP: 0.5 to 99.9
-    uint8_t vdop;       // VDOP: 0.5 to 99.9
-    uint32_t last_time; // Store the current time (e.g., from a timer)
+    char mode1[2];              // Mode 1: (M = Manual, A = Automatic)
+    uint8_t mode2;              // Mode 2: Fix type: (1 = not available, 2 = 2D, 3 = 3D)
+    uint8_t prn[NMEA_GSA_PRNS]; // PRN numbers of the SVs used in the fix (0: unused slot)
+    int32_t pdop;               // PDOP: 0.5 to 99.9, * NMEA_DOP_SCALE
+    int32_t hdop;               // HDOP: 0.5 to 99.9, * NMEA_DOP_SCALE
+    int32_t vdop;               // VDOP: 0.5 to 99.9, * NMEA_DOP_SCALE
+    uint32_t last_time;         // Store the current time (e.g., from a timer)
   } GPGSA_Data;
 
   // https://receiverhelp.trimble.com/alloy-gnss/en-us/NMEA-0183messages_VTG.html
   typedef struct
   {
-    float track1;       // Track made good (degrees true)
+    int32_t track1;     // Track made good (degrees true) * NMEA_ANGLE_SCALE
     char track1_id[2];  // T: track made good is relative to true north
-    float track2;       // Track made good (degrees magnetic)
+    int32_t track2;     // Track made good (degrees magnetic) * NMEA_ANGLE_SCALE
     char track2_id[2];  // M: track made good is relative to magnetic north
-    float speed1;       // Speed, in knots
+    int32_t speed1;     // Speed, in knots * NMEA_SPEED_SCALE
     char speed1_id[2];  // N: speed is measured in knots
-    float speed2;       // Speed over ground in kilometers/hour (kph)
+    int32_t speed2;     // Speed over ground in kilometers/hour (kph) * NMEA_SPEED_SCALE
     char speed2_id[2];  // K: speed over ground is measured in kph
     uint32_t last_time; // Store the current time (e.g., from a timer)
   } GPVTG_Data;
 
+  // One satellite in view, as reported by GSV
+  typedef struct
+  {
+    uint8_t prn;       // SV PRN number (01 to 32 for GPS, 33 to 64 for SBAS, 65 to 96 for GLONASS)
+    uint8_t elevation; // Elevation, in degrees, 90° maximum
+    uint16_t azimuth;  // Azimuth, degrees from True North, 000° through 359°
+    uint8_t snr;       // SNR, 00 through 99 dB (0 when not tracking)
+    bool used;         // Listed by the last GSA sentence as used in the fix (table entries only)
+    uint8_t talker;    // NMEATalker of the GSV sequence (table entries only)
+  } NMEASatellite;
+
   // https://receiverhelp.trimble.com/alloy-gnss/en-us/NMEA-0183messages_GSV.html
   typedef struct
   {
-    uint8_t total;      // Total number of messages of this type in this cycle
-    uint8_t count;      // Message number
-    uint8_t total_sv;   // Total number of SVs visible
-    uint8_t prn_sv;     // SV PRN number
-    uint8_t elevation;  // Elevation, in degrees, 90° maximum
-    uint8_t azimuth;    // Azimuth, degrees from True North, 000° through 359°
-    uint8_t snr;        // SNR, 00 through 99 dB (null when not tracking)
-    uint32_t last_time; // Store the current time (e.g., from a timer)
+    uint8_t total;                                 // Total number of messages of this type in this cycle
+    uint8_t count;                                 // Message number
+    uint8_t total_sv;                              // Total number of SVs visible
+    uint8_t satellite_count;                       // Number of entries in `satellites` (1 to 4)
+    NMEASatellite satellites[NMEA_GSV_SATELLITES]; // SVs described by this message
+    uint32_t last_time;                            // Store the current time (e.g., from a timer)
   } GPGSV_Data;
 
+  // PMTK001 - Acknowledgement of a PMTK command (Quectel L80 protocol specification, 2.1)
+  typedef struct
+  {
+    uint16_t command;   // Packet type of the acknowledged command (e.g. 314)
+    uint8_t flag;       // 0: invalid packet, 1: unsupported, 2: valid but failed, 3: succeeded
+    uint32_t last_time; // Store the current time (e.g., from a timer)
+  } PMTK001_Data;
+
+  /**
+   * @brief Satellites in view, assembled from a whole GSV sequence.
+   *
+   * Each GSV message appends its satellites; the table is marked complete when the last message
+   * of a sequence arrives in order. Every talker (GP, GL, ...) sends its own sequence, which only
+   * replaces that talker's satellites. A missing or out-of-order message drops the rest of the
+   * sequence until the talker's next first message. Lives inside the parser, so no heap is involved.
+   */
+  typedef struct
+  {
+    NMEASatellite satellites[NMEA_MAX_SATELLITES]; // Satellites of the sequence, in message order
+    uint8_t count;                                 // Number of entries in `satellites`
+    uint8_t in_view;                               // Total number of SVs visible, over all talkers
+    uint8_t announced[NMEA_TALKER_COUNT];          // SVs visible announced by each talker's last sequence
+    uint8_t next[NMEA_TALKER_COUNT];               // Next expected message per talker (0: no sequence open)
+    bool complete;                                 // A sequence just completed and no other is open
+    uint32_t last_time;                            // Time the last sequence was completed
+  } NMEASatelliteTable;
+
   // https://receiverhelp.trimble.com/alloy-gnss/en-us/NMEA-0183messages_MessageOverview.html
+  // The top-level fields follow whichever sentence arrived last; use NMEAParser_fix for one epoch.
   typedef struct
   {
     char *utc_time;      // UTC of position in hhmmss.ss format
-    double latitude;     // Latitude in dd mm,mmmm format (0-7 decimal places)
+    int32_t latitude;    // Latitude in degrees * NMEA_DEGREES_SCALE, negative south
     char *latitude_dir;  // Direction of latitude N: North S: South
-    double longitude;    // Longitude in ddd mm,mmmm format (0-7 decimal places)
+    int32_t longitude;   // Longitude in degrees * NMEA_DEGREES_SCALE, negative west
     char *longitude_dir; // Direction of longitude E: East W: West
-    float speed;         // Speed over the ground in knots
-
-    GPGGA_Data gpgga; // GPGGA - Time, position, and fix related data
-    GPGLL_Data gpgll; // GPGLL - Position data: position fix, time of position fix, and status
-    GPRMC_Data gprmc; // GPRMC - Position, velocity, and time
-    GPGSA_Data gpgsa; // GPGSA - GPS DOP and active satellites
-    GPVTG_Data gpvtg; // GPVTG - Track made good and speed over ground
-    GPGSV_Data gpgsv; // GPGSV - Satellite information
+    int32_t speed;       // Speed over the ground in knots * NMEA_SPEED_SCALE
+
+    GPGGA_Data gpgga;     // GPGGA - Time, position, and fix related data
+    GPGLL_Data gpgll;     // GPGLL - Position data: position fix, time of position fix, and status
+    GPRMC_Data gprmc;     // GPRMC - Position, velocity, and time
+    GPGSA_Data gpgsa;     // GPGSA - GPS DOP and active satellites
+    GPVTG_Data gpvtg;     // GPVTG - Track made good and speed over ground
+    GPGSV_Data gpgsv;     // GPGSV - Satellite information
+    PMTK001_Data pmtk001; // PMTK001 - Acknowledgement of the last PMTK command
   } GPSData;
 
+  // Sentence types, whatever the talker; dispatched by the parser and counted in `NMEAParserStats`
+  typedef enum
+  {
+    NMEA_SENTENCE_GGA,
+    NMEA_SENTENCE_GLL,
+    NMEA_SENTENCE_RMC,
+    NMEA_SENTENCE_GSA,
+    NMEA_SENTENCE_VTG,
+    NMEA_SENTENCE_GSV,
+    NMEA_SENTENCE_ACK,   // $PMTK001 reply to a command (not part of any epoch)
+    NMEA_SENTENCE_OTHER, // Unknown or unreadable address
+    NMEA_SENTENCE_COUNT
+  } NMEASentenceType;
+
+#define NMEA_SENTENCE_BIT(type) (1u << (type))                          // Bit of a type in `NMEAParser.enabled`
+#define NMEA_SENTENCES_ALL (NMEA_SENTENCE_BIT(NMEA_SENTENCE_OTHER) - 1) // Every type the parser knows
+
+// Types whose parsing code is compiled in (NMEA_SENTENCE_BIT mask); the others are counted, then ignored
+#ifndef NMEA_PARSER_SENTENCES
+#define NMEA_PARSER_SENTENCES NMEA_SENTENCES_ALL
+#endif
+
+  // Line quality and parser load, to tune the baud rate and the sentence mix from data
   typedef struct
+  {
+    uint32_t accepted[NMEA_SENTENCE_COUNT]; // Sentences with a valid checksum, by type
+    uint32_t rejected[NMEA_SENTENCE_COUNT]; // Sentences dropped for a bad or missing checksum, by type
+    uint32_t ring_overflows;                // Characters dropped because the receive ring was full
+    uint32_t dma_overflows;                 // Samples lost because the DMA ring wrapped (DMA receive mode)
+    uint32_t line_truncations;              // Lines longer than UART_MAX_BUFFER_LENGTH
+    uint32_t framing_errors;                // Characters dropped for a low stop bit (UART_PIO_CLKDIV only)
+    uint32_t parse_cycles;                  // Cycles spent parsing the last accepted sentence
+    uint32_t parse_cycles_max;              // Longest parse in cycles
+    uint64_t parse_cycles_total;            // Cycles spent parsing all accepted sentences
+  } NMEAParserStats;
+
+// Event fired once every sentence of one UTC time has been parsed (see NMEAParser_on)
+#define NMEA_EVENT_EPOCH (1u << 31)
+
+// Event fired by gps/geofence.c when a fence is entered or left (see NMEAParser_notify, Geofence_event)
+#define NMEA_EVENT_GEOFENCE (1u << 30)
+
+  typedef enum
+  {
+    NMEA_EPOCH_NONE,      // No sentence with a UTC time seen yet
+    NMEA_EPOCH_OPEN,      // Collecting the sentences of `time`
+    NMEA_EPOCH_COMMITTED, // `time` was published; later sentences of it are left out (see openEpoch)
+    NMEA_EPOCH_NEXT       // Sentences without a UTC time are held for the next `time` (see joinEpoch)
+  } NMEAEpochState;
+
+  /**
+   * @brief Groups the sentences of one UTC time into a single fix.
+   *
+   * Every parsed sentence is merged into `fix`; the fix is published as a whole when a sentence
+   * with a new UTC time arrives, when the receiver has been silent for `NMEA_EPOCH_TIMEOUT_MS`,
+   * or as soon as the last sentence of the module's learned output order has been parsed. A new
+   * UTC time clears `fix` (the date excepted), so every field comes from the epoch's own sentences;
+   * sentences without a UTC time that arrive after a commit are held for the next epoch.
+   */
+  typedef struct
+  {
+    NMEAFix fix;       // Fix being assembled
+    uint8_t state;     // NMEAEpochState
+    uint32_t time;     // UTC time of the epoch (see `NMEAFix.utc_time`)
+    uint32_t updated;  // Milliseconds since boot of the last sentence merged into `fix`
+    uint8_t sentences; // Sentences merged since the epoch opened (held ones not counted)
+    uint16_t last;     // Type and talker of the last sentence merged (`type | talker << 8`)
+    uint8_t length;    // Learned: sentences per epoch (0 while unknown)
+    uint16_t end;      // Learned: type and talker of the last sentence of an epoch
+    uint8_t misses;    // Epochs in a row that ended without the learned last sentence
+  } NMEAEpoch;
+
+  typedef struct NMEAParser NMEAParser;
+
+  /**
+   * @brief Called by the parser when something an application registered for has changed.
+   *
+   * @param parser The parser that fired the event.
+   * @param event `NMEA_SENTENCE_BIT` of the sentence type just parsed, `NMEA_EVENT_EPOCH` or `NMEA_EVENT_GEOFENCE`.
+   * @param ctx The pointer given to `NMEAParser_on`.
+   */
+  typedef void (*NMEAParserCallback)(NMEAParser *parser, uint32_t event, void *ctx);
+
+  typedef struct
+  {
+    uint32_t events;             // Events the callback is interested in
+    NMEAParserCallback callback; // Function to call
+    void *ctx;                   // Passed back to the callback
+  } NMEAParserListener;
+
+  struct NMEAParser
   {
     UartPico *pico;
     UartRx *uart_rx;
     UartTx *uart_tx;
     GPSData data;
+    NMEAFixLatch fix;              // Compact fix, republished once per epoch
+    NMEAParserStats stats;         // Sentence counters and parse timing, read with NMEAParser_stats
+    NMEASatelliteTable satellites; // Satellites in view, from the last GSV sequence
+
+    uint32_t enabled; // NMEA_SENTENCE_BIT of every sentence type to parse (NMEA_SENTENCES_ALL after init)
 
-    bool GPGGA_ENABLED; // Flag to enable/disable GPGGA parsing
-    bool GPGLL_ENABLED; // Flag to enable/disable GPGLL parsing
-    bool GPRMC_ENABLED; // Flag to enable/disable GPRMC parsing
-    bool GPGSA_ENABLED; // Flag to enable/disable GPGSA parsing
-    bool GPVTG_ENABLED; // Flag to enable/disable GPVTG parsing
-    bool GPGSV_ENABLED; // Flag to enable/disable GPGSV parsing
-  } NMEAParser;
+    NMEAParserListener listeners[NMEA_PARSER_LISTENERS]; // Registered callbacks
+    uint8_t listener_count;                              // Number of entries in `listeners`
+    NMEAEpoch epoch;                                     // Sentences of the current UTC time
+  };
 
   int NMEAParser_init(NMEAParser *parser, int rx, int tx);
   int NMEAParser_available(NMEAParser *parser);
   void NMEAParser_sentence(NMEAParser *parser, char *sentence);
+  void NMEAParser_parse(NMEAParser *parser, const char *sentence, size_t length);
+  bool NMEAParser_parseLine(NMEAParser *parser, const UartRxLine *line);
+  bool NMEAParser_readSentence(NMEAParser *parser, UartRxLine *line);
   char *NMEAParser_read(NMEAParser *parser);
+  void NMEAParser_fix(NMEAParser *parser, NMEAFix *fix);
+  void NMEAParser_stats(NMEAParser *parser, NMEAParserStats *stats);
+  const NMEASatelliteTable *NMEAParser_satellites(NMEAParser *parser);
+  int NMEAParser_on(NMEAParser *parser, uint32_t events, NMEAParserCallback callback, void *ctx);
+  void NMEAParser_off(NMEAParser *parser, NMEAParserCallback callback, void *ctx);
+  void NMEAParser_notify(NMEAParser *parser, uint32_t event);
+  int NMEAParser_setBaud(NMEAParser *parser, unsigned long baud);
+  unsigned long NMEAParser_detectBaud(NMEAParser *parser);
   void NMEAParser_free(NMEAParser *parser);
 
 #ifdef __cplusplus
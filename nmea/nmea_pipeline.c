@@ -0,0 +1,238 @@
+#include "nmea_pipeline.h"
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include <hardware/irq.h>
+#include <hardware/sync.h>
+
+/**
+ * @brief Points a string field of a copied `GPSData` at the copy instead of the original.
+ *
+ * @param field The pointer field inside the copy.
+ * @param from The structure the copy was taken from.
+ * @param to The copy.
+ */
+static void rebase(char **field, const GPSData *from, GPSData *to)
+{
+  if (*field != NULL)
+  {
+    *field = (char *)to + (*field - (const char *)from);
+  }
+}
+
+/**
+ * @brief Publishes the parser's data to core0 under the sequence lock.
+ *
+ * @param pipeline Pointer to the NMEAPipeline structure.
+ * @param received_time Time at which the sentence's terminating LF was drained.
+ */
+static void NMEAPipeline_publish(NMEAPipeline *pipeline, uint32_t received_time)
+{
+  const GPSData *data = &pipeline->parser->data;
+  pipeline->sequence++; // Odd: readers retry
+  __dmb();
+  pipeline->snapshot = *data;
+  rebase(&pipeline->snapshot.utc_time, data, &pipeline->snapshot);
+  rebase(&pipeline->snapshot.latitude_dir, data, &pipeline->snapshot);
+  rebase(&pipeline->snapshot.longitude_dir, data, &pipeline->snapshot);
+  pipeline->received_time = received_time;
+  pipeline->sentences++;
+  __dmb();
+  pipeline->sequence++; // Even: snapshot consistent
+}
+
+/**
+ * @brief Forwards queued commands from core0 to the module.
+ *
+ * @param pipeline Pointer to the NMEAPipeline structure.
+ */
+static void NMEAPipeline_forward(NMEAPipeline *pipeline)
+{
+  const uint8_t *span;
+  size_t count;
+  UartTx *uart_tx = pipeline->parser->uart_tx;
+  while (uart_tx && (count = RingBuffer_peek(&pipeline->commands, &span)) > 0)
+  {
+    size_t sent = UartTx_send(uart_tx, span, count);
+    RingBuffer_consume(&pipeline->commands, sent);
+    if (sent < count)
+    {
+      break; // TX queue full; retry on the next pass
+    }
+  }
+}
+
+/**
+ * @brief Core1 handler for the inter-core FIFO doorbell rung by `NMEAPipeline_send`.
+ *
+ * Its only job is to wake core1; the queued commands are forwarded from the main loop.
+ */
+static void NMEAPipeline_doorbell(void)
+{
+  while (multicore_fifo_rvalid())
+  {
+    (void)multicore_fifo_pop_blocking();
+  }
+  multicore_fifo_clear_irq();
+}
+
+/**
+ * @brief Core1 entry point: owns the UART, frames and parses sentences, publishes snapshots.
+ */
+static void NMEAPipeline_core1(void)
+{
+  NMEAPipeline *pipeline = (NMEAPipeline *)(uintptr_t)multicore_fifo_pop_blocking();
+  NMEAParser *parser = pipeline->parser;
+  NMEAParser_init(parser, pipeline->rx, pipeline->tx); // Registers the RX interrupt on core1
+  parser->enabled = pipeline->enabled;                  // Before the first sentence is parsed
+
+  multicore_fifo_clear_irq();
+  irq_set_exclusive_handler(SIO_IRQ_PROC1, NMEAPipeline_doorbell);
+  irq_set_enabled(SIO_IRQ_PROC1, true);
+  pipeline->ready = true;
+
+  while (true)
+  {
+    UartRxLine line;
+    while (NMEAParser_readSentence(parser, &line))
+    {
+      // Stamped when the LF left the PIO FIFO, so the latency covers framing and parsing too; with
+      // several lines waiting, this is the LF of the newest one
+      NMEAPipeline_publish(pipeline, parser->uart_rx->line_time);
+    }
+    NMEAPipeline_forward(pipeline);
+
+    // In IRQ mode, sleep until the next character or doorbell; interrupts are masked so one
+    // arriving between the check and the WFI still wakes the core instead of being slept through
+    if (parser->uart_rx->dma_chan < 0)
+    {
+      uint32_t status = save_and_disable_interrupts();
+      if (NMEAParser_available(parser) == 0 && RingBuffer_available(&pipeline->commands) == 0)
+      {
+        __wfi();
+      }
+      restore_interrupts(status);
+    }
+  }
+}
+
+/**
+ * @brief Launches the pipeline on core1 and waits until the parser is running.
+ *
+ * The parser must be zero-initialized (or have its `pico` configured) and must not be used
+ * from core0 afterwards.
+ *
+ * @param pipeline Pointer to the NMEAPipeline structure.
+ * @param parser Pointer to the parser that core1 will own.
+ * @param rx The RX pin number for UART communication.
+ * @param tx The TX pin number for UART communication.
+ * @param enabled Sentences to parse (`NMEA_SENTENCES_ALL` or a mask of `NMEA_SENTENCE_BIT`s); set by
+ *        core1 before any sentence is parsed, since `parser->enabled` cannot be changed from core0.
+ *
+ * @return Returns `NMEA_PARSER_SUCCESS` (0).
+ */
+int NMEAPipeline_start(NMEAPipeline *pipeline, NMEAParser *parser, int rx, int tx, uint32_t enabled)
+{
+  pipeline->parser = parser;
+  pipeline->rx = rx;
+  pipeline->tx = tx;
+  pipeline->enabled = enabled;
+  pipeline->ready = false;
+  pipeline->sequence = 0;
+  pipeline->sentences = 0;
+  pipeline->received_time = 0;
+  RingBuffer_init(&pipeline->commands, pipeline->command_queue, NMEA_PIPELINE_COMMAND_QUEUE_SIZE);
+
+  multicore_launch_core1(NMEAPipeline_core1);
+  multicore_fifo_push_blocking((uint32_t)(uintptr_t)pipeline);
+  while (!pipeline->ready)
+  {
+    tight_loop_contents();
+  }
+  return NMEA_PARSER_SUCCESS;
+}
+
+/**
+ * @brief Copies the latest snapshot published by core1 (core0 side).
+ *
+ * Never blocks core1: if a snapshot is being written, the copy is simply retried.
+ *
+ * @param pipeline Pointer to the NMEAPipeline structure.
+ * @param data Receives the latest parsed data.
+ * @param received_time If not NULL, receives the time the LF of the sentence behind the snapshot was drained
+ *        (see `UartRx.line_time`).
+ *
+ * @return Returns `true` if at least one sentence has been published.
+ */
+bool NMEAPipeline_latest(NMEAPipeline *pipeline, GPSData *data, uint32_t *received_time)
+{
+  uint32_t sequence;
+  uint32_t sentences;
+  do
+  {
+    while ((sequence = pipeline->sequence) & 1)
+    {
+      tight_loop_contents(); // Core1 is writing
+    }
+    __dmb();
+    *data = pipeline->snapshot;
+    sentences = pipeline->sentences;
+    if (received_time)
+    {
+      *received_time = pipeline->received_time;
+    }
+    __dmb();
+  } while (pipeline->sequence != sequence);
+
+  rebase(&data->utc_time, &pipeline->snapshot, data);
+  rebase(&data->latitude_dir, &pipeline->snapshot, data);
+  rebase(&data->longitude_dir, &pipeline->snapshot, data);
+  return sentences > 0;
+}
+
+/**
+ * @brief Copies the latest compact fix published by the parser on core1 (core0 side).
+ *
+ * Much cheaper than `NMEAPipeline_latest` when only position and velocity are needed.
+ *
+ * @param pipeline Pointer to the NMEAPipeline structure.
+ * @param fix Receives the snapshot.
+ */
+void NMEAPipeline_fix(NMEAPipeline *pipeline, NMEAFix *fix)
+{
+  NMEAParser_fix(pipeline->parser, fix);
+}
+
+/**
+ * @brief Returns the number of sentences published so far; cheap change detection for core0.
+ *
+ * @param pipeline Pointer to the NMEAPipeline structure.
+ */
+uint32_t NMEAPipeline_sentences(NMEAPipeline *pipeline)
+{
+  uint32_t sentences = pipeline->sentences;
+  __dmb(); // A snapshot read after a new count is at least as new
+  return sentences;
+}
+
+/**
+ * @brief Queues a command line for core1 to send to the module (core0 side).
+ *
+ * The command is followed by "\r\n". Only core0 may call this function.
+ *
+ * @param pipeline Pointer to the NMEAPipeline structure.
+ * @param command The null-terminated command, e.g. "$PMTK220,1000*1F".
+ *
+ * @return Number of bytes queued; less than the full line if the command queue is full.
+ */
+size_t NMEAPipeline_send(NMEAPipeline *pipeline, const char *command)
+{
+  size_t length = strlen(command);
+  if (RingBuffer_space(&pipeline->commands) < length + 2)
+  {
+    return 0; // Never queue half a command
+  }
+  size_t count = RingBuffer_write(&pipeline->commands, (const uint8_t *)command, length);
+  count += RingBuffer_write(&pipeline->commands, (const uint8_t *)"\r\n", 2);
+  multicore_fifo_push_timeout_us(0, 0); // Ring the doorbell; a full FIFO means core1 is already awake
+  return count;
+}
@@ -0,0 +1,49 @@
+#ifndef NMEA_PIPELINE_H
+#define NMEA_PIPELINE_H
+
+#include "nmea_parser.h"
+
+// Size of the core0 -> core1 command queue (power of two)
+#define NMEA_PIPELINE_COMMAND_QUEUE_SIZE 256
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  /**
+   * @brief Dual-core pipeline: core1 owns the UART, framing and parsing; core0 reads snapshots.
+   *
+   * Core1 initializes the parser (so the RX interrupt is taken on core1), parses every sentence
+   * and publishes a copy of `GPSData` under a sequence lock. Core0 never touches the parser;
+   * it copies the latest snapshot with `NMEAPipeline_latest` and sends commands through
+   * `NMEAPipeline_send`, which core1 forwards to the module.
+   */
+  typedef struct
+  {
+    NMEAParser *parser; // Parser owned by core1
+    int rx;             // RX pin passed to NMEAParser_init on core1
+    int tx;             // TX pin passed to NMEAParser_init on core1
+    uint32_t enabled;   // Sentence mask core1 applies to `parser->enabled` before parsing
+    volatile bool ready; // Set by core1 once the parser is running
+
+    volatile uint32_t sequence;  // Sequence lock: odd while core1 is writing the snapshot
+    GPSData snapshot;            // Latest parsed data, pointers rebased into the snapshot
+    uint32_t received_time;      // time_us_32() when the LF of the sentence behind the snapshot was drained
+    volatile uint32_t sentences; // Number of sentences published so far (updated under the sequence lock)
+
+    uint8_t command_queue[NMEA_PIPELINE_COMMAND_QUEUE_SIZE]; // Storage for `commands`
+    RingBuffer commands;                                     // Command bytes from core0 to core1
+  } NMEAPipeline;
+
+  int NMEAPipeline_start(NMEAPipeline *pipeline, NMEAParser *parser, int rx, int tx, uint32_t enabled);
+  bool NMEAPipeline_latest(NMEAPipeline *pipeline, GPSData *data, uint32_t *received_time);
+  void NMEAPipeline_fix(NMEAPipeline *pipeline, NMEAFix *fix);
+  uint32_t NMEAPipeline_sentences(NMEAPipeline *pipeline);
+  size_t NMEAPipeline_send(NMEAPipeline *pipeline, const char *command);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NMEA_PIPELINE_H
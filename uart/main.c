@@ -3,6 +3,8 @@
 #include "uart_pico.h"
 #include "uart_rx.h"
 #include "uart_tx.h"
+#include "trace.h"
+#include "pmtk.h"
 
 // https://www.dragino.com/downloads/downloads/datasheet/other_vendors/L80-R/Quectel_L80-R_Hardware_Design_V1.2.pdf
 /*
@@ -37,6 +39,7 @@ void setup()
 
     uart_rx = UartRx_init(&uart_pico, TXD2RX);
     UartRx_activate(uart_rx); // connect gps sensor
+    TRACE_INIT(); // Stage timing, printed every RP_PICO_TRACE_PRINT_S seconds when built with RP_PICO_TRACE=1
     printf("GPS Module Initialized.\n");
 }
 
@@ -57,13 +60,13 @@ void loop()
         {
             // If currently paused, resume
             printf("Resume\n");
-            UartTx_println(uart_tx, "$PMTK161,0*29");
+            UartTx_println(uart_tx, PMTK_TEST); // Any character wakes the module
         }
         else
         {
             // If currently running, pause
             printf("Pause\n");
-            UartTx_println(uart_tx, "$PMTK161,0*28");
+            UartTx_println(uart_tx, PMTK_STANDBY);
         }
 
         // Toggle paused state
@@ -90,6 +93,7 @@ int main()
     while (true)
     {
         loop();
+        TRACE_POLL();
     }
     return 0;
 }
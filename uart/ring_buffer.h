@@ -0,0 +1,172 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <hardware/sync.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Lock-free single-producer/single-consumer byte ring.
+     *
+     * The producer (typically an interrupt handler) only writes `head`, the consumer (typically
+     * the main loop) only writes `tail`. Both indices run freely and are masked on access, so the
+     * capacity must be a power of two and `head - tail` is always the number of stored bytes.
+     */
+    typedef struct
+    {
+        uint8_t *buffer;             /**< Storage of `mask + 1` bytes */
+        uint32_t mask;               /**< Capacity minus one */
+        volatile uint32_t head;      /**< Free-running write index, owned by the producer */
+        volatile uint32_t tail;      /**< Free-running read index, owned by the consumer */
+        volatile uint32_t overflows; /**< Bytes dropped by the producer because the ring was full */
+    } RingBuffer;
+
+    /**
+     * @brief Initializes a ring over caller-provided storage.
+     *
+     * @param ring Pointer to the RingBuffer to initialize.
+     * @param buffer Storage for the ring.
+     * @param capacity Size of `buffer` in bytes; must be a power of two.
+     * @return 0 on success, 1 if the capacity is not a power of two.
+     */
+    static inline int RingBuffer_init(RingBuffer *ring, uint8_t *buffer, size_t capacity)
+    {
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+        {
+            return 1;
+        }
+        ring->buffer = buffer;
+        ring->mask = capacity - 1;
+        ring->head = 0;
+        ring->tail = 0;
+        ring->overflows = 0;
+        return 0;
+    }
+
+    /**
+     * @brief Returns the capacity of the ring in bytes.
+     */
+    static inline size_t RingBuffer_capacity(const RingBuffer *ring)
+    {
+        return ring->mask + 1;
+    }
+
+    /**
+     * @brief Returns the number of bytes ready to be read (safe from either side).
+     */
+    static inline size_t RingBuffer_available(const RingBuffer *ring)
+    {
+        return ring->head - ring->tail;
+    }
+
+    /**
+     * @brief Returns the number of bytes that can be written without dropping data.
+     */
+    static inline size_t RingBuffer_space(const RingBuffer *ring)
+    {
+        return RingBuffer_capacity(ring) - RingBuffer_available(ring);
+    }
+
+    /**
+     * @brief Producer: appends one byte, or counts an overflow if the ring is full.
+     *
+     * @param ring Pointer to the RingBuffer.
+     * @param c The byte to append.
+     * @return true if the byte was stored, false if it was dropped.
+     */
+    static inline bool RingBuffer_push(RingBuffer *ring, uint8_t c)
+    {
+        uint32_t head = ring->head;
+        if (head - ring->tail > ring->mask)
+        {
+            ring->overflows++;
+            return false;
+        }
+        ring->buffer[head & ring->mask] = c;
+        __dmb(); // Publish the byte before the index that makes it visible
+        ring->head = head + 1;
+        return true;
+    }
+
+    /**
+     * @brief Producer: appends as many bytes of `data` as fit; the rest is counted as overflow.
+     *
+     * @param ring Pointer to the RingBuffer.
+     * @param data Bytes to append.
+     * @param len Number of bytes in `data`.
+     * @return Number of bytes stored.
+     */
+    static inline size_t RingBuffer_write(RingBuffer *ring, const uint8_t *data, size_t len)
+    {
+        uint32_t head = ring->head;
+        size_t space = RingBuffer_capacity(ring) - (head - ring->tail);
+        size_t count = len < space ? len : space;
+        for (size_t i = 0; i < count; i++)
+        {
+            ring->buffer[(head + i) & ring->mask] = data[i];
+        }
+        ring->overflows += len - count;
+        __dmb();
+        ring->head = head + count;
+        return count;
+    }
+
+    /**
+     * @brief Consumer: returns the longest contiguous run of readable bytes without consuming it.
+     *
+     * @param ring Pointer to the RingBuffer.
+     * @param span On return, points to the first readable byte.
+     * @return Number of contiguous bytes at `*span` (0 if the ring is empty).
+     */
+    static inline size_t RingBuffer_peek(const RingBuffer *ring, const uint8_t **span)
+    {
+        uint32_t tail = ring->tail;
+        size_t count = ring->head - tail;
+        __dmb(); // Read the index before the bytes it covers
+        size_t offset = tail & ring->mask;
+        size_t contiguous = RingBuffer_capacity(ring) - offset;
+        *span = &ring->buffer[offset];
+        return count < contiguous ? count : contiguous;
+    }
+
+    /**
+     * @brief Consumer: releases `count` bytes previously returned by `RingBuffer_peek`.
+     */
+    static inline void RingBuffer_consume(RingBuffer *ring, size_t count)
+    {
+        __dmb(); // Finish reading the bytes before handing their slots back to the producer
+        ring->tail = ring->tail + count;
+    }
+
+    /**
+     * @brief Consumer: removes one byte.
+     *
+     * @param ring Pointer to the RingBuffer.
+     * @param c On success, receives the byte.
+     * @return true if a byte was read, false if the ring is empty.
+     */
+    static inline bool RingBuffer_pop(RingBuffer *ring, uint8_t *c)
+    {
+        uint32_t tail = ring->tail;
+        if (ring->head == tail)
+        {
+            return false;
+        }
+        __dmb();
+        *c = ring->buffer[tail & ring->mask];
+        __dmb();
+        ring->tail = tail + 1;
+        return true;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,242 @@
+#include "trace.h"
+
+#if RP_PICO_TRACE
+#include <stdio.h>
+#include <string.h>
+#include <hardware/clocks.h>
+#include <hardware/sync.h>
+#include <pico/time.h>
+
+static TraceEvent trace_events[TRACE_EVENTS];        // Last TRACE_EVENTS stages, any kind
+static uint32_t trace_next;                          // Events recorded since boot
+static TraceStats trace_stats[TRACE_STAGE_COUNT];    // Since the last reset
+static uint32_t trace_reported;                      // Time of the last report of Trace_poll (milliseconds)
+static TraceSpanStats trace_spans[TRACE_SPAN_COUNT]; // Since boot
+
+static const char *const trace_names[TRACE_STAGE_COUNT] = {"irq", "dma", "line", "parse", "dispatch"};
+static const char *const trace_span_names[TRACE_SPAN_COUNT] = {"ttff-cold", "ttff-aided", "ttff-wakeup"};
+
+/**
+ * @brief Returns the histogram bucket of a duration.
+ */
+static uint8_t Trace_bucket(uint32_t cycles)
+{
+    if (cycles < 4)
+    {
+        return cycles;
+    }
+    uint32_t msb = 31 - __builtin_clz(cycles);
+    return (msb - 1) * 4 + ((cycles >> (msb - 2)) & 3); // Top bit selects the octave, the next two its quarter
+}
+
+/**
+ * @brief Returns the longest duration that falls in a bucket.
+ */
+static uint32_t Trace_bucketEdge(uint8_t bucket)
+{
+    if (bucket < 4)
+    {
+        return bucket;
+    }
+    uint32_t shift = bucket / 4 - 1;
+    return ((4u + bucket % 4 + 1) << shift) - 1;
+}
+
+/**
+ * @brief Starts SysTick as a free-running cycle counter unless it already runs, and clears the statistics.
+ *
+ * The NMEA parser starts SysTick the same way, so the order of the two does not matter.
+ */
+void Trace_init()
+{
+    if (!(systick_hw->csr & 1))
+    {
+        systick_hw->rvr = 0x00FFFFFF;
+        systick_hw->cvr = 0;
+        systick_hw->csr = 0x5; // Enable, processor clock, no interrupt
+    }
+    Trace_reset();
+    trace_reported = time_us_32() / 1000;
+}
+
+/**
+ * @brief Records the end of a stage.
+ *
+ * Safe to call from the RX interrupt: the update runs with interrupts disabled (a few dozen
+ * cycles). A stage interrupted by another one includes the time spent in it.
+ *
+ * @param stage The stage that ended.
+ * @param start `Trace_cycles()` when it started (see TRACE_BEGIN).
+ */
+void Trace_record(TraceStage stage, uint32_t start)
+{
+    uint32_t cycles = (start - systick_hw->cvr) & 0x00FFFFFF; // SysTick counts down
+    uint32_t now = time_us_32();
+
+    uint32_t status = save_and_disable_interrupts();
+    TraceEvent *event = &trace_events[trace_next++ & (TRACE_EVENTS - 1)];
+    event->time = now;
+    event->cycles = cycles | (uint32_t)stage << 24;
+
+    TraceStats *stats = &trace_stats[stage];
+    if (stats->count == 0 || cycles < stats->min)
+    {
+        stats->min = cycles;
+    }
+    if (cycles > stats->max)
+    {
+        stats->max = cycles;
+    }
+    stats->count++;
+    stats->total += cycles;
+    stats->buckets[Trace_bucket(cycles)]++;
+    restore_interrupts(status);
+}
+
+/**
+ * @brief Copies the statistics of a stage and computes its 99th percentile.
+ *
+ * @param stage The stage.
+ * @param stats Receives the statistics.
+ */
+void Trace_stats(TraceStage stage, TraceStats *stats)
+{
+    uint32_t status = save_and_disable_interrupts();
+    *stats = trace_stats[stage];
+    restore_interrupts(status);
+
+    stats->p99 = 0;
+    uint32_t rank = stats->count - stats->count / 100; // Runs at or below the 99th percentile
+    uint32_t seen = 0;
+    for (uint8_t bucket = 0; bucket < TRACE_BUCKETS && stats->count > 0; bucket++)
+    {
+        seen += stats->buckets[bucket];
+        if (seen >= rank)
+        {
+            stats->p99 = Trace_bucketEdge(bucket) < stats->max ? Trace_bucketEdge(bucket) : stats->max;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Records a span, e.g. the time to first fix of a start.
+ *
+ * Spans are rare (a few per power cycle), so they are kept apart from the stages and survive `Trace_reset`.
+ *
+ * @param span The span.
+ * @param ms Its length in milliseconds.
+ */
+void Trace_span(TraceSpan span, uint32_t ms)
+{
+    uint32_t status = save_and_disable_interrupts();
+    TraceSpanStats *stats = &trace_spans[span];
+    if (stats->count == 0 || ms < stats->min)
+    {
+        stats->min = ms;
+    }
+    if (ms > stats->max)
+    {
+        stats->max = ms;
+    }
+    stats->count++;
+    stats->last = ms;
+    stats->total += ms;
+    restore_interrupts(status);
+}
+
+/**
+ * @brief Copies the statistics of a span.
+ *
+ * @param span The span.
+ * @param stats Receives the statistics.
+ */
+void Trace_spanStats(TraceSpan span, TraceSpanStats *stats)
+{
+    uint32_t status = save_and_disable_interrupts();
+    *stats = trace_spans[span];
+    restore_interrupts(status);
+}
+
+/**
+ * @brief Copies the most recent events, oldest first.
+ *
+ * @param events Receives the events.
+ * @param count Capacity of `events`.
+ * @return The number of events copied (at most TRACE_EVENTS).
+ */
+size_t Trace_events(TraceEvent *events, size_t count)
+{
+    uint32_t status = save_and_disable_interrupts();
+    uint32_t recorded = trace_next < TRACE_EVENTS ? trace_next : TRACE_EVENTS;
+    if (count > recorded)
+    {
+        count = recorded;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        events[i] = trace_events[(trace_next - count + i) & (TRACE_EVENTS - 1)];
+    }
+    restore_interrupts(status);
+    return count;
+}
+
+/**
+ * @brief Clears the statistics of every stage; the event ring is kept.
+ */
+void Trace_reset()
+{
+    uint32_t status = save_and_disable_interrupts();
+    memset(trace_stats, 0, sizeof(trace_stats));
+    restore_interrupts(status);
+}
+
+/**
+ * @brief Prints the statistics of every stage, in cycles, and of every span seen, in milliseconds, to stdio.
+ */
+void Trace_print()
+{
+    printf("Trace (cycles at %lu MHz): stage count min avg p99 max\n", (unsigned long)(clock_get_hz(clk_sys) / 1000000));
+    for (int stage = 0; stage < TRACE_STAGE_COUNT; stage++)
+    {
+        TraceStats stats;
+        Trace_stats((TraceStage)stage, &stats);
+        if (stats.count == 0)
+        {
+            continue;
+        }
+        printf("  %-8s %8lu %6lu %6lu %6lu %6lu\n", trace_names[stage], (unsigned long)stats.count,
+               (unsigned long)stats.min, (unsigned long)(stats.total / stats.count), (unsigned long)stats.p99,
+               (unsigned long)stats.max);
+    }
+    for (int span = 0; span < TRACE_SPAN_COUNT; span++)
+    {
+        TraceSpanStats stats;
+        Trace_spanStats((TraceSpan)span, &stats);
+        if (stats.count == 0)
+        {
+            continue;
+        }
+        printf("  %-11s %5lu ms last, %lu min, %lu avg, %lu max (%lu starts)\n", trace_span_names[span],
+               (unsigned long)stats.last, (unsigned long)stats.min, (unsigned long)(stats.total / stats.count),
+               (unsigned long)stats.max, (unsigned long)stats.count);
+    }
+}
+
+/**
+ * @brief Prints and clears the statistics every `interval_s` seconds; call it from the main loop.
+ *
+ * @param interval_s Seconds between two reports (0: never).
+ */
+void Trace_poll(uint32_t interval_s)
+{
+    uint32_t now = time_us_32() / 1000;
+    if (interval_s == 0 || now - trace_reported < interval_s * 1000)
+    {
+        return;
+    }
+    trace_reported = now;
+    Trace_print();
+    Trace_reset();
+}
+#endif
@@ -0,0 +1,120 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <hardware/structs/systick.h>
+
+/**
+ * Hot-path instrumentation of the receive path:
+ *  - 0: the TRACE_* macros expand to nothing (default)
+ *  - 1: every traced stage records its duration in SysTick cycles
+ */
+#ifndef RP_PICO_TRACE
+#define RP_PICO_TRACE 0
+#endif
+
+// Seconds between two reports printed by TRACE_POLL (0: only when Trace_print is called)
+#ifndef RP_PICO_TRACE_PRINT_S
+#define RP_PICO_TRACE_PRINT_S 0
+#endif
+
+#define TRACE_EVENTS 256 // Events kept in the ring (power of two)
+#define TRACE_BUCKETS 92 // Histogram buckets: exact below 4 cycles, then 4 per octave up to 2^24
+
+#if RP_PICO_TRACE
+#define TRACE_INIT() Trace_init()
+#define TRACE_BEGIN(start) uint32_t start = Trace_cycles()
+#define TRACE_END(stage, start) Trace_record(stage, start)
+#define TRACE_POLL() Trace_poll(RP_PICO_TRACE_PRINT_S)
+#define TRACE_SPAN(span, ms) Trace_span(span, ms)
+#else
+#define TRACE_INIT() ((void)0)
+#define TRACE_BEGIN(start)
+#define TRACE_END(stage, start) ((void)0)
+#define TRACE_POLL() ((void)0)
+#define TRACE_SPAN(span, ms) ((void)0)
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Traced stages, from the PIO FIFO to the listeners
+    typedef enum
+    {
+        TRACE_STAGE_IRQ,      // UartRx_handleIRQ, entry to exit
+        TRACE_STAGE_DMA,      // Decoding the samples written by the DMA channel (DMA receive mode)
+        TRACE_STAGE_LINE,     // UartRx_readSentence calls that end a line (framing and checksum XOR)
+        TRACE_STAGE_PARSE,    // Parsing an accepted sentence, its dispatch included (also NMEAParser_rest)
+        TRACE_STAGE_DISPATCH, // Listener callbacks of one event
+        TRACE_STAGE_COUNT
+    } TraceStage;
+
+    // Traced spans: rare, long intervals measured in milliseconds rather than cycles
+    typedef enum
+    {
+        TRACE_SPAN_TTFF_COLD,   // Time to first fix after power-on without aiding
+        TRACE_SPAN_TTFF_AIDED,  // Time to first fix after power-on with time/position aiding (PMTK740/741)
+        TRACE_SPAN_TTFF_WAKEUP, // Time to first fix after waking the module from standby
+        TRACE_SPAN_COUNT
+    } TraceSpan;
+
+    /**
+     * @brief Statistics of one span since boot (`Trace_reset` keeps them).
+     */
+    typedef struct
+    {
+        uint32_t count; /**< Spans recorded. */
+        uint32_t last;  /**< Last span in milliseconds. */
+        uint32_t min;   /**< Shortest span in milliseconds. */
+        uint32_t max;   /**< Longest span in milliseconds. */
+        uint64_t total; /**< Sum of all spans in milliseconds. */
+    } TraceSpanStats;
+
+    /**
+     * @brief One traced stage, as kept in the event ring.
+     */
+    typedef struct
+    {
+        uint32_t time;   /**< End of the stage in microseconds since boot (time_us_32). */
+        uint32_t cycles; /**< Duration in cycles (bits 0-23) and stage (bits 24-31). */
+    } TraceEvent;
+
+    /**
+     * @brief Duration statistics of one stage since the last reset.
+     */
+    typedef struct
+    {
+        uint32_t count;                  /**< Times the stage ran. */
+        uint32_t min;                    /**< Shortest run in cycles. */
+        uint32_t max;                    /**< Longest run in cycles. */
+        uint64_t total;                  /**< Sum of all runs in cycles. */
+        uint32_t p99;                    /**< 99th percentile: upper edge of its bucket, within 25 %. */
+        uint32_t buckets[TRACE_BUCKETS]; /**< Histogram of the runs (see TRACE_BUCKETS). */
+    } TraceStats;
+
+    /**
+     * @brief Reads the SysTick counter (24 bits, counting down) started by `Trace_init`.
+     */
+    static inline uint32_t Trace_cycles(void)
+    {
+        return systick_hw->cvr;
+    }
+
+    void Trace_init(void);
+    void Trace_record(TraceStage stage, uint32_t start);
+    void Trace_stats(TraceStage stage, TraceStats *stats);
+    void Trace_span(TraceSpan span, uint32_t ms);
+    void Trace_spanStats(TraceSpan span, TraceSpanStats *stats);
+    size_t Trace_events(TraceEvent *events, size_t count);
+    void Trace_reset(void);
+    void Trace_print(void);
+    void Trace_poll(uint32_t interval_s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRACE_H
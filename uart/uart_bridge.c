@@ -0,0 +1,716 @@
+#include "uart_bridge.h"
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+#include <hardware/sync.h>
+
+// Framing states
+#define UART_BRIDGE_HUNT 0    // Between messages
+#define UART_BRIDGE_ADDRESS 1 // NMEA: address field
+#define UART_BRIDGE_BODY 2    // NMEA: rest of the sentence; RTCM3: rest of the frame
+#define UART_BRIDGE_HEADER 3  // RTCM3: the two length bytes
+
+// Bridges on the zero-copy path, indexed by DMA channel
+static UartBridge *uart_bridge_instances[NUM_DMA_CHANNELS];
+
+#if RP_PICO_STATIC_ALLOC
+// Bridges and their taps; a slot is free while its `rx` is NULL
+static UartBridge uart_bridge_pool[UART_BRIDGE_MAX_INSTANCES];
+static uint8_t uart_bridge_taps[UART_BRIDGE_MAX_INSTANCES][UART_BRIDGE_STATIC_TAP_SIZE];
+#endif
+
+/**
+ * @brief Returns the character at a position of the source.
+ *
+ * @param bridge Pointer to the UartBridge structure.
+ * @param index Free-running position, between `send` and the end of the received characters.
+ */
+static inline uint8_t UartBridge_character(const UartBridge *bridge, uint32_t index)
+{
+#if UART_PIO_CLKDIV
+    if (bridge->zero_copy)
+    {
+        const UartRx *rx = bridge->rx;
+        return rx->dma_buffer[index & (rx->dma_size - 1)] >> (32 - rx->rxBits); // Data bits, as UartRx_decode
+    }
+#endif
+    return bridge->source->buffer[index & bridge->source->mask];
+}
+
+/**
+ * @brief Marks the characters up to `end` as either forwarded or skipped, in stream order.
+ *
+ * Accepted characters extend `ready`. Skipped ones are released right away when nothing waits
+ * before them, and otherwise make a gap; a message accepted behind the gap is `held` and
+ * stops the framing until the gap is passed.
+ *
+ * @param bridge Pointer to the UartBridge structure.
+ * @param end Position after the last character of the span.
+ * @param forward True to forward the span, false to skip it.
+ */
+static void UartBridge_publish(UartBridge *bridge, uint32_t end, bool forward)
+{
+    uint32_t status = save_and_disable_interrupts(); // The DMA interrupt moves `send` and passes gaps
+    if (!bridge->skipping)
+    {
+        if (forward)
+        {
+            bridge->ready = end;
+        }
+        else if (bridge->send == bridge->ready)
+        {
+            bridge->send = end;
+            bridge->ready = end;
+        }
+        else
+        {
+            bridge->gap = end;
+            bridge->held = end;
+            bridge->skipping = true;
+        }
+    }
+    else if (forward)
+    {
+        bridge->held = end;
+    }
+    else
+    {
+        bridge->gap = end;
+        bridge->held = end;
+    }
+    restore_interrupts(status);
+}
+
+/**
+ * @brief Passes the gap once everything before it has been forwarded.
+ *
+ * Must be called with the DMA interrupt unable to run.
+ */
+static inline void UartBridge_pass(UartBridge *bridge)
+{
+    if (bridge->skipping && bridge->send == bridge->ready)
+    {
+        bridge->send = bridge->gap;
+        bridge->ready = bridge->held;
+        bridge->skipping = false;
+    }
+}
+
+/**
+ * @brief Returns true if the filter lets the message with the given key through.
+ *
+ * @param bridge Pointer to the UartBridge structure.
+ * @param key NMEA address, or RTCM message number in decimal.
+ * @param length Characters in `key`.
+ */
+static bool UartBridge_match(const UartBridge *bridge, const char *key, uint8_t length)
+{
+    if (bridge->filter_count == 0)
+    {
+        return true;
+    }
+    for (uint8_t i = 0; i < bridge->filter_count; i++)
+    {
+        const char *entry = bridge->filters[i];
+        uint8_t n = bridge->filter_lengths[i];
+        bool match;
+        if (bridge->mode == UART_BRIDGE_RTCM3)
+        {
+            match = n == length && memcmp(key, entry, n) == 0;
+        }
+        else if (n == 3)
+        {
+            match = length == 5 && memcmp(key + 2, entry, 3) == 0; // Sentence type of any talker
+        }
+        else
+        {
+            match = n <= length && memcmp(key, entry, n) == 0; // Start of the address
+        }
+        if (match)
+        {
+            return bridge->filter_pass;
+        }
+    }
+    return !bridge->filter_pass;
+}
+
+/**
+ * @brief Ends the message being framed at `end`, forwarded if the filter lets it through.
+ */
+static void UartBridge_complete(UartBridge *bridge, uint32_t end, const char *key, uint8_t length)
+{
+    bool forward = UartBridge_match(bridge, key, length);
+    if (forward)
+    {
+        bridge->stats.messages++;
+    }
+    else
+    {
+        bridge->stats.filtered++;
+    }
+    UartBridge_publish(bridge, end, forward);
+    bridge->state = UART_BRIDGE_HUNT;
+}
+
+/**
+ * @brief Drops the characters framed since `start` up to `end`.
+ */
+static void UartBridge_drop(UartBridge *bridge, uint32_t end)
+{
+    bridge->stats.dropped += end - bridge->start;
+    UartBridge_publish(bridge, end, false);
+    bridge->state = UART_BRIDGE_HUNT;
+}
+
+/**
+ * @brief Frames one character of an NMEA stream.
+ *
+ * @param bridge Pointer to the UartBridge structure.
+ * @param index Position of the character.
+ * @param c The character.
+ */
+static void UartBridge_nmea(UartBridge *bridge, uint32_t index, uint8_t c)
+{
+    if (c == '$' || c == '!')
+    {
+        if (bridge->state != UART_BRIDGE_HUNT)
+        {
+            UartBridge_drop(bridge, index); // A sentence cut short by the next one
+        }
+        bridge->state = UART_BRIDGE_ADDRESS;
+        bridge->start = index;
+        bridge->address_length = 0;
+        return;
+    }
+    if (bridge->state == UART_BRIDGE_HUNT)
+    {
+        bridge->start = index;
+        UartBridge_drop(bridge, index + 1);
+        return;
+    }
+    if (c == '\n')
+    {
+        UartBridge_complete(bridge, index + 1, bridge->address, bridge->address_length);
+    }
+    else if (index + 1 - bridge->start >= bridge->limit)
+    {
+        UartBridge_drop(bridge, index + 1); // Too long for the source; the rest is dropped between sentences
+    }
+    else if (bridge->state == UART_BRIDGE_ADDRESS)
+    {
+        if (c == ',' || c == '*')
+        {
+            bridge->state = UART_BRIDGE_BODY;
+        }
+        else if (bridge->address_length < UART_BRIDGE_ADDRESS_LENGTH)
+        {
+            bridge->address[bridge->address_length++] = c;
+        }
+    }
+}
+
+/**
+ * @brief Frames one character of an RTCM 3 stream.
+ *
+ * @param bridge Pointer to the UartBridge structure.
+ * @param index Position of the character.
+ * @param c The character.
+ */
+static void UartBridge_rtcm3(UartBridge *bridge, uint32_t index, uint8_t c)
+{
+    uint32_t position = index - bridge->start;
+    switch (bridge->state)
+    {
+    case UART_BRIDGE_HUNT:
+        bridge->start = index;
+        if (c == UART_BRIDGE_RTCM3_PREAMBLE)
+        {
+            bridge->state = UART_BRIDGE_HEADER;
+            bridge->number = 0;
+        }
+        else
+        {
+            UartBridge_drop(bridge, index + 1);
+        }
+        break;
+    case UART_BRIDGE_HEADER:
+        if (position == 1)
+        {
+            if (c & 0xFC) // Reserved bits: not a frame
+            {
+                UartBridge_drop(bridge, index + 1);
+                break;
+            }
+            bridge->length = (uint16_t)(c & 3) << 8;
+            break;
+        }
+        bridge->length = (bridge->length | c) + 6; // Header, payload and CRC
+        bridge->state = UART_BRIDGE_BODY;
+        if (bridge->length > bridge->limit)
+        {
+            UartBridge_drop(bridge, index + 1); // Too long for the source; the rest is dropped between frames
+        }
+        break;
+    default:
+        if (position == 3)
+        {
+            bridge->number = (uint16_t)c << 4;
+        }
+        else if (position == 4)
+        {
+            bridge->number |= c >> 4;
+        }
+        if (position + 1 == bridge->length)
+        {
+            char key[5];
+            uint8_t length = 0;
+            for (uint32_t divisor = 1000; divisor > 0; divisor /= 10)
+            {
+                if (bridge->number >= divisor || divisor == 1 || length > 0)
+                {
+                    key[length++] = (char)('0' + bridge->number / divisor % 10);
+                }
+            }
+            UartBridge_complete(bridge, index + 1, key, length);
+        }
+        break;
+    }
+}
+
+/**
+ * @brief Frames the characters received up to `end`, until a message is held behind a gap.
+ *
+ * @param bridge Pointer to the UartBridge structure.
+ * @param end Position after the last received character.
+ */
+static void UartBridge_scan(UartBridge *bridge, uint32_t end)
+{
+    if (bridge->mode == UART_BRIDGE_RAW)
+    {
+        bridge->scan = end;
+        UartBridge_publish(bridge, end, true);
+        return;
+    }
+    while (bridge->scan != end && !(bridge->skipping && bridge->held != bridge->gap))
+    {
+        uint32_t index = bridge->scan++;
+        uint8_t c = UartBridge_character(bridge, index);
+        if (bridge->mode == UART_BRIDGE_NMEA)
+        {
+            UartBridge_nmea(bridge, index, c);
+        }
+        else
+        {
+            UartBridge_rtcm3(bridge, index, c);
+        }
+    }
+}
+
+/**
+ * @brief Drops everything not forwarded yet and restarts the framing at `position`.
+ *
+ * Must be called with the DMA interrupt unable to run.
+ */
+static void UartBridge_restart(UartBridge *bridge, uint32_t position)
+{
+    bridge->scan = position;
+    bridge->start = position;
+    bridge->send = position;
+    bridge->ready = position;
+    bridge->skipping = false;
+    bridge->state = UART_BRIDGE_HUNT;
+}
+
+/**
+ * @brief Zero-copy path: starts a DMA transfer of the accepted samples if the transmitter is free.
+ *
+ * Must be called with the DMA interrupt unable to run.
+ *
+ * @param bridge Pointer to the UartBridge structure.
+ */
+static void UartBridge_kick(UartBridge *bridge)
+{
+    if (bridge->batch != 0)
+    {
+        return;
+    }
+    UartBridge_pass(bridge);
+    uint32_t count = bridge->ready - bridge->send;
+    if (count == 0 || !UartTx_claim(bridge->tx))
+    {
+        return; // Nothing to send, or the transmit queue has the FIFO: retried at the next poll
+    }
+    const UartRx *rx = bridge->rx;
+    bridge->batch = count;
+    dma_channel_transfer_from_buffer_now(bridge->dma_chan, &rx->dma_buffer[bridge->send & (rx->dma_size - 1)], count);
+}
+
+#if UART_PIO_CLKDIV
+/**
+ * @brief Handles DMA completion for every bridge on the zero-copy path.
+ */
+static void UartBridge_handleDMAIRQ(void)
+{
+    for (uint chan = 0; chan < NUM_DMA_CHANNELS; chan++)
+    {
+        UartBridge *bridge = uart_bridge_instances[chan];
+        if (bridge && dma_channel_get_irq0_status(chan))
+        {
+            dma_channel_acknowledge_irq0(chan);
+            bridge->send += bridge->batch;
+            bridge->stats.bytes += bridge->batch;
+            bridge->batch = 0;
+            UartTx_release(bridge->tx); // The transmit queue goes first if it has bytes waiting
+            UartBridge_kick(bridge);
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Zero-copy path: returns the number of samples the receiver's DMA channel has written.
+ *
+ * The count follows the channel's write address, so it stays right when the receiver re-arms
+ * its channel.
+ */
+static uint32_t UartBridge_produced(UartBridge *bridge)
+{
+    const UartRx *rx = bridge->rx;
+    uint32_t address = dma_channel_hw_addr(rx->dma_chan)->write_addr;
+    uint32_t index = (address - (uint32_t)(uintptr_t)rx->dma_buffer) / sizeof(uint32_t);
+    bridge->produced += (index - bridge->produced) & (rx->dma_size - 1);
+    return bridge->produced;
+}
+
+/**
+ * @brief Copy path: queues the accepted characters with `UartTx_send` and releases the source.
+ *
+ * A run of accepted characters is only queued once it fits the transmit queue as a whole
+ * (or the queue is empty), so a message is never split around bytes queued by other code.
+ *
+ * @param bridge Pointer to the UartBridge structure.
+ */
+static void UartBridge_send(UartBridge *bridge)
+{
+    RingBuffer *source = bridge->source;
+    UartTx *tx = bridge->tx;
+    while (true)
+    {
+        UartBridge_pass(bridge);
+        RingBuffer_consume(source, bridge->send - source->tail); // Skipped characters
+        uint32_t pending = bridge->ready - bridge->send;
+        if (pending == 0)
+        {
+            break;
+        }
+        if (tx->dma_chan >= 0)
+        {
+            size_t space = RingBuffer_space(&tx->ring);
+            if (space < pending && space < RingBuffer_capacity(&tx->ring))
+            {
+                break; // Wait for the queue to drain
+            }
+        }
+        const uint8_t *span;
+        size_t count = RingBuffer_peek(source, &span);
+        if (count > pending)
+        {
+            count = pending;
+        }
+        size_t sent = UartTx_send(tx, span, count);
+        bridge->send += sent;
+        bridge->stats.bytes += sent;
+        if (sent < count)
+        {
+            break; // Transmit queue full
+        }
+    }
+    RingBuffer_consume(source, bridge->send - source->tail);
+}
+
+/**
+ * @brief Initializes a bridge between an active receiver and an active transmitter.
+ *
+ * The bridge forwards nothing until `UartBridge_activate` is called.
+ *
+ * @param rx The receiver whose stream is forwarded.
+ * @param tx The transmitter it is forwarded to.
+ * @param mode UartBridgeMode.
+ * @return Pointer to the bridge, or NULL if no memory (or no pool slot) is left.
+ */
+UartBridge *UartBridge_init(UartRx *rx, UartTx *tx, UartBridgeMode mode)
+{
+#if RP_PICO_STATIC_ALLOC
+    UartBridge *bridge = NULL;
+    for (int i = 0; i < UART_BRIDGE_MAX_INSTANCES && !bridge; i++)
+    {
+        if (uart_bridge_pool[i].rx == NULL)
+        {
+            bridge = &uart_bridge_pool[i];
+        }
+    }
+    if (bridge == NULL)
+    {
+        return NULL; // Every bridge is in use
+    }
+#else
+    UartBridge *bridge = (UartBridge *)malloc(sizeof(UartBridge));
+    if (bridge == NULL)
+    {
+        return NULL;
+    }
+#endif
+    memset(bridge, 0, sizeof(UartBridge));
+    bridge->rx = rx;
+    bridge->tx = tx;
+    bridge->mode = mode;
+    bridge->dma_chan = -1;
+    return bridge;
+}
+
+/**
+ * @brief Sets the longest message to frame: what the source holds, and a line for NMEA.
+ */
+static void UartBridge_limit(UartBridge *bridge, uint32_t capacity)
+{
+    bridge->limit = bridge->mode == UART_BRIDGE_NMEA && capacity > UART_MAX_BUFFER_LENGTH ? UART_MAX_BUFFER_LENGTH : capacity;
+}
+
+/**
+ * @brief Starts forwarding, on the zero-copy path when the receiver and the transmitter allow it.
+ *
+ * The zero-copy path needs UART_PIO_CLKDIV, 8 data bits on both sides, the receiver activated
+ * with `UartRx_activateDMA`, the transmitter with `UartTx_activateDMA`, and a free DMA channel.
+ * Otherwise the characters are read from a tap of `tapSize` bytes attached to the receiver, so
+ * it can still be read as usual, or from the receiver's own ring if `tapSize` is 0 (the bridge
+ * is then the receiver's only reader).
+ *
+ * @param bridge Pointer to the UartBridge structure.
+ * @param tapSize Size of the tap in bytes (power of two), or 0; unused on the zero-copy path.
+ * @return 0 on success, non-zero if either side is not active or the tap cannot be allocated.
+ */
+int UartBridge_activate(UartBridge *bridge, size_t tapSize)
+{
+    UartRx *rx = bridge->rx;
+    UartTx *tx = bridge->tx;
+    if (rx->pio == NULL || tx->pio == NULL || bridge->zero_copy || bridge->source != NULL)
+    {
+        return 1; // Inactive, or already activated
+    }
+
+#if UART_PIO_CLKDIV
+    int chan = rx->dma_chan >= 0 && tx->dma_chan >= 0 && rx->pico->bits == 8 && tx->pico->bits == 8
+                   ? dma_claim_unused_channel(false)
+                   : -1;
+    if (chan >= 0)
+    {
+        uint ring_bits = 2; // log2 of the receiver's ring size in bytes
+        while ((1u << ring_bits) < rx->dma_size * sizeof(uint32_t))
+        {
+            ring_bits++;
+        }
+        dma_channel_config c = dma_channel_get_default_config(chan);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+        channel_config_set_read_increment(&c, true);                        // Walk the receiver's sample ring
+        channel_config_set_write_increment(&c, false);                      // Always write the SM TX FIFO
+        channel_config_set_ring(&c, false, ring_bits);                      // Wrap the read address at the ring size
+        channel_config_set_dreq(&c, pio_get_dreq(tx->pio, tx->sm, true)); // Paced by the TX FIFO
+        dma_channel_configure(chan, &c, &tx->pio->txf[tx->sm], rx->dma_buffer, 0, false);
+
+        // The DMA completion interrupt is shared with the transmitters and any other DMA users
+        static bool handler_installed = false;
+        if (!handler_installed)
+        {
+            irq_add_shared_handler(DMA_IRQ_0, UartBridge_handleDMAIRQ, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+            irq_set_enabled(DMA_IRQ_0, true);
+            handler_installed = true;
+        }
+        bridge->dma_chan = chan;
+        bridge->zero_copy = true;
+        bridge->produced = 0;
+        UartBridge_restart(bridge, UartBridge_produced(bridge)); // Forward what arrives from now on
+        UartBridge_limit(bridge, rx->dma_size);
+        uart_bridge_instances[chan] = bridge;
+        dma_channel_set_irq0_enabled(chan, true);
+        return 0;
+    }
+#endif
+
+    if (tapSize == 0)
+    {
+        bridge->source = &rx->ring;
+    }
+    else
+    {
+#if RP_PICO_STATIC_ALLOC
+        if (tapSize > UART_BRIDGE_STATIC_TAP_SIZE)
+        {
+            return 1; // Larger than the static tap
+        }
+        bridge->queue = uart_bridge_taps[bridge - uart_bridge_pool];
+#else
+        bridge->queue = (uint8_t *)malloc(tapSize);
+#endif
+        if (bridge->queue == NULL || RingBuffer_init(&bridge->tap, bridge->queue, tapSize) != 0)
+        {
+#if !RP_PICO_STATIC_ALLOC
+            free(bridge->queue);
+#endif
+            bridge->queue = NULL;
+            return 1;
+        }
+        bridge->source = &bridge->tap;
+        rx->tap = &bridge->tap;
+    }
+    bridge->source_overflows = bridge->source->overflows;
+    UartBridge_restart(bridge, bridge->source->tail);
+    UartBridge_limit(bridge, RingBuffer_capacity(bridge->source));
+    return 0;
+}
+
+/**
+ * @brief Sets the filter of the messages: the entries to forward, or the entries to drop.
+ *
+ * In NMEA mode an entry of three characters is a sentence type and matches it from any talker
+ * ("GGA" matches $GPGGA and $GNGGA); a longer or shorter entry matches the start of the address
+ * ("GPGSV", "PMTK"). In RTCM3 mode an entry is a message number ("1005", "1077"). Raw mode
+ * ignores the filter.
+ *
+ * @param bridge Pointer to the UartBridge structure.
+ * @param entries Comma-separated entries, e.g. "GGA,RMC", or NULL to forward every message.
+ * @param pass True to forward only the messages matching an entry, false to drop them.
+ * @return 0 on success, non-zero if there are more than UART_BRIDGE_FILTERS entries or one is
+ *         empty or longer than UART_BRIDGE_FILTER_LENGTH (the filter is then cleared).
+ */
+int UartBridge_filter(UartBridge *bridge, const char *entries, bool pass)
+{
+    bridge->filter_count = 0;
+    bridge->filter_pass = pass;
+    if (entries == NULL)
+    {
+        return 0;
+    }
+    uint8_t count = 0;
+    for (const char *entry = entries; *entry != '\0';)
+    {
+        const char *comma = strchr(entry, ',');
+        size_t length = comma ? (size_t)(comma - entry) : strlen(entry);
+        if (count == UART_BRIDGE_FILTERS || length == 0 || length > UART_BRIDGE_FILTER_LENGTH)
+        {
+            return 1;
+        }
+        memcpy(bridge->filters[count], entry, length);
+        bridge->filter_lengths[count++] = (uint8_t)length;
+        entry += length + (comma ? 1 : 0);
+    }
+    bridge->filter_count = count;
+    return 0;
+}
+
+/**
+ * @brief Frames what was received since the last call and forwards the complete messages.
+ *
+ * Call it from the main loop, like the receiver's read functions. On the zero-copy path the DMA
+ * interrupt carries on with the messages already framed; on the copy path everything happens here.
+ *
+ * @param bridge Pointer to the UartBridge structure.
+ */
+void UartBridge_poll(UartBridge *bridge)
+{
+    if (bridge->zero_copy)
+    {
+        uint32_t produced = UartBridge_produced(bridge);
+        uint32_t status = save_and_disable_interrupts();
+        if (produced - bridge->send > bridge->rx->dma_size)
+        {
+            // The receiver's ring wrapped over samples not forwarded yet, maybe under the transfer
+            if (bridge->batch != 0)
+            {
+                dma_channel_set_irq0_enabled(bridge->dma_chan, false);
+                dma_channel_abort(bridge->dma_chan);
+                dma_channel_acknowledge_irq0(bridge->dma_chan);
+                dma_channel_set_irq0_enabled(bridge->dma_chan, true);
+                bridge->batch = 0;
+                UartTx_release(bridge->tx);
+            }
+            UartBridge_restart(bridge, produced);
+            bridge->stats.overruns++;
+        }
+        restore_interrupts(status);
+
+        UartBridge_scan(bridge, produced);
+        status = save_and_disable_interrupts();
+        UartBridge_kick(bridge);
+        restore_interrupts(status);
+        return;
+    }
+
+    RingBuffer *source = bridge->source;
+    if (source == NULL)
+    {
+        return; // Not activated
+    }
+    if (bridge->rx->dma_chan >= 0)
+    {
+        UartRx_available(bridge->rx); // Decodes the pending samples into the rings
+    }
+    if (source->overflows != bridge->source_overflows)
+    {
+        // Characters were lost at the end of the source: drop everything not forwarded yet
+        bridge->source_overflows = source->overflows;
+        UartBridge_restart(bridge, source->head);
+        RingBuffer_consume(source, bridge->send - source->tail);
+        bridge->stats.overruns++;
+        return;
+    }
+    uint32_t head = source->head;
+    __dmb(); // Read the index before the characters it covers
+    UartBridge_scan(bridge, head);
+    UartBridge_send(bridge);
+}
+
+/**
+ * @brief Copies the counters.
+ *
+ * @param bridge Pointer to the UartBridge structure.
+ * @param stats Receives the counters.
+ */
+void UartBridge_stats(const UartBridge *bridge, UartBridgeStats *stats)
+{
+    *stats = bridge->stats;
+}
+
+/**
+ * @brief Stops a bridge and frees it; the receiver and the transmitter stay active.
+ *
+ * Free the bridge before its receiver or its transmitter.
+ * With `RP_PICO_STATIC_ALLOC` the bridge and its tap go back to the static pool instead.
+ *
+ * @param bridge Pointer to the UartBridge structure, or NULL.
+ */
+void UartBridge_free(UartBridge *bridge)
+{
+    if (bridge)
+    {
+        if (bridge->dma_chan >= 0)
+        {
+            dma_channel_set_irq0_enabled(bridge->dma_chan, false);
+            dma_channel_abort(bridge->dma_chan);
+            uart_bridge_instances[bridge->dma_chan] = NULL;
+            dma_channel_unclaim(bridge->dma_chan);
+            if (bridge->batch != 0)
+            {
+                UartTx_release(bridge->tx);
+            }
+        }
+        if (bridge->rx->tap == &bridge->tap)
+        {
+            bridge->rx->tap = NULL;
+        }
+#if RP_PICO_STATIC_ALLOC
+        bridge->rx = NULL; // Back to the pool, with its tap
+#else
+        free(bridge->queue);
+        free(bridge);
+#endif
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef UART_BRIDGE_H
+#define UART_BRIDGE_H
+
+#include "uart_rx.h"
+#include "uart_tx.h"
+
+#define UART_BRIDGE_FILTERS 8        // Entries of a filter (see UartBridge_filter)
+#define UART_BRIDGE_FILTER_LENGTH 7  // Longest filter entry, in characters
+#define UART_BRIDGE_ADDRESS_LENGTH 8 // Characters of an NMEA address kept for the filter
+#define UART_BRIDGE_RTCM3_PREAMBLE 0xD3
+
+// Static pools (RP_PICO_STATIC_ALLOC only): bridges, and the largest tap of each
+#ifndef UART_BRIDGE_MAX_INSTANCES
+#define UART_BRIDGE_MAX_INSTANCES 2
+#endif
+#ifndef UART_BRIDGE_STATIC_TAP_SIZE
+#define UART_BRIDGE_STATIC_TAP_SIZE 512 // Largest `tapSize` of UartBridge_activate (power of two)
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief What a bridge forwards, and in which units.
+     */
+    typedef enum
+    {
+        UART_BRIDGE_RAW,   /**< Every character, as soon as it is received. */
+        UART_BRIDGE_NMEA,  /**< Complete NMEA sentences, from '$' or '!' to '\n'. */
+        UART_BRIDGE_RTCM3, /**< Complete RTCM 3 frames: preamble 0xD3, 10-bit length, payload, CRC-24Q (not checked). */
+    } UartBridgeMode;
+
+    /**
+     * @brief Counters of a bridge.
+     */
+    typedef struct
+    {
+        uint32_t messages; /**< Sentences or frames accepted for forwarding (0 in raw mode). */
+        uint32_t bytes;    /**< Characters handed to the transmitter. */
+        uint32_t filtered; /**< Sentences or frames dropped by the filter. */
+        uint32_t dropped;  /**< Characters dropped outside messages, or in broken or too long messages. */
+        uint32_t overruns; /**< Times the receiver got so far ahead that everything not forwarded yet was dropped. */
+    } UartBridgeStats;
+
+    /**
+     * @brief Forwards the stream of a receiver to a transmitter, e.g. corrections from a base link
+     *        to the GNSS module, or the module's NMEA to a logger.
+     *
+     * With UART_PIO_CLKDIV, 8 data bits, the receiver in DMA receive mode and the transmitter in
+     * asynchronous mode, the bridge is zero-copy: the clock-divider TX program takes the words the
+     * RX program pushes as they are, so a DMA channel of the bridge moves the raw samples from the
+     * receiver's DMA ring straight into the transmitter's PIO FIFO. The CPU only reads the samples
+     * to find the message boundaries; the receiver's own reader decodes the same ring unchanged.
+     * The transmitter sends each sample as a frame of its own stop bits, so at the receiver's
+     * baud rate with one stop bit it takes exactly as long as the frame took to arrive.
+     *
+     * Otherwise the bridge reads decoded characters from a tap of the receiver (a second ring its
+     * decoder fills, so the receiver can still be parsed) or from the receiver's own ring, and
+     * queues them with `UartTx_send`.
+     *
+     * In NMEA and RTCM3 modes only complete messages are forwarded, each one whole, so they never
+     * interleave with the bytes other code sends through the same transmitter (e.g. PMTK commands
+     * to the module), and an optional filter drops sentence types or RTCM message numbers. The
+     * receiver's DMA ring or the tap must hold the longest message plus the longest gap between
+     * two polls: 256 samples are 22 ms at 115200 baud, an RTCM 3 frame can take 1029 bytes.
+     */
+    typedef struct
+    {
+        UartRx *rx;                                  /**< Source of the stream */
+        UartTx *tx;                                  /**< Destination of the stream */
+        uint8_t mode;                                /**< UartBridgeMode */
+        bool zero_copy;                              /**< True if the samples go from the receiver's DMA ring to the PIO FIFO by DMA */
+        int dma_chan;                                /**< DMA channel of the zero-copy path, or -1 */
+        uint8_t *queue;                              /**< Storage of the tap, or NULL */
+        RingBuffer tap;                              /**< Copy of the receiver's characters (copy path with a tap) */
+        RingBuffer *source;                          /**< Characters read by the copy path: `tap`, or the receiver's own ring */
+        uint32_t source_overflows;                   /**< `source->overflows` at the last poll */
+        uint32_t limit;                              /**< Longest message the source can hold, in characters */
+
+        // Free-running character (or sample) positions in the source; send <= ready <= gap <= held <= scan
+        uint32_t produced;                           /**< Zero-copy: samples written by the receiver's DMA channel */
+        uint32_t scan;                               /**< Next character to frame */
+        uint32_t start;                              /**< First character of the message being framed */
+        volatile uint32_t send;                      /**< First character not forwarded or skipped yet */
+        volatile uint32_t ready;                     /**< End of the accepted characters waiting to be forwarded */
+        volatile uint32_t gap;                       /**< End of the characters to skip once `ready` is reached (while `skipping`) */
+        volatile uint32_t held;                      /**< End of a message accepted behind the gap, or equal to `gap` */
+        volatile bool skipping;                      /**< True while a gap waits behind the accepted characters */
+        volatile uint32_t batch;                     /**< Zero-copy: samples in the DMA transfer, 0 while idle */
+
+        uint8_t state;                               /**< Framing state */
+        uint16_t length;                             /**< RTCM3: characters of the frame being framed */
+        uint16_t number;                             /**< RTCM3: message number of the frame being framed */
+        char address[UART_BRIDGE_ADDRESS_LENGTH];    /**< NMEA: address of the sentence being framed */
+        uint8_t address_length;                      /**< NMEA: characters in `address` */
+        char filters[UART_BRIDGE_FILTERS][UART_BRIDGE_FILTER_LENGTH]; /**< Filter entries, not null-terminated */
+        uint8_t filter_lengths[UART_BRIDGE_FILTERS]; /**< Characters of every entry */
+        uint8_t filter_count;                        /**< Entries of the filter, 0 to forward everything */
+        bool filter_pass;                            /**< True: forward only the entries; false: drop them */
+        UartBridgeStats stats;                       /**< Counters */
+    } UartBridge;
+
+    /**
+     * @brief Creates a bridge between an active receiver and an active transmitter.
+     *
+     * @param rx The receiver whose stream is forwarded.
+     * @param tx The transmitter it is forwarded to.
+     * @param mode UartBridgeMode.
+     * @return Pointer to the bridge, or NULL if no memory (or no pool slot) is left.
+     */
+    UartBridge *UartBridge_init(UartRx *rx, UartTx *tx, UartBridgeMode mode);
+    int UartBridge_activate(UartBridge *bridge, size_t tapSize);
+    int UartBridge_filter(UartBridge *bridge, const char *entries, bool pass);
+    void UartBridge_poll(UartBridge *bridge);
+    void UartBridge_stats(const UartBridge *bridge, UartBridgeStats *stats);
+    void UartBridge_free(UartBridge *bridge);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UART_BRIDGE_H
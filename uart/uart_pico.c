@@ -0,0 +1,126 @@
+#include "uart_pico.h"
+
+/**
+ * @brief A patched program copy loaded in one PIO block.
+ */
+typedef struct
+{
+    PIO pio;                   /**< PIO block holding the copy, or NULL if the slot is free */
+    const pio_program_t *base; /**< Unpatched program the copy was made from */
+    int bits;                  /**< Value patched into the first instruction */
+    int offset;                /**< Offset of the copy in instruction memory */
+    uint8_t length;            /**< Number of instructions */
+    uint8_t users;             /**< State machines currently running the copy */
+} UartPicoProgram;
+
+static UartPicoProgram uart_pico_programs[UART_PICO_MAX_PROGRAMS];
+
+/**
+ * @brief Claims a free state machine (SM) and a copy of a program patched for the given frame size.
+ *
+ * @param pio On success, receives the PIO instance that runs the program.
+ * @param sm On success, receives the claimed state machine number.
+ * @param bits The value loaded into X by the patched first instruction.
+ * @param pg The PIO program to load.
+ *
+ * @return The offset of the program in instruction memory, or a negative error code.
+ */
+int UartPico_find_offset_for_program(PIO *pio, int *sm, int bits, const pio_program_t *pg)
+{
+    *pio = NULL;
+    if (pg->length > PIO_INSTRUCTION_COUNT)
+    {
+        return -1; // The program cannot fit in any instruction memory
+    }
+
+    // Reuse a copy that is already patched for this frame size
+    for (int i = 0; i < UART_PICO_MAX_PROGRAMS; i++)
+    {
+        UartPicoProgram *entry = &uart_pico_programs[i];
+        if (entry->pio && entry->base == pg && entry->bits == bits)
+        {
+            *sm = pio_claim_unused_sm(entry->pio, false);
+            if (*sm >= 0)
+            {
+                entry->users++;
+                *pio = entry->pio;
+                return entry->offset;
+            }
+        }
+    }
+
+    UartPicoProgram *slot = NULL;
+    for (int i = 0; i < UART_PICO_MAX_PROGRAMS && !slot; i++)
+    {
+        if (!uart_pico_programs[i].pio)
+        {
+            slot = &uart_pico_programs[i];
+        }
+    }
+    if (!slot)
+    {
+        return -2; // Every registry slot is in use
+    }
+
+    // Patch a stack copy of the program; the SDK copies it into instruction memory and relocates jumps
+    uint16_t insn[PIO_INSTRUCTION_COUNT];
+    memcpy(insn, pg->instructions, pg->length * sizeof(uint16_t));
+    insn[0] = pio_encode_set(pio_x, bits);
+    pio_program_t program = *pg;
+    program.instructions = insn;
+
+    for (uint index = 0; index < NUM_PIOS; index++)
+    {
+        PIO bpio = pio_get_instance(index);
+        if (!pio_can_add_program(bpio, &program))
+        {
+            continue;
+        }
+        int claimed = pio_claim_unused_sm(bpio, false);
+        if (claimed < 0)
+        {
+            continue;
+        }
+
+        slot->pio = bpio;
+        slot->base = pg;
+        slot->bits = bits;
+        slot->offset = pio_add_program(bpio, &program);
+        slot->length = pg->length;
+        slot->users = 1;
+
+        *pio = bpio;
+        *sm = claimed;
+        return slot->offset;
+    }
+
+    return -3; // To indicate failure (no free space available).
+}
+
+/**
+ * @brief Releases a state machine claimed by `UartPico_find_offset_for_program`.
+ *
+ * @param pio The PIO instance that runs the program.
+ * @param sm The state machine to stop and unclaim.
+ * @param offset The program offset returned when the state machine was claimed.
+ */
+void UartPico_release_program(PIO pio, int sm, int offset)
+{
+    pio_sm_set_enabled(pio, sm, false);
+    pio_sm_unclaim(pio, sm);
+
+    for (int i = 0; i < UART_PICO_MAX_PROGRAMS; i++)
+    {
+        UartPicoProgram *entry = &uart_pico_programs[i];
+        if (entry->pio == pio && entry->offset == offset)
+        {
+            if (--entry->users == 0)
+            {
+                pio_program_t program = {.instructions = entry->base->instructions, .length = entry->length, .origin = -1};
+                pio_remove_program(pio, &program, offset);
+                entry->pio = NULL;
+            }
+            return;
+        }
+    }
+}
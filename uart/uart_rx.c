@@ -1,12 +1,59 @@
 #include "uart_pico.h"
 #include "uart_rx.h"
+#include "uart_rx_decode.h"
+#include "trace.h"
 #include <hardware/clocks.h>
+#include <hardware/dma.h>
+#include <pico/time.h>
 
+#if UART_PIO_CLKDIV
+#define pio_rx_wrap_target 0
+#define pio_rx_wrap 4
+#else
 #define pio_rx_wrap_target 0
 #define pio_rx_wrap 6
+#endif
+
+// Receivers in IRQ mode, indexed by PIO block and state machine
+static UartRx *uart_rx_instances[NUM_PIOS][NUM_PIO_STATE_MACHINES];
 
-static UartRx *uart_rx_instances[NUM_PIO_STATE_MACHINES] = {NULL, NULL, NULL, NULL};
+#if RP_PICO_STATIC_ALLOC
+// Receivers and their buffers; a slot is free while its `pico` is NULL
+static UartRx uart_rx_pool[UART_RX_MAX_INSTANCES];
+static uint8_t uart_rx_queues[UART_RX_MAX_INSTANCES][UART_RX_STATIC_FIFO_SIZE];
 
+// The DMA ring wrap requires every buffer to be aligned to its own size
+static uint32_t uart_rx_dma_buffers[UART_RX_MAX_INSTANCES][UART_RX_STATIC_DMA_SAMPLES]
+    __attribute__((aligned(UART_RX_STATIC_DMA_SAMPLES * sizeof(uint32_t))));
+#endif
+
+#if UART_PIO_CLKDIV
+/**
+ * @brief PIO RX program instructions (clock divider, UART_PIO_CYCLES_PER_BIT cycles per bit).
+ *
+ * The start edge is followed by 12 cycles (1.5 bits) to reach the middle of the first data bit,
+ * then every data bit and the first stop bit are sampled once, 8 cycles apart. Autopush sends
+ * the frame after the stop bit sample, so the program is already waiting for the next start bit
+ * a quarter of a bit before the end of the stop bit. A low stop bit (framing error or break)
+ * lands in bit 31 of the pushed word and is rejected by the decoder.
+ */
+static const uint16_t pio_rx_program_instructions[] = {
+    0xe027, //  0: set    x, 7
+    0x2b20, //  1: wait   0 pin, 0        [11]
+    0x4001, //  2: in     pins, 1
+    0x0642, //  3: jmp    x--, 2          [6]
+    0x4001, //  4: in     pins, 1
+};
+
+/**
+ * @brief Structure representing the PIO RX program.
+ */
+static const struct pio_program pio_rx_program = {
+    .instructions = pio_rx_program_instructions,
+    .length = 5,
+    .origin = -1,
+};
+#else
 /**
  * @brief PIO RX program instructions.
  */
@@ -28,6 +75,7 @@ static const struct pio_program pio_rx_program = {
     .length = 7,
     .origin = -1,
 };
+#endif
 
 /**
  * @brief Initializes the PIO RX program with the given parameters.
@@ -36,8 +84,9 @@ static const struct pio_program pio_rx_program = {
  * @param sm The state machine number.
  * @param offset The program offset in PIO memory.
  * @param pin The GPIO pin for RX.
+ * @param samples Samples per frame, pushed automatically by the clock-divider program.
  */
-static inline void pio_rx_program_init(PIO pio, uint sm, uint offset, uint pin)
+static inline void pio_rx_program_init(PIO pio, uint sm, uint offset, uint pin, uint samples)
 {
     pio_sm_set_consecutive_pindirs(pio, sm, pin, 1, false);
     pio_gpio_init(pio, pin);
@@ -46,58 +95,158 @@ static inline void pio_rx_program_init(PIO pio, uint sm, uint offset, uint pin)
     sm_config_set_wrap(&c, offset + pio_rx_wrap_target, offset + pio_rx_wrap);
     sm_config_set_in_pins(&c, pin); // for WAIT, IN
     sm_config_set_jmp_pin(&c, pin); // for JMP
+#if UART_PIO_CLKDIV
+    sm_config_set_in_shift(&c, true, true, samples);
+#else
+    (void)samples; // Pushed explicitly
     sm_config_set_in_shift(&c, true, false, 32);
+#endif
     pio_sm_init(pio, sm, offset, &c);
 }
 
+/**
+ * @brief Decodes one raw PIO sample into a character.
+ *
+ * The PIO program samples the line at half-bit rate, so every data bit occupies two
+ * consecutive positions of the pushed word; only the even positions are kept.
+ * The decoder is selected at compile time with `UART_RX_DECODE_TABLE_BITS`.
+ * The clock-divider program samples every bit once, so its words need no compaction.
+ *
+ * @param uart Pointer to the UartRx structure.
+ * @param decode Raw 32-bit word pushed by the RX state machine.
+ * @return The decoded character.
+ */
+static inline uint8_t UartRx_decode(UartRx *uart, uint32_t decode)
+{
+#if UART_PIO_CLKDIV
+    return (decode >> (32 - uart->rxBits)) & ((1u << uart->pico->bits) - 1);
+#else
+    decode >>= 33 - uart->rxBits;
+#if UART_RX_DECODE_TABLE_BITS
+    return UartRx_decodeTable(decode, uart->pico->bits);
+#else
+    return UartRx_decodeLoop(decode, uart->pico->bits);
+#endif
+#endif
+}
+
+/**
+ * @brief Decodes one raw PIO sample into the receive ring.
+ *
+ * With the clock-divider program, frames whose stop bit was sampled low are counted in
+ * `framing_errors` and dropped instead. A tap, if attached, gets the same characters. Every
+ * '\n' stamps `line_time`.
+ *
+ * @param uart Pointer to the UartRx structure.
+ * @param sample Raw 32-bit word pushed by the RX state machine.
+ */
+static inline void UartRx_receive(UartRx *uart, uint32_t sample)
+{
+#if UART_PIO_CLKDIV
+    if (!(sample & 0x80000000u)) // Stop bit
+    {
+        uart->framing_errors++;
+        return;
+    }
+#endif
+    uint8_t c = UartRx_decode(uart, sample);
+    if (c == '\n')
+    {
+        uart->line_time = time_us_32();
+    }
+    RingBuffer_push(&uart->ring, c);
+    if (uart->tap)
+    {
+        RingBuffer_push(uart->tap, c);
+    }
+}
+
 /**
  * @brief Handles the interrupt triggered by the RX FIFO.
+ *
+ * The same handler serves PIO0 and PIO1 and drains every registered state machine with a
+ * non-empty FIFO in one pass, so one busy receiver cannot starve the others.
  */
 void UartRx_handleIRQ()
 {
-    UartRx *uart = NULL;
-
-    uint sm; /**< State machine number */
-    // Loop through the uart_rx_instances array to find the corresponding UartRx instance
-    for (sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++)
+    TRACE_BEGIN(start);
+    for (uint index = 0; index < NUM_PIOS; index++)
     {
-        uart = uart_rx_instances[sm];
-        if (uart && pio_sm_is_rx_fifo_empty(uart->pio, sm) == false)
+        for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++)
         {
-            break; // We found the correct UartRx instance for the state machine 'sm'
+            UartRx *uart = uart_rx_instances[index][sm];
+            if (!uart)
+            {
+                continue;
+            }
+            while (!pio_sm_is_rx_fifo_empty(uart->pio, sm))
+            {
+                UartRx_receive(uart, uart->pio->rxf[sm]);
+            }
         }
-        uart = NULL; // Reset to NULL if not found
     }
+    TRACE_END(TRACE_STAGE_IRQ, start);
+}
 
-    if (!uart)
+/**
+ * @brief Decodes every sample the DMA channel has written since the last call.
+ *
+ * In DMA receive mode no interrupt fires per character; instead the consumer side
+ * (`UartRx_available`, `UartRx_read`, `UartRx_readLine`) calls this function to decode the
+ * pending samples in one batch. If the DMA ring filled up, the oldest samples are skipped and
+ * counted in `dma_overflows`, down to `dma_size - 1` so the slot being written is left alone.
+ *
+ * @param uart Pointer to the UartRx structure.
+ */
+static void UartRx_drainDMA(UartRx *uart)
+{
+    TRACE_BEGIN(start);
+    dma_channel_hw_t *hw = dma_channel_hw_addr(uart->dma_chan);
+    uint32_t written = UINT32_MAX - hw->transfer_count; // Samples written since the channel was armed
+    uint32_t pending = written - uart->dma_count;
+    uint32_t mask = uart->dma_size - 1;
+
+    if (pending >= uart->dma_size)
     {
-        return; // If we couldn't find a valid UartRx instance, return early
+        // The oldest slot is the one the channel writes next: resume one sample after it so the
+        // first sample decoded cannot be overwritten while it is read
+        uint32_t lost = pending - (uart->dma_size - 1);
+        uart->dma_overflows += lost;
+        uart->dma_reader = (uart->dma_reader + lost) & mask;
+        pending = uart->dma_size - 1;
     }
 
-    UartPico *pico = uart->pico;
-    while (!pio_sm_is_rx_fifo_empty(uart->pio, sm))
+    uart->dma_count += pending;
+    uint32_t decoded = pending;
+    while (pending--)
     {
-        uint32_t decode = uart->pio->rxf[sm];
-        decode >>= 33 - uart->rxBits;
-        uint32_t val = 0;
-        for (int b = 0; b < pico->bits + 1; b++)
-        {
-            val |= (decode & (1 << (b * 2))) ? 1 << b : 0;
-        }
-        int next_writer = uart->writer + 1;
-        if (next_writer == pico->fifoSize)
-        {
-            next_writer = 0;
-        }
-        if (next_writer != uart->reader)
-        {
-            uart->queue[uart->writer] = val & ((1 << pico->bits) - 1);
-            asm volatile("" ::: "memory");
-            uart->writer = next_writer;
-        }
+        UartRx_receive(uart, uart->dma_buffer[uart->dma_reader]);
+        uart->dma_reader = (uart->dma_reader + 1) & mask;
+    }
+
+    // The transfer count ran out; everything has been decoded, so re-arm from the current write address
+    if (!dma_channel_is_busy(uart->dma_chan))
+    {
+        uart->dma_count = 0;
+        dma_channel_set_trans_count(uart->dma_chan, UINT32_MAX, true);
+    }
+    if (decoded > 0)
+    {
+        TRACE_END(TRACE_STAGE_DMA, start); // Only the calls that found samples
     }
 }
 
+/**
+ * @brief Releases the DMA sample ring of a receiver.
+ */
+static void UartRx_freeDMABuffer(UartRx *uart)
+{
+#if !RP_PICO_STATIC_ALLOC
+    free(uart->dma_buffer);
+#endif
+    uart->dma_buffer = NULL;
+}
+
 /**
  * @brief Initializes the UART receiver with the specified parameters.
  *
@@ -107,24 +256,60 @@ void UartRx_handleIRQ()
  */
 UartRx *UartRx_init(UartPico *pico, uint8_t rx)
 {
+    // The ring indexes with a mask, so round the FIFO up to a power of two
+    size_t capacity = 1;
+    while (capacity < pico->fifoSize)
+    {
+        capacity <<= 1;
+    }
+
+#if RP_PICO_STATIC_ALLOC
+    UartRx *uart = NULL;
+    for (int i = 0; i < UART_RX_MAX_INSTANCES && !uart; i++)
+    {
+        if (uart_rx_pool[i].pico == NULL)
+        {
+            uart = &uart_rx_pool[i];
+        }
+    }
+    if (uart == NULL || capacity > UART_RX_STATIC_FIFO_SIZE)
+    {
+        return NULL; // Every receiver is in use, or the FIFO does not fit
+    }
+    uart->queue = uart_rx_queues[uart - uart_rx_pool];
+#else
     UartRx *uart = (UartRx *)malloc(sizeof(UartRx));
     if (uart == NULL)
     {
         return NULL;
     }
 
-    uart->pico = pico;
-    uart->rx = rx;
-    uart->reader = 0;
-    uart->writer = 0;
-
     // Allocate memory for the queue
-    uart->queue = (uint8_t *)malloc(pico->fifoSize * sizeof(uint8_t));
+    uart->queue = (uint8_t *)malloc(capacity * sizeof(uint8_t));
     if (uart->queue == NULL)
     {
         free(uart);
         return NULL;
     }
+#endif
+
+    uart->pico = pico;
+    uart->pio = NULL;
+    uart->rx = rx;
+    uart->tap = NULL;
+    uart->dma_chan = -1;
+    uart->dma_buffer = NULL;
+    uart->dma_size = 0;
+    uart->dma_reader = 0;
+    uart->dma_count = 0;
+    uart->dma_overflows = 0;
+    uart->line_length = 0;
+    uart->line_consume = 0;
+    uart->line_checksum = 0;
+    uart->line_truncations = 0;
+    uart->framing_errors = 0;
+    uart->line_time = 0;
+    RingBuffer_init(&uart->ring, uart->queue, capacity);
     return uart;
 }
 
@@ -132,7 +317,8 @@ UartRx *UartRx_init(UartPico *pico, uint8_t rx)
  * @brief Frees the memory allocated for a `UartRx` instance.
  *
  * This function deallocates the memory associated with the `UartRx` structure, ensuring that there are no memory leaks.
- * It should be called when the `UartRx` instance is no longer needed.
+ * It should be called when the `UartRx` instance is no longer needed. With `RP_PICO_STATIC_ALLOC` the
+ * receiver and its buffers go back to the static pool instead.
  *
  * @param uart Pointer to the `UartRx` instance to be freed.
  */
@@ -140,40 +326,147 @@ void UartRx_free(UartRx *uart)
 {
     if (uart)
     {
+        if (uart->dma_chan >= 0)
+        {
+            dma_channel_abort(uart->dma_chan);
+            dma_channel_unclaim(uart->dma_chan);
+            UartRx_freeDMABuffer(uart);
+        }
+        if (uart->pio)
+        {
+            pio_sm_set_enabled(uart->pio, uart->sm, false);
+            uart_rx_instances[pio_get_index(uart->pio)][uart->sm] = NULL;
+            UartPico_release_program(uart->pio, uart->sm, uart->offset);
+        }
+#if RP_PICO_STATIC_ALLOC
+        uart->pico = NULL; // Back to the pool
+#else
         if (uart->queue)
         {
             free(uart->queue);
         }
         free(uart);
+#endif
     }
 }
 
+#if UART_PIO_CLKDIV
 /**
- * @brief Activates the UART receiver (sets up the PIO, state machine, and interrupts).
+ * @brief Returns the state machine clock divider for `pico->baud`.
+ */
+static float UartRx_clkdiv(UartPico *pico)
+{
+    return (float)clock_get_hz(clk_sys) / (pico->baud * UART_PIO_CYCLES_PER_BIT);
+}
+#else
+/**
+ * @brief Returns the value kept in OSR: the length of the PIO half-bit loop at `pico->baud`.
+ */
+static uint32_t UartRx_halfBitDelay(UartPico *pico)
+{
+    return clock_get_hz(clk_sys) / (pico->baud * 2) - 7; // insns in PIO halfbit loop
+}
+#endif
+
+/**
+ * @brief Loads the RX program and configures the state machine without enabling it.
  *
  * @param uart Pointer to the UartRx structure.
  * @return 0 on success, non-zero on failure.
  */
-int UartRx_activate(UartRx *uart)
+static int UartRx_start(UartRx *uart)
 {
     UartPico *pico = uart->pico;
+#if UART_PIO_CLKDIV
+    uart->rxBits = pico->bits + 1; // Data bits and the first stop bit
+    int offset = UartPico_find_offset_for_program(&uart->pio, &uart->sm, pico->bits - 1, &pio_rx_program);
+#else
     uart->rxBits = 2 * (pico->bits + pico->stop + 1) - 1;
-    int sm; /**< State machine number */
-    int offset = UartPico_find_offset_for_program(pico, &uart->pio, &sm, uart->rxBits, &pio_rx_program);
+    int offset = UartPico_find_offset_for_program(&uart->pio, &uart->sm, uart->rxBits, &pio_rx_program);
+#endif
     if (offset < 0)
     {
         return 1; // Return error if the program offset was not found
     }
+    uart->offset = offset;
     gpio_init(uart->rx);             // Initialize the pin
     gpio_set_dir(uart->rx, GPIO_IN); // Set the pin as input
     gpio_pull_up(uart->rx);          // Enable internal pull-up resistor
 
-    pio_rx_program_init(uart->pio, sm, offset, uart->rx);
-    pio_sm_clear_fifos(uart->pio, sm); // Remove any existing data
+    pio_rx_program_init(uart->pio, uart->sm, offset, uart->rx, uart->rxBits);
+    pio_sm_clear_fifos(uart->pio, uart->sm); // Remove any existing data
 
+#if UART_PIO_CLKDIV
+    pio_sm_set_clkdiv(uart->pio, uart->sm, UartRx_clkdiv(pico));
+#else
     // Put phase divider into OSR w/o using add'l program memory
-    pio_sm_put_blocking(uart->pio, sm, clock_get_hz(clk_sys) / (pico->baud * 2) - 7 /* insns in PIO halfbit loop */);
-    pio_sm_exec(uart->pio, sm, pio_encode_pull(false, false));
+    pio_sm_put_blocking(uart->pio, uart->sm, UartRx_halfBitDelay(pico));
+    pio_sm_exec(uart->pio, uart->sm, pio_encode_pull(false, false));
+#endif
+    return 0;
+}
+
+/**
+ * @brief Re-times a running receiver to the current `pico->baud`.
+ *
+ * The state machine, its program and its FIFO mode (IRQ or DMA) are kept: the state machine is
+ * stopped, the half-bit delay is pulled into OSR again (or the clock divider is reloaded) and
+ * the program restarts at its first instruction. A frame being received during the switch is
+ * lost; see `UartRx_clear`.
+ *
+ * @param uart Pointer to the UartRx structure.
+ * @return 0 on success, non-zero if the receiver is not active.
+ */
+int UartRx_reconfigure(UartRx *uart)
+{
+    if (uart->pio == NULL)
+    {
+        return 1;
+    }
+    pio_sm_set_enabled(uart->pio, uart->sm, false);
+    pio_sm_restart(uart->pio, uart->sm);
+#if UART_PIO_CLKDIV
+    pio_sm_set_clkdiv(uart->pio, uart->sm, UartRx_clkdiv(uart->pico));
+    pio_sm_clkdiv_restart(uart->pio, uart->sm);
+#else
+    pio_sm_put_blocking(uart->pio, uart->sm, UartRx_halfBitDelay(uart->pico));
+    pio_sm_exec(uart->pio, uart->sm, pio_encode_pull(false, false));
+#endif
+    pio_sm_exec(uart->pio, uart->sm, pio_encode_jmp(uart->offset));
+    pio_sm_set_enabled(uart->pio, uart->sm, true);
+    return 0;
+}
+
+/**
+ * @brief Discards every character received so far, including a partially framed line.
+ *
+ * @param uart Pointer to the UartRx structure.
+ */
+void UartRx_clear(UartRx *uart)
+{
+    if (uart->dma_chan >= 0)
+    {
+        UartRx_drainDMA(uart);
+    }
+    RingBuffer_consume(&uart->ring, RingBuffer_available(&uart->ring));
+    uart->line_length = 0;
+    uart->line_consume = 0;
+    uart->line_checksum = 0;
+}
+
+/**
+ * @brief Activates the UART receiver (sets up the PIO, state machine, and interrupts).
+ *
+ * @param uart Pointer to the UartRx structure.
+ * @return 0 on success, non-zero on failure.
+ */
+int UartRx_activate(UartRx *uart)
+{
+    if (UartRx_start(uart) != 0)
+    {
+        return 1;
+    }
+    int sm = uart->sm;
 
     // Enable interrupts on rxfifo
     switch (sm)
@@ -192,7 +485,7 @@ int UartRx_activate(UartRx *uart)
         break;
     }
 
-    uart_rx_instances[sm] = uart; // Register the instance in the static array
+    uart_rx_instances[pio_get_index(uart->pio)][sm] = uart; // Register the instance in the static array
 
     uint8_t irqno = pio_get_index(uart->pio) == 0 ? PIO0_IRQ_0 : PIO1_IRQ_0;
     irq_set_exclusive_handler(irqno, UartRx_handleIRQ);
@@ -204,6 +497,94 @@ int UartRx_activate(UartRx *uart)
     return 0;
 }
 
+/**
+ * @brief Activates the UART receiver in DMA mode.
+ *
+ * Instead of raising an interrupt for every character, a DMA channel paced by the PIO RX DREQ
+ * copies raw samples into a ring of `samples` words. The samples are decoded in batches whenever
+ * `UartRx_available`, `UartRx_read` or `UartRx_readLine` is called, so those functions keep
+ * working unchanged. The ring must be large enough to cover the longest gap between two calls
+ * (e.g. 256 samples is about 22 ms at 115200 baud).
+ *
+ * @param uart Pointer to the UartRx structure.
+ * @param samples Number of raw samples in the DMA ring; must be a power of two between 2 and 8192.
+ * @return 0 on success, non-zero on failure.
+ */
+int UartRx_activateDMA(UartRx *uart, size_t samples)
+{
+    uint ring_bits = 0; /**< log2 of the ring size in bytes, as required by the DMA ring wrap */
+    while ((1u << ring_bits) < samples)
+    {
+        ring_bits++;
+    }
+    ring_bits += 2; // Each sample is a 32-bit word
+    if (samples < 2 || (samples & (samples - 1)) != 0 || ring_bits > 15)
+    {
+        return 1; // Return error if the ring cannot be wrapped by the DMA engine
+    }
+
+#if RP_PICO_STATIC_ALLOC
+    if (samples > UART_RX_STATIC_DMA_SAMPLES)
+    {
+        return 1; // Larger than the static ring
+    }
+    uart->dma_buffer = uart_rx_dma_buffers[uart - uart_rx_pool];
+#else
+    // The DMA ring wrap requires the buffer to be aligned to its own size
+    size_t bytes = samples * sizeof(uint32_t);
+    uart->dma_buffer = (uint32_t *)aligned_alloc(bytes, bytes);
+    if (uart->dma_buffer == NULL)
+    {
+        return 1;
+    }
+#endif
+
+    if (UartRx_start(uart) != 0)
+    {
+        UartRx_freeDMABuffer(uart);
+        return 1;
+    }
+
+    uart->dma_chan = dma_claim_unused_channel(false);
+    if (uart->dma_chan < 0)
+    {
+        UartPico_release_program(uart->pio, uart->sm, uart->offset);
+        uart->pio = NULL;
+        UartRx_freeDMABuffer(uart);
+        return 1;
+    }
+    uart->dma_size = samples;
+    uart->dma_reader = 0;
+    uart->dma_count = 0;
+
+    dma_channel_config c = dma_channel_get_default_config(uart->dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);                          // Always read the SM RX FIFO
+    channel_config_set_write_increment(&c, true);                          // Walk the sample ring
+    channel_config_set_ring(&c, true, ring_bits);                          // Wrap the write address at the ring size
+    channel_config_set_dreq(&c, pio_get_dreq(uart->pio, uart->sm, false)); // Paced by the RX FIFO
+    dma_channel_configure(uart->dma_chan, &c, uart->dma_buffer, &uart->pio->rxf[uart->sm], UINT32_MAX, true);
+
+    gpio_set_inover(uart->rx, false);
+    pio_sm_set_enabled(uart->pio, uart->sm, true);
+
+    return 0;
+}
+
+/**
+ * @brief Releases the ring bytes held by the line view returned by the previous read.
+ *
+ * @param uart Pointer to the UartRx structure.
+ */
+static inline void UartRx_releaseLine(UartRx *uart)
+{
+    if (uart->line_consume)
+    {
+        RingBuffer_consume(&uart->ring, uart->line_consume);
+        uart->line_consume = 0;
+    }
+}
+
 /**
  * @brief Checks if data is available in the UART RX FIFO.
  *
@@ -212,69 +593,189 @@ int UartRx_activate(UartRx *uart)
  */
 int UartRx_available(UartRx *uart)
 {
-    return (uart->writer - uart->reader) % uart->pico->fifoSize;
+    if (uart->dma_chan >= 0)
+    {
+        UartRx_drainDMA(uart);
+    }
+    return RingBuffer_available(&uart->ring) - uart->line_consume;
 }
 
 /**
- * @brief Reads data from the UART RX FIFO until a terminator is found.
+ * @brief Reads all data currently held in the UART RX FIFO.
  *
  * @param uart Pointer to the UartRx structure.
- * @param terminator Character that marks the end of the string.
- * @return The string of data received from the UART.
+ * @return A pointer to a static, null-terminated buffer with the data received from the UART.
  */
 char *UartRx_read(UartRx *uart)
 {
-    UartPico *pico = uart->pico;
     static char result[UART_MAX_BUFFER_LENGTH];
-    int idx = 0;
-    while (uart->reader != uart->writer)
+    size_t idx = 0;
+    if (uart->dma_chan >= 0)
+    {
+        UartRx_drainDMA(uart);
+    }
+    UartRx_releaseLine(uart);
+
+    const uint8_t *span;
+    size_t count;
+    while (idx < UART_MAX_BUFFER_LENGTH - 1 && (count = RingBuffer_peek(&uart->ring, &span)) > 0)
     {
-        char c = (char)uart->queue[uart->reader];
-        uart->reader = (uart->reader + 1) % pico->fifoSize; // Move the reader pointer
-        result[idx++] = c;
+        if (count > UART_MAX_BUFFER_LENGTH - 1 - idx)
+        {
+            count = UART_MAX_BUFFER_LENGTH - 1 - idx;
+        }
+        memcpy(&result[idx], span, count);
+        RingBuffer_consume(&uart->ring, count);
+        idx += count;
     }
+    result[idx] = '\0';
     return result;
 }
 
-static char _result[UART_MAX_BUFFER_LENGTH]; // Store the result (the line)
-static int _result_idx = 0;                  // Track the position in the result buffer
+/**
+ * @brief Looks for the end of a line in a span and XORs the characters before it.
+ *
+ * This replaces a `memchr` for '\n': the span is scanned once, and the checksum comes for free.
+ *
+ * @param span First character to scan.
+ * @param count Number of characters in the span.
+ * @param checksum XOR of the characters scanned so far; updated with the characters before '\n'.
+ * @return Pointer to the '\n', or NULL if the span holds none.
+ */
+static inline const uint8_t *UartRx_scanLine(const uint8_t *span, size_t count, uint8_t *checksum)
+{
+    uint8_t x = *checksum;
+    for (const uint8_t *end = span + count; span < end; span++)
+    {
+        if (*span == '\n')
+        {
+            *checksum = x;
+            return span;
+        }
+        x ^= *span;
+    }
+    *checksum = x;
+    return NULL;
+}
 
 /**
- * @brief Reads characters from the UART buffer until a newline ('\n') is encountered.
+ * @brief Reads the next complete line without copying it when possible.
  *
- * This function processes available characters in the UART buffer incrementally,
- * appending them to a static result buffer. Once a newline character ('\n') is
- * encountered, the result buffer is terminated and returned. If no newline is found,
- * the function returns NULL, and you can call it repeatedly to continue processing
- * characters until the newline is found.
+ * If the whole line is contiguous in the receive ring, the returned view points straight into
+ * the ring and those bytes are only released on the next read call. Lines that wrap around the
+ * end of the ring, or that arrive over several calls, are collected in the receiver's own line
+ * buffer; characters beyond `UART_MAX_BUFFER_LENGTH` are dropped and the line is counted in
+ * `line_truncations`. Each receiver keeps its own framing state, so several receivers can be read
+ * independently.
  *
- * @param uart Pointer to a UartRx structure, which contains the UART buffer and read/write pointers.
- * @return A pointer to a static buffer holding the collected string, or NULL if no newline is found yet.
+ * @param uart Pointer to the UartRx structure.
+ * @param line On success, receives the view of the line (including the terminating '\n') and its checksum.
+ * @return true if a complete line is available, false otherwise.
  */
-char *UartRx_readLine(UartRx *uart)
+bool UartRx_readSentence(UartRx *uart, UartRxLine *line)
 {
-    UartPico *pico = uart->pico;
+    if (uart->dma_chan >= 0)
+    {
+        UartRx_drainDMA(uart);
+    }
+    UartRx_releaseLine(uart);
+    TRACE_BEGIN(start);
 
-    // Process available characters in the buffer
-    while (uart->reader != uart->writer)
+    // Process available characters in the buffer, one contiguous span at a time
+    const uint8_t *span;
+    size_t count;
+    while ((count = RingBuffer_peek(&uart->ring, &span)) > 0)
     {
-        char c = (char)uart->queue[uart->reader];
-        uart->reader = (uart->reader + 1) % pico->fifoSize; // Move the reader pointer
+        // The checksum covers the characters the line will hold: all of them when it is handed
+        // out in place, only those that fit when it is collected in the line buffer
+        size_t room = UART_MAX_BUFFER_LENGTH - uart->line_length;
+        size_t scan = count < room ? count : room;
+        uint8_t checksum = uart->line_checksum;
+        const uint8_t *eol = UartRx_scanLine(span, scan, &checksum);
+        if (!eol && scan < count)
+        {
+            uint8_t whole = checksum;
+            eol = UartRx_scanLine(span + scan, count - scan, &whole);
+            if (eol && uart->line_length == 0)
+            {
+                checksum = whole;
+            }
+        }
+        size_t length = eol ? (size_t)(eol - span) + 1 : count;
 
-        // Append the character to the result buffer
-        if (_result_idx < UART_MAX_BUFFER_LENGTH - 1)
+        // The line starts and ends inside this span: hand out a view of the ring itself
+        if (eol && uart->line_length == 0)
         {
-            _result[_result_idx++] = c;
+            uart->line_consume = length;
+            line->data = (const char *)span;
+            line->length = length;
+            line->checksum = checksum;
+            TRACE_END(TRACE_STAGE_LINE, start);
+            return true;
         }
 
-        // If a newline is encountered, terminate the string and return it
-        if (c == '\n')
+        // Otherwise collect the span (or as much as fits) in the line buffer
+        size_t copy = length < room ? length : room;
+        if (copy > 0 && copy == room && (copy < length || !eol))
         {
-            _result[_result_idx] = '\0'; // Null-terminate the string
-            _result_idx = 0;             // Reset for the next line
-            return _result;              // Return the collected line
+            uart->line_truncations++; // Counted once, when the buffer fills up before the line ends
+        }
+        memcpy(&uart->line[uart->line_length], span, copy);
+        uart->line_length += copy;
+        uart->line_checksum = checksum;
+        RingBuffer_consume(&uart->ring, length);
+
+        if (eol)
+        {
+            line->data = uart->line;
+            line->length = uart->line_length;
+            line->checksum = uart->line_checksum;
+            uart->line_length = 0; // Reset for the next line
+            uart->line_checksum = 0;
+            TRACE_END(TRACE_STAGE_LINE, start);
+            return true;
         }
     }
 
-    return NULL;
+    return false;
+}
+
+/**
+ * @brief Returns a line view as a null-terminated string in the receiver's line buffer.
+ *
+ * @param uart Pointer to the UartRx structure the line was read from.
+ * @param line The view returned by `UartRx_readSentence`.
+ * @return A pointer to the receiver's null-terminated line buffer.
+ */
+char *UartRx_lineString(UartRx *uart, const UartRxLine *line)
+{
+    size_t length = line->length < UART_MAX_BUFFER_LENGTH - 1 ? line->length : UART_MAX_BUFFER_LENGTH - 1;
+    if (line->data != uart->line)
+    {
+        memcpy(uart->line, line->data, length); // Move an in-place line out of the ring
+    }
+    uart->line[length] = '\0'; // Null-terminate the string
+    return uart->line;
+}
+
+/**
+ * @brief Reads characters from the UART buffer until a newline ('\n') is encountered.
+ *
+ * This function processes available characters in the UART buffer incrementally,
+ * appending them to the receiver's line buffer. Once a newline character ('\n') is
+ * encountered, the line is terminated and returned. If no newline is found,
+ * the function returns NULL, and you can call it repeatedly to continue processing
+ * characters until the newline is found.
+ *
+ * @param uart Pointer to a UartRx structure, which contains the UART buffer and read/write pointers.
+ * @return A pointer to the receiver's null-terminated line buffer, or NULL if no newline is found yet.
+ */
+char *UartRx_readLine(UartRx *uart)
+{
+    UartRxLine line;
+    if (!UartRx_readSentence(uart, &line))
+    {
+        return NULL;
+    }
+    return UartRx_lineString(uart, &line); // Return the collected line
 }
@@ -2,14 +2,41 @@
 #define UART_RX_H
 
 #include "uart_pico.h"
+#include "ring_buffer.h"
 
 #define UART_MAX_BUFFER_LENGTH 256
 
+// Static pools (RP_PICO_STATIC_ALLOC only): receivers, and the largest FIFO and DMA ring of each
+#ifndef UART_RX_MAX_INSTANCES
+#define UART_RX_MAX_INSTANCES 2
+#endif
+#ifndef UART_RX_STATIC_FIFO_SIZE
+#define UART_RX_STATIC_FIFO_SIZE 128 // Largest `UartPico.fifoSize` (power of two)
+#endif
+#ifndef UART_RX_STATIC_DMA_SAMPLES
+#define UART_RX_STATIC_DMA_SAMPLES 256 // Largest `samples` of UartRx_activateDMA (power of two)
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+    /**
+     * @brief Read-only view of one received line, including its terminating '\n'.
+     *
+     * The view points either straight into the receive ring or into the receiver's line buffer
+     * and is not null-terminated. It stays valid until the next read call on the same receiver.
+     * The XOR of the characters is accumulated while the line is framed, so protocols with an
+     * XOR checksum (e.g. NMEA) can validate the line without scanning it again.
+     */
+    typedef struct
+    {
+        const char *data; /**< First character of the line */
+        size_t length;    /**< Number of characters in the line */
+        uint8_t checksum; /**< XOR of every character of the line except the terminating '\n' */
+    } UartRxLine;
+
     /**
      * @brief Structure representing a UART receiver.
      */
@@ -19,9 +46,26 @@ extern "C"
         PIO pio;         /**< Pointer to the PIO instance */
         int rx;          /**< Pin number for receiving data */
         int rxBits;      /**< Number of bits to read per frame */
-        uint8_t *queue;  /**< Pointer to the FIFO buffer */
-        uint32_t reader; /**< Reader pointer for FIFO */
-        uint32_t writer; /**< Writer pointer for FIFO */
+        int sm;          /**< State machine number */
+        int offset;      /**< Offset of the RX program in instruction memory */
+        uint8_t *queue;  /**< Storage of the FIFO buffer */
+        RingBuffer ring; /**< FIFO of decoded characters (IRQ/DMA drain producer, reader consumer) */
+        RingBuffer *tap; /**< Second FIFO that gets a copy of every decoded character, or NULL (see uart_bridge.h) */
+
+        int dma_chan;           /**< DMA channel in DMA receive mode, or -1 in IRQ mode */
+        uint32_t *dma_buffer;   /**< Ring of raw PIO samples written by the DMA channel */
+        uint32_t dma_size;      /**< Number of samples in the DMA ring (power of two) */
+        uint32_t dma_reader;    /**< Index of the next sample to decode */
+        uint32_t dma_count;     /**< Samples decoded since the DMA channel was last armed */
+        uint32_t dma_overflows; /**< Samples lost because the DMA ring wrapped before decoding */
+
+        char line[UART_MAX_BUFFER_LENGTH]; /**< Line buffer for lines that wrap around the ring */
+        size_t line_length;                /**< Number of characters collected in `line` */
+        size_t line_consume;               /**< Ring bytes still held by the last in-place line view */
+        uint8_t line_checksum;             /**< XOR of the characters collected in `line` */
+        uint32_t line_truncations;         /**< Lines cut at `UART_MAX_BUFFER_LENGTH` characters */
+        uint32_t framing_errors;           /**< Frames dropped for a low stop bit (UART_PIO_CLKDIV only) */
+        volatile uint32_t line_time;       /**< time_us_32() when the last '\n' was decoded into the ring */
     } UartRx;
 
     /**
@@ -34,9 +78,14 @@ extern "C"
     UartRx *UartRx_init(UartPico *pico, uint8_t rx);
     void UartRx_free(UartRx *uart);
     int UartRx_activate(UartRx *uart);
+    int UartRx_activateDMA(UartRx *uart, size_t samples);
+    int UartRx_reconfigure(UartRx *uart);
+    void UartRx_clear(UartRx *uart);
     int UartRx_available(UartRx *uart);
     char *UartRx_read(UartRx *uart);
     char *UartRx_readLine(UartRx *uart);
+    bool UartRx_readSentence(UartRx *uart, UartRxLine *line);
+    char *UartRx_lineString(UartRx *uart, const UartRxLine *line);
     void UartRx_handleIRQ(void);
 
 #ifdef __cplusplus
@@ -0,0 +1,24 @@
+#include "uart_rx_decode.h"
+#include <pico/platform.h>
+
+#if UART_RX_DECODE_TABLE_BITS
+
+// Each bit pair of the index contributes its low (even) bit to the entry, so the table is
+// generated by recursively expanding one pair at a time: index = p0 + 4 * p1 + 16 * p2 + ...
+#define UART_RX_P1(v) (v), (v) + 1, (v), (v) + 1
+#define UART_RX_P2(v) UART_RX_P1(v), UART_RX_P1((v) + 2), UART_RX_P1(v), UART_RX_P1((v) + 2)
+#define UART_RX_P3(v) UART_RX_P2(v), UART_RX_P2((v) + 4), UART_RX_P2(v), UART_RX_P2((v) + 4)
+#define UART_RX_P4(v) UART_RX_P3(v), UART_RX_P3((v) + 8), UART_RX_P3(v), UART_RX_P3((v) + 8)
+#define UART_RX_P5(v) UART_RX_P4(v), UART_RX_P4((v) + 16), UART_RX_P4(v), UART_RX_P4((v) + 16)
+#define UART_RX_P6(v) UART_RX_P5(v), UART_RX_P5((v) + 32), UART_RX_P5(v), UART_RX_P5((v) + 32)
+#define UART_RX_P7(v) UART_RX_P6(v), UART_RX_P6((v) + 64), UART_RX_P6(v), UART_RX_P6((v) + 64)
+#define UART_RX_P8(v) UART_RX_P7(v), UART_RX_P7((v) + 128), UART_RX_P7(v), UART_RX_P7((v) + 128)
+
+#if UART_RX_DECODE_TABLE_BITS == 8
+// Small enough to keep in RAM, so a lookup from the RX interrupt never waits on an XIP cache miss
+const uint8_t __not_in_flash("uart_rx") uart_rx_decode_table[256] = {UART_RX_P4(0)};
+#else
+const uint8_t uart_rx_decode_table[65536] = {UART_RX_P8(0)};
+#endif
+
+#endif // UART_RX_DECODE_TABLE_BITS
@@ -0,0 +1,73 @@
+#ifndef UART_RX_DECODE_H
+#define UART_RX_DECODE_H
+
+#include <stdint.h>
+
+/**
+ * Selects how UartRx turns a raw PIO sample into a character:
+ *  - 0:  walk every bit pair in a loop (the original decoder)
+ *  - 8:  256-entry bit-compaction table, 4 data bits per lookup (kept in RAM)
+ *  - 16: 65536-entry bit-compaction table, 8 data bits per lookup (kept in flash)
+ */
+#ifndef UART_RX_DECODE_TABLE_BITS
+#define UART_RX_DECODE_TABLE_BITS 8
+#endif
+
+#if UART_RX_DECODE_TABLE_BITS != 0 && UART_RX_DECODE_TABLE_BITS != 8 && UART_RX_DECODE_TABLE_BITS != 16
+#error "UART_RX_DECODE_TABLE_BITS must be 0, 8 or 16"
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if UART_RX_DECODE_TABLE_BITS
+    /**
+     * @brief Bit-compaction table: entry `i` holds the even bits of `i` packed together.
+     */
+    extern const uint8_t uart_rx_decode_table[1u << UART_RX_DECODE_TABLE_BITS];
+#endif
+
+    /**
+     * @brief Decodes an aligned half-bit sample word by walking every bit pair.
+     *
+     * @param decode Sample word shifted so that the first data bit sits at bit 0.
+     * @param bits Number of data bits per frame.
+     * @return The decoded character.
+     */
+    static inline uint32_t UartRx_decodeLoop(uint32_t decode, int bits)
+    {
+        uint32_t val = 0;
+        for (int b = 0; b < bits + 1; b++)
+        {
+            val |= (decode & (1 << (b * 2))) ? 1 << b : 0;
+        }
+        return val & ((1 << bits) - 1);
+    }
+
+#if UART_RX_DECODE_TABLE_BITS
+    /**
+     * @brief Decodes an aligned half-bit sample word with the bit-compaction table.
+     *
+     * @param decode Sample word shifted so that the first data bit sits at bit 0.
+     * @param bits Number of data bits per frame.
+     * @return The decoded character.
+     */
+    static inline uint32_t UartRx_decodeTable(uint32_t decode, int bits)
+    {
+        uint32_t val = 0;
+        for (int shift = 0; shift < bits; shift += UART_RX_DECODE_TABLE_BITS / 2)
+        {
+            val |= (uint32_t)uart_rx_decode_table[decode & ((1u << UART_RX_DECODE_TABLE_BITS) - 1)] << shift;
+            decode >>= UART_RX_DECODE_TABLE_BITS;
+        }
+        return val & ((1 << bits) - 1);
+    }
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UART_RX_DECODE_H
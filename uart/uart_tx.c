@@ -1,11 +1,63 @@
 #include "uart_pico.h"
 #include "uart_tx.h"
 #include <hardware/clocks.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+#include <hardware/sync.h>
 
 // Constants for the PIO program to handle UART transmission
+#if UART_PIO_CLKDIV
 #define pio_tx_wrap 5
 #define pio_tx_wrap_target 0
+#else
+#define pio_tx_wrap 5
+#define pio_tx_wrap_target 0
+#endif
+
+// Transmitters in asynchronous mode, indexed by DMA channel
+static UartTx *uart_tx_instances[NUM_DMA_CHANNELS];
+
+// Guards the queues against the DMA interrupt, which may be taken on the other core
+static spin_lock_t *uart_tx_lock;
+
+#if RP_PICO_STATIC_ALLOC
+// Transmitters and their buffers; a slot is free while its `pico` is NULL
+static UartTx uart_tx_pool[UART_TX_MAX_INSTANCES];
+static uint8_t uart_tx_queues[UART_TX_MAX_INSTANCES][UART_TX_STATIC_QUEUE_SIZE];
+static uint32_t uart_tx_dma_words[UART_TX_MAX_INSTANCES][UART_TX_DMA_BATCH];
+#endif
+
+#if UART_PIO_CLKDIV
+/**
+ * @brief PIO TX program instructions (clock divider, UART_PIO_CYCLES_PER_BIT cycles per bit).
+ *
+ * The frame word has the layout of the words the clock-divider RX program pushes: the low 22
+ * bits are discarded, then the start bit (bit 22) and the data bits are held for 8 cycles each;
+ * autopull refills the OSR after the last data bit, so anything above it is ignored. The stop
+ * bits are side-set: the `mov` starts them and the `jmp y--` loop, loaded with ISR, makes the
+ * stop time `pico->stop` bits including the `set` and `out` of the next frame. A frame thus
+ * takes exactly 1 + bits + stop bits, as fast as the RX program receives them, and a received
+ * 8-bit frame can be written to this FIFO unchanged (see uart_bridge.h). Waiting for data, the
+ * state machine stalls on the `out` with the line high.
+ */
+static const uint16_t pio_tx_program_instructions[] = {
+    0xe028, //  0: set    x, 8
+    0x7876, //  1: out    null, 22        side 1
+    0x6601, //  2: out    pins, 1         [6]
+    0x0042, //  3: jmp    x--, 2
+    0xb846, //  4: mov    y, isr          side 1
+    0x0085, //  5: jmp    y--, 5
+};
 
+/**
+ * @brief Structure representing the PIO TX program.
+ */
+static const struct pio_program pio_tx_program = {
+    .instructions = pio_tx_program_instructions,
+    .length = 6,
+    .origin = -1,
+};
+#else
 /**
  * @brief PIO TX program instructions to handle UART transmission
  */
@@ -26,6 +78,7 @@ static const struct pio_program pio_tx_program = {
     .length = 6,
     .origin = -1,
 };
+#endif
 
 /**
  * @brief Initializes the PIO (Programmable Input/Output) state machine to handle UART transmission.
@@ -38,8 +91,9 @@ static const struct pio_program pio_tx_program = {
  * @param sm  State machine number used in PIO.
  * @param offset Offset to the PIO program instructions to be executed.
  * @param pin_tx TX pin used for UART transmission.
+ * @param bits Data bits per frame (sets the autopull threshold of the clock-divider program).
  */
-static inline void pio_tx_program_init(PIO pio, uint sm, uint offset, uint pin_tx)
+static inline void pio_tx_program_init(PIO pio, uint sm, uint offset, uint pin_tx, uint bits)
 {
     // Set the pin to high initially
     pio_sm_set_set_pins(pio, sm, pin_tx, 1);
@@ -52,7 +106,13 @@ static inline void pio_tx_program_init(PIO pio, uint sm, uint offset, uint pin_t
     sm_config_set_wrap(&c, offset + pio_tx_wrap_target, offset + pio_tx_wrap);
 
     sm_config_set_sideset(&c, 2, true, false);     // Configure side-set (start/stop bits)
+#if UART_PIO_CLKDIV
+    // Autopull once the start and data bits are out: 22 discarded bits, start bit, data bits
+    sm_config_set_out_shift(&c, true, true, 23 + bits);
+#else
+    (void)bits;
     sm_config_set_out_shift(&c, true, false, 32);  // Shift data out to TX pin
+#endif
     sm_config_set_out_pins(&c, pin_tx, 1);         // Set which pin to use for output (TX pin)
     sm_config_set_sideset_pins(&c, pin_tx);        // Configure the side-set pins (for timing control)
     sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX); // Join the state machine’s FIFO to TX
@@ -74,33 +134,102 @@ static inline void pio_tx_program_init(PIO pio, uint sm, uint offset, uint pin_t
  */
 UartTx *UartTx_init(UartPico *pico, uint8_t tx)
 {
+#if RP_PICO_STATIC_ALLOC
+    UartTx *uart = NULL;
+    for (int i = 0; i < UART_TX_MAX_INSTANCES && !uart; i++)
+    {
+        if (uart_tx_pool[i].pico == NULL)
+        {
+            uart = &uart_tx_pool[i];
+        }
+    }
+    if (uart == NULL)
+    {
+        return NULL; // Every transmitter is in use
+    }
+#else
     // Allocate memory for the UART object
     UartTx *uart = (UartTx *)malloc(sizeof(UartTx));
     if (uart == NULL)
     {                // Check if memory allocation was successful
         return NULL; // Return NULL if allocation failed
     }
-    uart->pico = pico; // Store the reference to the UartPico object
-    uart->tx = tx;     // Set the TX pin
-    return uart;       // Return the initialized UART object
+#endif
+    uart->pico = pico;        // Store the reference to the UartPico object
+    uart->pio = NULL;         // No state machine claimed until activation
+    uart->tx = tx;            // Set the TX pin
+    uart->dma_chan = -1;      // Blocking mode until UartTx_activateDMA is called
+    uart->queue = NULL;       // No transmit queue in blocking mode
+    uart->dma_words = NULL;   // No DMA staging buffer in blocking mode
+    uart->dma_batch = 0;      // Nothing in flight
+    uart->busy = false;       // Idle
+    uart->callback = NULL;    // No completion callback
+    uart->callback_ctx = NULL;
+    return uart; // Return the initialized UART object
 }
 
 /**
  * @brief Frees the memory allocated for a `UartTx` instance.
  *
  * This function deallocates the memory associated with the `UartTx` structure, ensuring that there are no memory leaks.
- * It should be called when the `UartTx` instance is no longer needed.
+ * It should be called when the `UartTx` instance is no longer needed. With `RP_PICO_STATIC_ALLOC` the
+ * transmitter and its buffers go back to the static pool instead.
  *
  * @param uart Pointer to the `UartTx` instance to be freed.
  */
 void UartTx_free(UartTx *uart)
 {
     if (uart != NULL)
-    {               // Check if the pointer is not NULL
+    { // Check if the pointer is not NULL
+        if (uart->dma_chan >= 0)
+        {
+            dma_channel_set_irq0_enabled(uart->dma_chan, false);
+            dma_channel_abort(uart->dma_chan);
+            uart_tx_instances[uart->dma_chan] = NULL;
+            dma_channel_unclaim(uart->dma_chan);
+        }
+        if (uart->pio != NULL)
+        {
+            UartPico_release_program(uart->pio, uart->sm, uart->offset); // Stop the state machine and release the program
+        }
+#if RP_PICO_STATIC_ALLOC
+        uart->pico = NULL; // Back to the pool, with its buffers
+#else
+        free(uart->dma_words); // Transmit queue and staging buffer (NULL in blocking mode)
+        free(uart->queue);
         free(uart); // Free the memory occupied by the UART instance
+#endif
     }
 }
 
+#if UART_PIO_CLKDIV
+/**
+ * @brief Returns the state machine clock divider for `pico->baud`.
+ */
+static float UartTx_clkdiv(UartPico *pico)
+{
+    return (float)clock_get_hz(clk_sys) / (pico->baud * UART_PIO_CYCLES_PER_BIT);
+}
+
+/**
+ * @brief Returns the value kept in ISR: the length of the stop bit loop for `pico->stop` stop bits.
+ *
+ * The `mov`, `set` and `out` around the loop take one cycle each and the loop one more than ISR.
+ */
+static uint32_t UartTx_stopDelay(UartPico *pico)
+{
+    return UART_PIO_CYCLES_PER_BIT * pico->stop - 4;
+}
+#else
+/**
+ * @brief Returns the value kept in ISR: the length of the PIO bit loop at `pico->baud`.
+ */
+static uint32_t UartTx_bitDelay(UartPico *pico)
+{
+    return clock_get_hz(clk_sys) / pico->baud - 2;
+}
+#endif
+
 /**
  * @brief Activates the UART transmission functionality.
  *
@@ -115,25 +244,38 @@ void UartTx_free(UartTx *uart)
 int UartTx_activate(UartTx *uart)
 {
     UartPico *pico = uart->pico;
+#if UART_PIO_CLKDIV
+    int txBits = pico->bits; // Start bit and data bits (x + 1 loops); the stop bits are timed from ISR
+#else
     int txBits = pico->bits + pico->stop + 1; // Calculate total number of bits for the UART frame
-    int offset = UartPico_find_offset_for_program(pico, &uart->pio, &uart->sm, txBits, &pio_tx_program);
+#endif
+    int offset = UartPico_find_offset_for_program(&uart->pio, &uart->sm, txBits, &pio_tx_program);
     if (offset < 0)
     {
         return 1; // Return error if the program offset was not found
     }
+    uart->offset = offset;
 
     gpio_init(uart->tx);              // Initialize the TX pin
     gpio_set_dir(uart->tx, GPIO_OUT); // Set TX pin direction to output
     gpio_pull_up(uart->tx);           // Enable pull-up resistor for TX pin
 
     // Initialize the PIO program for UART TX
-    pio_tx_program_init(uart->pio, uart->sm, offset, uart->tx);
+    pio_tx_program_init(uart->pio, uart->sm, offset, uart->tx, pico->bits);
     pio_sm_clear_fifos(uart->pio, uart->sm); // Clear any existing data in PIO FIFO
 
     // Set the baud rate and configure the PIO to start transmission
-    pio_sm_put_blocking(uart->pio, uart->sm, clock_get_hz(clk_sys) / pico->baud - 2);
+#if UART_PIO_CLKDIV
+    pio_sm_set_clkdiv(uart->pio, uart->sm, UartTx_clkdiv(pico));
+    pio_sm_put_blocking(uart->pio, uart->sm, UartTx_stopDelay(pico));
     pio_sm_exec(uart->pio, uart->sm, pio_encode_pull(false, false));    // Pull instruction for ISR
     pio_sm_exec(uart->pio, uart->sm, pio_encode_mov(pio_isr, pio_osr)); // Move instruction for ISRs
+    pio_sm_exec(uart->pio, uart->sm, pio_encode_out(pio_null, 32));     // Empty OSR for the first frame
+#else
+    pio_sm_put_blocking(uart->pio, uart->sm, UartTx_bitDelay(pico));
+    pio_sm_exec(uart->pio, uart->sm, pio_encode_pull(false, false));    // Pull instruction for ISR
+    pio_sm_exec(uart->pio, uart->sm, pio_encode_mov(pio_isr, pio_osr)); // Move instruction for ISRs
+#endif
 
     gpio_set_outover(uart->tx, false);             // Disable output overdrive for the TX pin
     pio_sm_set_enabled(uart->pio, uart->sm, true); // Enable the PIO state machine
@@ -142,40 +284,387 @@ int UartTx_activate(UartTx *uart)
 }
 
 /**
- * @brief Writes a single byte to the UART TX FIFO.
+ * @brief Re-times a running transmitter to the current `pico->baud`.
  *
- * This function sends a byte of data to the UART TX FIFO. It checks whether the FIFO is full, and if not, it
- * sends the byte. If the FIFO is full, the function simply returns without sending the byte, allowing other functions
- * to retry later.
+ * Everything already queued is sent at the old rate first (see `UartTx_flush`). The state
+ * machine and its program are kept: the bit delay (or the clock divider) is reloaded the same
+ * way `UartTx_activate` loads it, and the program restarts at its first instruction.
+ *
+ * @param uart Pointer to the `UartTx` instance.
+ *
+ * @return 0 on success, or 1 if the transmitter is not active.
+ */
+int UartTx_reconfigure(UartTx *uart)
+{
+    if (uart->pio == NULL)
+    {
+        return 1;
+    }
+    UartTx_flush(uart);
+    pio_sm_set_enabled(uart->pio, uart->sm, false);
+    pio_sm_restart(uart->pio, uart->sm);
+#if UART_PIO_CLKDIV
+    pio_sm_set_clkdiv(uart->pio, uart->sm, UartTx_clkdiv(uart->pico));
+    pio_sm_clkdiv_restart(uart->pio, uart->sm);
+    pio_sm_put_blocking(uart->pio, uart->sm, UartTx_stopDelay(uart->pico));
+    pio_sm_exec(uart->pio, uart->sm, pio_encode_pull(false, false));    // Pull instruction for ISR
+    pio_sm_exec(uart->pio, uart->sm, pio_encode_mov(pio_isr, pio_osr)); // Move instruction for ISRs
+    pio_sm_exec(uart->pio, uart->sm, pio_encode_out(pio_null, 32));     // Empty OSR for the next frame
+#else
+    pio_sm_put_blocking(uart->pio, uart->sm, UartTx_bitDelay(uart->pico));
+    pio_sm_exec(uart->pio, uart->sm, pio_encode_pull(false, false));    // Pull instruction for ISR
+    pio_sm_exec(uart->pio, uart->sm, pio_encode_mov(pio_isr, pio_osr)); // Move instruction for ISRs
+#endif
+    pio_sm_exec(uart->pio, uart->sm, pio_encode_jmp(uart->offset));
+    pio_sm_set_enabled(uart->pio, uart->sm, true);
+    return 0;
+}
+
+/**
+ * @brief Formats a byte as the word the PIO TX program shifts out (start bit, data, stop bits).
  *
  * @param uart Pointer to the `UartTx` instance.
  * @param c The byte to be transmitted over UART.
  */
-void UartTx_write(UartTx *uart, uint8_t c)
+static inline uint32_t UartTx_frame(UartTx *uart, uint8_t c)
 {
-    UartPico *pico = uart->pico;
     uint32_t val = c;
+#if UART_PIO_CLKDIV
+    (void)uart;
+    return val << 23; // Start bit (low) in bit 22, above the 22 bits the program discards; stop bits are side-set
+#else
+    val |= 7 << uart->pico->bits; // Set the bits according to the specified UART configuration
+    return val << 1;              // Shift the byte to add the start bit (low)
+#endif
+}
+
+/**
+ * @brief Starts a DMA transfer for the next contiguous run of queued bytes.
+ *
+ * Must be called with `uart_tx_lock` held so the queue has a single consumer, whichever core
+ * takes the DMA interrupt.
+ *
+ * @param uart Pointer to the `UartTx` instance.
+ * @return true if the queue ran empty and the transmitter went idle.
+ */
+static bool UartTx_kick(UartTx *uart)
+{
+    RingBuffer_consume(&uart->ring, uart->dma_batch); // Release the batch that just completed
+    uart->dma_batch = 0;
+
+    const uint8_t *span;
+    size_t count = RingBuffer_peek(&uart->ring, &span);
+    if (count == 0)
+    {
+        uart->busy = false;
+        return true;
+    }
+
+    if (count > UART_TX_DMA_BATCH)
+    {
+        count = UART_TX_DMA_BATCH;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        uart->dma_words[i] = UartTx_frame(uart, span[i]);
+    }
+    uart->dma_batch = count;
+    dma_channel_transfer_from_buffer_now(uart->dma_chan, uart->dma_words, count);
+    return false;
+}
+
+/**
+ * @brief Handles DMA completion for every transmitter in asynchronous mode.
+ */
+static void UartTx_handleDMAIRQ(void)
+{
+    for (uint chan = 0; chan < NUM_DMA_CHANNELS; chan++)
+    {
+        UartTx *uart = uart_tx_instances[chan];
+        if (uart && dma_channel_get_irq0_status(chan))
+        {
+            dma_channel_acknowledge_irq0(chan);
+            uint32_t status = spin_lock_blocking(uart_tx_lock);
+            bool idle = UartTx_kick(uart);
+            spin_unlock(uart_tx_lock, status);
+            if (idle && uart->callback)
+            {
+                uart->callback(uart->callback_ctx); // Outside the lock: UartTx_send takes it to queue more bytes
+            }
+        }
+    }
+}
+
+/**
+ * @brief Undoes a failed `UartTx_activateDMA`: releases the state machine and the queue.
+ *
+ * @param uart Pointer to the `UartTx` instance.
+ */
+static void UartTx_abandonDMA(UartTx *uart)
+{
+    if (uart->pio != NULL)
+    {
+        UartPico_release_program(uart->pio, uart->sm, uart->offset);
+        uart->pio = NULL;
+    }
+#if !RP_PICO_STATIC_ALLOC
+    free(uart->queue);
+    free(uart->dma_words);
+#endif
+    uart->queue = NULL;
+    uart->dma_words = NULL;
+}
+
+/**
+ * @brief Activates the UART transmission functionality in asynchronous (DMA) mode.
+ *
+ * Bytes passed to `UartTx_send` (and to `UartTx_write`/`UartTx_print`/`UartTx_println`) are
+ * queued and returned from immediately; a DMA channel paced by the TX DREQ moves them into the
+ * PIO FIFO in batches of up to `UART_TX_DMA_BATCH` frames.
+ *
+ * @param uart Pointer to the `UartTx` instance.
+ * @param queueSize Size of the transmit queue in bytes; must be a power of two.
+ *
+ * @return 0 if the UART was successfully activated, or 1 if an error occurred during the initialization;
+ *         the transmitter is then left inactive, ready for `UartTx_activate` (blocking mode).
+ */
+int UartTx_activateDMA(UartTx *uart, size_t queueSize)
+{
+#if RP_PICO_STATIC_ALLOC
+    if (queueSize > UART_TX_STATIC_QUEUE_SIZE || RingBuffer_init(&uart->ring, uart_tx_queues[uart - uart_tx_pool], queueSize) != 0)
+    {
+        return 1; // Larger than the static queue, or not a power of two
+    }
+    uart->queue = uart_tx_queues[uart - uart_tx_pool];
+    uart->dma_words = uart_tx_dma_words[uart - uart_tx_pool];
+#else
+    uart->queue = (uint8_t *)malloc(queueSize);
+    uart->dma_words = (uint32_t *)malloc(UART_TX_DMA_BATCH * sizeof(uint32_t));
+    if (uart->queue == NULL || uart->dma_words == NULL || RingBuffer_init(&uart->ring, uart->queue, queueSize) != 0)
+    {
+        free(uart->queue);
+        free(uart->dma_words);
+        uart->queue = NULL;
+        uart->dma_words = NULL;
+        return 1;
+    }
+#endif
+
+    if (UartTx_activate(uart) != 0)
+    {
+        UartTx_abandonDMA(uart);
+        return 1;
+    }
+    if (uart_tx_lock == NULL)
+    {
+        int lock = spin_lock_claim_unused(false);
+        if (lock < 0)
+        {
+            UartTx_abandonDMA(uart);
+            return 1; // No spin lock left
+        }
+        uart_tx_lock = spin_lock_instance(lock);
+    }
+
+    int chan = dma_claim_unused_channel(false);
+    if (chan < 0)
+    {
+        UartTx_abandonDMA(uart);
+        return 1; // No DMA channel left
+    }
+
+    dma_channel_config c = dma_channel_get_default_config(chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);                           // Walk the staged frames
+    channel_config_set_write_increment(&c, false);                         // Always write the SM TX FIFO
+    channel_config_set_dreq(&c, pio_get_dreq(uart->pio, uart->sm, true)); // Paced by the TX FIFO
+    dma_channel_configure(chan, &c, &uart->pio->txf[uart->sm], uart->dma_words, 0, false);
+
+    // The DMA completion interrupt is shared with any other DMA users in the application
+    static bool handler_installed = false;
+    if (!handler_installed)
+    {
+        irq_add_shared_handler(DMA_IRQ_0, UartTx_handleDMAIRQ, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+        handler_installed = true;
+    }
+    uart_tx_instances[chan] = uart;
+    dma_channel_set_irq0_enabled(chan, true);
+    uart->dma_chan = chan;
+
+    return 0;
+}
+
+/**
+ * @brief Queues bytes for asynchronous transmission and returns immediately.
+ *
+ * In blocking mode (no DMA channel) the bytes are written to the PIO FIFO before returning.
+ * In asynchronous mode it may be called from the main loop of either core and from the
+ * `UartTx_onComplete` callback: the queue is written under the transmitters' spin lock.
+ *
+ * @param uart Pointer to the `UartTx` instance.
+ * @param buf The bytes to be transmitted.
+ * @param len Number of bytes in `buf`.
+ *
+ * @return Number of bytes accepted; less than `len` if the transmit queue is full.
+ */
+size_t UartTx_send(UartTx *uart, const uint8_t *buf, size_t len)
+{
+    if (uart->dma_chan < 0)
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+            pio_sm_put_blocking(uart->pio, uart->sm, UartTx_frame(uart, buf[i]));
+        }
+        return len;
+    }
+
+    // The queue gets a single producer at a time, the main loop or the completion callback
+    uint32_t status = spin_lock_blocking(uart_tx_lock);
+    size_t space = RingBuffer_space(&uart->ring);
+    size_t count = RingBuffer_write(&uart->ring, buf, len < space ? len : space);
+
+    // Start the DMA channel if it went idle; the interrupt keeps it going from here
+    if (!uart->busy && RingBuffer_available(&uart->ring) > 0)
+    {
+        uart->busy = true;
+        UartTx_kick(uart);
+    }
+    spin_unlock(uart_tx_lock, status);
+    return count;
+}
+
+/**
+ * @brief Registers a callback fired from the DMA interrupt when the transmit queue runs empty.
+ *
+ * The callback runs in interrupt context on the core that takes DMA_IRQ_0 and may queue more
+ * bytes with `UartTx_send`.
+ *
+ * @param uart Pointer to the `UartTx` instance.
+ * @param callback The function to call, or NULL to remove it.
+ * @param ctx Argument passed to `callback`.
+ */
+void UartTx_onComplete(UartTx *uart, UartTx_callback callback, void *ctx)
+{
+    uart->callback = callback;
+    uart->callback_ctx = ctx;
+}
+
+/**
+ * @brief Takes the PIO FIFO of an idle transmitter for another DMA channel (see uart_bridge.h).
+ *
+ * While claimed, the transmitter counts as busy: `UartTx_send` keeps queueing bytes but starts
+ * no transfer, so the other channel's frames and the queued bytes never interleave.
+ *
+ * @param uart Pointer to the `UartTx` instance, in asynchronous mode.
+ * @return true if the FIFO was claimed, false if the transmit queue is being sent.
+ */
+bool UartTx_claim(UartTx *uart)
+{
+    if (uart->dma_chan < 0)
+    {
+        return false;
+    }
+    uint32_t status = spin_lock_blocking(uart_tx_lock);
+    bool claimed = !uart->busy;
+    if (claimed)
+    {
+        uart->busy = true;
+    }
+    spin_unlock(uart_tx_lock, status);
+    return claimed;
+}
+
+/**
+ * @brief Hands the PIO FIFO back after `UartTx_claim` and starts sending the bytes queued meanwhile.
+ *
+ * May be called from an interrupt handler, e.g. the claiming channel's DMA completion.
+ *
+ * @param uart Pointer to the `UartTx` instance.
+ */
+void UartTx_release(UartTx *uart)
+{
+    uint32_t status = spin_lock_blocking(uart_tx_lock);
+    uart->busy = false;
+    if (RingBuffer_available(&uart->ring) > 0)
+    {
+        uart->busy = true;
+        UartTx_kick(uart);
+    }
+    spin_unlock(uart_tx_lock, status);
+}
+
+/**
+ * @brief Returns true while queued bytes are still being handed to the PIO.
+ *
+ * @param uart Pointer to the `UartTx` instance.
+ */
+bool UartTx_isBusy(UartTx *uart)
+{
+    return uart->busy;
+}
 
-    val |= 7 << pico->bits; // Set the bits according to the specified UART configuration
-    val <<= 1;              // Shift the byte to add the start bit (low)
+/**
+ * @brief Blocks until every queued byte has left the TX pin.
+ *
+ * Waits for the transmit queue to drain, then for the PIO FIFO to empty and for the state
+ * machine to stall on its next `pull`, which happens once the last stop bit is out.
+ *
+ * @param uart Pointer to the `UartTx` instance.
+ */
+void UartTx_flush(UartTx *uart)
+{
+    while (uart->busy)
+    {
+        tight_loop_contents();
+    }
+    while (!pio_sm_is_tx_fifo_empty(uart->pio, uart->sm))
+    {
+        tight_loop_contents();
+    }
+    uint32_t stall = 1u << (PIO_FDEBUG_TXSTALL_LSB + uart->sm);
+    uart->pio->fdebug = stall; // Clear the sticky flag, then wait for the SM to stall again
+    while (!(uart->pio->fdebug & stall))
+    {
+        tight_loop_contents();
+    }
+}
 
-    // Send the byte to the FIFO
-    pio_sm_put_blocking(uart->pio, uart->sm, val);
+/**
+ * @brief Writes a single byte to the UART TX FIFO.
+ *
+ * In blocking mode this waits for room in the PIO FIFO. In asynchronous mode the byte is
+ * queued behind any bytes already waiting, waiting only if the transmit queue is full.
+ *
+ * @param uart Pointer to the `UartTx` instance.
+ * @param c The byte to be transmitted over UART.
+ */
+void UartTx_write(UartTx *uart, uint8_t c)
+{
+    while (UartTx_send(uart, &c, 1) == 0)
+    {
+        tight_loop_contents(); // Transmit queue full
+    }
 }
 
 /**
  * @brief Prints a null-terminated string via UART transmission.
  *
- * This function sends each character of the provided string to the UART TX FIFO, using the `UartTx_write` function.
+ * This function sends the provided string in one call to `UartTx_send`, waiting only while
+ * the transmit queue is full.
  *
  * @param uart Pointer to the `UartTx` instance.
  * @param str The null-terminated string to be transmitted over UART.
  */
 void UartTx_print(UartTx *uart, const char *str)
 {
-    for (size_t i = 0; i < strlen(str); i++)
+    const uint8_t *data = (const uint8_t *)str;
+    size_t len = strlen(str);
+    while (len > 0)
     {
-        UartTx_write(uart, str[i]);
+        size_t sent = UartTx_send(uart, data, len);
+        data += sent;
+        len -= sent;
     }
 }
 
@@ -190,6 +679,5 @@ void UartTx_print(UartTx *uart, const char *str)
 void UartTx_println(UartTx *uart, const char *str)
 {
     UartTx_print(uart, str);  // Send the string
-    UartTx_write(uart, '\r'); // Send carriage return
-    UartTx_write(uart, '\n'); // Send newline
+    UartTx_print(uart, "\r\n"); // Send carriage return and newline
 }
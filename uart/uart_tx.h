@@ -2,12 +2,27 @@
 #define UART_TX_H
 
 #include "uart_pico.h"
+#include "ring_buffer.h"
+
+// Number of frames handed to one DMA transfer in asynchronous mode
+#define UART_TX_DMA_BATCH 32
+
+// Static pools (RP_PICO_STATIC_ALLOC only): transmitters, and the largest queue of each
+#ifndef UART_TX_MAX_INSTANCES
+#define UART_TX_MAX_INSTANCES 2
+#endif
+#ifndef UART_TX_STATIC_QUEUE_SIZE
+#define UART_TX_STATIC_QUEUE_SIZE 256 // Largest `queueSize` of UartTx_activateDMA (power of two)
+#endif
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+// Called from the DMA interrupt once every queued byte has been handed to the PIO; may call UartTx_send
+typedef void (*UartTx_callback)(void *ctx);
+
 // Structure to hold the configuration for UART TX
 typedef struct
 {
@@ -15,14 +30,32 @@ typedef struct
     PIO pio;              /**< PIO instance for UART TX */
     int tx;               /**< TX pin number for UART transmission */
     int sm;               /**< State machine number for UART TX in PIO */
+    int offset;           /**< Offset of the TX program in instruction memory */
+
+    int dma_chan;              /**< DMA channel in asynchronous mode, or -1 in blocking mode */
+    uint8_t *queue;            /**< Storage of the transmit queue */
+    RingBuffer ring;           /**< Bytes waiting to be sent (UartTx_send producer, DMA IRQ consumer) */
+    uint32_t *dma_words;       /**< PIO frames of the batch currently being transferred */
+    size_t dma_batch;          /**< Number of queued bytes covered by the current transfer */
+    volatile bool busy;        /**< True while the DMA channel is working through the queue */
+    UartTx_callback callback;  /**< Completion callback, or NULL */
+    void *callback_ctx;        /**< Argument passed to the completion callback */
 } UartTx;
 
 // Function prototypes for initializing, activating, and using the UART TX
 UartTx* UartTx_init(UartPico *pico, uint8_t tx);
 int UartTx_activate(UartTx *uart);
+int UartTx_activateDMA(UartTx *uart, size_t queueSize);
+int UartTx_reconfigure(UartTx *uart);
 void UartTx_write(UartTx *uart, uint8_t c);
 void UartTx_print(UartTx *uart, const char *str);
 void UartTx_println(UartTx *uart, const char *str);
+size_t UartTx_send(UartTx *uart, const uint8_t *buf, size_t len);
+void UartTx_onComplete(UartTx *uart, UartTx_callback callback, void *ctx);
+bool UartTx_claim(UartTx *uart);
+void UartTx_release(UartTx *uart);
+bool UartTx_isBusy(UartTx *uart);
+void UartTx_flush(UartTx *uart);
 void UartTx_free(UartTx *uart);
 
 #ifdef __cplusplus